@@ -0,0 +1,174 @@
+#ifndef MY_COMPRESS_INCLUDED
+#define MY_COMPRESS_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file include/my_compress.h
+
+  Compression algorithms of the client/server protocol.
+
+  Besides zlib, which is always available with HAVE_COMPRESS, the protocol
+  can use LZ4 and zstd if mysys is built with them (HAVE_LZ4, HAVE_ZSTD).
+  The client picks the algorithm from those the server offers in its
+  handshake:
+
+  - zlib: CLIENT_COMPRESS
+  - zstd: CLIENT_ZSTD_COMPRESSION_ALGORITHM
+  - LZ4: CLIENT_COMPRESS and COMPRESSION_FLAG_LZ4
+
+  The client asks for only one of them. All 32 capability flags are used
+  by some client, so LZ4 has none of its own: COMPRESSION_FLAG_LZ4 is set
+  in the compression flags byte, the first of the reserved bytes of the
+  server handshake packet and of the client handshake response. Other
+  servers and clients always leave that byte 0. With zstd or LZ4, the
+  handshake response ends with one byte holding the compression level the
+  client uses, after the connection attributes. The compressed packet
+  format is unchanged, and each side compresses with a level of its own
+  choosing.
+
+  A compression context keeps the state of an algorithm and a buffer
+  between packets, so that they are not allocated for every packet.
+*/
+
+#include "my_global.h"
+
+/** The client uses zstd compression, see CLIENT_COMPRESS */
+#define CLIENT_ZSTD_COMPRESSION_ALGORITHM (1UL << 26)
+
+/** Any of the compression capabilities */
+#define CLIENT_ANY_COMPRESSION (CLIENT_COMPRESS | \
+                                CLIENT_ZSTD_COMPRESSION_ALGORITHM)
+
+/** The client uses LZ4 compression, in the compression flags byte */
+#define COMPRESSION_FLAG_LZ4 (1U << 0)
+
+C_MODE_START
+
+enum enum_compression_algorithm
+{
+  MYSQL_ZLIB= 0,
+  MYSQL_LZ4,
+  MYSQL_ZSTD,
+  MYSQL_COMPRESSION_ALGORITHMS
+};
+
+typedef struct st_mysql_compress_context
+{
+  enum enum_compression_algorithm algorithm;
+  /** Level to compress with, 0 for the default of the algorithm */
+  uint level;
+  /** z_stream, LZ4 state or ZSTD_CCtx, created on first use */
+  void *compress_state;
+  /** z_stream or ZSTD_DCtx, created on first use */
+  void *uncompress_state;
+  /** Buffer for packets of up to MY_COMPRESS_BUFFER_KEEP bytes */
+  uchar *buffer;
+  size_t buffer_length;
+} mysql_compress_context;
+
+/**
+  Larger buffers returned by mysql_compress_context_buffer() are freed by
+  mysql_compress_context_release() rather than kept in the context.
+*/
+#define MY_COMPRESS_BUFFER_KEEP (64 * 1024)
+
+/** The capability flag of an algorithm */
+ulong mysql_compression_capability(enum enum_compression_algorithm algorithm);
+
+/** The compression flag of an algorithm, 0 if it has none */
+uint mysql_compression_flag(enum enum_compression_algorithm algorithm);
+
+/** The algorithm asked for by client capabilities and compression flags */
+enum enum_compression_algorithm
+mysql_compression_algorithm(ulong client_capabilities, uint compression_flags);
+
+/** Name of an algorithm, as in @@protocol_compression_algorithms */
+const char *mysql_compression_algorithm_name(enum enum_compression_algorithm);
+
+/** The level an algorithm compresses with by default */
+uint mysql_compression_default_level(enum enum_compression_algorithm);
+
+/** Whether mysys was built with an algorithm */
+my_bool mysql_compression_algorithm_supported(enum enum_compression_algorithm);
+
+void mysql_compress_context_init(mysql_compress_context *ctx,
+                                 enum enum_compression_algorithm algorithm,
+                                 uint level);
+void mysql_compress_context_deinit(mysql_compress_context *ctx);
+
+/**
+  Get a buffer of at least the given length, to compress or uncompress
+  into. Must be given back with mysql_compress_context_release().
+
+  @return the buffer, or NULL if out of memory
+*/
+uchar *mysql_compress_context_buffer(mysql_compress_context *ctx,
+                                     size_t length);
+void mysql_compress_context_release(mysql_compress_context *ctx,
+                                    uchar *buffer);
+
+/**
+  Compress data with the algorithm of a context.
+
+  @param ctx         compression context
+  @param dst         buffer for the compressed data
+  @param dst_length  size of dst; the data is not compressed if the result
+                     would not be smaller than this
+  @param src         data to compress
+  @param src_length  length of the data
+
+  @return length of the compressed data, or 0 if it was not compressed
+*/
+size_t my_compress_buffer(mysql_compress_context *ctx,
+                          uchar *dst, size_t dst_length,
+                          const uchar *src, size_t src_length);
+
+/**
+  Uncompress data compressed with my_compress_buffer().
+
+  @param ctx         compression context
+  @param dst         buffer for the original data
+  @param dst_length  length of the original data
+  @param src         compressed data
+  @param src_length  length of the compressed data
+
+  @retval FALSE  ok
+  @retval TRUE   corrupt data, or out of memory
+*/
+my_bool my_uncompress_buffer(mysql_compress_context *ctx,
+                             uchar *dst, size_t dst_length,
+                             const uchar *src, size_t src_length);
+
+struct st_net;
+
+/**
+  Compress the packets of a connection with an algorithm, once NET::compress
+  is set. Implemented in net_serv.cc.
+
+  @retval FALSE  ok
+  @retval TRUE   the algorithm is not supported, or out of memory
+*/
+my_bool net_set_compression(struct st_net *net,
+                            enum enum_compression_algorithm algorithm,
+                            uint level);
+
+/** The compression context of a connection, NULL for plain zlib */
+mysql_compress_context *net_compress_context(struct st_net *net);
+
+C_MODE_END
+
+#endif /* MY_COMPRESS_INCLUDED */
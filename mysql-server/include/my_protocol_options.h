@@ -0,0 +1,48 @@
+#ifndef MY_PROTOCOL_OPTIONS_INCLUDED
+#define MY_PROTOCOL_OPTIONS_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file include/my_protocol_options.h
+
+  Options of the client/server protocol that a client turns on for its
+  session with COM_SET_OPTION, see mysql_set_server_option(), like
+  MYSQL_OPTION_MULTI_STATEMENTS_ON.
+
+  All 32 capability flags are used by some client, so these features are
+  not offered in the handshake. The client asks for them once it is
+  connected. A server that does not have an option answers with
+  ER_UNKNOWN_COM_ERROR, and the client then does without it. The values
+  are far from those of enum_mysql_set_option, so that they don't collide
+  with new values of it.
+
+  - MYSQL_OPTION_PIPELINE_ON: the client may send commands before it has
+    read the responses to the previous ones. The server then holds back
+    the responses of a command while the next command is already there,
+    and sends them with the responses of the next command.
+  - MYSQL_OPTION_STMT_EXECUTE_BATCH_ON: a COM_STMT_EXECUTE packet with an
+    iteration count greater than 1 holds that many sets of parameters to
+    execute the statement with. Without it, the server uses the first set
+    and ignores the iteration count, as it always did.
+*/
+
+#define MYSQL_OPTION_PIPELINE_ON            0x100
+#define MYSQL_OPTION_PIPELINE_OFF           0x101
+#define MYSQL_OPTION_STMT_EXECUTE_BATCH_ON  0x102
+#define MYSQL_OPTION_STMT_EXECUTE_BATCH_OFF 0x103
+
+#endif /* MY_PROTOCOL_OPTIONS_INCLUDED */
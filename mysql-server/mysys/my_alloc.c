@@ -410,6 +410,98 @@ void free_root(MEM_ROOT *root, myf MyFlags)
 }
 
 
+
+/*
+  Deallocate everything used by alloc_root, but keep blocks for reuse
+
+  SYNOPSIS
+    free_root_retain()
+      root		Memory root
+      retain_size	Keep blocks up to this many bytes in total,
+			the preallocated block included
+      allocated_blocks	Incremented by the number of blocks malloc'ed
+			since the previous call
+      reused_blocks	Incremented by the number of kept blocks, other
+			than the preallocated one, which were allocated
+			from again since the previous call
+
+  NOTES
+    Like free_root(root, MYF(MY_KEEP_PREALLOC)), except that the blocks
+    which fit in retain_size are left in the free list of the root, where
+    alloc_root() takes them before it malloc's a new block. The
+    preallocated block is kept first in the list, it is the one most used.
+    Without PREALLOCATE_MEMORY_CHUNKS, alloc_root() mallocs every
+    allocation and this is just free_root().
+*/
+
+void free_root_retain(MEM_ROOT *root, size_t retain_size,
+                      ulonglong *allocated_blocks, ulonglong *reused_blocks)
+{
+#ifdef PREALLOCATE_MEMORY_CHUNKS
+  /* init_alloc_root() and free_root() start counting blocks at 4 */
+  uint fresh= root->block_num - 4;
+  uint touched= 0;
+  size_t kept_size= root->pre_alloc ? root->pre_alloc->size : 0;
+  USED_MEM *kept= 0;
+  USED_MEM *lists[2];
+  USED_MEM *next,*old;
+  uint i;
+  DBUG_ENTER("free_root_retain");
+  DBUG_PRINT("enter",("root: 0x%lx  retain_size: %lu", (long) root,
+                      (ulong) retain_size));
+
+  lists[0]= root->used;
+  lists[1]= root->free;
+  for (i= 0; i < 2; i++)
+  {
+    for (next= lists[i]; next ;)
+    {
+      old=next; next= next->next;
+      if (old != root->pre_alloc &&
+          old->left + ALIGN_SIZE(sizeof(USED_MEM)) != old->size)
+        touched++;
+
+      if (old == root->pre_alloc || kept_size + old->size <= retain_size)
+      {
+        if (old != root->pre_alloc)
+          kept_size+= old->size;
+        old->left= old->size - (uint)ALIGN_SIZE(sizeof(USED_MEM));
+        TRASH_MEM(old);
+        if (old == root->pre_alloc || !kept)
+        {
+          old->next= kept;
+          kept= old;
+        }
+        else
+        {
+          old->next= kept->next;
+          kept->next= old;
+        }
+      }
+      else
+      {
+        old->left= old->size;
+        TRASH_MEM(old);
+        my_free(old);
+      }
+    }
+  }
+  root->used= 0;
+  root->free= kept;
+  root->block_num= 4;
+  root->first_block_usage= 0;
+
+  *allocated_blocks+= fresh;
+  *reused_blocks+= touched > fresh ? touched - fresh : 0;
+  DBUG_VOID_RETURN;
+#else
+  (void) retain_size;
+  (void) allocated_blocks;
+  (void) reused_blocks;
+  free_root(root, MYF(MY_KEEP_PREALLOC));
+#endif
+}
+
 char *strdup_root(MEM_ROOT *root, const char *str)
 {
   return strmake_root(root, str, strlen(str));
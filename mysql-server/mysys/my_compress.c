@@ -19,8 +19,16 @@
 #include <mysys_priv.h>
 #ifdef HAVE_COMPRESS
 #include <my_sys.h>
+#include <my_compress.h>
+#include <mysql_com.h>                          /* CLIENT_COMPRESS */
 #include <m_string.h>
 #include <zlib.h>
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 /*
    This replaces the packet with a compressed packet
@@ -137,6 +145,334 @@ my_bool my_uncompress(uchar *packet, size_t len, size_t *complen)
   DBUG_RETURN(0);
 }
 
+/*
+  Compression contexts of the client/server protocol, see my_compress.h
+*/
+
+static const char *compression_algorithm_names[]= { "zlib", "lz4", "zstd" };
+
+
+ulong mysql_compression_capability(enum enum_compression_algorithm algorithm)
+{
+  switch (algorithm)
+  {
+  case MYSQL_ZSTD:
+    return CLIENT_ZSTD_COMPRESSION_ALGORITHM;
+  default:
+    return CLIENT_COMPRESS;
+  }
+}
+
+
+uint mysql_compression_flag(enum enum_compression_algorithm algorithm)
+{
+  return algorithm == MYSQL_LZ4 ? COMPRESSION_FLAG_LZ4 : 0;
+}
+
+
+enum enum_compression_algorithm
+mysql_compression_algorithm(ulong client_capabilities, uint compression_flags)
+{
+  if (client_capabilities & CLIENT_ZSTD_COMPRESSION_ALGORITHM)
+    return MYSQL_ZSTD;
+  if (compression_flags & COMPRESSION_FLAG_LZ4)
+    return MYSQL_LZ4;
+  return MYSQL_ZLIB;
+}
+
+
+const char *
+mysql_compression_algorithm_name(enum enum_compression_algorithm algorithm)
+{
+  DBUG_ASSERT(algorithm < MYSQL_COMPRESSION_ALGORITHMS);
+  return compression_algorithm_names[algorithm];
+}
+
+
+uint mysql_compression_default_level(enum enum_compression_algorithm algorithm)
+{
+  switch (algorithm)
+  {
+  case MYSQL_LZ4:
+    return 1;
+  case MYSQL_ZSTD:
+    return 3;                                   /* ZSTD_CLEVEL_DEFAULT */
+  default:
+    return 6;                                   /* Z_DEFAULT_COMPRESSION */
+  }
+}
+
+
+my_bool
+mysql_compression_algorithm_supported(enum enum_compression_algorithm algorithm)
+{
+  switch (algorithm)
+  {
+  case MYSQL_ZLIB:
+    return TRUE;
+#ifdef HAVE_LZ4
+  case MYSQL_LZ4:
+    return TRUE;
+#endif
+#ifdef HAVE_ZSTD
+  case MYSQL_ZSTD:
+    return TRUE;
+#endif
+  default:
+    return FALSE;
+  }
+}
+
+
+void mysql_compress_context_init(mysql_compress_context *ctx,
+                                 enum enum_compression_algorithm algorithm,
+                                 uint level)
+{
+  DBUG_ASSERT(mysql_compression_algorithm_supported(algorithm));
+  ctx->algorithm= algorithm;
+  ctx->level= level;
+  ctx->compress_state= NULL;
+  ctx->uncompress_state= NULL;
+  ctx->buffer= NULL;
+  ctx->buffer_length= 0;
+}
+
+
+void mysql_compress_context_deinit(mysql_compress_context *ctx)
+{
+  switch (ctx->algorithm)
+  {
+  case MYSQL_ZLIB:
+    if (ctx->compress_state)
+      deflateEnd((z_stream *) ctx->compress_state);
+    if (ctx->uncompress_state)
+      inflateEnd((z_stream *) ctx->uncompress_state);
+    my_free(ctx->compress_state);
+    my_free(ctx->uncompress_state);
+    break;
+#ifdef HAVE_LZ4
+  case MYSQL_LZ4:
+    my_free(ctx->compress_state);
+    break;
+#endif
+#ifdef HAVE_ZSTD
+  case MYSQL_ZSTD:
+    ZSTD_freeCCtx((ZSTD_CCtx *) ctx->compress_state);
+    ZSTD_freeDCtx((ZSTD_DCtx *) ctx->uncompress_state);
+    break;
+#endif
+  default:
+    break;
+  }
+  my_free(ctx->buffer);
+  ctx->compress_state= NULL;
+  ctx->uncompress_state= NULL;
+  ctx->buffer= NULL;
+  ctx->buffer_length= 0;
+}
+
+
+uchar *mysql_compress_context_buffer(mysql_compress_context *ctx,
+                                     size_t length)
+{
+  if (length > MY_COMPRESS_BUFFER_KEEP)
+    return (uchar *) my_malloc(key_memory_my_compress_alloc, length,
+                               MYF(MY_WME));
+  if (ctx->buffer == NULL)
+  {
+    if (!(ctx->buffer= (uchar *) my_malloc(key_memory_my_compress_alloc,
+                                           MY_COMPRESS_BUFFER_KEEP,
+                                           MYF(MY_WME))))
+      return NULL;
+    ctx->buffer_length= MY_COMPRESS_BUFFER_KEEP;
+  }
+  return ctx->buffer;
+}
+
+
+void mysql_compress_context_release(mysql_compress_context *ctx,
+                                    uchar *buffer)
+{
+  if (buffer != ctx->buffer)
+    my_free(buffer);
+}
+
+
+/**
+  Compress with zlib, in the format of compress(), reusing the z_stream
+  of the context instead of initializing one for every packet.
+*/
+
+static size_t zlib_compress(mysql_compress_context *ctx,
+                            uchar *dst, size_t dst_length,
+                            const uchar *src, size_t src_length)
+{
+  z_stream *stream= (z_stream *) ctx->compress_state;
+  int res;
+
+  if (stream == NULL)
+  {
+    const int level= ctx->level ? (int) MY_MIN(ctx->level, 9) :
+                                  (int) mysql_compression_default_level(MYSQL_ZLIB);
+    if (!(stream= (z_stream *) my_malloc(key_memory_my_compress_alloc,
+                                         sizeof(z_stream),
+                                         MYF(MY_WME | MY_ZEROFILL))))
+      return 0;
+    if (deflateInit(stream, level) != Z_OK)
+    {
+      my_free(stream);
+      return 0;
+    }
+    ctx->compress_state= stream;
+  }
+  else if (deflateReset(stream) != Z_OK)
+    return 0;
+
+  stream->next_in= (Bytef *) src;
+  stream->avail_in= (uInt) src_length;
+  stream->next_out= (Bytef *) dst;
+  stream->avail_out= (uInt) dst_length;
+
+  /* Z_OK means that the output buffer was too small */
+  res= deflate(stream, Z_FINISH);
+  return res == Z_STREAM_END ? (size_t) stream->total_out : 0;
+}
+
+
+static my_bool zlib_uncompress(mysql_compress_context *ctx,
+                               uchar *dst, size_t dst_length,
+                               const uchar *src, size_t src_length)
+{
+  z_stream *stream= (z_stream *) ctx->uncompress_state;
+
+  if (stream == NULL)
+  {
+    if (!(stream= (z_stream *) my_malloc(key_memory_my_compress_alloc,
+                                         sizeof(z_stream),
+                                         MYF(MY_WME | MY_ZEROFILL))))
+      return TRUE;
+    if (inflateInit(stream) != Z_OK)
+    {
+      my_free(stream);
+      return TRUE;
+    }
+    ctx->uncompress_state= stream;
+  }
+  else if (inflateReset(stream) != Z_OK)
+    return TRUE;
+
+  stream->next_in= (Bytef *) src;
+  stream->avail_in= (uInt) src_length;
+  stream->next_out= (Bytef *) dst;
+  stream->avail_out= (uInt) dst_length;
+
+  return inflate(stream, Z_FINISH) != Z_STREAM_END ||
+         stream->total_out != dst_length;
+}
+
+
+size_t my_compress_buffer(mysql_compress_context *ctx,
+                          uchar *dst, size_t dst_length,
+                          const uchar *src, size_t src_length)
+{
+  size_t length= 0;
+  DBUG_ENTER("my_compress_buffer");
+
+  if (src_length < MIN_COMPRESS_LENGTH)
+    DBUG_RETURN(0);
+  /* Only worth it if the result is smaller than the original */
+  dst_length= MY_MIN(dst_length, src_length - 1);
+
+  switch (ctx->algorithm)
+  {
+  case MYSQL_ZLIB:
+    length= zlib_compress(ctx, dst, dst_length, src, src_length);
+    break;
+#ifdef HAVE_LZ4
+  case MYSQL_LZ4:
+  {
+    int res;
+    if (ctx->compress_state == NULL &&
+        !(ctx->compress_state= my_malloc(key_memory_my_compress_alloc,
+                                         LZ4_sizeofState(), MYF(MY_WME))))
+      break;
+    /* LZ4 has a single level: the fast one */
+    res= LZ4_compress_fast_extState(ctx->compress_state, (const char *) src,
+                                    (char *) dst, (int) src_length,
+                                    (int) dst_length, 1);
+    length= res > 0 ? (size_t) res : 0;
+    break;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case MYSQL_ZSTD:
+  {
+    size_t res;
+    if (ctx->compress_state == NULL &&
+        !(ctx->compress_state= ZSTD_createCCtx()))
+      break;
+    res= ZSTD_compressCCtx((ZSTD_CCtx *) ctx->compress_state,
+                           dst, dst_length, src, src_length,
+                           (int) (ctx->level ? ctx->level :
+                                  mysql_compression_default_level(MYSQL_ZSTD)));
+    length= ZSTD_isError(res) ? 0 : res;
+    break;
+  }
+#endif
+  default:
+    DBUG_ASSERT(0);
+  }
+
+  DBUG_PRINT("info", ("%s: %lu -> %lu",
+                      mysql_compression_algorithm_name(ctx->algorithm),
+                      (ulong) src_length, (ulong) length));
+  DBUG_RETURN(length);
+}
+
+
+my_bool my_uncompress_buffer(mysql_compress_context *ctx,
+                             uchar *dst, size_t dst_length,
+                             const uchar *src, size_t src_length)
+{
+  my_bool error= TRUE;
+  DBUG_ENTER("my_uncompress_buffer");
+
+  switch (ctx->algorithm)
+  {
+  case MYSQL_ZLIB:
+    error= zlib_uncompress(ctx, dst, dst_length, src, src_length);
+    break;
+#ifdef HAVE_LZ4
+  case MYSQL_LZ4:
+    error= LZ4_decompress_safe((const char *) src, (char *) dst,
+                               (int) src_length, (int) dst_length) !=
+           (int) dst_length;
+    break;
+#endif
+#ifdef HAVE_ZSTD
+  case MYSQL_ZSTD:
+  {
+    size_t res;
+    if (ctx->uncompress_state == NULL &&
+        !(ctx->uncompress_state= ZSTD_createDCtx()))
+      break;
+    res= ZSTD_decompressDCtx((ZSTD_DCtx *) ctx->uncompress_state,
+                             dst, dst_length, src, src_length);
+    error= ZSTD_isError(res) || res != dst_length;
+    break;
+  }
+#endif
+  default:
+    DBUG_ASSERT(0);
+  }
+
+  if (error)
+    DBUG_PRINT("error", ("Can't uncompress %s packet",
+                         mysql_compression_algorithm_name(ctx->algorithm)));
+  DBUG_RETURN(error);
+}
+
+
 /*
   Internal representation of the frm blob is:
 
@@ -0,0 +1,158 @@
+#!/usr/bin/perl
+# Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Library General Public
+# License as published by the Free Software Foundation; version 2
+# of the License.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public
+# License along with this library; if not, write to the Free
+# Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+# MA 02110-1301, USA
+#
+# Test of ref joins executed with plain nested loop, block nested loop
+# and batched key access. The inner table is accessed through a secondary
+# index with keys in random order, which is where sorting the key batch
+# before the lookups pays off.
+#
+##################### Standard benchmark inits ##############################
+
+use Cwd;
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+$opt_loop_count=100000;
+$opt_medium_loop_count=20;
+
+$pwd = cwd(); $pwd = "." if ($pwd eq '');
+require "$pwd/bench-init.pl" || die "Can't read Configuration file: $!\n";
+
+if ($opt_small_test)
+{
+  $opt_loop_count/=10;
+  $opt_medium_loop_count/=10;
+}
+
+print "Testing the speed of ref joins with different join buffering\n";
+print "The test-tables have $opt_loop_count rows.\n\n";
+
+if ($opt_server !~ /^mysql/)
+{
+  print "Join buffering can only be tuned with MySQL, skipping test\n";
+  end_benchmark(new Benchmark);
+  exit(0);
+}
+
+####
+####  Connect and start timeing
+####
+
+$dbh = $server->connect();
+$start_time=new Benchmark;
+
+####
+#### Create needed tables
+####
+
+goto select_test if ($opt_skip_create);
+
+print "Creating tables\n";
+$dbh->do("drop table bench1" . $server->{'drop_attr'});
+$dbh->do("drop table bench2" . $server->{'drop_attr'});
+
+do_many($dbh,$server->create("bench1",
+			     ["id integer(9) NOT NULL",
+			      "ref_id integer(9) NOT NULL",
+			      "filler char(32) NOT NULL"],
+			     ["primary key (id)"]));
+do_many($dbh,$server->create("bench2",
+			     ["id integer(9) NOT NULL",
+			      "key_id integer(9) NOT NULL",
+			      "filler char(200) NOT NULL"],
+			     ["primary key (id)",
+			      "unique (key_id)"]));
+
+####
+#### Insert $opt_loop_count records in both tables. bench1.ref_id refers
+#### to bench2.key_id in a pseudo random order, and bench2.key_id is not
+#### correlated with bench2.id.
+####
+
+print "Inserting $opt_loop_count rows into each table\n";
+
+$loop_time=new Benchmark;
+$prime=1000003;
+for ($id=0 ; $id < $opt_loop_count ; $id++)
+{
+  $ref_id=($id*$prime) % $opt_loop_count;
+  $key_id=($id*7919) % $opt_loop_count;
+  do_query($dbh,"insert into bench1 values ($id,$ref_id,'row $id')");
+  do_query($dbh,"insert into bench2 values ($id,$key_id,'row $id')");
+}
+$end_time=new Benchmark;
+print "Time to insert (" . ($opt_loop_count*2) . "): " .
+    timestr(timediff($end_time, $loop_time),"all") . "\n\n";
+
+if ($opt_fast && defined($server->{vacuum}))
+{
+  $server->vacuum(0,\$dbh,"bench1","bench2");
+}
+
+####
+#### Do the joins
+####
+
+select_test:
+
+@join_modes=
+  (["nested_loop", "block_nested_loop=off,batched_key_access=off"],
+   ["block_nested_loop", "block_nested_loop=on,batched_key_access=off"],
+   ["batched_key_access",
+    "mrr=on,mrr_cost_based=off,block_nested_loop=off,batched_key_access=on"]);
+
+$query="select count(*),sum(length(bench2.filler)) from bench1,bench2 " .
+  "where bench2.key_id=bench1.ref_id and bench1.id < ";
+
+foreach $mode (@join_modes)
+{
+  do_query($dbh,"set optimizer_switch='$mode->[1]'");
+  foreach $fraction (10, 1)
+  {
+    $limit=int($opt_loop_count/$fraction);
+    $loop_time=new Benchmark;
+    $rows=$estimated=$count=0;
+    for ($i=0 ; $i < $opt_medium_loop_count ; $i++)
+    {
+      $count++;
+      $rows+=fetch_all_rows($dbh,$query . $limit);
+      $end_time=new Benchmark;
+      last if ($estimated=predict_query_time($loop_time,$end_time,\$count,
+					     $i+1,$opt_medium_loop_count));
+    }
+    print_time($estimated);
+    print " for join_$mode->[0]_$limit ($count:$rows): " .
+      timestr(timediff($end_time, $loop_time),"all") . "\n";
+  }
+}
+do_query($dbh,"set optimizer_switch=default");
+
+####
+#### End of benchmark
+####
+
+if (!$opt_skip_delete)
+{
+  do_query($dbh,"drop table bench1" . $server->{'drop_attr'});
+  do_query($dbh,"drop table bench2" . $server->{'drop_attr'});
+}
+
+$dbh->disconnect;				# close connection
+
+end_benchmark($start_time);
@@ -0,0 +1,218 @@
+#!/usr/bin/perl
+# Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Library General Public
+# License as published by the Free Software Foundation; version 2
+# of the License.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public
+# License along with this library; if not, write to the Free
+# Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+# MA 02110-1301, USA
+#
+# Test of the time to choose the join order of star and snowflake joins
+# of many tables with the greedy search and with the dynamic programming
+# search, and of the estimated cost of the chosen plans. Only EXPLAIN is
+# run, so the time is the time of optimization.
+#
+##################### Standard benchmark inits ##############################
+
+use Cwd;
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+$opt_loop_count=1000;
+$opt_medium_loop_count=200;
+$opt_dimensions=8;
+
+$pwd = cwd(); $pwd = "." if ($pwd eq '');
+require "$pwd/bench-init.pl" || die "Can't read Configuration file: $!\n";
+
+if ($opt_small_test)
+{
+  $opt_loop_count/=10;
+  $opt_medium_loop_count/=10;
+}
+
+print "Testing the speed of join order optimization\n";
+print "The fact table has $opt_loop_count rows and $opt_dimensions " .
+  "dimension tables, each with a sub-dimension table.\n\n";
+
+if ($opt_server !~ /^mysql/)
+{
+  print "The join order search can only be tuned with MySQL, skipping test\n";
+  end_benchmark(new Benchmark);
+  exit(0);
+}
+
+####
+####  Connect and start timeing
+####
+
+$dbh = $server->connect();
+$start_time=new Benchmark;
+
+####
+#### Create needed tables
+####
+
+goto select_test if ($opt_skip_create);
+
+print "Creating tables\n";
+for ($d=1 ; $d <= $opt_dimensions ; $d++)
+{
+  $dbh->do("drop table bench_dim$d" . $server->{'drop_attr'});
+  $dbh->do("drop table bench_sub$d" . $server->{'drop_attr'});
+}
+$dbh->do("drop table bench_fact" . $server->{'drop_attr'});
+
+@fact_fields=("id integer(9) NOT NULL");
+@fact_keys=("primary key (id)");
+for ($d=1 ; $d <= $opt_dimensions ; $d++)
+{
+  push(@fact_fields,"dim$d integer(9) NOT NULL");
+  push(@fact_keys,"index (dim$d)");
+  do_many($dbh,$server->create("bench_dim$d",
+			       ["id integer(9) NOT NULL",
+				"sub_id integer(9) NOT NULL",
+				"val integer(9) NOT NULL"],
+			       ["primary key (id)"]));
+  do_many($dbh,$server->create("bench_sub$d",
+			       ["id integer(9) NOT NULL",
+				"val integer(9) NOT NULL"],
+			       ["primary key (id)"]));
+}
+do_many($dbh,$server->create("bench_fact",\@fact_fields,\@fact_keys));
+
+####
+#### Dimension tables of different sizes, so that the order of the
+#### joins matters for the cost of the plan
+####
+
+print "Inserting rows\n";
+
+$loop_time=new Benchmark;
+$rows=0;
+for ($d=1 ; $d <= $opt_dimensions ; $d++)
+{
+  $dim_rows=$d*10;
+  for ($id=0 ; $id < $dim_rows ; $id++)
+  {
+    $sub_id=$id % ($d+1);
+    do_query($dbh,"insert into bench_dim$d values ($id,$sub_id,$id % 7)");
+    $rows++;
+  }
+  for ($id=0 ; $id <= $d ; $id++)
+  {
+    do_query($dbh,"insert into bench_sub$d values ($id,$id)");
+    $rows++;
+  }
+}
+for ($id=0 ; $id < $opt_loop_count ; $id++)
+{
+  $values="$id";
+  for ($d=1 ; $d <= $opt_dimensions ; $d++)
+  {
+    $values.="," . (($id*7919+$d) % ($d*10));
+  }
+  do_query($dbh,"insert into bench_fact values ($values)");
+  $rows++;
+}
+$end_time=new Benchmark;
+print "Time to insert ($rows): " .
+    timestr(timediff($end_time, $loop_time),"all") . "\n\n";
+
+if ($opt_fast && defined($server->{vacuum}))
+{
+  $server->vacuum(0,\$dbh,"bench_fact");
+}
+do_query($dbh,"analyze table bench_fact");
+
+####
+#### Optimize the joins
+####
+
+select_test:
+
+$star_tables="bench_fact";
+$star_where="";
+for ($d=1 ; $d <= $opt_dimensions ; $d++)
+{
+  $star_tables.=",bench_dim$d";
+  $star_where.=" and " if ($d > 1);
+  $star_where.="bench_fact.dim$d=bench_dim$d.id and bench_dim$d.val < $d";
+}
+$snowflake_tables=$star_tables;
+$snowflake_where=$star_where;
+for ($d=1 ; $d <= $opt_dimensions ; $d++)
+{
+  $snowflake_tables.=",bench_sub$d";
+  $snowflake_where.=" and bench_dim$d.sub_id=bench_sub$d.id";
+}
+
+@queries=
+  (["star",
+    "explain select count(*) from $star_tables where $star_where"],
+   ["snowflake",
+    "explain select count(*) from $snowflake_tables where $snowflake_where"]);
+
+@search_modes=
+  (["greedy", "optimizer_dp_join_limit=0"],
+   ["greedy_exhaustive",
+    "optimizer_dp_join_limit=0,optimizer_prune_level=0"],
+   ["dp", "optimizer_dp_join_limit=61"],
+   ["dp_max_plans_100",
+    "optimizer_dp_join_limit=61,optimizer_dp_max_plans=100"]);
+
+foreach $query (@queries)
+{
+  foreach $mode (@search_modes)
+  {
+    do_query($dbh,"set $mode->[1]");
+    $loop_time=new Benchmark;
+    $count=0;
+    for ($i=0 ; $i < $opt_medium_loop_count ; $i++)
+    {
+      $count++;
+      fetch_all_rows($dbh,$query->[1]);
+      $end_time=new Benchmark;
+      last if ($estimated=predict_query_time($loop_time,$end_time,\$count,
+					     $i+1,$opt_medium_loop_count));
+    }
+    $sth=$dbh->prepare("show session status like 'Last_query_cost'") or
+      die $DBI::errstr;
+    $sth->execute or die $DBI::errstr;
+    ($name,$cost)=$sth->fetchrow_array;
+    $sth->finish;
+    print_time($estimated);
+    print " for $query->[0]_$mode->[0] ($count, cost $cost): " .
+      timestr(timediff($end_time, $loop_time),"all") . "\n";
+    do_query($dbh,"set optimizer_dp_join_limit=default," .
+	     "optimizer_dp_max_plans=default,optimizer_prune_level=default");
+  }
+}
+
+####
+#### End of benchmark
+####
+
+if (!$opt_skip_delete)
+{
+  for ($d=1 ; $d <= $opt_dimensions ; $d++)
+  {
+    do_query($dbh,"drop table bench_dim$d" . $server->{'drop_attr'});
+    do_query($dbh,"drop table bench_sub$d" . $server->{'drop_attr'});
+  }
+  do_query($dbh,"drop table bench_fact" . $server->{'drop_attr'});
+}
+
+$dbh->disconnect;				# close connection
+
+end_benchmark($start_time);
@@ -0,0 +1,180 @@
+#!/usr/bin/perl
+# Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Library General Public
+# License as published by the Free Software Foundation; version 2
+# of the License.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public
+# License along with this library; if not, write to the Free
+# Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+# MA 02110-1301, USA
+#
+# Test of the rate of connects and of short queries with many concurrent
+# clients. Run it against a server started with
+# --thread-handling=one-thread-per-connection and against one started
+# with --thread-handling=pool-of-threads, and compare the results.
+#
+##################### Standard benchmark inits ##############################
+
+use Cwd;
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+$opt_loop_count=10000;
+$opt_medium_loop_count=1000;
+$opt_clients=64;
+
+$pwd = cwd(); $pwd = "." if ($pwd eq '');
+require "$pwd/bench-init.pl" || die "Can't read Configuration file: $!\n";
+
+if ($opt_small_test)
+{
+  $opt_loop_count/=10;
+  $opt_medium_loop_count/=10;
+  $opt_clients/=4;
+}
+
+print "Testing the speed of connects and short queries of many clients\n";
+print "$opt_clients concurrent clients\n\n";
+
+if ($opt_server !~ /^mysql/)
+{
+  print "The thread handling can only be chosen with MySQL, skipping test\n";
+  end_benchmark(new Benchmark);
+  exit(0);
+}
+
+####
+####  Connect and start timeing
+####
+
+$dbh = $server->connect();
+$start_time=new Benchmark;
+
+$sth=$dbh->prepare("select \@\@thread_handling") or die $DBI::errstr;
+$sth->execute or die $DBI::errstr;
+($thread_handling)=$sth->fetchrow_array;
+$sth->finish;
+print "The server uses thread_handling=$thread_handling\n";
+
+####
+#### Create needed tables
+####
+
+goto select_test if ($opt_skip_create);
+
+print "Creating table\n";
+$dbh->do("drop table bench1" . $server->{'drop_attr'});
+
+do_many($dbh,$server->create("bench1",
+			     ["id integer(9) NOT NULL",
+			      "val integer(9) NOT NULL"],
+			     ["primary key (id)"]));
+
+print "Inserting $opt_medium_loop_count rows\n";
+$dbh->do("LOCK TABLES bench1 WRITE") if ($limits->{'lock_tables'});
+for ($i=0 ; $i < $opt_medium_loop_count ; $i++)
+{
+  $dbh->do("insert into bench1 values ($i," . ($i % 100) . ")") or
+    die $DBI::errstr;
+}
+$dbh->do("UNLOCK TABLES") if ($limits->{'lock_tables'});
+
+####
+#### Run the clients
+####
+
+select_test:
+
+#
+# Start $opt_clients processes that run &$work($count) at the same time
+# and wait for all of them.
+#
+
+sub run_clients
+{
+  my ($work,$count)=@_;
+  my ($client,$pid,%pids);
+
+  for ($client=0 ; $client < $opt_clients ; $client++)
+  {
+    $pid=fork();
+    die "Can't fork: $!\n" if (!defined($pid));
+    if ($pid == 0)
+    {
+      $dbh->{InactiveDestroy}=1;	# Don't close the parent's connection
+      exit(&$work($client,$count));
+    }
+    $pids{$pid}=1;
+  }
+  while (($pid=wait()) > 0)
+  {
+    die "Client $pid failed\n" if ($? && $pids{$pid});
+  }
+}
+
+sub connect_client
+{
+  my ($client,$count)=@_;
+  my ($i,$cdbh);
+
+  for ($i=0 ; $i < $count ; $i++)
+  {
+    $cdbh=$server->connect() || return 1;
+    $cdbh->disconnect;
+  }
+  return 0;
+}
+
+sub query_client
+{
+  my ($client,$count)=@_;
+  my ($i,$cdbh,$sth);
+
+  $cdbh=$server->connect() || return 1;
+  $sth=$cdbh->prepare("select val from bench1 where id=?") || return 1;
+  for ($i=0 ; $i < $count ; $i++)
+  {
+    $sth->execute(($client * $count + $i) % $opt_medium_loop_count) ||
+      return 1;
+    $sth->fetchrow_array;
+  }
+  $sth->finish;
+  $cdbh->disconnect;
+  return 0;
+}
+
+$count=int($opt_medium_loop_count / $opt_clients) + 1;
+$loop_time=new Benchmark;
+run_clients(\&connect_client,$count);
+$end_time=new Benchmark;
+print "Time for connect+disconnect (" . $count * $opt_clients . "): " .
+  timestr(timediff($end_time, $loop_time),"all") . "\n";
+
+$count=int($opt_loop_count / $opt_clients) + 1;
+$loop_time=new Benchmark;
+run_clients(\&query_client,$count);
+$end_time=new Benchmark;
+print "Time for select_key_concurrent (" . $count * $opt_clients . "): " .
+  timestr(timediff($end_time, $loop_time),"all") . "\n";
+
+####
+#### End of benchmark
+####
+
+if (!$opt_skip_delete)
+{
+  do_query($dbh,"drop table bench1" . $server->{'drop_attr'});
+}
+
+$dbh->disconnect;				# close connection
+
+end_benchmark($start_time);
@@ -66,6 +66,7 @@ my_bool	net_flush(NET *net);
 #include "mysqld_error.h"
 #include "errmsg.h"
 #include <violite.h>
+#include <my_compress.h>
 
 #if !defined(_WIN32)
 #include <my_pthread.h>				/* because of signal()	*/
@@ -3261,13 +3262,18 @@ error:
     4           client capabilities
     4           max packet size
     1           charset number
-    23          reserved (always 0)
+    1           compression flags, see my_compress.h
+    22          reserved (always 0)
     n           user name, \0-terminated
     n           plugin auth data (e.g. scramble), length encoded
     n           database name, \0-terminated
                 (if CLIENT_CONNECT_WITH_DB is set in the capabilities)
     n           client auth plugin name - \0-terminated string,
                 (if CLIENT_PLUGIN_AUTH is set in the capabilities)
+    n           connection attributes
+                (if CLIENT_CONNECT_ATTRS is set in the capabilities)
+    1           compression level (if the client compresses with zstd
+                or LZ4)
 
   @retval 0 ok
   @retval 1 error
@@ -3277,6 +3283,7 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
 {
   MYSQL *mysql= mpvio->mysql;
   NET *net= &mysql->net;
+  const mysql_compress_context *compress_ctx= net_compress_context(net);
   char *buff, *end;
   size_t buff_size;
   size_t connect_attrs_len=
@@ -3291,7 +3298,7 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
     see end= buff+32 below, fixed size of the packet is 32 bytes.
      +9 because data is a length encoded binary where meta data size is max 9.
   */
-  buff_size= 33 + USERNAME_LENGTH + data_len + 9 + NAME_LEN + NAME_LEN + connect_attrs_len + 9;
+  buff_size= 33 + USERNAME_LENGTH + data_len + 9 + NAME_LEN + NAME_LEN + connect_attrs_len + 9 + 1;
   buff= my_alloca(buff_size);
 
   mysql->client_flag|= mysql->options.client_flag;
@@ -3322,9 +3329,10 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
                        (~(CLIENT_COMPRESS | CLIENT_SSL | CLIENT_PROTOCOL_41) 
                        | mysql->server_capabilities);
 
-#ifndef HAVE_COMPRESS
-  mysql->client_flag&= ~CLIENT_COMPRESS;
-#endif
+  /* Ask for the algorithm picked from the server handshake, if any */
+  mysql->client_flag&= ~CLIENT_ANY_COMPRESSION;
+  if (compress_ctx)
+    mysql->client_flag|= mysql_compression_capability(compress_ctx->algorithm);
 
   if (mysql->client_flag & CLIENT_PROTOCOL_41)
   {
@@ -3334,6 +3342,8 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
     int4store(buff_p + 4, net->max_packet_size);
     buff[8]= (char) mysql->charset->number;
     memset(buff+9, 0, 32-9);
+    if (compress_ctx)
+      buff[9]= (char) mysql_compression_flag(compress_ctx->algorithm);
     end= buff+32;
   }
   else
@@ -3505,6 +3515,10 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
 
   end= (char *) send_client_connect_attrs(mysql, (uchar *) end);
 
+  /* The level the client compresses with, for algorithms other than zlib */
+  if (compress_ctx && compress_ctx->algorithm != MYSQL_ZLIB)
+    *end++= (char) mysql_compression_default_level(compress_ctx->algorithm);
+
   /* Write authentication package */
   MYSQL_TRACE(SEND_AUTH_RESPONSE, mysql, (end-buff, (const unsigned char*)buff));
   if (my_net_write(net, (uchar*) buff, (size_t) (end-buff)) || net_flush(net))
@@ -3939,6 +3953,7 @@ CLI_MYSQL_REAL_CONNECT(MYSQL *mysql,const char *host, const char *user,
 {
   char		buff[NAME_LEN+USERNAME_LENGTH+100];
   int           scramble_data_len, pkt_scramble_len= 0;
+  uint          server_compression_flags= 0;
   char          *end,*host_info= 0, *server_version_end, *pkt_end;
   char          *scramble_data;
   const char    *scramble_plugin;
@@ -4434,6 +4449,7 @@ CLI_MYSQL_REAL_CONNECT(MYSQL *mysql,const char *host, const char *user,
     mysql->server_status=uint2korr((uchar*) end + 3);
     mysql->server_capabilities|= uint2korr((uchar*) end + 5) << 16;
     pkt_scramble_len= end[7];
+    server_compression_flags= (uchar) end[8];
     if (pkt_scramble_len < 0)
     {
       set_mysql_error(mysql, CR_MALFORMED_PACKET,
@@ -4504,6 +4520,38 @@ CLI_MYSQL_REAL_CONNECT(MYSQL *mysql,const char *host, const char *user,
 
   mysql->client_flag= client_flag;
 
+#ifdef HAVE_COMPRESS
+  /*
+    Compress with the best algorithm both sides support: zstd, which
+    compresses better than zlib at less CPU cost, then LZ4, then zlib.
+    It is picked here, where the compression flags of the server are
+    known, and the connection is compressed with it once authenticated.
+  */
+  if ((client_flag | mysql->options.client_flag) & CLIENT_COMPRESS)
+  {
+    static const enum enum_compression_algorithm preferred[]=
+      { MYSQL_ZSTD, MYSQL_LZ4, MYSQL_ZLIB };
+    uint i;
+
+    for (i= 0; i < array_elements(preferred); i++)
+    {
+      ulong capability= mysql_compression_capability(preferred[i]);
+      uint flag= mysql_compression_flag(preferred[i]);
+      if ((mysql->server_capabilities & capability) &&
+          (server_compression_flags & flag) == flag &&
+          mysql_compression_algorithm_supported(preferred[i]))
+      {
+        if (net_set_compression(net, preferred[i], 0))
+        {
+          set_mysql_error(mysql, CR_OUT_OF_MEMORY, unknown_sqlstate);
+          goto error;
+        }
+        break;
+      }
+    }
+  }
+#endif
+
   MYSQL_TRACE(INIT_PACKET_RECEIVED, mysql, (pkt_length, net->read_pos));
   MYSQL_TRACE_STAGE(mysql, AUTHENTICATE);
 
@@ -4521,7 +4569,7 @@ CLI_MYSQL_REAL_CONNECT(MYSQL *mysql,const char *host, const char *user,
     Part 3: authenticated, finish the initialization of the connection
   */
 
-  if (mysql->client_flag & CLIENT_COMPRESS)      /* We will use compression */
+  if (mysql->client_flag & CLIENT_ANY_COMPRESSION) /* We will use compression */
     net->compress=1;
 
 #ifdef CHECK_LICENSE 
@@ -25,6 +25,7 @@
 #include "sql_db.h"                     /* mysql_change_db */
 #include "connection_handler_manager.h"
 #include <mysql/plugin_validate_password.h> /* validate_password plugin */
+#include <my_compress.h>                /* CLIENT_ANY_COMPRESSION */
 #include "sys_vars.h"
 #include <fstream>                      /* std::fstream */
 #include <string>                       /* std::string */
@@ -537,6 +538,44 @@ static void login_failed_error(MPVIO_EXT *mpvio, int passwd_used)
 }
 
 
+/**
+  Whether the server offers a compression algorithm: it must be in
+  @@protocol_compression_algorithms, and the server built with it.
+*/
+static bool server_offers_compression(enum_compression_algorithm algorithm)
+{
+#ifdef HAVE_COMPRESS
+  return (protocol_compression_algorithms & (1ULL << algorithm)) &&
+         mysql_compression_algorithm_supported(algorithm);
+#else
+  return false;
+#endif
+}
+
+
+/**
+  The compression capabilities the server offers.
+
+  @param[out] compression_flags  the compression flags it offers
+*/
+static ulong server_compression_capabilities(uint *compression_flags)
+{
+  ulong capabilities= 0;
+  *compression_flags= 0;
+  for (uint i= 0; i < MYSQL_COMPRESSION_ALGORITHMS; i++)
+  {
+    const enum_compression_algorithm algorithm=
+      static_cast<enum_compression_algorithm>(i);
+    if (server_offers_compression(algorithm))
+    {
+      capabilities|= mysql_compression_capability(algorithm);
+      *compression_flags|= mysql_compression_flag(algorithm);
+    }
+  }
+  return capabilities;
+}
+
+
 /**
   sends a server handshake initialization packet, the very first packet
   after the connection was established
@@ -555,7 +594,8 @@ static void login_failed_error(MPVIO_EXT *mpvio, int passwd_used)
     2           server status
     2           server capabilities (two upper bytes)
     1           length of the scramble
-    10          reserved, always 0
+    1           compression flags, see my_compress.h
+    9           reserved, always 0
     n           rest of the plugin provided data (at least 12 bytes)
     1           \0 byte, terminating the second part of a scramble
 
@@ -580,7 +620,9 @@ static bool send_server_handshake_packet(MPVIO_EXT *mpvio,
   if (opt_using_transactions)
     mpvio->client_capabilities|= CLIENT_TRANSACTIONS;
 
-  mpvio->client_capabilities|= CAN_CLIENT_COMPRESS;
+  uint compression_flags;
+  mpvio->client_capabilities|=
+    server_compression_capabilities(&compression_flags);
 
   if (ssl_acceptor_fd)
   {
@@ -647,6 +689,7 @@ static bool send_server_handshake_packet(MPVIO_EXT *mpvio,
   end[7]= data_len;
   DBUG_EXECUTE_IF("poison_srv_handshake_scramble_len", end[7]= -100;);
   memset(end + 8, 0, 10);
+  end[8]= (char) compression_flags;
   end+= 18;
   /* write scramble tail */
   end= (char*) memcpy(end, data + AUTH_PLUGIN_DATA_PART_1_LENGTH,
@@ -1385,6 +1428,7 @@ static size_t parse_client_handshake_packet(MPVIO_EXT *mpvio,
   DBUG_ASSERT(mpvio->status == MPVIO_EXT::FAILURE);
 
   uint charset_code= 0;
+  uint compression_flags= 0;
   end= (char *)net->read_pos;
   /*
     In order to safely scan a head for '\0' string terminators
@@ -1435,8 +1479,9 @@ static size_t parse_client_handshake_packet(MPVIO_EXT *mpvio,
     mpvio->client_capabilities= uint4korr(end);
     mpvio->max_client_packet_length= uint4korr(end + 4);
     charset_code= (uint)(uchar)*(end + 8);
+    compression_flags= (uint)(uchar)*(end + 9);
     /*
-      Skip 23 remaining filler bytes which have no particular meaning.
+      Skip 22 remaining filler bytes which have no particular meaning.
     */
     end+= AUTH_PACKET_HEADER_SIZE_PROTO_41;
     bytes_remaining_in_packet-= AUTH_PACKET_HEADER_SIZE_PROTO_41;
@@ -1526,6 +1571,22 @@ skip_to_ssl:
   }
 #endif /* HAVE_OPENSSL */
 
+  /*
+    The client must ask for one of the compression algorithms the server
+    offered, as it starts to compress with it after authentication.
+  */
+  const ulong compression= mpvio->client_capabilities & CLIENT_ANY_COMPRESSION;
+  if (compression || compression_flags)
+  {
+    const enum_compression_algorithm algorithm=
+      mysql_compression_algorithm(compression, compression_flags);
+    if (compression != mysql_compression_capability(algorithm) ||
+        compression_flags != mysql_compression_flag(algorithm) ||
+        !server_offers_compression(algorithm) ||
+        net_set_compression(net, algorithm, protocol_compression_level))
+      return packet_error;
+  }
+
   if ((mpvio->client_capabilities & CLIENT_TRANSACTIONS) &&
       opt_using_transactions)
     net->return_status= mpvio->server_status;
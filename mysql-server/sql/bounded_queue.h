@@ -120,6 +120,33 @@ public:
     return reinterpret_cast<Key_type*>(queue_remove(&m_queue, 0));
   }
 
+  /**
+    Checks whether an element would be among the top-N elements.
+    If the queue is full, push() replaces the top element, which is the
+    element to discard next. An element whose key does not sort before
+    the key of that top element would thus be discarded right away.
+
+    @param  key  Pointer to the key of the element.
+    @retval true if the queue is full and the element would be discarded.
+   */
+  bool would_discard(Key_type *key)
+  {
+    DBUG_ASSERT(is_initialized());
+    if (!queue_is_full((&m_queue)))
+      return false;
+    return (m_queue.compare(m_queue.first_cmp_arg,
+                            reinterpret_cast<uchar*>(key),
+                            queue_top(&m_queue)) * m_queue.max_at_top) <= 0;
+  }
+
+  /**
+    Removes all elements from the queue, so that it can be refilled.
+   */
+  void clear()
+  {
+    m_queue.elements= 0;
+  }
+
   /**
     The number of elements in the queue.
    */
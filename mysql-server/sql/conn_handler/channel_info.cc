@@ -37,6 +37,7 @@ THD* Channel_info::create_thd()
   }
 
   my_net_init(&thd->net, vio_tmp);
+  thd->accept_utime= accept_utime;
 
   return thd;
 }
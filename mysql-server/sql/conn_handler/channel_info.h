@@ -36,6 +36,7 @@ typedef struct st_vio Vio;
 class Channel_info
 {
   ulonglong prior_thr_create_utime;
+  ulonglong accept_utime;
 
 protected:
   /**
@@ -46,7 +47,8 @@ protected:
   virtual Vio* create_and_init_vio() const = 0;
 
   Channel_info()
-  : prior_thr_create_utime(0)
+  : prior_thr_create_utime(0),
+    accept_utime(my_micro_time())
   { }
 
 public:
@@ -80,6 +82,10 @@ public:
 
   void set_prior_thr_create_utime()
   { prior_thr_create_utime= my_micro_time(); }
+
+  /// When the connection was accepted
+  ulonglong get_accept_utime() const
+  { return accept_utime; }
 };
 
 #endif // SQL_CHANNEL_INFO_INCLUDED.
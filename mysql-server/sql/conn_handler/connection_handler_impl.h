@@ -105,4 +105,64 @@ protected:
   virtual uint get_max_threads() const { return 1; }
 };
 
+
+#if defined(__linux__)
+/// The pool-of-threads connection handler needs epoll
+#define HAVE_POOL_OF_THREADS 1
+#endif
+
+/**
+  This class represents the connection handling functionality of
+  connections being multiplexed over a pool of threads.
+
+  The pool is divided into thread groups, and each connection belongs to
+  one group. Between statements, a connection is not bound to any
+  thread: a listener thread of the group waits with epoll for data from
+  the clients of the group and queues the connections that have sent a
+  command. Worker threads of the group dequeue the connections and run
+  the commands. The number of workers of a group that run statements at
+  the same time is limited, but workers that wait for locks, I/O or
+  sleeps (see thd_wait_begin()) are not counted, and a timer thread
+  starts another worker if the queued connections of a group have not
+  been served for a while (a stall). Connections in a transaction are
+  served before other connections for a limited number of commands, so
+  that they release their locks sooner. The timer thread also closes
+  connections that have been idle for longer than wait_timeout.
+
+  Only available if HAVE_POOL_OF_THREADS is defined.
+*/
+class Pool_of_threads_connection_handler : public Connection_handler
+{
+  Pool_of_threads_connection_handler(
+    const Pool_of_threads_connection_handler&);
+  Pool_of_threads_connection_handler&
+    operator=(const Pool_of_threads_connection_handler&);
+
+public:
+  // System variables
+  static ulong pool_size;
+  static ulong oversubscribe;
+  static ulong stall_limit;
+  static ulong max_pool_threads;
+  static ulong high_prio_tickets;
+  // Status variables
+  static ulong threads;                  // Protected by LOCK_thread_pool.
+  static ulong stalls;
+
+  Pool_of_threads_connection_handler() {}
+  virtual ~Pool_of_threads_connection_handler();
+
+  /**
+    Create the thread groups.
+
+    @return true if initialization failed, false otherwise.
+  */
+  bool init();
+
+protected:
+  virtual bool add_connection(Channel_info* channel_info);
+
+  virtual uint get_max_threads() const;
+};
+
 #endif // CONNECTION_HANDLER_IMPL_INCLUDED
@@ -21,6 +21,8 @@
 #include "mysqld_error.h"              // ER_*
 #include "channel_info.h"              // Channel_info
 #include "connection_handler_impl.h"   // Per_thread_connection_handler
+#include "log.h"                       // sql_print_warning
+#include "my_atomic.h"                 // my_atomic_add64
 #include "mysqld.h"                    // max_connections
 #include "plugin_connection_handler.h" // Plugin_connection_handler
 #include "sql_callback.h"              // MYSQL_CALLBACK
@@ -39,6 +41,7 @@ Connection_handler_manager* Connection_handler_manager::m_instance= NULL;
 ulong Connection_handler_manager::thread_handling=
   SCHEDULER_ONE_THREAD_PER_CONNECTION;
 uint Connection_handler_manager::max_threads= 0;
+int64 volatile Connection_handler_manager::connect_latency[CONNECT_LATENCY_BUCKETS];
 
 
 /**
@@ -143,6 +146,27 @@ bool Connection_handler_manager::init()
   case SCHEDULER_NO_THREADS:
     connection_handler= new (std::nothrow) One_thread_connection_handler();
     break;
+  case SCHEDULER_POOL_OF_THREADS:
+#ifdef HAVE_POOL_OF_THREADS
+    {
+      Pool_of_threads_connection_handler *pool=
+        new (std::nothrow) Pool_of_threads_connection_handler();
+      if (pool != NULL && pool->init())
+      {
+        delete pool;
+        pool= NULL;
+      }
+      connection_handler= pool;
+    }
+#else
+    sql_print_warning("The pool-of-threads thread handling is not "
+                      "supported on this platform, using "
+                      "one-thread-per-connection instead.");
+    Connection_handler_manager::thread_handling=
+      SCHEDULER_ONE_THREAD_PER_CONNECTION;
+    connection_handler= new (std::nothrow) Per_thread_connection_handler();
+#endif
+    break;
   default:
     DBUG_ASSERT(false);
   }
@@ -250,6 +274,19 @@ Connection_handler_manager::process_new_connection(Channel_info* channel_info)
 }
 
 
+void Connection_handler_manager::add_connect_latency(ulonglong usecs)
+{
+  static const ulonglong bucket_limits[CONNECT_LATENCY_BUCKETS - 1]=
+    { 100, 1000, 10000, 100000, 1000000 };
+
+  uint bucket= 0;
+  while (bucket < CONNECT_LATENCY_BUCKETS - 1 &&
+         usecs >= bucket_limits[bucket])
+    bucket++;
+  my_atomic_add64(&connect_latency[bucket], 1);
+}
+
+
 THD* create_thd(Channel_info* channel_info)
 {
   THD* thd= channel_info->create_thd();
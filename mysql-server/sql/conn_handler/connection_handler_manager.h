@@ -109,6 +109,7 @@ public:
   {
     SCHEDULER_ONE_THREAD_PER_CONNECTION=0,
     SCHEDULER_NO_THREADS,
+    SCHEDULER_POOL_OF_THREADS,
     SCHEDULER_TYPES_COUNT
   };
 
@@ -131,6 +132,22 @@ public:
   */
   static uint max_threads;
 
+  /**
+    Histogram of the connect latency, the time from the accept of a
+    connection to the end of its authentication: the number of
+    connections that took less than 100us, 1ms, 10ms, 100ms, 1s and
+    the number that took longer.
+  */
+  static const uint CONNECT_LATENCY_BUCKETS= 6;
+  static int64 volatile connect_latency[CONNECT_LATENCY_BUCKETS];
+
+  /**
+    Account for a connection in the connect latency histogram.
+
+    @param usecs  the time from accept to the end of authentication
+  */
+  static void add_connect_latency(ulonglong usecs);
+
   /**
     Singleton method to return an instance of this class.
   */
@@ -0,0 +1,1146 @@
+/*
+   Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+#include "connection_handler_impl.h"
+
+#include "mysql/thread_pool_priv.h"      // thd_get_fd
+#include "channel_info.h"                // Channel_info
+#include "connection_handler_manager.h"  // Connection_handler_manager
+#include "mysqld.h"                      // connection_attrib
+#include "mysqld_error.h"                // ER_*
+#include "mysqld_thd_manager.h"          // Global_THD_manager
+#include "sql_audit.h"                   // mysql_audit_release
+#include "sql_class.h"                   // THD
+#include "sql_connect.h"                 // close_connection
+#include "sql_parse.h"                   // do_command
+#include "sql_plist.h"                   // I_P_List
+#include "log.h"                         // Error_log_throttle
+
+
+// Initialize static members
+ulong Pool_of_threads_connection_handler::pool_size= 16;
+ulong Pool_of_threads_connection_handler::oversubscribe= 3;
+ulong Pool_of_threads_connection_handler::stall_limit= 500;
+ulong Pool_of_threads_connection_handler::max_pool_threads= 100000;
+ulong Pool_of_threads_connection_handler::high_prio_tickets= UINT_MAX32;
+ulong Pool_of_threads_connection_handler::threads= 0;
+ulong Pool_of_threads_connection_handler::stalls= 0;
+
+#ifdef HAVE_POOL_OF_THREADS
+
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <algorithm>
+
+/// Seconds after which a worker without work ends, if it is not the last
+static const uint THREAD_IDLE_TIMEOUT= 60;
+
+/// Maximum number of events that the listener gets from epoll at a time
+static const int MAX_EVENTS= 64;
+
+// Error log throttle for the thread creation failure in the thread pool.
+static
+Error_log_throttle create_thread_err_log_throttle(Log_throttle
+                                                  ::LOG_THROTTLE_WINDOW_SIZE,
+                                                  sql_print_error,
+                                                  "Error log throttle: %10lu"
+                                                  " 'Can't create thread in"
+                                                  " the thread pool'"
+                                                  " error(s) suppressed");
+
+struct Thread_group;
+
+/**
+  A connection handled by the thread pool.
+*/
+struct Pool_connection
+{
+  Pool_connection(Channel_info *channel_info_arg, Thread_group *group_arg)
+  : channel_info(channel_info_arg), thd(NULL), group(group_arg), fd(-1),
+    in_poll(false), timed_out(false), waiting(false), high_prio(false),
+    tickets(0), idle_deadline(0), next_in_queue(NULL), prev_in_queue(NULL),
+    next_in_group(NULL), prev_in_group(NULL)
+  { }
+
+  /// The new connection, until a worker has created its THD
+  Channel_info *channel_info;
+  THD *thd;
+  Thread_group *group;
+  /**
+    Duplicate of the socket descriptor, registered with epoll. Closing
+    the socket of the Vio (on KILL or shutdown) does not remove the
+    socket from epoll as long as this descriptor is open, so the closing
+    is seen by the listener.
+  */
+  int fd;
+  /// Whether the listener waits for a command. Protected by the group mutex.
+  bool in_poll;
+  /**
+    Set by the listener, which no longer polls the connection, when it has
+    been idle for wait_timeout
+  */
+  bool timed_out;
+  /// Whether the connection is between thd_wait_begin() and thd_wait_end()
+  bool waiting;
+  /// Whether the next command is queued with priority
+  bool high_prio;
+  /// Number of commands left that may be queued with priority
+  ulong tickets;
+  /// my_micro_time() at which the connection has been idle for wait_timeout
+  ulonglong idle_deadline;
+
+  // Links in the queue and in the connection list of the group
+  Pool_connection *next_in_queue;
+  Pool_connection **prev_in_queue;
+  Pool_connection *next_in_group;
+  Pool_connection **prev_in_group;
+};
+
+
+typedef I_P_List<Pool_connection,
+                 I_P_List_adapter<Pool_connection,
+                                  &Pool_connection::next_in_queue,
+                                  &Pool_connection::prev_in_queue>,
+                 I_P_List_null_counter,
+                 I_P_List_fast_push_back<Pool_connection> >
+        Pool_connection_queue;
+
+typedef I_P_List<Pool_connection,
+                 I_P_List_adapter<Pool_connection,
+                                  &Pool_connection::next_in_group,
+                                  &Pool_connection::prev_in_group> >
+        Pool_connection_list;
+
+
+/**
+  A thread group: a listener thread and the worker threads that run the
+  commands of the connections of the group. All members are protected
+  by the mutex of the group.
+*/
+struct Thread_group
+{
+  Thread_group()
+  : pollfd(-1), thread_count(0), active_thread_count(0),
+    waiting_thread_count(0), pending_wakeups(0), event_count(0),
+    last_event_count(0), next_idle_deadline(ULLONG_MAX),
+    listener_started(false), stalled(false), shutdown(false)
+  {
+    wakeup_pipe[0]= wakeup_pipe[1]= -1;
+  }
+
+  mysql_mutex_t mutex;
+  /// Workers without work wait on this
+  mysql_cond_t cond;
+  int pollfd;
+  /**
+    Writing into this pipe wakes up the listener, at shutdown and when
+    connections have been idle for wait_timeout
+  */
+  int wakeup_pipe[2];
+
+  /// Connections in a transaction that have sent a command
+  Pool_connection_queue high_prio_queue;
+  /// Other connections that have sent a command, and new connections
+  Pool_connection_queue queue;
+  /// Logged in connections
+  Pool_connection_list connections;
+
+  /// Number of workers
+  uint thread_count;
+  /// Number of workers running a command, and not in thd_wait_begin()
+  uint active_thread_count;
+  /// Number of workers waiting on cond
+  uint waiting_thread_count;
+  /// Number of workers woken up or created that have not checked the queues
+  uint pending_wakeups;
+  /// Number of dequeued events, and the number at the last stall check
+  ulonglong event_count;
+  ulonglong last_event_count;
+  /**
+    Lower bound of idle_deadline of the connections in poll, ULLONG_MAX
+    while the listener has yet to check them
+  */
+  ulonglong next_idle_deadline;
+  bool listener_started;
+  /// Set by the timer: one more worker may dequeue an event
+  bool stalled;
+  bool shutdown;
+};
+
+
+static Thread_group *thread_groups= NULL;
+static uint thread_group_count= 0;
+
+/**
+  Protects the thread count, the starting of the timer and the selection
+  of the group of a new connection. If both this and a group mutex are
+  taken, the group mutex is taken first.
+*/
+static mysql_mutex_t LOCK_thread_pool;
+/// The timer waits on this between checks
+static mysql_cond_t COND_thread_pool_timer;
+/// Signalled when a thread of the pool ends
+static mysql_cond_t COND_thread_pool_exit;
+static bool timer_started= false;
+static bool pool_shutdown= false;
+static uint next_thread_group= 0;
+
+// Passed around as arguments even without the performance schema
+static PSI_thread_key key_thread_pool_worker;
+static PSI_thread_key key_thread_pool_listener;
+static PSI_thread_key key_thread_pool_timer;
+
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_LOCK_thread_pool;
+static PSI_mutex_key key_LOCK_thread_group;
+
+static PSI_mutex_info all_pool_mutexes[]=
+{
+  { &key_LOCK_thread_pool, "LOCK_thread_pool", PSI_FLAG_GLOBAL},
+  { &key_LOCK_thread_group, "Thread_group::mutex", 0}
+};
+
+static PSI_cond_key key_COND_thread_pool_timer;
+static PSI_cond_key key_COND_thread_pool_exit;
+static PSI_cond_key key_COND_thread_group;
+
+static PSI_cond_info all_pool_conds[]=
+{
+  { &key_COND_thread_pool_timer, "COND_thread_pool_timer", PSI_FLAG_GLOBAL},
+  { &key_COND_thread_pool_exit, "COND_thread_pool_exit", PSI_FLAG_GLOBAL},
+  { &key_COND_thread_group, "Thread_group::cond", 0}
+};
+
+static PSI_thread_info all_pool_threads[]=
+{
+  { &key_thread_pool_worker, "thread_pool_worker", 0},
+  { &key_thread_pool_listener, "thread_pool_listener", 0},
+  { &key_thread_pool_timer, "thread_pool_timer", PSI_FLAG_GLOBAL}
+};
+#endif
+
+
+/**
+  Maximum number of workers of a group that may run commands at the
+  same time.
+*/
+static inline uint active_thread_limit()
+{
+  return 1 + Pool_of_threads_connection_handler::oversubscribe;
+}
+
+
+static inline bool queues_empty(const Thread_group *group)
+{
+  return group->high_prio_queue.is_empty() && group->queue.is_empty();
+}
+
+
+/**
+  Account for the end of a thread of the pool. Must be the last use of
+  pool data by the thread.
+*/
+
+static void thread_exited()
+{
+  mysql_mutex_lock(&LOCK_thread_pool);
+  Pool_of_threads_connection_handler::threads--;
+  mysql_cond_broadcast(&COND_thread_pool_exit);
+  mysql_mutex_unlock(&LOCK_thread_pool);
+}
+
+
+/**
+  Create a thread of the pool.
+
+  @retval false  the thread was created
+  @retval true   max_pool_threads is reached, or thread creation failed
+*/
+
+static bool create_pool_thread(PSI_thread_key key, void *(*func)(void*),
+                               Thread_group *group)
+{
+  int error= 0;
+  pthread_t id;
+
+  mysql_mutex_lock(&LOCK_thread_pool);
+  if (pool_shutdown ||
+      Pool_of_threads_connection_handler::threads >=
+      Pool_of_threads_connection_handler::max_pool_threads)
+    error= EAGAIN;
+  else if (!(error= mysql_thread_create(key, &id, &connection_attrib, func,
+                                        group)))
+    Pool_of_threads_connection_handler::threads++;
+  mysql_mutex_unlock(&LOCK_thread_pool);
+
+  if (error)
+  {
+    if (!create_thread_err_log_throttle.log())
+      sql_print_error("Can't create thread in the thread pool (errno= %d)",
+                      error);
+    return true;
+  }
+  Global_THD_manager::get_instance()->inc_thread_created();
+  return false;
+}
+
+
+extern "C" void *worker_main(void *arg);
+
+/**
+  Wake up a worker of the group without work, or create a new one.
+
+  @retval true if there was no worker to wake up and none could be created
+*/
+
+static bool wake_or_create_worker(Thread_group *group)
+{
+  mysql_mutex_assert_owner(&group->mutex);
+  if (group->waiting_thread_count > group->pending_wakeups)
+  {
+    group->pending_wakeups++;
+    mysql_cond_signal(&group->cond);
+    return false;
+  }
+  if (create_pool_thread(key_thread_pool_worker, worker_main, group))
+    return true;
+  group->thread_count++;
+  group->pending_wakeups++;
+  return false;
+}
+
+
+/**
+  Wake up or create a worker if the queued events of the group may be
+  handled by one more worker.
+*/
+
+static void wake_worker_if_needed(Thread_group *group)
+{
+  mysql_mutex_assert_owner(&group->mutex);
+  if (!queues_empty(group) &&
+      group->active_thread_count + group->pending_wakeups <
+      active_thread_limit())
+    wake_or_create_worker(group);
+}
+
+
+/**
+  Wait until the group has an event that this worker may handle.
+
+  @return the connection of the event, or NULL if the worker should end
+*/
+
+static Pool_connection *get_event(Thread_group *group)
+{
+  mysql_mutex_assert_owner(&group->mutex);
+  for (;;)
+  {
+    if (group->shutdown)
+      return NULL;
+
+    if (group->active_thread_count < active_thread_limit() || group->stalled)
+    {
+      Pool_connection *conn= group->high_prio_queue.pop_front();
+      if (conn == NULL)
+        conn= group->queue.pop_front();
+      if (conn != NULL)
+      {
+        group->stalled= false;
+        group->event_count++;
+        group->active_thread_count++;
+        return conn;
+      }
+    }
+
+    struct timespec abstime;
+    set_timespec(&abstime, THREAD_IDLE_TIMEOUT);
+    group->waiting_thread_count++;
+    int error= mysql_cond_timedwait(&group->cond, &group->mutex, &abstime);
+    group->waiting_thread_count--;
+    if (error == ETIMEDOUT || error == ETIME)
+    {
+      // Keep one worker, so that a new event is handled without delay
+      if (group->thread_count > 1 && queues_empty(group))
+        return NULL;
+    }
+    else if (group->pending_wakeups > 0)
+      group->pending_wakeups--;
+  }
+}
+
+
+/**
+  Bind the THD of a connection to the current worker.
+
+  @retval true on failure
+*/
+
+static bool attach_thd(THD *thd, char *stack_start)
+{
+  thd->thread_stack= stack_start;
+  if (thd->store_globals())
+    return true;
+  /*
+    THD::mysys_var::abort is associated with physical thread rather
+    than with THD object. So we need to reset this flag before using
+    this thread for handling of the THD.
+  */
+  thd->mysys_var->abort= 0;
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_THREAD_CALL(set_thread)(thd_get_psi(thd));
+#endif
+  mysql_socket_set_thread_owner(thd->net.vio->mysql_socket);
+  return false;
+}
+
+
+/**
+  Unbind the THD of a connection from the current worker, so that a
+  KILL does not interrupt whatever the worker does next.
+*/
+
+static void detach_thd(THD *thd)
+{
+  thd->restore_globals();
+  thd->set_mysys_var(NULL);
+}
+
+
+/**
+  End a connection, whose THD is bound to the current worker.
+
+  @param conn       the connection, deleted by this function
+  @param logged_in  whether thd_prepare_connection() succeeded
+*/
+
+static void end_pool_connection(Pool_connection *conn, bool logged_in)
+{
+  THD *thd= conn->thd;
+  Thread_group *group= conn->group;
+
+  if (logged_in)
+    end_connection(thd);
+  close_connection(thd);
+  Connection_handler_manager::dec_connection_count();
+
+  thd->get_stmt_da()->reset_diagnostics_area();
+  thd->release_resources();
+
+  // Clean up errors now, before the worker handles another connection.
+  ERR_remove_state(0);
+
+  Global_THD_manager::get_instance()->remove_thd(thd);
+
+  if (conn->fd >= 0)
+  {
+    mysql_mutex_lock(&group->mutex);
+    group->connections.remove(conn);
+    mysql_mutex_unlock(&group->mutex);
+    close(conn->fd);
+  }
+  delete thd;
+
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  /*
+    Delete the instrumentation for the job that just completed.
+  */
+  PSI_THREAD_CALL(delete_current_thread)();
+#endif
+  delete conn;
+}
+
+
+/**
+  Wait for the next command of a connection, whose THD is bound to the
+  current worker. The THD is unbound.
+*/
+
+static void wait_for_command(Pool_connection *conn)
+{
+  THD *thd= conn->thd;
+  Thread_group *group= conn->group;
+
+  /*
+    A connection in a transaction holds locks that other connections may
+    wait for, so its next command is handled with priority, unless it has
+    used up its tickets.
+  */
+  bool high_prio= false;
+  if (thd->in_active_multi_stmt_transaction() || thd->locked_tables_mode)
+  {
+    if (conn->tickets > 0)
+    {
+      conn->tickets--;
+      high_prio= true;
+    }
+  }
+  else
+    conn->tickets= Pool_of_threads_connection_handler::high_prio_tickets;
+
+  const ulonglong idle_deadline= my_micro_time() +
+    thd->variables.net_wait_timeout * 1000000ULL;
+
+  detach_thd(thd);
+
+  mysql_mutex_lock(&group->mutex);
+  conn->high_prio= high_prio;
+  conn->idle_deadline= idle_deadline;
+  conn->in_poll= true;
+  group->next_idle_deadline= std::min(group->next_idle_deadline,
+                                      idle_deadline);
+  mysql_mutex_unlock(&group->mutex);
+
+  // The event may be handled by another worker as soon as it is armed
+  struct epoll_event ev;
+  ev.events= EPOLLIN | EPOLLONESHOT;
+  ev.data.ptr= conn;
+  if (epoll_ctl(group->pollfd, EPOLL_CTL_MOD, conn->fd, &ev))
+  {
+    sql_print_error("Thread pool: epoll_ctl() failed (errno= %d)", errno);
+    mysql_mutex_lock(&group->mutex);
+    conn->in_poll= false;
+    mysql_mutex_unlock(&group->mutex);
+    char *stack_start= reinterpret_cast<char*>(&thd);
+    attach_thd(thd, stack_start);
+    end_pool_connection(conn, true);
+  }
+}
+
+
+/**
+  Create the THD of a new connection, log it in, and register it with
+  the listener of its group.
+*/
+
+static void start_connection(Pool_connection *conn, char *stack_start)
+{
+  Connection_handler_manager *handler_manager=
+    Connection_handler_manager::get_instance();
+  Channel_info *channel_info= conn->channel_info;
+  conn->channel_info= NULL;
+
+  THD *thd= channel_info->create_thd();
+  if (thd == NULL)
+  {
+    connection_errors_internal++;
+    channel_info->send_error_and_close_channel(ER_OUT_OF_RESOURCES, 0, false);
+    delete channel_info;
+    handler_manager->inc_aborted_connects();
+    Connection_handler_manager::dec_connection_count();
+    delete conn;
+    return;
+  }
+  delete channel_info;
+
+  thd->set_new_thread_id();
+  thd->start_utime= thd->thr_create_utime= my_micro_time();
+  thd_set_scheduler_data(thd, conn);
+  conn->thd= thd;
+  conn->tickets= Pool_of_threads_connection_handler::high_prio_tickets;
+
+  thd->thread_stack= stack_start;
+  if (thd->store_globals())
+  {
+    connection_errors_internal++;
+    close_connection(thd, ER_OUT_OF_RESOURCES);
+    thd->release_resources();
+    delete thd;
+    handler_manager->inc_aborted_connects();
+    Connection_handler_manager::dec_connection_count();
+    delete conn;
+    return;
+  }
+  thd->mysys_var->abort= 0;
+
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_thread *psi= PSI_THREAD_CALL(new_thread)
+    (key_thread_one_connection, thd, thd->thread_id());
+  thd_set_psi(thd, psi);
+  PSI_THREAD_CALL(set_thread)(psi);
+#endif
+  mysql_thread_set_psi_id(thd->thread_id());
+  mysql_thread_set_psi_THD(thd);
+  mysql_socket_set_thread_owner(thd->net.vio->mysql_socket);
+
+  Global_THD_manager::get_instance()->add_thd(thd);
+
+  if (thd_prepare_connection(thd))
+  {
+    handler_manager->inc_aborted_connects();
+    end_pool_connection(conn, false);
+    return;
+  }
+
+  Thread_group *group= conn->group;
+  /*
+    Register the socket disarmed: with only EPOLLONESHOT in the mask not
+    even a hangup is reported until wait_for_command() arms it.
+  */
+  struct epoll_event ev;
+  ev.events= EPOLLONESHOT;
+  ev.data.ptr= conn;
+  conn->fd= dup(thd_get_fd(thd));
+  if (conn->fd < 0 || epoll_ctl(group->pollfd, EPOLL_CTL_ADD, conn->fd, &ev))
+  {
+    sql_print_error("Thread pool: can't register connection %lu "
+                    "(errno= %d)", thd->thread_id(), errno);
+    if (conn->fd >= 0)
+      close(conn->fd);
+    conn->fd= -1;
+    end_pool_connection(conn, true);
+    return;
+  }
+
+  mysql_mutex_lock(&group->mutex);
+  group->connections.push_front(conn);
+  mysql_mutex_unlock(&group->mutex);
+
+  wait_for_command(conn);
+}
+
+
+/**
+  Run the commands that a connection has sent.
+*/
+
+static void handle_event(Pool_connection *conn, char *stack_start)
+{
+  if (conn->thd == NULL)
+  {
+    start_connection(conn, stack_start);
+    return;
+  }
+
+  THD *thd= conn->thd;
+  if (attach_thd(thd, stack_start))
+  {
+    end_pool_connection(conn, true);
+    return;
+  }
+
+  if (conn->timed_out)
+  {
+    /*
+      The connection has been idle for wait_timeout. End it like when the
+      read of the next command times out in one-thread-per-connection, but
+      tell the client why, and without counting it as aborted.
+    */
+    net_new_transaction(&thd->net);
+    my_error(ER_NET_READ_INTERRUPTED, MYF(0));
+    thd->protocol->end_statement();
+    end_pool_connection(conn, true);
+    return;
+  }
+
+  for (;;)
+  {
+    if (!thd_is_connection_alive(thd))
+    {
+      end_pool_connection(conn, true);
+      return;
+    }
+    mysql_audit_release(thd);
+    if (do_command(thd))
+    {
+      end_pool_connection(conn, true);
+      return;
+    }
+    // Commands that are already read from the socket are not seen by epoll
+    if (!thd_connection_has_data(thd) && !thd->net.remain_in_buf)
+      break;
+  }
+  wait_for_command(conn);
+}
+
+
+extern "C" void *worker_main(void *arg)
+{
+  Thread_group *group= static_cast<Thread_group*>(arg);
+
+  if (my_thread_init())
+  {
+    mysql_mutex_lock(&group->mutex);
+    group->thread_count--;
+    if (group->pending_wakeups > 0)
+      group->pending_wakeups--;
+    mysql_mutex_unlock(&group->mutex);
+    thread_exited();
+    pthread_exit(0);
+    return NULL;
+  }
+
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_thread *worker_psi= PSI_THREAD_CALL(get_thread)();
+#endif
+
+  mysql_mutex_lock(&group->mutex);
+  if (group->pending_wakeups > 0)
+    group->pending_wakeups--;
+  Pool_connection *conn;
+  while ((conn= get_event(group)) != NULL)
+  {
+    mysql_mutex_unlock(&group->mutex);
+    handle_event(conn, reinterpret_cast<char*>(&conn));
+#ifdef HAVE_PSI_THREAD_INTERFACE
+    PSI_THREAD_CALL(set_thread)(worker_psi);
+#endif
+    mysql_mutex_lock(&group->mutex);
+    group->active_thread_count--;
+  }
+  group->thread_count--;
+  mysql_mutex_unlock(&group->mutex);
+
+  thread_exited();
+  my_thread_end();
+  pthread_exit(0);
+  return NULL;
+}
+
+
+/**
+  Queue the connections that have been idle for longer than wait_timeout,
+  for a worker to end them. Called by the listener after it has queued
+  the events it got from epoll, so that no event is pending for a
+  connection that is still in poll.
+
+  @return the number of connections queued
+*/
+
+static int queue_idle_connections(Thread_group *group, ulonglong now)
+{
+  mysql_mutex_assert_owner(&group->mutex);
+  int queued= 0;
+  ulonglong next_idle_deadline= ULLONG_MAX;
+  I_P_List_iterator<Pool_connection, Pool_connection_list>
+    it(group->connections);
+  Pool_connection *conn;
+  while ((conn= it++))
+  {
+    if (!conn->in_poll)
+      continue;
+    if (conn->idle_deadline > now)
+    {
+      next_idle_deadline= std::min(next_idle_deadline, conn->idle_deadline);
+      continue;
+    }
+    // No event is reported for the connection after this
+    if (epoll_ctl(group->pollfd, EPOLL_CTL_DEL, conn->fd, NULL))
+    {
+      sql_print_error("Thread pool: epoll_ctl() failed (errno= %d)", errno);
+      continue;
+    }
+    conn->in_poll= false;
+    conn->timed_out= true;
+    group->queue.push_back(conn);
+    queued++;
+  }
+  group->next_idle_deadline= next_idle_deadline;
+  return queued;
+}
+
+
+extern "C" void *listener_main(void *arg)
+{
+  Thread_group *group= static_cast<Thread_group*>(arg);
+  struct epoll_event events[MAX_EVENTS];
+
+  if (my_thread_init())
+  {
+    thread_exited();
+    pthread_exit(0);
+    return NULL;
+  }
+
+  for (;;)
+  {
+    int count= epoll_wait(group->pollfd, events, MAX_EVENTS, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      sql_print_error("Thread pool: epoll_wait() failed (errno= %d)", errno);
+      break;
+    }
+
+    mysql_mutex_lock(&group->mutex);
+    if (group->shutdown)
+    {
+      mysql_mutex_unlock(&group->mutex);
+      break;
+    }
+    int queued= 0;
+    bool check_idle= false;
+    for (int i= 0; i < count; i++)
+    {
+      Pool_connection *conn=
+        static_cast<Pool_connection*>(events[i].data.ptr);
+      if (conn == NULL)                         // The wakeup pipe
+      {
+        char buff[16];
+        while (read(group->wakeup_pipe[0], buff, sizeof(buff)) > 0)
+        { }
+        check_idle= true;
+        continue;
+      }
+      conn->in_poll= false;
+      if (conn->high_prio)
+        group->high_prio_queue.push_back(conn);
+      else
+        group->queue.push_back(conn);
+      queued++;
+    }
+    if (check_idle)
+      queued+= queue_idle_connections(group, my_micro_time());
+    for (int i= 0; i < queued && !queues_empty(group); i++)
+    {
+      if (group->thread_count > 0 &&
+          group->active_thread_count + group->pending_wakeups >=
+          active_thread_limit())
+        break;
+      if (wake_or_create_worker(group))
+        break;
+    }
+    mysql_mutex_unlock(&group->mutex);
+  }
+
+  thread_exited();
+  my_thread_end();
+  pthread_exit(0);
+  return NULL;
+}
+
+
+/**
+  Check a thread group for a stall, and wake up its listener if
+  connections may have been idle for longer than wait_timeout.
+*/
+
+static void check_thread_group(Thread_group *group, ulonglong now)
+{
+  mysql_mutex_lock(&group->mutex);
+
+  /*
+    If events are queued but none has been dequeued since the last check,
+    all active workers run long commands or wait for something that is
+    not reported by thd_wait_begin(). Let one more worker run.
+  */
+  if (!queues_empty(group) && group->event_count == group->last_event_count)
+  {
+    group->stalled= true;
+    Pool_of_threads_connection_handler::stalls++;
+    wake_or_create_worker(group);
+  }
+  group->last_event_count= group->event_count;
+
+  /*
+    Only the listener may take a connection out of poll without a race
+    with its events; it sets next_idle_deadline again.
+  */
+  if (now >= group->next_idle_deadline &&
+      write(group->wakeup_pipe[1], "", 1) == 1)
+    group->next_idle_deadline= ULLONG_MAX;
+
+  mysql_mutex_unlock(&group->mutex);
+}
+
+
+extern "C" void *timer_main(void *arg)
+{
+  if (my_thread_init())
+  {
+    thread_exited();
+    pthread_exit(0);
+    return NULL;
+  }
+
+  mysql_mutex_lock(&LOCK_thread_pool);
+  while (!pool_shutdown)
+  {
+    struct timespec abstime;
+    set_timespec_nsec(&abstime,
+                      Pool_of_threads_connection_handler::stall_limit *
+                      1000000ULL);
+    mysql_cond_timedwait(&COND_thread_pool_timer, &LOCK_thread_pool,
+                         &abstime);
+    if (pool_shutdown)
+      break;
+    mysql_mutex_unlock(&LOCK_thread_pool);
+
+    const ulonglong now= my_micro_time();
+    for (uint i= 0; i < thread_group_count; i++)
+      check_thread_group(&thread_groups[i], now);
+
+    mysql_mutex_lock(&LOCK_thread_pool);
+  }
+  mysql_mutex_unlock(&LOCK_thread_pool);
+
+  thread_exited();
+  my_thread_end();
+  pthread_exit(0);
+  return NULL;
+}
+
+
+/*
+  Workers that wait are not counted as active, so that another worker
+  may run a command meanwhile.
+*/
+
+static void pool_thd_wait_begin(THD *thd, int wait_type)
+{
+  if (thd == NULL)
+    return;
+  Pool_connection *conn=
+    static_cast<Pool_connection*>(thd_get_scheduler_data(thd));
+  if (conn == NULL || conn->waiting)
+    return;
+
+  Thread_group *group= conn->group;
+  conn->waiting= true;
+  mysql_mutex_lock(&group->mutex);
+  group->active_thread_count--;
+  wake_worker_if_needed(group);
+  mysql_mutex_unlock(&group->mutex);
+}
+
+
+static void pool_thd_wait_end(THD *thd)
+{
+  if (thd == NULL)
+    return;
+  Pool_connection *conn=
+    static_cast<Pool_connection*>(thd_get_scheduler_data(thd));
+  if (conn == NULL || !conn->waiting)
+    return;
+
+  Thread_group *group= conn->group;
+  conn->waiting= false;
+  mysql_mutex_lock(&group->mutex);
+  group->active_thread_count++;
+  mysql_mutex_unlock(&group->mutex);
+}
+
+
+/*
+  No post-kill notification is needed: THD::awake() closes the socket of
+  a connection killed by another one, and the listener of an idle
+  connection sees that.
+*/
+static THD_event_functions pool_event_functions=
+{
+  pool_thd_wait_begin,
+  pool_thd_wait_end,
+  NULL
+};
+
+
+bool Pool_of_threads_connection_handler::init()
+{
+#ifdef HAVE_PSI_INTERFACE
+  int count= array_elements(all_pool_mutexes);
+  mysql_mutex_register("sql", all_pool_mutexes, count);
+
+  count= array_elements(all_pool_conds);
+  mysql_cond_register("sql", all_pool_conds, count);
+
+  count= array_elements(all_pool_threads);
+  mysql_thread_register("sql", all_pool_threads, count);
+#endif
+
+  mysql_mutex_init(key_LOCK_thread_pool, &LOCK_thread_pool,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_thread_pool_timer, &COND_thread_pool_timer);
+  mysql_cond_init(key_COND_thread_pool_exit, &COND_thread_pool_exit);
+  pool_shutdown= false;
+  timer_started= false;
+  next_thread_group= 0;
+
+  thread_groups= new (std::nothrow) Thread_group[pool_size];
+  if (thread_groups == NULL)
+    return true;
+
+  thread_group_count= 0;
+  while (thread_group_count < pool_size)
+  {
+    Thread_group *group= &thread_groups[thread_group_count];
+    mysql_mutex_init(key_LOCK_thread_group, &group->mutex,
+                     MY_MUTEX_INIT_FAST);
+    mysql_cond_init(key_COND_thread_group, &group->cond);
+    /*
+      The destructor destroys the mutex and cond of the groups counted,
+      and closes the descriptors of those that are open.
+    */
+    thread_group_count++;
+
+    struct epoll_event ev;
+    ev.events= EPOLLIN;
+    ev.data.ptr= NULL;
+    if ((group->pollfd= epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+        pipe2(group->wakeup_pipe, O_CLOEXEC | O_NONBLOCK) ||
+        epoll_ctl(group->pollfd, EPOLL_CTL_ADD, group->wakeup_pipe[0], &ev))
+    {
+      sql_print_error("Thread pool: can't create thread group "
+                      "(errno= %d)", errno);
+      return true;
+    }
+  }
+
+  Connection_handler_manager::event_functions= &pool_event_functions;
+  return false;
+}
+
+
+Pool_of_threads_connection_handler::~Pool_of_threads_connection_handler()
+{
+  if (Connection_handler_manager::event_functions == &pool_event_functions)
+    Connection_handler_manager::event_functions= NULL;
+
+  mysql_mutex_lock(&LOCK_thread_pool);
+  pool_shutdown= true;
+  mysql_cond_signal(&COND_thread_pool_timer);
+  mysql_mutex_unlock(&LOCK_thread_pool);
+
+  for (uint i= 0; i < thread_group_count; i++)
+  {
+    Thread_group *group= &thread_groups[i];
+    mysql_mutex_lock(&group->mutex);
+    group->shutdown= true;
+    mysql_cond_broadcast(&group->cond);
+    if (group->wakeup_pipe[1] >= 0 &&
+        write(group->wakeup_pipe[1], "", 1) != 1)
+      sql_print_warning("Thread pool: can't wake up listener (errno= %d)",
+                        errno);
+    mysql_mutex_unlock(&group->mutex);
+  }
+
+  mysql_mutex_lock(&LOCK_thread_pool);
+  while (threads > 0)
+    mysql_cond_wait(&COND_thread_pool_exit, &LOCK_thread_pool);
+  mysql_mutex_unlock(&LOCK_thread_pool);
+
+  for (uint i= 0; i < thread_group_count; i++)
+  {
+    Thread_group *group= &thread_groups[i];
+
+    // Connections that no worker has started
+    Pool_connection *conn;
+    while ((conn= group->queue.pop_front()) != NULL)
+    {
+      DBUG_ASSERT(conn->thd == NULL);
+      conn->channel_info->send_error_and_close_channel(ER_SERVER_SHUTDOWN,
+                                                       0, false);
+      delete conn->channel_info;
+      Connection_handler_manager::dec_connection_count();
+      delete conn;
+    }
+    DBUG_ASSERT(group->high_prio_queue.is_empty());
+    DBUG_ASSERT(group->connections.is_empty());
+
+    if (group->pollfd >= 0)
+      close(group->pollfd);
+    if (group->wakeup_pipe[0] >= 0)
+    {
+      close(group->wakeup_pipe[0]);
+      close(group->wakeup_pipe[1]);
+    }
+    mysql_mutex_destroy(&group->mutex);
+    mysql_cond_destroy(&group->cond);
+  }
+  delete [] thread_groups;
+  thread_groups= NULL;
+  thread_group_count= 0;
+
+  mysql_mutex_destroy(&LOCK_thread_pool);
+  mysql_cond_destroy(&COND_thread_pool_timer);
+  mysql_cond_destroy(&COND_thread_pool_exit);
+}
+
+
+bool
+Pool_of_threads_connection_handler::add_connection(Channel_info* channel_info)
+{
+  DBUG_ENTER("Pool_of_threads_connection_handler::add_connection");
+
+  bool error= false;
+  mysql_mutex_lock(&LOCK_thread_pool);
+  Thread_group *group= &thread_groups[next_thread_group];
+  next_thread_group= (next_thread_group + 1) % thread_group_count;
+  bool start_timer= !timer_started;
+  timer_started= true;
+  mysql_mutex_unlock(&LOCK_thread_pool);
+
+  if (start_timer &&
+      create_pool_thread(key_thread_pool_timer, timer_main, NULL))
+  {
+    mysql_mutex_lock(&LOCK_thread_pool);
+    timer_started= false;
+    mysql_mutex_unlock(&LOCK_thread_pool);
+    error= true;
+  }
+
+  Pool_connection *conn= NULL;
+  if (!error &&
+      (conn= new (std::nothrow) Pool_connection(channel_info, group)) == NULL)
+    error= true;
+
+  if (!error)
+  {
+    mysql_mutex_lock(&group->mutex);
+    if (!group->listener_started &&
+        !create_pool_thread(key_thread_pool_listener, listener_main, group))
+      group->listener_started= true;
+
+    if (!group->listener_started)
+      error= true;
+    else
+    {
+      group->queue.push_back(conn);
+      if (group->thread_count == 0 ||
+          group->active_thread_count + group->pending_wakeups <
+          active_thread_limit())
+      {
+        if (wake_or_create_worker(group) && group->thread_count == 0)
+        {
+          group->queue.remove(conn);
+          error= true;
+        }
+      }
+    }
+    mysql_mutex_unlock(&group->mutex);
+  }
+
+  if (error)
+  {
+    delete conn;
+    connection_errors_internal++;
+    channel_info->send_error_and_close_channel(ER_CANT_CREATE_THREAD,
+                                               EAGAIN, true);
+    Connection_handler_manager::dec_connection_count();
+    DBUG_RETURN(true);
+  }
+  DBUG_RETURN(false);
+}
+
+
+uint Pool_of_threads_connection_handler::get_max_threads() const
+{
+  return max_pool_threads;
+}
+
+#endif // HAVE_POOL_OF_THREADS
@@ -254,6 +254,7 @@ class TCP_socket
   uint m_tcp_port; // TCP port to bind to
   uint m_backlog;  // Backlog length for queue of pending connections.
   uint m_port_timeout; // Port timeout
+  bool m_reuse_port; // Set SO_REUSEPORT before bind
 
   MYSQL_SOCKET create_socket(const struct addrinfo *addrinfo_list,
                              int addr_family,
@@ -308,15 +309,19 @@ public:
     @param  bind_addr_str  ip address as string value.
     @param  back_log backlog specifying length of pending connection queue.
     @param  m_port_timeout port timeout value
+    @param  reuse_port  set SO_REUSEPORT on the socket, to let other
+                        sockets bind to the same address and port.
   */
   TCP_socket(std::string bind_addr_str,
              uint tcp_port,
              uint backlog,
-             uint port_timeout)
+             uint port_timeout,
+             bool reuse_port)
   : m_bind_addr_str(bind_addr_str),
     m_tcp_port(tcp_port),
     m_backlog(backlog),
-    m_port_timeout(port_timeout)
+    m_port_timeout(port_timeout),
+    m_reuse_port(reuse_port)
   { }
 
   /**
@@ -455,6 +460,27 @@ public:
                                      (char*)&option_flag,sizeof(option_flag));
     }
 #endif
+#ifdef SO_REUSEPORT
+    /*
+      With several acceptor threads, each one has a listener socket of its
+      own bound to the same port, and the kernel spreads the incoming
+      connections over them.
+    */
+    if (m_reuse_port)
+    {
+      int option_flag= 1;
+
+      if (mysql_socket_setsockopt(listener_socket, SOL_SOCKET, SO_REUSEPORT,
+                                  (char *) &option_flag, sizeof (option_flag)))
+      {
+        sql_print_error("Failed to set SO_REUSEPORT on the TCP/IP socket "
+                        "(error: %d).", (int) socket_errno);
+        freeaddrinfo(ai);
+        mysql_socket_close(listener_socket);
+        return MYSQL_INVALID_SOCKET;
+      }
+    }
+#endif
 #ifdef IPV6_V6ONLY
      /*
        For interoperability with older clients, IPv6 socket should
@@ -766,12 +792,14 @@ Mysqld_socket_listener::Mysqld_socket_listener(std::string bind_addr_str,
                                                uint tcp_port,
                                                uint backlog,
                                                uint port_timeout,
-                                               std::string unix_sockname)
+                                               std::string unix_sockname,
+                                               bool reuse_port)
   : m_bind_addr_str(bind_addr_str),
     m_tcp_port(tcp_port),
     m_backlog(backlog),
     m_port_timeout(port_timeout),
     m_unix_sockname(unix_sockname),
+    m_reuse_port(reuse_port),
     m_unlink_sockname(false),
     m_error_count(0)
 {
@@ -790,7 +818,7 @@ bool Mysqld_socket_listener::setup_listener()
   if (m_tcp_port)
   {
     TCP_socket tcp_socket(m_bind_addr_str, m_tcp_port,
-                          m_backlog, m_port_timeout);
+                          m_backlog, m_port_timeout, m_reuse_port);
 
     MYSQL_SOCKET mysql_socket= tcp_socket.get_listener_socket();
     if (mysql_socket.fd == INVALID_SOCKET)
@@ -77,6 +77,7 @@ class Mysqld_socket_listener
   uint m_backlog; // backlog specifying length of pending connection queue
   uint m_port_timeout; // port timeout value
   std::string m_unix_sockname; // unix socket pathname to bind to
+  bool m_reuse_port; // Bind the TCP socket with SO_REUSEPORT if true.
   bool m_unlink_sockname; // Unlink socket & lock file if true.
   /*
     Map indexed by MYSQL socket fds and correspoding bool to distinguish
@@ -145,10 +146,12 @@ public:
                             connection queue used in listen.
     @param   port_timeout   portname.
     @param   unix_sockname  pathname for unix socket to bind to
+    @param   reuse_port     bind the TCP socket with SO_REUSEPORT, so that
+                            several listeners can share the TCP port.
   */
   Mysqld_socket_listener(std::string bind_addr_str, uint tcp_port,
                          uint backlog, uint port_timeout,
-                         std::string unix_sockname);
+                         std::string unix_sockname, bool reuse_port);
 
   /**
     Set up a listener - set of sockets to listen for connection events
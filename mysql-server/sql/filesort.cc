@@ -596,6 +596,75 @@ uint Filesort::make_sortorder()
 }
 
 
+Top_n_filter *Top_n_filter::create(THD *thd, TABLE *table, Filesort *filesort)
+{
+  DBUG_ENTER("Top_n_filter::create");
+  DBUG_ASSERT(filesort->limit != HA_POS_ERROR);
+
+  const uint s_length= filesort->make_sortorder();
+  if (s_length == 0)
+    DBUG_RETURN(NULL);                          /* purecov: inspected */
+
+  /*
+    Keys are made from the record about to be written, so every part of
+    the key must be a column of the table.
+  */
+  for (uint i= 0; i < s_length; i++)
+  {
+    const Field *field= filesort->sortorder[i].field;
+    if (field == NULL || field->table != table)
+      DBUG_RETURN(NULL);
+  }
+
+  bool multi_byte_charset;
+  const uint sort_len= sortlength(thd, filesort->sortorder, s_length,
+                                  &multi_byte_charset);
+  const ha_rows max_rows= filesort->limit;
+
+  // Like a priority queue in filesort(), the keys must fit in the sort buffer
+  if (max_rows >=
+      thd->variables.sortbuff_size / (sort_len + sizeof(uchar *)))
+    DBUG_RETURN(NULL);
+
+  // The queue needs one extra key, and we need a buffer for the current key
+  const uint num_keys= static_cast<uint>(max_rows) + 1;
+  SORT_FIELD *sortorder=
+    static_cast<SORT_FIELD *>(thd->alloc(sizeof(SORT_FIELD) * s_length));
+  uchar **keys=
+    static_cast<uchar **>(thd->alloc(sizeof(uchar *) * num_keys));
+  uchar *key_buffer=
+    static_cast<uchar *>(thd->alloc(sort_len * (num_keys + 1)));
+  Top_n_filter *filter= new (thd->mem_root) Top_n_filter;
+  if (sortorder == NULL || keys == NULL || key_buffer == NULL ||
+      filter == NULL)
+    DBUG_RETURN(NULL);                          /* purecov: inspected */
+
+  // Use a copy, filesort() makes its sort order again when it runs
+  memcpy(sortorder, filesort->sortorder, sizeof(SORT_FIELD) * s_length);
+  for (uint i= 0; i < num_keys; i++)
+    keys[i]= key_buffer + i * sort_len;
+  filter->m_key= key_buffer + num_keys * sort_len;
+
+  Sort_param *const param= &filter->m_param;
+  param->sort_length= sort_len;
+  param->rec_length= sort_len;
+  param->max_rows= max_rows;
+  param->sort_form= table;
+  param->local_sortorder=
+    Bounds_checked_array<SORT_FIELD>(sortorder, s_length);
+
+  if (filter->m_queue.init(max_rows,
+                           true,                // max_at_top
+                           NULL,                // compare_function
+                           filter, keys))
+  {
+    delete filter;
+    DBUG_RETURN(NULL);
+  }
+  DBUG_RETURN(filter);
+}
+
+
 void Filesort_info::read_chunk_descriptors(IO_CACHE *chunk_file, uint count)
 {
   DBUG_ENTER("Filesort_info::read_chunk_descriptors");
@@ -19,6 +19,8 @@
 #include "my_global.h"                          /* uint, uchar */
 #include "my_base.h"                            /* ha_rows */
 #include "sql_list.h"                           /* Sql_alloc */
+#include "sql_sort.h"                           /* Sort_param */
+#include "bounded_queue.h"                      /* Bounded_queue */
 class THD;
 struct TABLE;
 typedef struct st_sort_field SORT_FIELD;
@@ -67,6 +69,74 @@ private:
   void cleanup();
 };
 
+
+/**
+  Filter for the rows written to a temporary table which is sorted with
+  a LIMIT afterwards, e.g. for
+
+    SELECT ... FROM t1 JOIN t2 ON ... ORDER BY t1.a, t2.b LIMIT 10
+
+  The filter keeps the sort keys of the first LIMIT rows written so far
+  in a Bounded_queue, like filesort() does when it uses a priority queue.
+  A row which does not sort before all of them cannot be in the result
+  and need not be written, so the temporary table gets a small part of
+  the join result rather than all of it.
+*/
+class Top_n_filter : public Sql_alloc
+{
+public:
+  /**
+    Set up a filter for the rows written to a temporary table.
+
+    @param thd       Thread handle
+    @param table     The temporary table
+    @param filesort  The sorting of the table, with a LIMIT
+
+    @returns The filter, or NULL if the sort order is not on columns of
+             the table, if the keys would not fit into the sort buffer,
+             or on error
+  */
+  static Top_n_filter *create(THD *thd, TABLE *table, Filesort *filesort);
+
+  /// Forget the rows written by a previous execution
+  void reset() { m_queue.clear(); }
+
+  /**
+    Check the row in table->record[0], and remember its key if the row
+    may be in the result.
+
+    @retval true   The row sorts after LIMIT rows already seen; skip it
+    @retval false  The row must be written
+  */
+  bool skip_row()
+  {
+    m_param.make_sortkey(m_key, m_key);
+    if (m_queue.would_discard(&m_key))
+      return true;
+    m_queue.push(m_key);
+    return false;
+  }
+
+  /// For Bounded_queue: the key of an element is the key made by skip_row()
+  uint make_sortkey(uchar *to, const uchar *key)
+  {
+    memcpy(to, key, m_param.sort_length);
+    return m_param.sort_length;
+  }
+
+  /// For Bounded_queue: the number of bytes to compare
+  size_t compare_length() const { return m_param.sort_length; }
+
+private:
+  Top_n_filter() : m_key(NULL) {}
+
+  /// Describes how keys are made from the record of the table
+  Sort_param m_param;
+  /// Buffer for the key of the current row
+  uchar *m_key;
+  Bounded_queue<uchar *, uchar *, Top_n_filter> m_queue;
+};
+
 ha_rows filesort(THD *thd, QEP_TAB *qep_tab, Filesort *fsort, bool sort_positions,
                  ha_rows *examined_rows, ha_rows *found_rows);
 void filesort_free_buffers(TABLE *table, bool full);
@@ -43,8 +43,11 @@
 #include "debug_sync.h"         // DEBUG_SYNC
 #include "sql_trigger.h"        // TRG_EXT, TRN_EXT
 #include "opt_costmodel.h"
+#include "opt_costcalibration.h"             // cost_calibration_start
 #include "opt_costconstantcache.h"           // reload_optimizer_cost_constants
+#include "range_estimate_cache.h"              // cached_records_in_range
 #include <my_bit.h>
+#include <algorithm>
 #include <list>
 
 #ifdef WITH_PARTITION_STORAGE_ENGINE
@@ -2678,8 +2681,11 @@ int handler::ha_rnd_pos(uchar *buf, uchar *pos)
   /* TODO: Find out how to solve ha_rnd_pos when finding duplicate update. */
   /* DBUG_ASSERT(inited == RND); */
 
+  const ulonglong start= cost_calibration_start();
   MYSQL_TABLE_IO_WAIT(PSI_TABLE_FETCH_ROW, MAX_KEY,
     { result= rnd_pos(buf, pos); })
+  if (start)
+    cost_calibration_add_block_read(ht, table_share, start);
   DBUG_RETURN(result);
 }
 
@@ -2720,8 +2726,11 @@ int handler::ha_index_read_map(uchar *buf, const uchar *key,
   DBUG_ASSERT(inited == INDEX);
   DBUG_ASSERT(!pushed_idx_cond || buf == table->record[0]);
 
+  const ulonglong start= cost_calibration_start();
   MYSQL_TABLE_IO_WAIT(PSI_TABLE_FETCH_ROW, active_index,
     { result= index_read_map(buf, key, keypart_map, find_flag); })
+  if (start)
+    cost_calibration_add_block_read(ht, table_share, start);
   DBUG_RETURN(result);
 }
 
@@ -2757,8 +2766,11 @@ int handler::ha_index_read_idx_map(uchar *buf, uint index, const uchar *key,
   DBUG_ASSERT(end_range == NULL);
   DBUG_ASSERT(!pushed_idx_cond || buf == table->record[0]);
 
+  const ulonglong start= cost_calibration_start();
   MYSQL_TABLE_IO_WAIT(PSI_TABLE_FETCH_ROW, index,
     { result= index_read_idx_map(buf, index, key, keypart_map, find_flag); })
+  if (start)
+    cost_calibration_add_block_read(ht, table_share, start);
   return result;
 }
 
@@ -5811,8 +5823,9 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
     {
       DBUG_EXECUTE_IF("crash_records_in_range", DBUG_SUICIDE(););
       DBUG_ASSERT(min_endp || max_endp);
-      if (HA_POS_ERROR == (rows= this->records_in_range(keyno, min_endp, 
-                                                        max_endp)))
+      if (HA_POS_ERROR == (rows= cached_records_in_range(this, table, keyno,
+                                                         min_endp,
+                                                         max_endp)))
       {
         /* Can't scan one range => can't do MRR scan at all */
         total_rows= HA_POS_ERROR;
@@ -5879,6 +5892,7 @@ ha_rows handler::multi_range_read_info(uint keyno, uint n_ranges, uint n_rows,
                                        uint *bufsz, uint *flags, 
                                        Cost_estimate *cost)
 {
+  const uint available_bufsz= *bufsz;
   *bufsz= 0; /* Default implementation doesn't need a buffer */
 
   *flags|= HA_MRR_USE_DEFAULT_IMPL;
@@ -5891,10 +5905,126 @@ ha_rows handler::multi_range_read_info(uint keyno, uint n_ranges, uint n_rows,
     *cost= index_scan_cost(keyno, n_ranges, n_rows);
   else
     *cost= read_cost(keyno, n_ranges, n_rows);
+
+  /*
+    Reading the ranges in key order is an option only if the user does
+    not need ordered output, and needs a buffer for at least two ranges.
+  */
+  const uint entry_size= mrr_sort_keys_entry_size(&table->key_info[keyno]);
+  Cost_estimate sort_keys_cost;
+  if (!(*flags & HA_MRR_SORTED) && n_ranges > 1 &&
+      available_bufsz >= 2 * entry_size &&
+      !sort_keys_mrr_cost(keyno, n_ranges, n_rows, *flags,
+                          &sort_keys_cost) &&
+      sort_keys_cost.total_cost() < cost->total_cost())
+  {
+    DBUG_PRINT("info", ("Sorted key lookups chosen"));
+    *flags|= HA_MRR_SORT_KEYS;
+    *flags&= ~HA_MRR_SUPPORT_SORTED;
+    *bufsz= min(available_bufsz, n_ranges * entry_size);
+    *cost= sort_keys_cost;
+  }
   return 0;
 }
 
 
+/**
+  Longest key of a range on an index. With index extensions, the key
+  parts of the primary key appended to a secondary key are not counted
+  in KEY::key_length, but can be part of the keys of ranges.
+
+  @param key_info  The index that is read
+
+  @return Number of bytes
+*/
+
+static uint mrr_max_key_length(const KEY *key_info)
+{
+  uint length= 0;
+  for (uint i= 0; i < key_info->actual_key_parts; i++)
+    length+= key_info->key_part[i].store_length;
+  return max(length, key_info->key_length);
+}
+
+
+/**
+  Space used in the MRR buffer for each range when the default MRR
+  implementation reads ranges in batches sorted by key: a pointer in
+  the sort array, a copy of the range and its start and end keys.
+
+  @param key_info  The index that is read
+
+  @return Number of bytes
+*/
+
+uint handler::mrr_sort_keys_entry_size(const KEY *key_info)
+{
+  return sizeof(KEY_MULTI_RANGE*) + ALIGN_SIZE(sizeof(KEY_MULTI_RANGE)) +
+         2 * ALIGN_SIZE(mrr_max_key_length(key_info));
+}
+
+
+/**
+  Get the cost of reading ranges in batches sorted by key
+
+  When the keys are looked up in key order, lookups of keys that are
+  close to each other find the index (and, for a clustered index, data)
+  blocks they need already read by the previous lookup. With N keys
+  uniformly spread over an index of B blocks, the expected number of
+  distinct blocks read is B * (1 - (1 - 1/B)^N) instead of N.
+
+  This only saves I/O if the index does not fit in the memory buffer
+  of the engine; as for DS-MRR, if the engine does not report the size
+  of its buffer, the index must be larger than 100MB.
+
+  @param keyno     Index number
+  @param n_ranges  Estimated number of ranges (keys) to look up
+  @param n_rows    Estimated total number of rows in the ranges
+  @param flags     HA_MRR_* flags given by the MRR user
+  @param cost[out] Cost of the sorted lookups
+
+  @retval false  OK, *cost is set
+  @retval true   Sorted lookups would not save any I/O
+*/
+
+bool handler::sort_keys_mrr_cost(uint keyno, uint n_ranges, uint n_rows,
+                                 uint flags, Cost_estimate *cost)
+{
+  THD *thd= current_thd;
+  if (!thd->optimizer_switch_flag(OPTIMIZER_SWITCH_MRR) ||
+      table->s->tmp_table != NO_TMP_TABLE)
+    return true;
+
+  const bool clustered= keyno == table_share->primary_key &&
+                        primary_key_is_clustered();
+  const ulonglong index_size= clustered ? stats.data_file_length :
+                                          stats.index_file_length;
+  longlong min_index_size= get_memory_buffer_size();
+  if (min_index_size == -1)
+    min_index_size= 100 * 1024 * 1024;          // 100 MB
+  DBUG_EXECUTE_IF("mrr_sort_keys_any_index_size", min_index_size= 0;);
+  if (index_size < static_cast<ulonglong>(min_index_size))
+    return true;
+
+  const double index_blocks=
+    max(1.0, static_cast<double>(index_size) / IO_SIZE);
+  const double blocks_read=
+    index_blocks * (1.0 - pow(1.0 - 1.0 / index_blocks, (double) n_ranges));
+
+  DBUG_ASSERT(cost->is_zero());
+  if (flags & HA_MRR_INDEX_ONLY)
+    *cost= index_scan_cost(keyno, blocks_read, n_rows);
+  else
+    *cost= read_cost(keyno, blocks_read, n_rows);
+
+  /* Cost of sorting the keys */
+  const Cost_model_table *const cost_model= table->cost_model();
+  cost->add_cpu(cost_model->key_compare_cost(n_ranges *
+                                             log((double) n_ranges) / M_LN2));
+  return false;
+}
+
+
 /**
   Initialize the MRR scan
 
@@ -5945,10 +6075,231 @@ handler::multi_range_read_init(RANGE_SEQ_IF *seq_funcs, void *seq_init_param,
   mrr_funcs= *seq_funcs;
   mrr_is_output_sorted= MY_TEST(mode & HA_MRR_SORTED);
   mrr_have_range= FALSE;
+  mrr_sort_keys= false;
+
+  if ((mode & HA_MRR_SORT_KEYS) && !mrr_is_output_sorted && buf &&
+      active_index != MAX_KEY)
+  {
+    /*
+      Lay out the buffer as an array of pointers to the ranges of a
+      batch, followed by the range copies with their key images.
+    */
+    const uint entry_size=
+      mrr_sort_keys_entry_size(&table->key_info[active_index]);
+    uchar *start= buf->buffer +
+      (ALIGN_SIZE((size_t) buf->buffer) - (size_t) buf->buffer);
+    const size_t space= buf->buffer_end > start ?
+                        static_cast<size_t>(buf->buffer_end - start) : 0;
+    mrr_batch_max= static_cast<uint>(space / entry_size);
+    if (mrr_batch_max >= 2)
+    {
+      mrr_batch= reinterpret_cast<KEY_MULTI_RANGE**>(start);
+      mrr_batch_entries= start +
+        ALIGN_SIZE(mrr_batch_max * sizeof(KEY_MULTI_RANGE*));
+      /* The alignment above may have cost one entry */
+      if (mrr_batch_entries + mrr_batch_max *
+          (entry_size - sizeof(KEY_MULTI_RANGE*)) > buf->buffer_end)
+        mrr_batch_max--;
+      mrr_batch_count= mrr_batch_pos= 0;
+      mrr_seq_eof= false;
+      mrr_batch_found= false;
+      mrr_no_association= MY_TEST(mode & HA_MRR_NO_ASSOCIATION);
+      mrr_sort_keys= true;
+    }
+  }
   DBUG_RETURN(0);
 }
 
 
+/**
+  Functor ordering ranges by their start key, for the batches of
+  the default MRR implementation.
+*/
+
+class Mrr_range_key_less
+{
+public:
+  explicit Mrr_range_key_less(KEY_PART_INFO *key_part)
+    : m_key_part(key_part)
+  {}
+
+  bool operator()(const KEY_MULTI_RANGE *a, const KEY_MULTI_RANGE *b) const
+  {
+    const uint length= min(a->start_key.length, b->start_key.length);
+    if (length > 0)
+    {
+      const int cmp= key_cmp2(m_key_part, a->start_key.key, length,
+                              b->start_key.key, length);
+      if (cmp != 0)
+        return cmp < 0;
+    }
+    return a->start_key.length < b->start_key.length;
+  }
+
+private:
+  KEY_PART_INFO *m_key_part;
+};
+
+
+/**
+  Read the next batch of ranges from the range sequence into the MRR
+  buffer and sort it by key.
+
+  @retval true   The batch contains at least one range
+  @retval false  The range sequence is exhausted
+*/
+
+bool handler::mrr_fill_sorted_batch()
+{
+  KEY *key_info= &table->key_info[active_index];
+  const size_t key_space= ALIGN_SIZE(mrr_max_key_length(key_info));
+  const size_t entry_size= mrr_sort_keys_entry_size(key_info) -
+                           sizeof(KEY_MULTI_RANGE*);
+  uchar *entry= mrr_batch_entries;
+  KEY_MULTI_RANGE range;
+
+  mrr_batch_count= mrr_batch_pos= 0;
+  mrr_batch_found= false;
+  while (mrr_batch_count < mrr_batch_max)
+  {
+    if (mrr_funcs.next(mrr_iter, &range))
+    {
+      mrr_seq_eof= true;
+      break;
+    }
+    KEY_MULTI_RANGE *copy= reinterpret_cast<KEY_MULTI_RANGE*>(entry);
+    uchar *start_key= entry + ALIGN_SIZE(sizeof(KEY_MULTI_RANGE));
+    uchar *end_key= start_key + key_space;
+    *copy= range;
+    DBUG_ASSERT(range.start_key.length <= key_space &&
+                range.end_key.length <= key_space);
+    if (range.start_key.length)
+    {
+      memcpy(start_key, range.start_key.key, range.start_key.length);
+      copy->start_key.key= start_key;
+    }
+    if (range.end_key.length)
+    {
+      if (range.end_key.key == range.start_key.key)
+        copy->end_key.key= start_key;
+      else
+      {
+        memcpy(end_key, range.end_key.key, range.end_key.length);
+        copy->end_key.key= end_key;
+      }
+    }
+    mrr_batch[mrr_batch_count++]= copy;
+    entry+= entry_size;
+  }
+  if (mrr_batch_count == 0)
+    return false;
+
+  std::sort(mrr_batch, mrr_batch + mrr_batch_count,
+            Mrr_range_key_less(key_info->key_part));
+  return true;
+}
+
+
+/*
+  TRUE <=> both ranges are lookups of the same value of a unique key, so
+  the second one matches exactly the rows the first one matched.
+*/
+
+static bool same_unique_point(const KEY_MULTI_RANGE *a,
+                              const KEY_MULTI_RANGE *b)
+{
+  return a->range_flag == (UNIQUE_RANGE | EQ_RANGE) &&
+         b->range_flag == (UNIQUE_RANGE | EQ_RANGE) &&
+         a->start_key.length == b->start_key.length &&
+         a->start_key.keypart_map == b->start_key.keypart_map &&
+         !memcmp(a->start_key.key, b->start_key.key, a->start_key.length);
+}
+
+
+/**
+  Get next record in MRR scan, reading ranges in batches sorted by key
+
+  Duplicate lookups of a unique key are not repeated: a key that was not
+  found is skipped, and a row that was found is returned again for the
+  next range (or skipped if there is no range association). As the batch
+  is sorted, the duplicates of a key follow each other within it; a key
+  that is looked up in several batches is read once per batch. This is
+  not done with a pushed index condition, which may depend on the range.
+
+  @param range_info  OUT  Undefined if HA_MRR_NO_ASSOCIATION flag is in effect
+                          Otherwise, the opaque value associated with the range
+                          that contains the returned record.
+
+  @retval 0      OK
+  @retval other  Error code
+*/
+
+int handler::mrr_sorted_keys_next(char **range_info)
+{
+  int result= HA_ERR_END_OF_FILE;
+  DBUG_ENTER("handler::mrr_sorted_keys_next");
+
+  for (;;)
+  {
+    if (mrr_have_range)
+    {
+      /* Save a call if there can be only one row in range. */
+      if (mrr_cur_range.range_flag != (UNIQUE_RANGE | EQ_RANGE))
+      {
+        result= read_range_next();
+        if (result != HA_ERR_END_OF_FILE)
+          break;
+      }
+      else if (was_semi_consistent_read())
+      {
+        result= read_range_first(&mrr_cur_range.start_key,
+                                 &mrr_cur_range.end_key, true, false);
+        if (result != HA_ERR_END_OF_FILE)
+          break;
+      }
+    }
+
+    if (mrr_batch_pos == mrr_batch_count &&
+        (mrr_seq_eof || !mrr_fill_sorted_batch()))
+    {
+      result= HA_ERR_END_OF_FILE;
+      break;
+    }
+
+    KEY_MULTI_RANGE *range= mrr_batch[mrr_batch_pos];
+    if (mrr_batch_pos > 0 && pushed_idx_cond == NULL &&
+        same_unique_point(mrr_batch[mrr_batch_pos - 1], range))
+    {
+      mrr_batch_pos++;
+      if (!mrr_batch_found || mrr_no_association)
+        continue;
+      /* The row is still in the record buffer */
+      mrr_cur_range= *range;
+      mrr_have_range= true;
+      result= 0;
+      break;
+    }
+    mrr_batch_pos++;
+
+    mrr_cur_range= *range;
+    mrr_have_range= true;
+    result= read_range_first(mrr_cur_range.start_key.keypart_map ?
+                               &mrr_cur_range.start_key : 0,
+                             mrr_cur_range.end_key.keypart_map ?
+                               &mrr_cur_range.end_key : 0,
+                             MY_TEST(mrr_cur_range.range_flag & EQ_RANGE),
+                             false);
+    mrr_batch_found= (result == 0);
+    if (result != HA_ERR_END_OF_FILE)
+      break;
+  }
+
+  *range_info= mrr_cur_range.ptr;
+  DBUG_PRINT("exit",("handler::mrr_sorted_keys_next result %d", result));
+  DBUG_RETURN(result);
+}
+
+
 /**
   Get next record in MRR scan
 
@@ -5968,6 +6319,9 @@ int handler::multi_range_read_next(char **range_info)
   int range_res;
   DBUG_ENTER("handler::multi_range_read_next");
 
+  if (mrr_sort_keys)
+    DBUG_RETURN(mrr_sorted_keys_next(range_info));
+
   if (!mrr_have_range)
   {
     mrr_have_range= TRUE;
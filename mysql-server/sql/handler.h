@@ -1780,6 +1780,15 @@ void get_sweep_read_cost(TABLE *table, ha_rows nrows, bool interrupted,
 */
 #define HA_MRR_SUPPORT_SORTED 256
 
+/*
+  Set by the default MRR implementation in multi_range_read_info() when it
+  estimates that looking up the keys in key order saves random I/O.
+  multi_range_read_init() will then collect batches of ranges in the
+  supplied buffer, sort each batch by key and read the ranges in that
+  order. The output is not ordered.
+*/
+#define HA_MRR_SORT_KEYS 512
+
 
 class ha_statistics
 {
@@ -2021,6 +2030,25 @@ public:
   /* Current range (the one we're now returning rows from) */
   KEY_MULTI_RANGE mrr_cur_range;
 
+  /*
+    Batch of ranges read from the range sequence by the default MRR
+    implementation when HA_MRR_SORT_KEYS is used. The range copies and
+    their key images are stored in the MRR buffer.
+  */
+  KEY_MULTI_RANGE **mrr_batch;  /* Ranges of the batch, sorted by key */
+  uchar *mrr_batch_entries;     /* Copies of the ranges and key images */
+  uint mrr_batch_max;           /* Max number of ranges in a batch */
+  uint mrr_batch_count;         /* Number of ranges in the current batch */
+  uint mrr_batch_pos;           /* Next range to read from the batch */
+  /* TRUE <=> ranges are read in batches sorted by key */
+  bool mrr_sort_keys;
+  /* TRUE <=> the range sequence has no more ranges */
+  bool mrr_seq_eof;
+  /* TRUE <=> the last range read from the batch matched a row */
+  bool mrr_batch_found;
+  /* TRUE <=> HA_MRR_NO_ASSOCIATION was passed to multi_range_read_init() */
+  bool mrr_no_association;
+
   /*
     The direction of the current range or index scan. This is used by
     the ICP implementation to determine if it has reached the end
@@ -2181,7 +2209,8 @@ public:
   handler(handlerton *ht_arg, TABLE_SHARE *share_arg)
     :table_share(share_arg), table(0),
     estimation_rows_to_insert(0), ht(ht_arg),
-    ref(0), range_scan_direction(RANGE_SCAN_ASC),
+    ref(0), mrr_sort_keys(false),
+    range_scan_direction(RANGE_SCAN_ASC),
     in_range_check_pushed_down(false), end_range(NULL),
     key_used_on_scan(MAX_KEY), active_index(MAX_KEY),
     ref_length(sizeof(my_off_t)),
@@ -2439,6 +2468,13 @@ public:
                                     HANDLER_BUFFER *buf);
   virtual int multi_range_read_next(char **range_info);
 
+  static uint mrr_sort_keys_entry_size(const KEY *key_info);
+private:
+  bool sort_keys_mrr_cost(uint keyno, uint n_ranges, uint n_rows,
+                          uint flags, Cost_estimate *cost);
+  bool mrr_fill_sorted_batch();
+  int mrr_sorted_keys_next(char **range_info);
+public:
 
   virtual const key_map *keys_to_use_for_scanning() { return &key_map_empty; }
   bool has_transactions()
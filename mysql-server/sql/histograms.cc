@@ -0,0 +1,1004 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "histograms.h"
+#include "sql_class.h"                          // THD, Dummy_error_handler
+#include "sql_base.h"                           // is_equal
+#include "sql_table.h"                          // build_table_filename
+#include "sql_time.h"                           // str_to_datetime
+#include "parse_file.h"                         // File_option
+#include "opt_trace.h"                          // Opt_trace_object
+#include "mysqld.h"                             // key_file_misc
+#include "log.h"                                // sql_print_warning
+
+#include <algorithm>
+
+const char * const HST_EXT= ".HST";
+
+/**
+  Histograms are built from at most this many rows. Larger tables are
+  sampled.
+*/
+static const ha_rows HISTOGRAM_MAX_SAMPLE_ROWS= 1000000;
+
+
+/*
+  Histogram
+*/
+
+bool Histogram::build(double *values, size_t num_values, ha_rows num_nulls,
+                      uint max_buckets)
+{
+  DBUG_ASSERT(max_buckets > 0);
+  m_buckets.clear();
+  const double total_rows= static_cast<double>(num_values + num_nulls);
+  if (total_rows == 0)
+  {
+    m_type= SINGLETON;
+    m_null_fraction= 0.0;
+    return false;
+  }
+  m_null_fraction= num_nulls / total_rows;
+
+  std::sort(values, values + num_values);
+
+  size_t num_distinct= 0;
+  for (size_t i= 0; i < num_values; i++)
+  {
+    if (i == 0 || values[i] != values[i - 1])
+      num_distinct++;
+  }
+
+  double cumulative= 0.0;
+  if (num_distinct <= max_buckets)
+  {
+    m_type= SINGLETON;
+    if (m_buckets.reserve(num_distinct))
+      return true;
+    size_t i= 0;
+    while (i < num_values)
+    {
+      const size_t start= i;
+      while (i < num_values && values[i] == values[start])
+        i++;
+      cumulative+= (i - start) / total_rows;
+      const Bucket bucket= { values[start], values[start], cumulative, 1.0 };
+      m_buckets.push_back(bucket);
+    }
+    return false;
+  }
+
+  /*
+    Equi-height: the remaining values are spread evenly over the remaining
+    buckets, and a bucket ends at the first value boundary after its share,
+    so that the values equal to each other are in the same bucket. The
+    last bucket takes all remaining values.
+  */
+  m_type= EQUI_HEIGHT;
+  if (m_buckets.reserve(max_buckets))
+    return true;
+  size_t i= 0;
+  for (uint bucket_no= 0; i < num_values; bucket_no++)
+  {
+    DBUG_ASSERT(bucket_no < max_buckets);
+    const size_t start= i;
+    const double end= start + static_cast<double>(num_values - start) /
+                              (max_buckets - bucket_no);
+    double bucket_distinct= 0.0;
+    do
+    {
+      const double value= values[i];
+      while (i < num_values && values[i] == value)
+        i++;
+      bucket_distinct++;
+    } while (i < num_values && i < end);
+
+    cumulative+= (i - start) / total_rows;
+    const Bucket bucket= { values[start], values[i - 1], cumulative,
+                           bucket_distinct };
+    m_buckets.push_back(bucket);
+  }
+  return false;
+}
+
+
+static bool append_double(String *str, double value)
+{
+  char buff[MY_GCVT_MAX_FIELD_WIDTH + 1];
+  const size_t length= my_gcvt(value, MY_GCVT_ARG_DOUBLE,
+                               MY_GCVT_MAX_FIELD_WIDTH, buff, NULL);
+  return str->append(' ') || str->append(buff, length);
+}
+
+
+/*
+  The text form is
+
+    <type> <null fraction> <number of buckets>
+
+  followed by
+
+    <lower> <upper> <cumulative frequency> <number of distinct values>
+
+  for each bucket.
+*/
+
+bool Histogram::store(String *str) const
+{
+  if (str->append(get_type_name()) ||
+      append_double(str, m_null_fraction) ||
+      str->append(' ') ||
+      str->append_ulonglong(m_buckets.size()))
+    return true;
+  for (size_t i= 0; i < m_buckets.size(); i++)
+  {
+    const Bucket &bucket= m_buckets[i];
+    if (append_double(str, bucket.lower) ||
+        append_double(str, bucket.upper) ||
+        append_double(str, bucket.cumulative_frequency) ||
+        append_double(str, bucket.num_distinct))
+      return true;
+  }
+  return false;
+}
+
+
+static bool read_double(const char **pos, const char *end, double *value)
+{
+  while (*pos < end && **pos == ' ')
+    (*pos)++;
+  if (*pos == end)
+    return true;
+  char *value_end= const_cast<char*>(end);
+  int error;
+  *value= my_strtod(*pos, &value_end, &error);
+  if (error || value_end == *pos)
+    return true;
+  *pos= value_end;
+  return false;
+}
+
+
+bool Histogram::load(const char *str, size_t length)
+{
+  const char *pos= str;
+  const char *end= str + length;
+  const char *type_end= static_cast<const char*>(memchr(str, ' ', length));
+  if (type_end == NULL)
+    return true;
+  const size_t type_length= type_end - str;
+  if (type_length == 9 && !memcmp(str, "singleton", 9))
+    m_type= SINGLETON;
+  else if (type_length == 11 && !memcmp(str, "equi-height", 11))
+    m_type= EQUI_HEIGHT;
+  else
+    return true;
+  pos= type_end;
+
+  double num_buckets;
+  if (read_double(&pos, end, &m_null_fraction) ||
+      read_double(&pos, end, &num_buckets) ||
+      m_null_fraction < 0.0 || m_null_fraction > 1.0 ||
+      num_buckets < 0.0 || num_buckets > UINT_MAX32)
+    return true;
+
+  m_buckets.clear();
+  if (m_buckets.reserve(static_cast<size_t>(num_buckets)))
+    return true;
+  double previous_upper= 0.0;
+  double previous_cumulative= 0.0;
+  for (size_t i= 0; i < static_cast<size_t>(num_buckets); i++)
+  {
+    Bucket bucket;
+    if (read_double(&pos, end, &bucket.lower) ||
+        read_double(&pos, end, &bucket.upper) ||
+        read_double(&pos, end, &bucket.cumulative_frequency) ||
+        read_double(&pos, end, &bucket.num_distinct))
+      return true;
+    // The buckets must be ordered and must not overlap
+    if (bucket.lower > bucket.upper ||
+        (i > 0 && bucket.lower <= previous_upper) ||
+        bucket.cumulative_frequency < previous_cumulative ||
+        bucket.num_distinct < 1.0)
+      return true;
+    previous_upper= bucket.upper;
+    previous_cumulative= bucket.cumulative_frequency;
+    m_buckets.push_back(bucket);
+  }
+  return pos != end;
+}
+
+
+/**
+  Find the first bucket whose upper bound is at or above a value.
+
+  @returns NULL if the value is above all buckets
+*/
+
+const Histogram::Bucket *Histogram::find_bucket(double value) const
+{
+  size_t low= 0;
+  size_t high= m_buckets.size();
+  while (low < high)
+  {
+    const size_t mid= low + (high - low) / 2;
+    if (m_buckets[mid].upper < value)
+      low= mid + 1;
+    else
+      high= mid;
+  }
+  return low == m_buckets.size() ? NULL : &m_buckets[low];
+}
+
+
+/// Fraction of all rows that are in a bucket
+double Histogram::get_frequency(const Bucket *bucket) const
+{
+  if (bucket == m_buckets.begin())
+    return bucket->cumulative_frequency;
+  return bucket->cumulative_frequency - (bucket - 1)->cumulative_frequency;
+}
+
+
+double Histogram::get_non_null_fraction() const
+{
+  return m_buckets.empty() ? 0.0 : m_buckets.back().cumulative_frequency;
+}
+
+
+double Histogram::get_equal_to_selectivity(double value) const
+{
+  const Bucket *bucket= find_bucket(value);
+  if (bucket == NULL || value < bucket->lower)
+    return 0.0;
+  // Assume that the values of a bucket are equally frequent
+  return get_frequency(bucket) / bucket->num_distinct;
+}
+
+
+double Histogram::get_less_than_selectivity(double value) const
+{
+  const Bucket *bucket= find_bucket(value);
+  if (bucket == NULL)
+    return get_non_null_fraction();
+
+  double selectivity= bucket->cumulative_frequency - get_frequency(bucket);
+  if (m_type == EQUI_HEIGHT && value > bucket->lower)
+  {
+    /*
+      Assume that the values of the bucket other than 'upper' are evenly
+      spread over [lower, upper).
+    */
+    const double frequency= get_frequency(bucket);
+    const double equal= frequency / bucket->num_distinct;
+    selectivity+= (frequency - equal) *
+      (value - bucket->lower) / (bucket->upper - bucket->lower);
+  }
+  return selectivity;
+}
+
+
+double Histogram::get_in_list_selectivity(const double *values,
+                                          size_t count) const
+{
+  double selectivity= 0.0;
+  for (size_t i= 0; i < count; i++)
+  {
+    // The same value may be in the list more than once
+    bool duplicate= false;
+    for (size_t j= 0; j < i && !duplicate; j++)
+      duplicate= values[j] == values[i];
+    if (!duplicate)
+      selectivity+= get_equal_to_selectivity(values[i]);
+  }
+  return selectivity;
+}
+
+
+double Histogram::get_selectivity(enum_operator op, const double *values,
+                                  size_t count) const
+{
+  double selectivity;
+  switch (op)
+  {
+  case EQUALS_TO:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_equal_to_selectivity(values[0]);
+    break;
+  case NOT_EQUALS_TO:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_non_null_fraction() -
+      get_equal_to_selectivity(values[0]);
+    break;
+  case LESS_THAN:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_less_than_selectivity(values[0]);
+    break;
+  case LESS_THAN_OR_EQUAL:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_less_equal_selectivity(values[0]);
+    break;
+  case GREATER_THAN:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_non_null_fraction() -
+      get_less_equal_selectivity(values[0]);
+    break;
+  case GREATER_THAN_OR_EQUAL:
+    DBUG_ASSERT(count == 1);
+    selectivity= get_non_null_fraction() -
+      get_less_than_selectivity(values[0]);
+    break;
+  case BETWEEN:
+    DBUG_ASSERT(count == 2);
+    selectivity= get_less_equal_selectivity(values[1]) -
+      get_less_than_selectivity(values[0]);
+    break;
+  case NOT_BETWEEN:
+    DBUG_ASSERT(count == 2);
+    selectivity= get_non_null_fraction() -
+      std::max(get_less_equal_selectivity(values[1]) -
+               get_less_than_selectivity(values[0]), 0.0);
+    break;
+  case IN_LIST:
+    selectivity= get_in_list_selectivity(values, count);
+    break;
+  case NOT_IN_LIST:
+    selectivity= get_non_null_fraction() -
+      get_in_list_selectivity(values, count);
+    break;
+  case IS_NULL:
+    selectivity= m_null_fraction;
+    break;
+  case IS_NOT_NULL:
+    selectivity= 1.0 - m_null_fraction;
+    break;
+  default:
+    DBUG_ASSERT(false);
+    selectivity= 1.0;
+  }
+  return std::min(std::max(selectivity, 0.0), 1.0);
+}
+
+
+/*
+  Values of columns and constants
+*/
+
+bool histogram_supported_field(const Field *field)
+{
+  if (field->is_temporal())
+    return true;
+  switch (field->result_type())
+  {
+  case INT_RESULT:
+  case REAL_RESULT:
+  case DECIMAL_RESULT:
+    return field->type() != MYSQL_TYPE_BIT;
+  default:
+    return false;
+  }
+}
+
+
+/// The value of a column in the current row, as stored in a histogram
+static double get_field_value(Field *field)
+{
+  if (field->is_temporal())
+    return static_cast<double>(field->val_temporal_by_field_type());
+  return field->val_real();
+}
+
+
+/**
+  Get the value of a constant as stored in the histogram of a column.
+
+  Only constants that can be evaluated cheaply and without warnings are
+  used: numbers for numeric columns, and temporal values and valid
+  temporal literals for temporal columns.
+
+  @returns true if the constant can not be used
+*/
+
+static bool get_item_value(const Field *field, Item *item, double *value)
+{
+  if (!item->const_item() || item->is_expensive())
+    return true;
+
+  if (!field->is_temporal())
+  {
+    if (item->is_temporal())
+      return true;
+    switch (item->result_type())
+    {
+    case INT_RESULT:
+    case REAL_RESULT:
+    case DECIMAL_RESULT:
+      *value= item->val_real();
+      return item->null_value;
+    default:
+      return true;
+    }
+  }
+
+  const bool is_time= field->type() == MYSQL_TYPE_TIME;
+  if (item->is_temporal())
+  {
+    const longlong packed= is_time ? item->val_time_temporal() :
+                                     item->val_date_temporal();
+    *value= static_cast<double>(packed);
+    return item->null_value;
+  }
+  if (item->result_type() != STRING_RESULT)
+    return true;
+
+  StringBuffer<MAX_DATE_STRING_REP_LENGTH> buffer;
+  const String *str= item->val_str(&buffer);
+  if (str == NULL)
+    return true;
+  MYSQL_TIME ltime;
+  MYSQL_TIME_STATUS status;
+  if (is_time)
+  {
+    if (str_to_time(str, &ltime, 0, &status) || status.warnings)
+      return true;
+    *value= static_cast<double>(TIME_to_longlong_time_packed(&ltime));
+  }
+  else
+  {
+    if (str_to_datetime(str, &ltime, 0, &status) || status.warnings)
+      return true;
+    *value= static_cast<double>(TIME_to_longlong_datetime_packed(&ltime));
+  }
+  return false;
+}
+
+
+/*
+  Use of histograms by the optimizer
+*/
+
+const Histogram *get_histogram(const Field *field)
+{
+  const TABLE_SHARE *share= field->table->s;
+  if (share->histograms == NULL)
+    return NULL;
+  return share->histograms[field->field_index];
+}
+
+
+static void trace_histogram(const Item_field *fld, Item *cond,
+                            const Histogram *histogram, float filter)
+{
+  Opt_trace_context * const trace= &fld->field->table->in_use->opt_trace;
+  Opt_trace_object(trace).
+    add("condition", cond).
+    add_alnum("histogram", histogram->get_type_name()).
+    add("buckets", static_cast<ulonglong>(histogram->get_num_buckets())).
+    add("filtering_effect", filter);
+}
+
+
+/// The operator of "b OP a" for the operator of "a OP b"
+static Histogram::enum_operator swap_operands(Histogram::enum_operator op)
+{
+  switch (op)
+  {
+  case Histogram::LESS_THAN:
+    return Histogram::GREATER_THAN;
+  case Histogram::LESS_THAN_OR_EQUAL:
+    return Histogram::GREATER_THAN_OR_EQUAL;
+  case Histogram::GREATER_THAN:
+    return Histogram::LESS_THAN;
+  case Histogram::GREATER_THAN_OR_EQUAL:
+    return Histogram::LESS_THAN_OR_EQUAL;
+  default:
+    return op;
+  }
+}
+
+
+bool get_histogram_filtering_effect(const Item_func *func,
+                                    const Item_field *fld,
+                                    Histogram::enum_operator op,
+                                    float *filter)
+{
+  const Histogram *histogram= get_histogram(fld->field);
+  if (histogram == NULL)
+    return true;
+
+  Item **args= func->arguments();
+  const uint arg_count= func->argument_count();
+  uint field_arg= 0;
+  while (field_arg < arg_count && args[field_arg]->real_item() != fld)
+    field_arg++;
+  if (field_arg == arg_count)
+    return true;
+  if (field_arg != 0)
+  {
+    // BETWEEN and IN need the column on the left hand side
+    if (op == Histogram::BETWEEN || op == Histogram::NOT_BETWEEN ||
+        op == Histogram::IN_LIST || op == Histogram::NOT_IN_LIST)
+      return true;
+    op= swap_operands(op);
+  }
+
+  double *values= NULL;
+  if (arg_count > 1 &&
+      !(values= static_cast<double*>(sql_alloc((arg_count - 1) *
+                                               sizeof(double)))))
+    return true;
+  uint count= 0;
+  for (uint i= 0; i < arg_count; i++)
+  {
+    if (i == field_arg)
+      continue;
+    if (get_item_value(fld->field, args[i], &values[count++]))
+      return true;
+  }
+
+  *filter= static_cast<float>(histogram->get_selectivity(op, values, count));
+  trace_histogram(fld, const_cast<Item_func*>(func), histogram, *filter);
+  return false;
+}
+
+
+bool get_histogram_equality_effect(Item *cond, const Item_field *fld,
+                                   Item *value, float *filter)
+{
+  const Histogram *histogram= get_histogram(fld->field);
+  if (histogram == NULL)
+    return true;
+  double v;
+  if (get_item_value(fld->field, value, &v))
+    return true;
+
+  *filter= static_cast<float>(histogram->get_selectivity(Histogram::EQUALS_TO,
+                                                         &v, 1));
+  trace_histogram(fld, cond, histogram, *filter);
+  return false;
+}
+
+
+/*
+  The .HST file
+*/
+
+static const LEX_STRING hst_file_type= { C_STRING_WITH_LEN("HISTOGRAMS") };
+
+static const int HST_NUM_REQUIRED_PARAMETERS= 3;
+
+/**
+  Contents of a .HST file. The three lists have one element per
+  histogram.
+*/
+
+struct Hst_file_data
+{
+  /// Names of the columns
+  List<LEX_STRING> columns;
+  /// Field::type() of the columns when the histograms were built
+  List<ulonglong> column_types;
+  /// Histograms in the text form of Histogram::store()
+  List<LEX_STRING> histograms;
+};
+
+static File_option hst_file_parameters[]=
+{
+  {
+    { C_STRING_WITH_LEN("columns") },
+    my_offsetof(struct Hst_file_data, columns),
+    FILE_OPTIONS_STRLIST
+  },
+  {
+    { C_STRING_WITH_LEN("column_types") },
+    my_offsetof(struct Hst_file_data, column_types),
+    FILE_OPTIONS_ULLLIST
+  },
+  {
+    { C_STRING_WITH_LEN("histograms") },
+    my_offsetof(struct Hst_file_data, histograms),
+    FILE_OPTIONS_STRLIST
+  },
+  { { 0, 0 }, 0, FILE_OPTIONS_STRING }
+};
+
+
+static size_t build_hst_path(char *path, const char *db,
+                             const char *table_name, bool *was_truncated)
+{
+  return build_table_filename(path, FN_REFLEN - 1, db, table_name, HST_EXT,
+                              0, was_truncated);
+}
+
+
+static bool hst_file_exists(const char *path)
+{
+  return access(path, F_OK) == 0;
+}
+
+
+/**
+  Read a .HST file.
+
+  @returns true if the file can not be read or is corrupt
+*/
+
+static bool read_hst_file(const char *path, MEM_ROOT *mem_root,
+                          Hst_file_data *hst)
+{
+  const LEX_STRING file= { const_cast<char*>(path), strlen(path) };
+  File_parser *parser= sql_parse_prepare(&file, mem_root, false);
+  if (parser == NULL || !is_equal(&hst_file_type, parser->type()))
+    return true;
+  if (parser->parse((uchar*) hst, mem_root, hst_file_parameters,
+                    HST_NUM_REQUIRED_PARAMETERS, &file_parser_dummy_hook))
+    return true;
+  return hst->columns.elements != hst->column_types.elements ||
+         hst->columns.elements != hst->histograms.elements;
+}
+
+
+/**
+  Write a .HST file, or delete it if there are no histograms.
+*/
+
+static bool write_hst_file(const char *db, const char *table_name,
+                           Hst_file_data *hst)
+{
+  char path[FN_REFLEN];
+  bool was_truncated= false;
+  LEX_STRING file;
+  file.length= build_hst_path(path, db, table_name, &was_truncated);
+  file.str= path;
+  if (was_truncated)
+  {
+    my_error(ER_IDENT_CAUSES_TOO_LONG_PATH, MYF(0), sizeof(path) - 1, path);
+    return true;
+  }
+
+  if (hst->columns.is_empty())
+    return hst_file_exists(path) &&
+           mysql_file_delete(key_file_misc, path, MYF(MY_WME));
+  return sql_create_definition_file(NULL, &file, &hst_file_type,
+                                    (uchar*) hst, hst_file_parameters);
+}
+
+
+/**
+  Find a column of a table by name.
+
+  @returns NULL if there is no such column
+*/
+
+static Field *find_share_field(const TABLE_SHARE *share, const char *name)
+{
+  for (Field **field= share->field; *field != NULL; field++)
+  {
+    if (!my_strcasecmp(system_charset_info, (*field)->field_name, name))
+      return *field;
+  }
+  return NULL;
+}
+
+
+/**
+  Remove the histograms of columns from the contents of a .HST file.
+
+  @param hst          contents of the file
+  @param share        if not NULL, also remove the histograms of columns
+                      that are not in the table or have changed type
+  @param names        names of the columns
+  @param num_names    number of elements in 'names'
+  @param[out] found   if not NULL, whether each column had a histogram
+*/
+
+static void remove_histograms(Hst_file_data *hst, const TABLE_SHARE *share,
+                              const char **names, uint num_names,
+                              bool *found)
+{
+  List_iterator<LEX_STRING> column_it(hst->columns);
+  List_iterator<ulonglong> type_it(hst->column_types);
+  List_iterator<LEX_STRING> histogram_it(hst->histograms);
+  LEX_STRING *column;
+  while ((column= column_it++))
+  {
+    const ulonglong *type= type_it++;
+    histogram_it++;
+
+    bool remove= false;
+    if (share != NULL)
+    {
+      const Field *field= find_share_field(share, column->str);
+      remove= field == NULL || field->type() != *type;
+    }
+    for (uint i= 0; i < num_names; i++)
+    {
+      if (!my_strcasecmp(system_charset_info, column->str, names[i]))
+      {
+        remove= true;
+        if (found != NULL)
+          found[i]= true;
+      }
+    }
+    if (remove)
+    {
+      column_it.remove();
+      type_it.remove();
+      histogram_it.remove();
+    }
+  }
+}
+
+
+void load_histograms(THD *thd, TABLE_SHARE *share)
+{
+  char path[FN_REFLEN];
+  bool was_truncated= false;
+  build_hst_path(path, share->db.str, share->table_name.str, &was_truncated);
+  if (was_truncated || !hst_file_exists(path))
+    return;
+
+  /*
+    Histograms are only hints for the optimizer: the table is opened
+    without them if the file can not be read.
+  */
+  Dummy_error_handler error_handler;
+  thd->push_internal_handler(&error_handler);
+
+  Hst_file_data hst;
+  if (!read_hst_file(path, thd->mem_root, &hst))
+  {
+    List_iterator<LEX_STRING> column_it(hst.columns);
+    List_iterator<ulonglong> type_it(hst.column_types);
+    List_iterator<LEX_STRING> histogram_it(hst.histograms);
+    LEX_STRING *column;
+    while ((column= column_it++))
+    {
+      const ulonglong *type= type_it++;
+      const LEX_STRING *text= histogram_it++;
+
+      // Ignore the histogram if the column has been dropped or altered
+      Field *field= find_share_field(share, column->str);
+      if (field == NULL || field->type() != *type ||
+          !histogram_supported_field(field))
+        continue;
+
+      if (share->histograms == NULL)
+      {
+        if (!(share->histograms= static_cast<Histogram**>(
+                alloc_root(&share->mem_root,
+                           share->fields * sizeof(Histogram*)))))
+          break;
+        memset(share->histograms, 0, share->fields * sizeof(Histogram*));
+      }
+      Histogram *histogram= new (&share->mem_root) Histogram(&share->mem_root);
+      if (histogram == NULL)
+        break;
+      if (histogram->load(text->str, text->length))
+      {
+        sql_print_warning("Ignoring the corrupt histogram of column '%s' "
+                          "in '%s'", column->str, path);
+        continue;
+      }
+      share->histograms[field->field_index]= histogram;
+    }
+  }
+
+  thd->pop_internal_handler();
+}
+
+
+bool update_histograms(THD *thd, TABLE *table, Field **fields,
+                       uint num_fields, uint max_buckets)
+{
+  handler *file= table->file;
+  int error;
+
+  /* Read only the columns of the histograms */
+  bitmap_clear_all(table->read_set);
+  for (uint i= 0; i < num_fields; i++)
+    bitmap_set_bit(table->read_set, fields[i]->field_index);
+  file->column_bitmaps_signal();
+
+  if ((error= file->info(HA_STATUS_VARIABLE)))
+  {
+    file->print_error(error, MYF(0));
+    return true;
+  }
+  const ha_rows estimated_rows= file->stats.records;
+  const ha_rows max_rows= std::min(estimated_rows, HISTOGRAM_MAX_SAMPLE_ROWS);
+  const double sampling_rate= estimated_rows > HISTOGRAM_MAX_SAMPLE_ROWS ?
+    static_cast<double>(HISTOGRAM_MAX_SAMPLE_ROWS) / estimated_rows : 1.0;
+
+  Mem_root_array<double, true> **values=
+    static_cast<Mem_root_array<double, true>**>(
+      thd->alloc(num_fields * sizeof(Mem_root_array<double, true>*)));
+  ha_rows *nulls= static_cast<ha_rows*>(thd->calloc(num_fields *
+                                                    sizeof(ha_rows)));
+  if (values == NULL || nulls == NULL)
+    return true;
+  for (uint i= 0; i < num_fields; i++)
+  {
+    values[i]= new (thd->mem_root) Mem_root_array<double, true>(thd->mem_root);
+    if (values[i] == NULL || values[i]->reserve(max_rows))
+      return true;
+  }
+
+  if ((error= file->ha_rnd_init(true)))
+  {
+    file->print_error(error, MYF(0));
+    return true;
+  }
+  /*
+    Take every 1/sampling_rate'th row. The row count is only an estimate,
+    so the scan stops when the sample is full.
+  */
+  ha_rows rows_read= 0;
+  ha_rows rows_sampled= 0;
+  while (rows_sampled < HISTOGRAM_MAX_SAMPLE_ROWS)
+  {
+    if ((error= file->ha_rnd_next(table->record[0])))
+    {
+      if (error == HA_ERR_RECORD_DELETED)
+        continue;
+      break;
+    }
+    if (thd->killed)
+    {
+      thd->send_kill_message();
+      file->ha_rnd_end();
+      return true;
+    }
+    rows_read++;
+    if (static_cast<ha_rows>(rows_read * sampling_rate) ==
+        static_cast<ha_rows>((rows_read - 1) * sampling_rate))
+      continue;
+
+    for (uint i= 0; i < num_fields; i++)
+    {
+      if (fields[i]->is_null())
+        nulls[i]++;
+      else if (values[i]->push_back(get_field_value(fields[i])))
+      {
+        file->ha_rnd_end();
+        return true;
+      }
+    }
+    rows_sampled++;
+  }
+  file->ha_rnd_end();
+  if (error && error != HA_ERR_END_OF_FILE)
+  {
+    file->print_error(error, MYF(0));
+    return true;
+  }
+
+  /*
+    Merge the new histograms with the stored ones, dropping those of
+    columns that no longer exist.
+  */
+  const TABLE_SHARE *share= table->s;
+  char path[FN_REFLEN];
+  bool was_truncated= false;
+  build_hst_path(path, share->db.str, share->table_name.str, &was_truncated);
+  Hst_file_data hst;
+  if (!was_truncated && hst_file_exists(path) &&
+      read_hst_file(path, thd->mem_root, &hst))
+  {
+    // Overwrite a corrupt file
+    thd->clear_error();
+    hst.columns.empty();
+    hst.column_types.empty();
+    hst.histograms.empty();
+  }
+
+  const char **names= static_cast<const char**>(
+    thd->alloc(num_fields * sizeof(const char*)));
+  if (names == NULL)
+    return true;
+  for (uint i= 0; i < num_fields; i++)
+    names[i]= fields[i]->field_name;
+  remove_histograms(&hst, share, names, num_fields, NULL);
+
+  for (uint i= 0; i < num_fields; i++)
+  {
+    Histogram histogram(thd->mem_root);
+    if (histogram.build(values[i]->begin(), values[i]->size(), nulls[i],
+                        max_buckets))
+      return true;
+
+    String text;
+    LEX_STRING *column= static_cast<LEX_STRING*>(
+      thd->alloc(sizeof(LEX_STRING)));
+    LEX_STRING *histogram_text= static_cast<LEX_STRING*>(
+      thd->alloc(sizeof(LEX_STRING)));
+    ulonglong *type= static_cast<ulonglong*>(thd->alloc(sizeof(ulonglong)));
+    if (column == NULL || histogram_text == NULL || type == NULL ||
+        histogram.store(&text) ||
+        !(column->str= thd->strdup(fields[i]->field_name)) ||
+        !(histogram_text->str= thd->strmake(text.ptr(), text.length())))
+      return true;
+    column->length= strlen(column->str);
+    histogram_text->length= text.length();
+    *type= fields[i]->type();
+
+    if (hst.columns.push_back(column, thd->mem_root) ||
+        hst.column_types.push_back(type, thd->mem_root) ||
+        hst.histograms.push_back(histogram_text, thd->mem_root))
+      return true;
+  }
+
+  return write_hst_file(share->db.str, share->table_name.str, &hst);
+}
+
+
+bool drop_histograms(THD *thd, const char *db, const char *table_name,
+                     List<String> *columns, bool *found)
+{
+  char path[FN_REFLEN];
+  bool was_truncated= false;
+  build_hst_path(path, db, table_name, &was_truncated);
+  if (was_truncated || !hst_file_exists(path))
+    return false;
+
+  Hst_file_data hst;
+  if (read_hst_file(path, thd->mem_root, &hst))
+  {
+    if (!thd->is_error())
+      my_error(ER_FPARSER_BAD_HEADER, MYF(0), path);
+    return true;
+  }
+
+  const char **names= static_cast<const char**>(
+    thd->alloc(columns->elements * sizeof(const char*)));
+  if (names == NULL)
+    return true;
+  List_iterator<String> it(*columns);
+  String *column;
+  for (uint i= 0; (column= it++); i++)
+    names[i]= column->c_ptr_safe();
+
+  const uint count= hst.columns.elements;
+  remove_histograms(&hst, NULL, names, columns->elements, found);
+  if (hst.columns.elements == count)
+    return false;
+  return write_hst_file(db, table_name, &hst);
+}
+
+
+void drop_all_histograms(const char *db, const char *table_name)
+{
+  char path[FN_REFLEN];
+  bool was_truncated= false;
+  build_hst_path(path, db, table_name, &was_truncated);
+  if (!was_truncated && hst_file_exists(path))
+    (void) mysql_file_delete(key_file_misc, path, MYF(0));
+}
+
+
+void rename_histograms(const char *db, const char *table_name,
+                       const char *new_db, const char *new_table_name)
+{
+  char from[FN_REFLEN];
+  char to[FN_REFLEN];
+  bool was_truncated= false;
+  build_hst_path(from, db, table_name, &was_truncated);
+  if (was_truncated || !hst_file_exists(from))
+    return;
+  build_hst_path(to, new_db, new_table_name, &was_truncated);
+  if (was_truncated)
+    return;
+  (void) mysql_file_rename(key_file_misc, from, to, MYF(0));
+}
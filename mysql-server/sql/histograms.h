@@ -0,0 +1,236 @@
+#ifndef HISTOGRAMS_INCLUDED
+#define HISTOGRAMS_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Column histograms, used by the optimizer to estimate the selectivity of
+  predicates on columns that are not indexed.
+
+  A histogram is built by ANALYZE TABLE t UPDATE HISTOGRAM ON col from the
+  values of the column in (a sample of) the rows of the table, and removed
+  by ANALYZE TABLE t DROP HISTOGRAM ON col. If the column has at most as
+  many distinct values as the requested number of buckets, a singleton
+  histogram with one bucket per value is built. Otherwise an equi-height
+  histogram is built, whose buckets each hold about the same number of
+  rows.
+
+  Histograms are supported for numeric and temporal columns. The values
+  are kept as doubles: temporal values in their packed longlong form, so
+  that the order of the values is preserved.
+
+  The histograms of a table are stored in a file next to the .frm file,
+  see HST_EXT, and are loaded into the TABLE_SHARE when the table
+  definition is opened. A histogram is ignored if the column has been
+  dropped, or has changed type, since the histogram was built.
+*/
+
+#include "my_global.h"
+#include "mem_root_array.h"                     // Mem_root_array
+#include "sql_alloc.h"                          // Sql_alloc
+#include "sql_list.h"                           // List
+
+class Field;
+class Item;
+class Item_field;
+class Item_func;
+class String;
+class THD;
+struct TABLE;
+struct TABLE_SHARE;
+
+/// Extension of the file holding the histograms of a table
+extern const char * const HST_EXT;
+
+class Histogram : public Sql_alloc
+{
+public:
+  enum enum_histogram_type { SINGLETON, EQUI_HEIGHT };
+
+  /// Predicates whose selectivity a histogram can estimate
+  enum enum_operator
+  {
+    EQUALS_TO,
+    NOT_EQUALS_TO,
+    LESS_THAN,
+    LESS_THAN_OR_EQUAL,
+    GREATER_THAN,
+    GREATER_THAN_OR_EQUAL,
+    BETWEEN,
+    NOT_BETWEEN,
+    IN_LIST,
+    NOT_IN_LIST,
+    IS_NULL,
+    IS_NOT_NULL
+  };
+
+  /**
+    A bucket holds the values in [lower, upper]. For a singleton histogram
+    lower and upper are the same value.
+  */
+  struct Bucket
+  {
+    double lower;
+    double upper;
+    /// Fraction of all rows with a non-NULL value <= upper
+    double cumulative_frequency;
+    /// Number of distinct values in the bucket
+    double num_distinct;
+  };
+
+  explicit Histogram(MEM_ROOT *mem_root)
+    : m_type(SINGLETON), m_null_fraction(0.0), m_buckets(mem_root)
+  {}
+
+  /**
+    Build the histogram.
+
+    @param values       the non-NULL values, sorted in place
+    @param num_values   number of elements in 'values'
+    @param num_nulls    number of NULL values
+    @param max_buckets  maximum number of buckets
+
+    @returns true if out of memory
+  */
+  bool build(double *values, size_t num_values, ha_rows num_nulls,
+             uint max_buckets);
+
+  /// Append the histogram in text form to 'str'
+  bool store(String *str) const;
+
+  /**
+    Read the histogram from the text form of store().
+
+    @returns true if the text is not a valid histogram
+  */
+  bool load(const char *str, size_t length);
+
+  enum_histogram_type get_type() const { return m_type; }
+  const char *get_type_name() const
+  { return m_type == SINGLETON ? "singleton" : "equi-height"; }
+  size_t get_num_buckets() const { return m_buckets.size(); }
+  const Bucket &get_bucket(size_t i) const { return m_buckets[i]; }
+  double get_null_fraction() const { return m_null_fraction; }
+
+  /**
+    Estimate the fraction of the rows of the table that satisfy a
+    predicate.
+
+    @param op      the predicate
+    @param values  the operands of the predicate other than the column:
+                   none for IS [NOT] NULL, two for [NOT] BETWEEN, one or
+                   more for [NOT] IN, one for the other predicates
+    @param count   number of elements in 'values'
+  */
+  double get_selectivity(enum_operator op, const double *values,
+                         size_t count) const;
+
+private:
+  const Bucket *find_bucket(double value) const;
+  double get_frequency(const Bucket *bucket) const;
+  double get_non_null_fraction() const;
+  double get_equal_to_selectivity(double value) const;
+  double get_less_than_selectivity(double value) const;
+  double get_less_equal_selectivity(double value) const
+  {
+    return get_less_than_selectivity(value) + get_equal_to_selectivity(value);
+  }
+  double get_in_list_selectivity(const double *values, size_t count) const;
+
+  enum_histogram_type m_type;
+  double m_null_fraction;
+  Mem_root_array<Bucket, true> m_buckets;
+};
+
+
+/**
+  Whether histograms can be built for a column: numeric and temporal
+  columns, except BIT.
+*/
+bool histogram_supported_field(const Field *field);
+
+/**
+  Get the histogram of a column.
+
+  @returns NULL if the column has no histogram
+*/
+const Histogram *get_histogram(const Field *field);
+
+/**
+  Estimate the filtering effect of a predicate on a column with a
+  histogram, and trace the estimate in the optimizer trace.
+
+  @param func         the predicate
+  @param fld          the column, one of the arguments of 'func'
+  @param op           what 'func' computes if 'fld' is its first argument
+  @param[out] filter  the estimated filtering effect
+
+  @returns false if the histogram was used, true if the column has no
+           histogram or the other arguments are not constant
+*/
+bool get_histogram_filtering_effect(const Item_func *func,
+                                    const Item_field *fld,
+                                    Histogram::enum_operator op,
+                                    float *filter);
+
+/**
+  Estimate the filtering effect of 'fld = value', which is implied by the
+  multiple equality 'cond', with the histogram of 'fld'.
+
+  @returns false if the histogram was used
+*/
+bool get_histogram_equality_effect(Item *cond, const Item_field *fld,
+                                   Item *value, float *filter);
+
+/// Load the histograms of a table, if it has any, into its share
+void load_histograms(THD *thd, TABLE_SHARE *share);
+
+/**
+  Build histograms for columns of an open table and store them, replacing
+  the existing histograms of those columns.
+
+  @param thd          thread handle
+  @param table        the table, opened and locked for reading
+  @param fields       the columns
+  @param num_fields   number of columns
+  @param max_buckets  maximum number of buckets of each histogram
+
+  @returns true on error, which has been reported
+*/
+bool update_histograms(THD *thd, TABLE *table, Field **fields,
+                       uint num_fields, uint max_buckets);
+
+/**
+  Remove the histograms of columns of a table.
+
+  @param[out] found  whether each column had a histogram
+
+  @returns true on error, which has been reported
+*/
+bool drop_histograms(THD *thd, const char *db, const char *table_name,
+                     List<String> *columns, bool *found);
+
+/// Delete the histograms of a dropped table
+void drop_all_histograms(const char *db, const char *table_name);
+
+/// Move the histograms of a renamed table
+void rename_histograms(const char *db, const char *table_name,
+                       const char *new_db, const char *new_table_name);
+
+#endif /* HISTOGRAMS_INCLUDED */
@@ -0,0 +1,145 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#ifndef HYPERLOGLOG_INCLUDED
+#define HYPERLOGLOG_INCLUDED
+
+#include <string.h>
+#include <math.h>
+#include "my_global.h"
+
+/**
+  HyperLogLog sketch for estimating the number of distinct values in a
+  stream, see Flajolet et al., "HyperLogLog: the analysis of a near-optimal
+  cardinality estimation algorithm" (2007).
+
+  Values are added as 64 bit hashes. The first HLL_PRECISION bits of a hash
+  select a register, and the register keeps the maximum position of the
+  leftmost 1-bit seen in the remaining bits. With 2^14 one-byte registers
+  the standard error of the estimate is about 1.04/sqrt(2^14) = 0.81%.
+
+  Two sketches built from disjoint (or overlapping) streams can be merged
+  into the sketch of the union by taking the register-wise maximum, so
+  partial sketches computed per group or per partition can be combined
+  without looking at the values again.
+*/
+class Hyperloglog
+{
+public:
+  static const uint HLL_PRECISION= 14;
+  static const uint HLL_REGISTERS= 1U << HLL_PRECISION;
+
+  Hyperloglog() { clear(); }
+
+  /** Forget all values added so far. */
+  void clear() { memset(m_registers, 0, sizeof(m_registers)); }
+
+  /**
+    Add a value to the sketch.
+
+    @param hash  64 bit hash of the value. The bits must be uniformly
+                 distributed; use mix() on hashes of lower quality.
+  */
+  void add(ulonglong hash)
+  {
+    const uint idx= static_cast<uint>(hash >> (64 - HLL_PRECISION));
+    /*
+      Shift out the index bits and set a guard bit so that the rank is
+      bounded by 64 - HLL_PRECISION + 1.
+    */
+    ulonglong w= (hash << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+    uchar rank= 1;
+    while (!(w & 0x8000000000000000ULL))
+    {
+      w<<= 1;
+      rank++;
+    }
+    if (rank > m_registers[idx])
+      m_registers[idx]= rank;
+  }
+
+  /** Make this sketch the sketch of the union of both streams. */
+  void merge(const Hyperloglog &other)
+  {
+    for (uint i= 0; i < HLL_REGISTERS; i++)
+    {
+      if (other.m_registers[i] > m_registers[i])
+        m_registers[i]= other.m_registers[i];
+    }
+  }
+
+  /** @return the estimated number of distinct values added */
+  ulonglong estimate() const
+  {
+    const double m= HLL_REGISTERS;
+    const double alpha= 0.7213 / (1.0 + 1.079 / m);
+    double sum= 0.0;
+    uint zeros= 0;
+    for (uint i= 0; i < HLL_REGISTERS; i++)
+    {
+      sum+= ldexp(1.0, -m_registers[i]);
+      if (m_registers[i] == 0)
+        zeros++;
+    }
+    double estimate= alpha * m * m / sum;
+    /*
+      Small range correction: linear counting is more precise while many
+      registers are still empty. No large range correction is needed
+      with 64 bit hashes.
+    */
+    if (estimate <= 2.5 * m && zeros != 0)
+      estimate= m * log(m / zeros);
+    return static_cast<ulonglong>(estimate + 0.5);
+  }
+
+  /** Size of the serialized sketch, see registers(). */
+  static size_t serialized_size() { return HLL_REGISTERS; }
+
+  /**
+    The register array, HLL_REGISTERS bytes. A sketch can be stored by
+    copying these bytes, and restored with load().
+  */
+  const uchar *registers() const { return m_registers; }
+
+  /** Restore a sketch from serialized_size() bytes saved from registers(). */
+  void load(const uchar *registers)
+  { memcpy(m_registers, registers, sizeof(m_registers)); }
+
+  /**
+    Finalization mix of MurmurHash3, turns a hash with poorly distributed
+    bits (or a plain integer) into a well distributed 64 bit hash.
+  */
+  static ulonglong mix(ulonglong k)
+  {
+    k^= k >> 33;
+    k*= 0xff51afd7ed558ccdULL;
+    k^= k >> 33;
+    k*= 0xc4ceb9fe1a85ec53ULL;
+    k^= k >> 33;
+    return k;
+  }
+
+  /** Combine hashes of the columns of a multi-column value. */
+  static ulonglong combine(ulonglong seed, ulonglong hash)
+  {
+    return mix(seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                       (seed >> 2)));
+  }
+
+private:
+  uchar m_registers[HLL_REGISTERS];
+};
+
+#endif  // HYPERLOGLOG_INCLUDED
@@ -9095,6 +9095,15 @@ longlong Item_cache_datetime::val_int()
   return val_int_from_decimal();
 }
 
+void Item_cache_real::store(Item *item, double val_arg)
+{
+  /* An explicit value is given, save it. */
+  value_cached= TRUE;
+  value= val_arg;
+  null_value= item->null_value;
+}
+
+
 bool Item_cache_real::cache_value()
 {
   if (!example)
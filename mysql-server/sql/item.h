@@ -4830,6 +4830,8 @@ public:
   Item_cache_real(): Item_cache(),
     value(0) {}
 
+  virtual void store(Item *item){ Item_cache::store(item); }
+  void store(Item *item, double val_arg);
   double val_real();
   longlong val_int();
   String* val_str(String *str);
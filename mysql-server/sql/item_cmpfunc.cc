@@ -30,6 +30,7 @@
 #include "opt_trace.h"
 #include "parse_tree_helpers.h"
 #include "template_utils.h"
+#include "histograms.h"                // get_histogram_filtering_effect
 
 #include <algorithm>
 using std::min;
@@ -2248,6 +2249,11 @@ float Item_func_ne::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::NOT_EQUALS_TO,
+                                      &filter))
+    return filter;
+
   return 1.0f - fld->get_cond_filter_default_probability(rows_in_table,
                                                          COND_FILTER_EQUALITY);
 }
@@ -2283,6 +2289,11 @@ float Item_func_ge::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld,
+                                      Histogram::GREATER_THAN_OR_EQUAL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2297,6 +2308,11 @@ float Item_func_lt::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::LESS_THAN,
+                                      &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2311,6 +2327,11 @@ float Item_func_le::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld,
+                                      Histogram::LESS_THAN_OR_EQUAL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2325,6 +2346,11 @@ float Item_func_gt::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::GREATER_THAN,
+                                      &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2804,6 +2830,13 @@ Item_func_between::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float histogram_filter;
+  if (!get_histogram_filtering_effect(this, fld,
+                                      negated ? Histogram::NOT_BETWEEN :
+                                                Histogram::BETWEEN,
+                                      &histogram_filter))
+    return histogram_filter;
+
   const float filter=
     fld->get_cond_filter_default_probability(rows_in_table,
                                              COND_FILTER_BETWEEN);
@@ -4804,6 +4837,20 @@ float Item_func_in::get_filtering_effect(table_map filter_for_table,
     DBUG_ASSERT(args[0]->type() == FIELD_ITEM || args[0]->type() == REF_ITEM);
     Item_ident *fieldref= static_cast<Item_ident*>(args[0]);
 
+    /*
+      A histogram of the column gives the selectivity of the whole list,
+      taking the frequency of each value into account.
+    */
+    const Item_field *fld= static_cast<Item_field*>(fieldref->real_item());
+    float histogram_filter;
+    if (fieldref->used_tables() == filter_for_table &&
+        !bitmap_is_set(fields_to_ignore, fld->field->field_index) &&
+        !get_histogram_filtering_effect(this, fld,
+                                        negated ? Histogram::NOT_IN_LIST :
+                                                  Histogram::IN_LIST,
+                                        &histogram_filter))
+      return histogram_filter;
+
     const float tmp_filt= get_single_col_filtering_effect(fieldref,
                                                           filter_for_table,
                                                           fields_to_ignore,
@@ -5814,6 +5861,10 @@ float Item_func_isnull::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::IS_NULL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_EQUALITY);
 }
@@ -5888,6 +5939,11 @@ Item_func_isnotnull::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::IS_NOT_NULL,
+                                      &filter))
+    return filter;
+
   return 1.0f - fld->get_cond_filter_default_probability(rows_in_table,
                                                          COND_FILTER_EQUALITY);
 }
@@ -7001,8 +7057,14 @@ float Item_equal::get_filtering_effect(table_map filter_for_table,
           cur_field->get_cond_filter_default_probability(rows_in_table,
                                                          COND_FILTER_EQUALITY);
 
-        // Use index statistics if available for this field
-        if (!cur_field->field->key_start.is_clear_all())
+        // Use the histogram of the column if there is one
+        const bool use_histogram=
+          const_item &&
+          !get_histogram_equality_effect(this, cur_field, const_item,
+                                         &cur_filter);
+
+        // Otherwise use index statistics if available for this field
+        if (!use_histogram && !cur_field->field->key_start.is_clear_all())
         { 
           // cur_field is indexed - there may be statistics for it.
           const TABLE *tab= cur_field->field->table;
@@ -7413,6 +7475,11 @@ float Item_func_eq::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!get_histogram_filtering_effect(this, fld, Histogram::EQUALS_TO,
+                                      &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_EQUALITY);
 }
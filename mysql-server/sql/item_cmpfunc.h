@@ -1867,6 +1867,8 @@ public:
                  using "expr LIKE pat ESCAPE 'escape_char'" syntax
   */
   bool escape_was_used_in_parsing() const { return escape_used_in_parsing; }
+  /// The ESCAPE argument, or the default escape character if none was given
+  Item *get_escape_item() const { return escape_item; }
 
   float get_filtering_effect(table_map filter_for_table,
                              table_map read_tables,
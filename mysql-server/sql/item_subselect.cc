@@ -42,6 +42,9 @@
 #include "sql_optimizer.h"                      // JOIN
 #include "opt_explain_format.h"
 #include "parse_tree_nodes.h"
+#include "key_hash_set.h"                       // Key_hash_set
+#include "sql_base.h"                           // fill_record
+#include "sql_tmp_table.h"                      // instantiate_tmp_table
 
 Item_subselect::Item_subselect():
   Item_result_field(), value_assigned(0), traced_before(false),
@@ -3489,13 +3492,190 @@ bool subselect_indexsubquery_engine::no_tables() const
 ******************************************************************************/
 
 
+/// Can values of this type be kept in subselect_hash_sj_engine::hash_set?
+
+static bool is_hash_set_int_type(enum_field_types type)
+{
+  switch (type)
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+/**
+  Result sink of subselect_hash_sj_engine.
+
+  Without a hash set, it writes the rows into the temporary table like
+  select_union does. With a hash set, the temporary table is not created:
+  the values of the single integer column are inserted into the set, and
+  a NULL value is only remembered. When the set is full, the temporary
+  table is created and filled with the values of the set, the set is
+  freed, and this row and all later rows are written to the table.
+*/
+
+class select_materialize_hash_set :public select_union
+{
+public:
+  explicit select_materialize_hash_set(ulonglong options)
+    :table_options(options), hash_set(NULL), has_nulls(false)
+  {}
+  bool create_table();
+  /**
+    Insert the values into 'set' instead of writing them into the
+    temporary table, which must not be created yet.
+
+    @param set  Initialized hash set
+  */
+  void set_hash_set(Key_hash_set *set) { hash_set= set; }
+  /// Has a NULL value been sent while the hash set was used?
+  bool hash_set_has_nulls() const { return has_nulls; }
+  bool send_data(List<Item> &items);
+  void cleanup();
+
+private:
+  bool spill_hash_set();
+  bool write_row();
+
+  /// Options to create the temporary table with
+  const ulonglong table_options;
+  /// Set receiving the values, or NULL if they go to the temporary table
+  Key_hash_set *hash_set;
+  bool has_nulls;
+};
+
+
+/**
+  Create the temporary table, which create_result_table() has only
+  described.
+
+  @retval true   error
+  @retval false  OK
+*/
+
+bool select_materialize_hash_set::create_table()
+{
+  if (instantiate_tmp_table(table, table->key_info,
+                            tmp_table_param.start_recinfo,
+                            &tmp_table_param.recinfo, table_options,
+                            thd->variables.big_tables, &thd->opt_trace))
+    return true;
+  table->file->extra(HA_EXTRA_WRITE_CACHE);
+  table->file->extra(HA_EXTRA_IGNORE_DUP_KEY);
+  if (table->hash_field)
+    table->file->ha_index_init(0, 0);
+  return false;
+}
+
+
+bool select_materialize_hash_set::send_data(List<Item> &values)
+{
+  if (hash_set == NULL)
+    return select_union::send_data(values);
+
+  fill_record(thd, table->field, values, NULL, NULL);
+  if (thd->is_error())
+    return true;
+
+  Field *const field= table->field[0];
+  if (field->is_null())
+  {
+    has_nulls= true;
+    return false;
+  }
+  const longlong value= field->val_int();
+  if (hash_set->insert((const uchar*) &value) != Key_hash_set::SET_FULL)
+    return false;
+
+  if (spill_hash_set())
+    return true;
+  field->store(value, field->flags & UNSIGNED_FLAG);
+  return write_row();
+}
+
+
+/**
+  Create the temporary table, move the values of the hash set into it,
+  and free the set.
+
+  @retval true   error
+  @retval false  OK
+*/
+
+bool select_materialize_hash_set::spill_hash_set()
+{
+  Field *const field= table->field[0];
+  const bool is_unsigned= field->flags & UNSIGNED_FLAG;
+
+  if (create_table())
+    return true;
+  if (has_nulls)
+  {
+    field->set_null();
+    if (write_row())
+      return true;
+  }
+  field->set_notnull();
+
+  const uchar *key;
+  for (ulong pos= 0; (key= hash_set->next_key(&pos)); )
+  {
+    longlong value;
+    memcpy(&value, key, sizeof(value));
+    field->store(value, is_unsigned);
+    if (write_row())
+      return true;
+  }
+  hash_set->free();
+  hash_set= NULL;
+  return false;
+}
+
+
+/**
+  Write record[0] into the temporary table, converting the table to an
+  on-disk table if it is full.
+
+  @retval true   error
+  @retval false  OK
+*/
+
+bool select_materialize_hash_set::write_row()
+{
+  int error;
+  if ((error= table->file->ha_write_row(table->record[0])) &&
+      !table->file->is_ignorable_error(error) &&
+      create_ondisk_from_heap(thd, table, tmp_table_param.start_recinfo,
+                              &tmp_table_param.recinfo, error, TRUE, NULL))
+    return true;
+  return false;
+}
+
+
+void select_materialize_hash_set::cleanup()
+{
+  hash_set= NULL;
+  has_nulls= false;
+  if (table != NULL && table->is_created())
+    select_union::cleanup();
+}
+
+
 /**
   Create all structures needed for subquery execution using hash semijoin.
 
   @detail
   - Create a temporary table to store the result of the IN subquery. The
     temporary table has one hash index on all its columns. If single-column,
-    the index allows at most one NULL row.
+    the index allows at most one NULL row. If the values are kept in a hash
+    set, the table is described but not created.
   - Create a new result sink that sends the result stream of the subquery to
     the temporary table,
   - Create and initialize a new JOIN_TAB, and TABLE_REF objects to perform
@@ -3514,7 +3694,7 @@ bool subselect_indexsubquery_engine::no_tables() const
 bool subselect_hash_sj_engine::setup(List<Item> *tmp_columns)
 {
   /* The result sink where we will materialize the subquery result. */
-  select_union  *tmp_result_sink;
+  select_materialize_hash_set *tmp_result_sink;
   /* The table into which the subquery is materialized. */
   TABLE         *tmp_table;
   KEY           *tmp_key; /* The only index on the temporary table. */
@@ -3529,15 +3709,18 @@ bool subselect_hash_sj_engine::setup(List<Item> *tmp_columns)
   /*
     Create and initialize a select result interceptor that stores the
     result stream in a temporary table. The temporary table itself is
-    managed (created/filled/etc) internally by the interceptor.
+    managed (created/filled/etc) internally by the interceptor. It is
+    created at the end of this function, unless the values are kept in
+    a hash set.
   */
-  if (!(tmp_result_sink= new select_union))
-    DBUG_RETURN(TRUE);
   THD * const thd= item->unit->thd;
+  const ulonglong tmp_options=
+    thd->variables.option_bits | TMP_TABLE_ALL_COLUMNS;
+  if (!(tmp_result_sink= new select_materialize_hash_set(tmp_options)))
+    DBUG_RETURN(TRUE);
   if (tmp_result_sink->create_result_table(
-                         thd, tmp_columns, true,
-                         thd->variables.option_bits | TMP_TABLE_ALL_COLUMNS,
-                         "materialized-subquery", true, true))
+                         thd, tmp_columns, true, tmp_options,
+                         "materialized-subquery", true, false))
     DBUG_RETURN(TRUE);
 
   tmp_table= tmp_result_sink->table;
@@ -3693,6 +3876,42 @@ bool subselect_hash_sj_engine::setup(List<Item> *tmp_columns)
   if (cond->fix_fields(thd, &cond))
     DBUG_RETURN(TRUE);
 
+  /*
+    If the subquery returns a single integer column, and the outer
+    expression is an integer too, the subquery is materialized into a hash
+    set, and lookups are done by value in the set instead of in the index
+    of the temporary table. The table is only created and filled if the
+    set gets full; see select_materialize_hash_set.
+  */
+  if (tmp_key_parts == 1 && !tmp_table->hash_field &&
+      is_hash_set_int_type(tmp_table->field[0]->type()))
+  {
+    Item *const outer= item_in->left_expr->element_index(0);
+    if (outer->result_type() == INT_RESULT && !outer->is_temporal() &&
+        is_hash_set_int_type(outer->field_type()))
+    {
+      hash_set= new (thd->mem_root)
+        Key_hash_set(key_memory_subselect_hash_set, sizeof(longlong),
+                     min(thd->variables.tmp_table_size,
+                         thd->variables.max_heap_table_size));
+      if (hash_set == NULL)
+        DBUG_RETURN(TRUE);
+      if (hash_set->init())
+      {
+        // The set can't even start within the limit: use the table
+        delete hash_set;
+        hash_set= NULL;
+      }
+      else
+      {
+        hash_set_unsigned= tmp_table->field[0]->flags & UNSIGNED_FLAG;
+        tmp_result_sink->set_hash_set(hash_set);
+      }
+    }
+  }
+  if (hash_set == NULL && tmp_result_sink->create_table())
+    DBUG_RETURN(TRUE);
+
   // Set 'tab' only when function cannot fail, because of assert in destructor
   tab= tmp_tab;
 
@@ -3738,6 +3957,9 @@ void subselect_hash_sj_engine::cleanup()
   free_tmp_table(thd, table);
   // Note that tab->qep_cleanup() is not called
   tab= NULL;
+  delete hash_set;
+  hash_set= NULL;
+  use_hash_set= false;
   materialize_engine->cleanup();
   DBUG_VOID_RETURN;
 }
@@ -3788,18 +4010,33 @@ bool subselect_hash_sj_engine::exec()
      */
     is_materialized= TRUE;
 
-    // Calculate row count:
-    table->file->info(HA_STATUS_VARIABLE);
-
-    if (!(table->file->ha_table_flags() & HA_STATS_RECORDS_IS_EXACT))
+    if (hash_set != NULL && hash_set->is_initialized())
+    {
+      // All values are in the set, the table has not been created
+      select_materialize_hash_set *const sink=
+        static_cast<select_materialize_hash_set *>(result);
+      use_hash_set= true;
+      table->file->stats.records=
+        hash_set->elements() + (sink->hash_set_has_nulls() ? 1 : 0);
+      if (mat_table_has_nulls == NEX_UNKNOWN)
+        mat_table_has_nulls=
+          sink->hash_set_has_nulls() ? NEX_TRUE : NEX_IRRELEVANT_OR_FALSE;
+    }
+    else
     {
-      // index must be closed before ha_records() is called
-      if (table->file->inited)
-        table->file->ha_index_or_rnd_end();
-      ha_rows num_rows= 0;
-      table->file->ha_records(&num_rows);
-      table->file->stats.records= num_rows;
-      res= thd->is_error();
+      // Calculate row count:
+      table->file->info(HA_STATUS_VARIABLE);
+
+      if (!(table->file->ha_table_flags() & HA_STATS_RECORDS_IS_EXACT))
+      {
+        // index must be closed before ha_records() is called
+        if (table->file->inited)
+          table->file->ha_index_or_rnd_end();
+        ha_rows num_rows= 0;
+        table->file->ha_records(&num_rows);
+        table->file->stats.records= num_rows;
+        res= thd->is_error();
+      }
     }
 
     /* Set tmp_param only if its usable, i.e. tmp_param->copy_field != NULL. */
@@ -3841,7 +4078,19 @@ err:
     DBUG_RETURN(false);
   }
 
-  if (subselect_indexsubquery_engine::exec())  // Search with index
+  if (use_hash_set)
+  {
+    Item *const outer= item_in->left_expr->element_index(0);
+    const longlong value= outer->val_int();
+    /*
+      Values are stored as longlong, so a negative signed value and a big
+      unsigned value may have the same image; they are never equal.
+    */
+    item_in->value= (outer->unsigned_flag == hash_set_unsigned ||
+                     value >= 0) &&
+                    hash_set->contains((const uchar*) &value);
+  }
+  else if (subselect_indexsubquery_engine::exec())  // Search with index
     DBUG_RETURN(true);
 
   if (!item_in->value && // no exact match
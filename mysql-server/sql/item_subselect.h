@@ -24,6 +24,7 @@ class JOIN;
 class select_result_interceptor;
 class subselect_engine;
 class subselect_hash_sj_engine;
+class Key_hash_set;
 class Item_bool_func2;
 class Cached_item;
 class Comp_creator;
@@ -790,13 +791,24 @@ private:
   subselect_single_select_engine *materialize_engine;
   /* Temp table context of the outer select's JOIN. */
   Temp_table_param *tmp_param;
+  /**
+    Set that the subquery is materialized into instead of the temp table,
+    for lookups without handler calls. NULL if the subquery does not
+    return a single integer column.
+  */
+  Key_hash_set *hash_set;
+  /// True if hash_set holds all values of the subquery
+  bool use_hash_set;
+  /// Whether the values in hash_set are UNSIGNED
+  bool hash_set_unsigned;
 
 public:
   subselect_hash_sj_engine(THD *thd, Item_subselect *in_predicate,
                            subselect_single_select_engine *old_engine)
     :subselect_indexsubquery_engine(thd, NULL, in_predicate, NULL,
                                     NULL, false, true),
-    is_materialized(false), materialize_engine(old_engine), tmp_param(NULL)
+    is_materialized(false), materialize_engine(old_engine), tmp_param(NULL),
+    hash_set(NULL), use_hash_set(false), hash_set_unsigned(false)
   {}
   ~subselect_hash_sj_engine();
 
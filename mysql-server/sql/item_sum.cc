@@ -30,6 +30,7 @@
 #include "parse_tree_helpers.h"
 #include "parse_tree_nodes.h"
 #include "aggregate_check.h"
+#include "sql_batch.h"                     // Batch_column
 
 using std::min;
 using std::max;
@@ -989,6 +990,13 @@ bool Aggregator_distinct::setup(THD *thd)
       */
       if (! tree)
         return TRUE;
+      /*
+        COUNT(DISTINCT) only needs the number of distinct keys, never the
+        keys in order, so binary comparable keys can be collected in a
+        hash set. If it can not be allocated, the tree is used.
+      */
+      if (all_binary)
+        (void) tree->enable_hash_set();
     }
     return FALSE;
   }
@@ -1531,6 +1539,99 @@ bool Item_sum_sum::add()
 }
 
 
+/**
+  Add an integer to a decimal sum, the way Item_sum_sum::add() does.
+*/
+
+static void add_int_to_decimal_sum(my_decimal *dec_buffs, uint *curr_dec_buff,
+                                   longlong value, bool unsigned_value)
+{
+  my_decimal dec;
+  int2my_decimal(E_DEC_FATAL_ERROR, value, unsigned_value, &dec);
+  my_decimal_add(E_DEC_FATAL_ERROR, dec_buffs + (*curr_dec_buff^1),
+                 &dec, dec_buffs + *curr_dec_buff);
+  *curr_dec_buff^= 1;
+}
+
+
+/**
+  Add the selected rows of a batch.
+
+  Integers are summed in a longlong, which is added to the decimal sum
+  at the end of the batch or when the next value would overflow it.
+  Doubles are added one at a time in row order, so that the sum is
+  rounded exactly as with add().
+*/
+
+void Item_sum_sum::add_batch(const Batch_column *column, const uint16 *rows,
+                             uint count)
+{
+  DBUG_ENTER("Item_sum_sum::add_batch");
+  DBUG_ASSERT(column != NULL);
+  if (hybrid_type != DECIMAL_RESULT)
+  {
+    DBUG_ASSERT(column->is_real);
+    for (uint i= 0; i < count; i++)
+    {
+      if (!column->is_null(rows[i]))
+      {
+        sum+= column->real_values[rows[i]];
+        null_value= 0;
+      }
+    }
+    DBUG_VOID_RETURN;
+  }
+
+  DBUG_ASSERT(!column->is_real);
+  bool found= false;
+  if (column->is_unsigned)
+  {
+    ulonglong partial= 0;
+    for (uint i= 0; i < count; i++)
+    {
+      if (column->is_null(rows[i]))
+        continue;
+      const ulonglong value=
+        static_cast<ulonglong>(column->int_values[rows[i]]);
+      if (partial > ULONGLONG_MAX - value)
+      {
+        add_int_to_decimal_sum(dec_buffs, &curr_dec_buff,
+                               static_cast<longlong>(partial), true);
+        partial= 0;
+      }
+      partial+= value;
+      found= true;
+    }
+    if (found)
+      add_int_to_decimal_sum(dec_buffs, &curr_dec_buff,
+                             static_cast<longlong>(partial), true);
+  }
+  else
+  {
+    longlong partial= 0;
+    for (uint i= 0; i < count; i++)
+    {
+      if (column->is_null(rows[i]))
+        continue;
+      const longlong value= column->int_values[rows[i]];
+      if ((value > 0 && partial > LONGLONG_MAX - value) ||
+          (value < 0 && partial < LONGLONG_MIN - value))
+      {
+        add_int_to_decimal_sum(dec_buffs, &curr_dec_buff, partial, false);
+        partial= 0;
+      }
+      partial+= value;
+      found= true;
+    }
+    if (found)
+      add_int_to_decimal_sum(dec_buffs, &curr_dec_buff, partial, false);
+  }
+  if (found)
+    null_value= 0;
+  DBUG_VOID_RETURN;
+}
+
+
 longlong Item_sum_sum::val_int()
 {
   DBUG_ASSERT(fixed == 1);
@@ -1708,6 +1809,20 @@ bool Item_sum_count::add()
   return 0;
 }
 
+
+void Item_sum_count::add_batch(const Batch_column *column, const uint16 *rows,
+                               uint count_arg)
+{
+  if (column == NULL)
+  {
+    // COUNT(*) or COUNT(<constant>)
+    if (!args[0]->is_null())
+      count+= count_arg;
+  }
+  else
+    count+= column->count_not_null(rows, count_arg);
+}
+
 longlong Item_sum_count::val_int()
 {
   DBUG_ASSERT(fixed == 1);
@@ -2085,6 +2200,88 @@ void Item_sum_hybrid::clear()
   null_value= 1;
 }
 
+
+/**
+  Find the smallest or largest non-NULL value among the selected rows.
+
+  @returns false if all the values are NULL
+*/
+
+template <typename T>
+static bool batch_min_max(const T *values, const bool *nulls,
+                          const uint16 *rows, uint count, bool is_min,
+                          T *result)
+{
+  bool found= false;
+  T best= 0;
+  for (uint i= 0; i < count; i++)
+  {
+    const uint16 row= rows[i];
+    if (nulls != NULL && nulls[row])
+      continue;
+    const T value= values[row];
+    /* Strict comparisons keep the first of equal values, as add() does */
+    if (!found || (is_min ? value < best : value > best))
+    {
+      best= value;
+      found= true;
+    }
+  }
+  *result= best;
+  return found;
+}
+
+
+void Item_sum_hybrid::add_batch(const Batch_column *column, const uint16 *rows,
+                                uint count)
+{
+  DBUG_ASSERT(column != NULL);
+  const bool is_min= sum_func() == MIN_FUNC;
+  if (column->is_real)
+  {
+    double best;
+    if (!batch_min_max(column->real_values, column->nulls, rows, count, is_min,
+                       &best))
+      return;
+    if (null_value ||
+        (is_min ? best < value->val_real() : best > value->val_real()))
+    {
+      down_cast<Item_cache_real*>(value)->store(args[0], best);
+      value->null_value= false;         // args[0] may hold a later NULL row
+      null_value= 0;
+    }
+  }
+  else if (column->is_unsigned)
+  {
+    ulonglong best;
+    if (!batch_min_max(reinterpret_cast<const ulonglong*>(column->int_values),
+                       column->nulls, rows, count, is_min, &best))
+      return;
+    const ulonglong current= static_cast<ulonglong>(value->val_int());
+    if (null_value || (is_min ? best < current : best > current))
+    {
+      down_cast<Item_cache_int*>(value)->store(args[0],
+                                               static_cast<longlong>(best));
+      value->null_value= false;
+      null_value= 0;
+    }
+  }
+  else
+  {
+    longlong best;
+    if (!batch_min_max(column->int_values, column->nulls, rows, count, is_min,
+                       &best))
+      return;
+    const longlong current= value->val_int();
+    if (null_value || (is_min ? best < current : best > current))
+    {
+      down_cast<Item_cache_int*>(value)->store(args[0], best);
+      value->null_value= false;
+      null_value= 0;
+    }
+  }
+}
+
 double Item_sum_hybrid::val_real()
 {
   DBUG_ASSERT(fixed == 1);
@@ -2303,6 +2500,113 @@ bool Item_sum_and::add()
   return 0;
 }
 
+/*
+  APPROX_COUNT_DISTINCT
+*/
+
+Item *Item_sum_approx_count_distinct::copy_or_same(THD* thd)
+{
+  return new (thd->mem_root) Item_sum_approx_count_distinct(thd, this);
+}
+
+
+/**
+  Compute a 64 bit hash of the current value of an argument.
+
+  Values that COUNT(DISTINCT) would consider equal get equal hashes:
+  numbers are hashed by value and strings with the hash function of
+  their collation.
+
+  @param       arg   argument to evaluate
+  @param[out]  hash  hash of the value
+
+  @retval false  hash computed
+  @retval true   the value is NULL
+*/
+
+bool Item_sum_approx_count_distinct::hash_arg(Item *arg, ulonglong *hash)
+{
+  switch (arg->result_type()) {
+  case INT_RESULT:
+  {
+    const longlong nr= arg->val_int();
+    if (arg->null_value)
+      return true;
+    *hash= Hyperloglog::mix(static_cast<ulonglong>(nr));
+    return false;
+  }
+  case REAL_RESULT:
+  {
+    double nr= arg->val_real();
+    if (arg->null_value)
+      return true;
+    if (nr == 0.0)
+      nr= 0.0;                                  // Hash -0.0 like 0.0
+    ulonglong bits;
+    memcpy(&bits, &nr, sizeof(bits));
+    *hash= Hyperloglog::mix(bits);
+    return false;
+  }
+  case DECIMAL_RESULT:
+  {
+    my_decimal value_buff;
+    my_decimal *dec= arg->val_decimal(&value_buff);
+    if (arg->null_value)
+      return true;
+    /* The binary image is unique for a given precision and scale */
+    uchar bin[DECIMAL_MAX_FIELD_SIZE];
+    const uint precision= arg->decimal_precision();
+    const uint scale= arg->decimals;
+    my_decimal2binary(E_DEC_FATAL_ERROR, dec, bin, precision, scale);
+    ulong nr1= 1, nr2= 4;
+    my_charset_bin.coll->hash_sort(&my_charset_bin, bin,
+                                   my_decimal_get_binary_size(precision,
+                                                              scale),
+                                   &nr1, &nr2);
+    *hash= Hyperloglog::mix(nr1);
+    return false;
+  }
+  case STRING_RESULT:
+  default:
+  {
+    char buff[MAX_FIELD_WIDTH];
+    String tmp(buff, sizeof(buff), &my_charset_bin);
+    String *res= arg->val_str(&tmp);
+    if (arg->null_value)
+      return true;
+    const CHARSET_INFO *cs= res->charset();
+    ulong nr1= 1, nr2= 4;
+    cs->coll->hash_sort(cs, pointer_cast<const uchar*>(res->ptr()),
+                        res->length(), &nr1, &nr2);
+    *hash= Hyperloglog::mix(nr1);
+    return false;
+  }
+  }
+}
+
+
+bool Item_sum_approx_count_distinct::add()
+{
+  ulonglong hash= 0;
+  for (uint i= 0; i < arg_count; i++)
+  {
+    ulonglong arg_hash;
+    if (hash_arg(args[i], &arg_hash))
+      return false;                             // Don't count NULL
+    hash= (i == 0) ? arg_hash : Hyperloglog::combine(hash, arg_hash);
+  }
+  sketch.add(hash);
+  return false;
+}
+
+
+longlong Item_sum_approx_count_distinct::val_int()
+{
+  DBUG_ASSERT(fixed == 1);
+  return static_cast<longlong>(sketch.estimate());
+}
+
+
 /************************************************************************
 ** reset result of a Item_sum with is saved in a tmp_table
 *************************************************************************/
@@ -21,8 +21,10 @@
 
 #include <my_tree.h>
 #include "sql_udf.h"                            /* udf_handler */
+#include "hyperloglog.h"                        /* Hyperloglog */
 
 class Item_sum;
+class Batch_column;
 class Aggregator_distinct;
 class Aggregator_simple;
 class PT_item_list;
@@ -341,7 +343,8 @@ public:
   enum Sumfunctype
   { COUNT_FUNC, COUNT_DISTINCT_FUNC, SUM_FUNC, SUM_DISTINCT_FUNC, AVG_FUNC,
     AVG_DISTINCT_FUNC, MIN_FUNC, MAX_FUNC, STD_FUNC,
-    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC
+    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC,
+    APPROX_COUNT_DISTINCT_FUNC
   };
 
   Item **ref_by; /* pointer to a ref to the object used to register it */
@@ -523,6 +526,18 @@ public:
   virtual bool add()= 0;
   virtual bool setup(THD *thd) { return false; }
 
+  /**
+    Aggregate the selected rows of a batch, see Batch_scan. Only called
+    for the functions that Batch_scan::create() accepts.
+
+    @param column  values of the argument, NULL if it is a constant
+    @param rows    indexes of the selected rows in the batch
+    @param count   number of selected rows
+  */
+  virtual void add_batch(const Batch_column *column, const uint16 *rows,
+                         uint count)
+  { DBUG_ASSERT(false); }
+
   virtual void cleanup();
 };
 
@@ -754,6 +769,7 @@ public:
   }
   void clear();
   bool add();
+  void add_batch(const Batch_column *column, const uint16 *rows, uint count);
   double val_real();
   longlong val_int();
   String *val_str(String*str);
@@ -811,6 +827,8 @@ class Item_sum_count :public Item_sum_int
     count=count_arg;
     Item_sum::make_const();
   }
+  void add_batch(const Batch_column *column, const uint16 *rows,
+                 uint count_arg);
   longlong val_int();
   void reset_field();
   void update_field();
@@ -1077,6 +1095,7 @@ protected:
   bool fix_fields(THD *, Item **);
   void setup_hybrid(Item *item, Item *value_arg);
   void clear();
+  void add_batch(const Batch_column *column, const uint16 *rows, uint count);
   double val_real();
   longlong val_int();
   longlong val_time_temporal();
@@ -1202,6 +1221,50 @@ class Item_sum_xor :public Item_sum_bit
 };
 
 
+/**
+  APPROX_COUNT_DISTINCT(expr, ...): estimate of COUNT(DISTINCT expr, ...)
+  computed with a HyperLogLog sketch in constant memory.
+
+  Rows where any argument is NULL are skipped, like COUNT(DISTINCT).
+  String arguments are hashed with the hash function of their collation,
+  so values that compare equal are counted once.
+
+  The sketch can not be updated in a tmp table field, so grouping is done
+  by sorting (quick_group is 0) and reset_field()/update_field() are
+  never called.
+*/
+
+class Item_sum_approx_count_distinct :public Item_sum_int
+{
+  Hyperloglog sketch;
+
+  bool hash_arg(Item *arg, ulonglong *hash);
+
+public:
+  Item_sum_approx_count_distinct(const POS &pos, PT_item_list *list)
+    :Item_sum_int(pos, list)
+  { quick_group= 0; }
+
+  Item_sum_approx_count_distinct(THD *thd,
+                                 Item_sum_approx_count_distinct *item)
+    :Item_sum_int(thd, item), sketch(item->sketch)
+  { quick_group= 0; }
+
+  enum Sumfunctype sum_func () const { return APPROX_COUNT_DISTINCT_FUNC; }
+  void clear() { sketch.clear(); }
+  bool add();
+  longlong val_int();
+  void no_rows_in_result() { clear(); }
+  void reset_field() { DBUG_ASSERT(0); }        // not used
+  void update_field() { DBUG_ASSERT(0); }       // not used
+  const char *func_name() const { return "approx_count_distinct("; }
+  Item *copy_or_same(THD* thd);
+
+  /** The sketch of the current group, to merge with other sketches. */
+  const Hyperloglog &get_sketch() const { return sketch; }
+};
+
+
 /*
   User defined aggregates
 */
@@ -0,0 +1,124 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "key_hash_set.h"
+#include "my_sys.h"                             // my_malloc
+#include "my_murmur3.h"                         // murmur3_32
+
+
+bool Key_hash_set::init()
+{
+  const size_t slot_size= m_key_size + 1;
+  if (m_slots != NULL && m_capacity == MIN_CAPACITY)
+  {
+    if (m_elements != 0)
+      memset(m_slots, 0, m_capacity * slot_size);
+    m_elements= 0;
+    return false;
+  }
+  free();
+  if (MIN_CAPACITY * slot_size > m_max_size)
+    return true;
+  if (!(m_slots= static_cast<uchar*>(my_malloc(m_psi_key,
+                                               MIN_CAPACITY * slot_size,
+                                               MYF(MY_ZEROFILL)))))
+    return true;
+  m_capacity= MIN_CAPACITY;
+  return false;
+}
+
+
+void Key_hash_set::free()
+{
+  my_free(m_slots);
+  m_slots= NULL;
+  m_capacity= 0;
+  m_elements= 0;
+}
+
+
+/*
+  Find the slot for a key using linear probing: either the slot holding
+  an equal key, or the first free slot.
+*/
+
+uchar *Key_hash_set::find_slot(uchar *slots, ulong capacity,
+                               const uchar *key) const
+{
+  DBUG_ASSERT(slots != NULL);
+  const size_t slot_size= m_key_size + 1;
+  ulong idx= murmur3_32(key, m_key_size, 0) & (capacity - 1);
+  for (;;)
+  {
+    uchar *slot= slots + idx * slot_size;
+    if (!slot[0] || !memcmp(slot + 1, key, m_key_size))
+      return slot;
+    idx= (idx + 1) & (capacity - 1);
+  }
+}
+
+
+/**
+  Double the number of slots and rehash all keys.
+
+  @retval false  OK
+  @retval true   The bigger set would exceed the limit, or out of memory.
+                 The old slots are left intact.
+*/
+
+bool Key_hash_set::grow()
+{
+  const size_t slot_size= m_key_size + 1;
+  const ulong new_capacity= m_capacity * 2;
+  if (new_capacity * slot_size > m_max_size)
+    return true;
+  uchar *new_slots= static_cast<uchar*>(my_malloc(m_psi_key,
+                                                  new_capacity * slot_size,
+                                                  MYF(MY_ZEROFILL)));
+  if (new_slots == NULL)
+    return true;
+
+  uchar *slot_end= m_slots + m_capacity * slot_size;
+  for (uchar *slot= m_slots; slot < slot_end; slot+= slot_size)
+  {
+    if (!slot[0])
+      continue;
+    uchar *to= find_slot(new_slots, new_capacity, slot + 1);
+    memcpy(to, slot, slot_size);
+  }
+  my_free(m_slots);
+  m_slots= new_slots;
+  m_capacity= new_capacity;
+  return false;
+}
+
+
+Key_hash_set::enum_insert_result Key_hash_set::insert(const uchar *key)
+{
+  uchar *slot= find_slot(m_slots, m_capacity, key);
+  if (slot[0])
+    return KEY_EXISTS;
+  /* Keep the load factor at or below 1/2 to keep probe sequences short */
+  if ((m_elements + 1) * 2 > m_capacity)
+  {
+    if (grow())
+      return SET_FULL;
+    slot= find_slot(m_slots, m_capacity, key);
+  }
+  slot[0]= 1;
+  memcpy(slot + 1, key, m_key_size);
+  m_elements++;
+  return KEY_INSERTED;
+}
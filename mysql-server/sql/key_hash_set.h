@@ -0,0 +1,135 @@
+#ifndef KEY_HASH_SET_INCLUDED
+#define KEY_HASH_SET_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "my_global.h"
+#include "sql_alloc.h"                          // Sql_alloc
+#include "mysql/psi/psi_memory.h"               // PSI_memory_key
+
+/**
+  An in-memory set of fixed size keys, with a limit on its memory usage.
+
+  The set uses open addressing with linear probing. Each slot is one
+  marker byte followed by the key, and keys are compared byte by byte,
+  so the set may only be used for keys whose images are equal exactly
+  when the keys are equal.
+
+  The set starts with MIN_CAPACITY slots and doubles when it is half
+  full. When it can not grow within the memory limit, insert() reports
+  it, and the owner moves the keys to some other storage, typically a
+  temporary table or a Unique tree; this is how the users of the set
+  spill to disk.
+*/
+
+class Key_hash_set : public Sql_alloc
+{
+public:
+  /// Initial number of slots. Must be a power of two.
+  static const ulong MIN_CAPACITY= 1024;
+
+  enum enum_insert_result
+  {
+    KEY_INSERTED,       ///< The key was not in the set, and has been added
+    KEY_EXISTS,         ///< An equal key was in the set already
+    SET_FULL            ///< The set can not grow to hold the key
+  };
+
+  /**
+    @param psi_key   Performance schema instrument for the slot memory
+    @param key_size  Size of each key
+    @param max_size  Memory limit for the slots
+  */
+  Key_hash_set(PSI_memory_key psi_key, size_t key_size, ulonglong max_size)
+    : m_psi_key(psi_key), m_key_size(key_size), m_max_size(max_size),
+      m_slots(NULL), m_capacity(0), m_elements(0)
+  {}
+
+  ~Key_hash_set() { free(); }
+
+  /**
+    Make the set empty and ready for insert(). The memory of a set
+    which has not grown beyond MIN_CAPACITY slots is reused.
+
+    @retval false  OK
+    @retval true   Out of memory, or MIN_CAPACITY slots exceed the limit
+  */
+  bool init();
+
+  /// Free the slots. init() must be called before the set is used again.
+  void free();
+
+  /// Has init() succeeded since the last free()?
+  bool is_initialized() const { return m_slots != NULL; }
+
+  /**
+    Add a key to the set, growing it if needed.
+
+    @param key  Key of key_size bytes
+
+    @returns whether the key was added. If SET_FULL, the set is unchanged.
+  */
+  enum_insert_result insert(const uchar *key);
+
+  /// Is there a key equal to 'key' in the set? The set must be initialized.
+  bool contains(const uchar *key) const
+  {
+    return find_slot(m_slots, m_capacity, key)[0] != 0;
+  }
+
+  /// Number of keys in the set
+  ulong elements() const { return m_elements; }
+
+  size_t key_size() const { return m_key_size; }
+
+  /**
+    Iterate over the keys in the set, in no particular order:
+
+      for (ulong pos= 0; (key= set.next_key(&pos)); )
+
+    @param[in,out] pos  Slot where the search starts; set to the slot
+                        after the returned key
+
+    @returns the next key, or NULL if there are no more keys
+  */
+  const uchar *next_key(ulong *pos) const
+  {
+    const size_t slot_size= m_key_size + 1;
+    for (; *pos < m_capacity; (*pos)++)
+    {
+      const uchar *slot= m_slots + *pos * slot_size;
+      if (slot[0])
+      {
+        (*pos)++;
+        return slot + 1;
+      }
+    }
+    return NULL;
+  }
+
+private:
+  uchar *find_slot(uchar *slots, ulong capacity, const uchar *key) const;
+  bool grow();
+
+  const PSI_memory_key m_psi_key;
+  const size_t m_key_size;
+  const ulonglong m_max_size;
+  uchar *m_slots;
+  ulong m_capacity;
+  ulong m_elements;
+};
+
+#endif /* KEY_HASH_SET_INCLUDED */
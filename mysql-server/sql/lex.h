@@ -93,6 +93,7 @@ static SYMBOL symbols[] = {
   { "BOOLEAN",                  SYM(BOOLEAN_SYM)},
   { "BOTH",                     SYM(BOTH)},
   { "BTREE",                    SYM(BTREE_SYM)},
+  { "BUCKETS",                  SYM(BUCKETS_SYM)},
   { "BY",                       SYM(BY)},
   { "BYTE",                     SYM(BYTE_SYM)},
   { "CACHE",                    SYM(CACHE_SYM)},
@@ -254,6 +255,7 @@ static SYMBOL symbols[] = {
   { "HAVING",                   SYM(HAVING)},
   { "HELP",                     SYM(HELP_SYM)},
   { "HIGH_PRIORITY",            SYM(HIGH_PRIORITY)},
+  { "HISTOGRAM",                SYM(HISTOGRAM_SYM)},
   { "HOST",                     SYM(HOST_SYM)},
   { "HOSTS",                    SYM(HOSTS_SYM)},
   { "HOUR",                     SYM(HOUR_SYM)},
@@ -490,6 +492,7 @@ static SYMBOL symbols[] = {
   { "REQUIRE",                  SYM(REQUIRE_SYM)},
   { "RESET",                    SYM(RESET_SYM)},
   { "RESIGNAL",                 SYM(RESIGNAL_SYM)},
+  { "RESOURCE",                 SYM(RESOURCE_SYM)},
   { "RESTORE",                  SYM(RESTORE_SYM)},
   { "RESTRICT",                 SYM(RESTRICT)},
   { "RESUME",                   SYM(RESUME_SYM)},
@@ -595,6 +598,7 @@ static SYMBOL symbols[] = {
   { "TEXT",                     SYM(TEXT_SYM)},
   { "THAN",                     SYM(THAN_SYM)},
   { "THEN",                     SYM(THEN_SYM)},
+  { "THREAD_PRIORITY",          SYM(THREAD_PRIORITY_SYM)},
   { "TIME",                     SYM(TIME_SYM)},
   { "TIMESTAMP",                SYM(TIMESTAMP)},
   { "TIMESTAMPADD",             SYM(TIMESTAMP_ADD)},
@@ -643,6 +647,7 @@ static SYMBOL symbols[] = {
   { "VARCHARACTER",             SYM(VARCHAR)},
   { "VARIABLES",                SYM(VARIABLES)},
   { "VARYING",                  SYM(VARYING)},
+  { "VCPU",                     SYM(VCPU_SYM)},
   { "WAIT",                     SYM(WAIT_SYM)},
   { "WARNINGS",                 SYM(WARNINGS)},
   { "WEEK",                     SYM(WEEK_SYM)},
@@ -670,6 +675,7 @@ static SYMBOL symbols[] = {
 
 static SYMBOL sql_functions[] = {
   { "ADDDATE",                  SYM(ADDDATE_SYM)},
+  { "APPROX_COUNT_DISTINCT",    SYM(APPROX_COUNT_DISTINCT_SYM)},
   { "BIT_AND",                  SYM(BIT_AND)},
   { "BIT_OR",                   SYM(BIT_OR)},
   { "BIT_XOR",                  SYM(BIT_XOR)},
@@ -30,6 +30,7 @@
 #include <functional>
 
 static PSI_memory_key key_memory_MDL_context_acquire_locks;
+static PSI_memory_key key_memory_MDL_lock_fast_path_shards;
 
 #ifdef HAVE_PSI_INTERFACE
 static PSI_mutex_key key_MDL_wait_LOCK_wait_status;
@@ -57,7 +58,8 @@ static PSI_cond_info all_mdl_conds[]=
 
 static PSI_memory_info all_mdl_memory[]=
 {
-  { &key_memory_MDL_context_acquire_locks, "MDL_context::acquire_locks", 0}
+  { &key_memory_MDL_context_acquire_locks, "MDL_context::acquire_locks", 0},
+  { &key_memory_MDL_lock_fast_path_shards, "MDL_lock::fast_path_shards", 0}
 };
 
 /**
@@ -792,7 +794,9 @@ public:
     MDL_lock::reinit(). So @sa MDL_lock::reiniti()
   */
   MDL_lock()
-    : m_obtrusive_locks_granted_waiting_count(0)
+    : m_obtrusive_locks_granted_waiting_count(0),
+      m_fast_path_shards(NULL),
+      m_fast_path_shards_buffer(NULL)
   {
     mysql_prlock_init(key_MDL_lock_rwlock, &m_rwlock);
   }
@@ -801,6 +805,7 @@ public:
 
   ~MDL_lock()
   {
+    my_free(m_fast_path_shards_buffer);
     mysql_prlock_destroy(&m_rwlock);
   }
 
@@ -859,9 +864,21 @@ public:
   */
   static const fast_path_state_t HAS_SLOW_PATH= 1ULL << 60;
   /**
-    Combination of IS_DESTROYED/HAS_OBTRUSIVE/HAS_SLOW_PATH flags and packed
-    counters of specific types of "unobtrusive" locks which were granted using
-    "fast path".
+    Flag in MDL_lock::m_fast_path_state that indicates that "unobtrusive"
+    locks are acquired on "fast path" by incrementing packed counters in
+    m_fast_path_shards rather than in m_fast_path_state.
+    Set using atomic compare-and-swap AND under protection of
+    MDL_lock::m_rwlock lock. Cleared only when there are no locks counted
+    in the shards, so while it is set the MDL_lock object is used.
+
+    @sa MDL_lock::fast_path_shard_add().
+  */
+  static const fast_path_state_t IS_SHARDED=
+    static_cast<fast_path_state_t>(1ULL << 63);
+  /**
+    Combination of IS_DESTROYED/HAS_OBTRUSIVE/HAS_SLOW_PATH/IS_SHARDED flags
+    and packed counters of specific types of "unobtrusive" locks which were
+    granted using "fast path".
 
     @sa MDL_scoped_lock::m_unobtrusive_lock_increment and
         MDL_object_lock::m_unobtrusive_lock_increment for details about how
@@ -904,14 +921,16 @@ public:
                            fast_path_state_t new_state)
   {
     /*
-      IS_DESTROYED, HAS_OBTRUSIVE and HAS_SLOW_PATH flags can be set or
-      cleared only while holding MDL_lock::m_rwlock lock.
+      IS_DESTROYED, HAS_OBTRUSIVE, HAS_SLOW_PATH and IS_SHARDED flags can
+      be set or cleared only while holding MDL_lock::m_rwlock lock.
       If HAS_SLOW_PATH flag is set all changes to m_fast_path_state
       should happen under protection of MDL_lock::m_rwlock ([INV1]).
     */
 #if !defined(DBUG_OFF)
-    if (((*old_state & (IS_DESTROYED | HAS_OBTRUSIVE | HAS_SLOW_PATH)) !=
-         (new_state & (IS_DESTROYED | HAS_OBTRUSIVE | HAS_SLOW_PATH))) ||
+    if (((*old_state & (IS_DESTROYED | HAS_OBTRUSIVE | HAS_SLOW_PATH |
+                        IS_SHARDED)) !=
+         (new_state & (IS_DESTROYED | HAS_OBTRUSIVE | HAS_SLOW_PATH |
+                       IS_SHARDED))) ||
         *old_state & HAS_OBTRUSIVE)
     {
       mysql_prlock_assert_write_owner(&m_rwlock);
@@ -960,6 +979,72 @@ public:
     my_atomic_store64(&m_fast_path_state, 0);
   }
 
+  /** Number of shards of "fast path" counters in m_fast_path_shards. */
+  static const uint FAST_PATH_SHARDS= 32;
+  /**
+    Number of failed compare-and-swap operations on m_fast_path_state during
+    "fast path" acquisitions after which the lock becomes sharded.
+  */
+  static const int32 FAST_PATH_SHARDING_THRESHOLD= 100;
+
+  /**
+    Packed counters of "unobtrusive" locks of the contexts which use one
+    shard, in a cache line of their own.
+  */
+  struct Fast_path_shard
+  {
+    /** Same packing as m_fast_path_state, without flags. */
+    volatile fast_path_state_t m_state;
+    /** Releases in progress, @sa MDL_lock::fast_path_shard_sub(). */
+    volatile int64 m_releasing;
+    char m_pad[CPU_LEVEL1_DCACHE_LINESIZE - 2 * sizeof(int64)];
+  };
+
+  /**
+    "Fast path" counters of sharded locks. With many concurrent "fast path"
+    acquisitions of the same lock, like DML statements on a hot table, the
+    cache line holding m_fast_path_state bounces between CPUs. A sharded
+    lock counts "unobtrusive" locks of each MDL_context in the shard of the
+    context instead (@sa IS_SHARDED), so that these statements don't write
+    to the cache line of m_fast_path_state.
+
+    Allocated when the lock becomes sharded for the first time and kept
+    until the MDL_lock object is deallocated. NULL before that.
+  */
+  Fast_path_shard * volatile m_fast_path_shards;
+  /** Memory of m_fast_path_shards, which is aligned on a cache line. */
+  uchar *m_fast_path_shards_buffer;
+  /**
+    Number of failed compare-and-swap operations on m_fast_path_state
+    since the lock was last drained.
+  */
+  volatile int32 m_fast_path_contention;
+
+  bool fast_path_shard_add(uint shard, fast_path_state_t increment);
+  void fast_path_shard_sub(uint shard, fast_path_state_t increment);
+  void count_fast_path_contention();
+  void drain_fast_path_shards();
+
+  /**
+    Packed counters of all "unobtrusive" locks granted using "fast path",
+    in m_fast_path_state and in the shards.
+
+    @sa MDL_lock::fast_path_granted_bitmap() for explanation about why it
+        is safe to use non-atomic read of MDL_lock::m_fast_path_state here.
+  */
+  fast_path_state_t fast_path_granted_count() const
+  {
+    fast_path_state_t state= m_fast_path_state;
+    fast_path_state_t result= state & ~(IS_DESTROYED | HAS_OBTRUSIVE |
+                                        HAS_SLOW_PATH | IS_SHARDED);
+    if (state & IS_SHARDED)
+    {
+      for (uint i= 0; i < FAST_PATH_SHARDS; i++)
+        result+= my_atomic_load64(&m_fast_path_shards[i].m_state);
+    }
+    return result;
+  }
+
   /**
     Pointer to strategy object which defines how different types of lock
     requests should be handled for the namespace to which this lock belongs.
@@ -976,7 +1061,7 @@ public:
   */
   static bitmap_t scoped_lock_fast_path_granted_bitmap(const MDL_lock &lock)
   {
-    return (lock.m_fast_path_state & 0xFFFFFFFFFFFFFFFULL) ?
+    return (lock.fast_path_granted_count() & 0xFFFFFFFFFFFFFFFULL) ?
             MDL_BIT(MDL_INTENTION_EXCLUSIVE) : 0;
   }
 
@@ -1002,7 +1087,7 @@ public:
   static bitmap_t object_lock_fast_path_granted_bitmap(const MDL_lock &lock)
   {
     bitmap_t result= 0;
-    fast_path_state_t fps= lock.m_fast_path_state;
+    fast_path_state_t fps= lock.fast_path_granted_count();
     if (fps & 0xFFFFFULL)
       result|= MDL_BIT(MDL_SHARED);
     if (fps & (0xFFFFFULL << 20))
@@ -1441,6 +1526,10 @@ void MDL_map::remove_random_unused(MDL_context *ctx, LF_PINS *pins,
 }
 
 
+/** Shard of "fast path" locks of the next MDL_context created. */
+static int32 volatile mdl_fast_path_next_shard= 0;
+
+
 /**
   Initialize a metadata locking context.
 
@@ -1454,7 +1543,10 @@ MDL_context::MDL_context()
   m_force_dml_deadlock_weight(false),
   m_waiting_for(NULL),
   m_pins(NULL),
-  m_rand_state(UINT_MAX32)
+  m_rand_state(UINT_MAX32),
+  m_fast_path_shard(static_cast<uint>(
+                      my_atomic_add32(&mdl_fast_path_next_shard, 1)) %
+                    MDL_lock::FAST_PATH_SHARDS)
 {
   mysql_prlock_init(key_MDL_context_LOCK_waiting_for, &m_LOCK_waiting_for);
 }
@@ -1610,6 +1702,7 @@ inline void MDL_lock::reinit(const MDL_key *mdl_key)
   m_piglet_lock_count= 0;
   m_current_waiting_incompatible_idx= 0;
   m_fast_path_state= 0;
+  m_fast_path_contention= 0;
   /*
     Check that we have clean "m_granted" and "m_waiting" sets/lists in both
     cases when we have fresh and re-used object.
@@ -1620,6 +1713,174 @@ inline void MDL_lock::reinit(const MDL_key *mdl_key)
 }
 
 
+/**
+  Try to acquire an "unobtrusive" lock on "fast path" by incrementing the
+  counter in a shard. Used when the IS_SHARDED flag is set.
+
+  The increment is followed by a check that the lock is still sharded and
+  has no "obtrusive" locks. A thread requesting the first "obtrusive" lock
+  sets HAS_OBTRUSIVE before summing up the shards in can_grant_lock(). As
+  both operations are full memory barriers, either the "obtrusive" request
+  sees the increment or we see its flag. In the latter case, and if the
+  lock was drained meanwhile, the increment is taken back under m_rwlock
+  and waiters are rescheduled in case they have seen it.
+
+  @param shard      shard of the requesting MDL_context
+  @param increment  "fast path" increment of the lock type
+
+  @retval true   Lock acquired.
+  @retval false  Lock must be acquired using "slow path".
+*/
+
+bool MDL_lock::fast_path_shard_add(uint shard, fast_path_state_t increment)
+{
+  Fast_path_shard *shards= static_cast<Fast_path_shard *>(
+    my_atomic_loadptr(reinterpret_cast<void * volatile *>(
+                        &m_fast_path_shards)));
+  if (shards == NULL)
+    return false;                               /* purecov: inspected */
+
+  my_atomic_add64(&shards[shard].m_state, increment);
+
+  if ((my_atomic_load64(&m_fast_path_state) &
+       (IS_DESTROYED | HAS_OBTRUSIVE | IS_SHARDED)) == IS_SHARDED)
+    return true;
+
+  mysql_prlock_wrlock(&m_rwlock);
+  my_atomic_add64(&shards[shard].m_state, -increment);
+  if (m_obtrusive_locks_granted_waiting_count)
+    reschedule_waiters();
+  mysql_prlock_unlock(&m_rwlock);
+  return false;
+}
+
+
+/**
+  Release an "unobtrusive" lock which was counted in a shard.
+
+  Once the counter is decremented the lock can be drained and destroyed
+  by other threads, unless we are still accounted for in m_releasing
+  of the shard which drain_fast_path_shards() checks as well.
+
+  @param shard      shard of the MDL_context which owns the lock
+  @param increment  "fast path" increment of the lock type
+*/
+
+void MDL_lock::fast_path_shard_sub(uint shard, fast_path_state_t increment)
+{
+  Fast_path_shard *fps= &m_fast_path_shards[shard];
+
+  my_atomic_add64(&fps->m_releasing, 1);
+  my_atomic_add64(&fps->m_state, -increment);
+
+  /*
+    There might be "obtrusive" lock requests waiting for our lock to go
+    away, @sa MDL_lock::fast_path_shard_add().
+  */
+  if (my_atomic_load64(&m_fast_path_state) & HAS_OBTRUSIVE)
+  {
+    mysql_prlock_wrlock(&m_rwlock);
+    if (m_obtrusive_locks_granted_waiting_count)
+      reschedule_waiters();
+    mysql_prlock_unlock(&m_rwlock);
+  }
+
+  my_atomic_add64(&fps->m_releasing, -1);
+}
+
+
+/**
+  Account for a failed compare-and-swap on m_fast_path_state during a
+  "fast path" acquisition, and make the lock sharded once they become
+  frequent.
+
+  @note Called while the calling context holds a "fast path" lock on
+        this object, so it can't be destroyed under our feet.
+*/
+
+void MDL_lock::count_fast_path_contention()
+{
+  if (my_atomic_add32(&m_fast_path_contention, 1) + 1 !=
+      FAST_PATH_SHARDING_THRESHOLD)
+    return;
+
+  mysql_prlock_wrlock(&m_rwlock);
+
+  fast_path_state_t old_state= m_fast_path_state;
+
+  if (m_fast_path_shards == NULL &&
+      !(old_state & (HAS_OBTRUSIVE | IS_SHARDED)))
+  {
+    const size_t size= (FAST_PATH_SHARDS + 1) * sizeof(Fast_path_shard);
+    if ((m_fast_path_shards_buffer=
+           static_cast<uchar *>(my_malloc(key_memory_MDL_lock_fast_path_shards,
+                                          size, MYF(MY_ZEROFILL)))))
+    {
+      my_atomic_storeptr(reinterpret_cast<void * volatile *>(
+                           &m_fast_path_shards),
+                         reinterpret_cast<void *>(
+                           MY_ALIGN(reinterpret_cast<size_t>(
+                                      m_fast_path_shards_buffer),
+                                    CPU_LEVEL1_DCACHE_LINESIZE)));
+    }
+  }
+
+  if (m_fast_path_shards != NULL &&
+      !(old_state & (HAS_OBTRUSIVE | IS_SHARDED)))
+  {
+    /*
+      Locks already counted in m_fast_path_state stay there, new ones are
+      counted in the shards.
+    */
+    while (! fast_path_state_cas(&old_state, old_state | IS_SHARDED))
+    { }
+  }
+  else
+  {
+    /* Try again later. */
+    my_atomic_store32(&m_fast_path_contention, 0);
+  }
+
+  mysql_prlock_unlock(&m_rwlock);
+}
+
+
+/**
+  Make the lock use m_fast_path_state for "fast path" locks again if none
+  are counted in the shards.
+
+  Called when the last "obtrusive" lock goes away. The HAS_OBTRUSIVE flag
+  is still set at this point, so new "fast path" locks can't be counted in
+  the shards, and the counters in m_fast_path_state can only change under
+  protection of m_rwlock (see invariant [INV1]).
+*/
+
+void MDL_lock::drain_fast_path_shards()
+{
+  mysql_prlock_assert_write_owner(&m_rwlock);
+  DBUG_ASSERT(m_fast_path_state & HAS_OBTRUSIVE);
+
+  if (!(m_fast_path_state & IS_SHARDED))
+    return;
+
+  for (uint i= 0; i < FAST_PATH_SHARDS; i++)
+  {
+    /*
+      The counter must be read before m_releasing, which a thread releasing
+      its lock increments before decrementing the counter.
+    */
+    if (my_atomic_load64(&m_fast_path_shards[i].m_state) != 0 ||
+        my_atomic_load64(&m_fast_path_shards[i].m_releasing) != 0)
+      return;
+  }
+
+  fast_path_state_t old_state= m_fast_path_state;
+  while (! fast_path_state_cas(&old_state, old_state & ~IS_SHARDED))
+  { }
+  my_atomic_store32(&m_fast_path_contention, 0);
+}
+
+
 /**
   @returns "Fast path" increment for request for "unobtrusive" type
             of lock, 0 - if it is request for "obtrusive" type of
@@ -2581,6 +2842,13 @@ void MDL_lock::remove_ticket(MDL_context *ctx, LF_PINS *pins,
   bool last_slow_path= m_granted.is_empty() && m_waiting.is_empty();
   bool last_use= false;
 
+  /*
+    Stop using shards for "fast path" locks before HAS_OBTRUSIVE is
+    cleared, if the lock has become idle.
+  */
+  if (last_obtrusive)
+    drain_fast_path_shards();
+
   if (last_slow_path || last_obtrusive)
   {
     fast_path_state_t old_state= m_fast_path_state;
@@ -2875,11 +3143,20 @@ void MDL_context::materialize_fast_path_locks()
         mysql_prlock_wrlock(&lock->m_rwlock);
         lock->m_granted.add_ticket(ticket);
         /*
-          Atomically decrement counter in MDL_lock::m_fast_path_state.
+          Atomically decrement counter in MDL_lock::m_fast_path_state, or in
+          the shard of this context if the lock was counted there.
           This needs to happen under protection of MDL_lock::m_rwlock to make
           it atomic with addition of ticket to MDL_lock::m_granted list and
           to enforce invariant [INV1].
         */
+        if (ticket->m_is_sharded)
+        {
+          my_atomic_add64(&lock->m_fast_path_shards[m_fast_path_shard].m_state,
+                          -unobtrusive_lock_increment);
+          ticket->m_is_sharded= false;
+          /* Only HAS_SLOW_PATH needs to be set below. */
+          unobtrusive_lock_increment= 0;
+        }
         MDL_lock::fast_path_state_t old_state= lock->m_fast_path_state;
         while (! lock->fast_path_state_cas(&old_state,
                          ((old_state - unobtrusive_lock_increment) |
@@ -3052,9 +3329,12 @@ retry:
     */
     MDL_lock::fast_path_state_t old_state= lock->m_fast_path_state;
     bool first_use;
+    uint attempts= 0;
 
     do
     {
+      attempts++;
+
       /*
         Check if hash look-up returned object marked as destroyed or
         it was marked as such while it was pinned by us. If yes we
@@ -3077,6 +3357,21 @@ retry:
       if (old_state & MDL_lock::HAS_OBTRUSIVE)
         goto slow_path;
 
+      /*
+        If the lock is sharded, count our lock in the shard of this context
+        instead of m_fast_path_state. The MDL_lock object is used as long
+        as it is sharded.
+      */
+      if (old_state & MDL_lock::IS_SHARDED)
+      {
+        if (! lock->fast_path_shard_add(m_fast_path_shard,
+                                        unobtrusive_lock_increment))
+          goto slow_path;
+        ticket->m_is_sharded= true;
+        first_use= false;
+        break;
+      }
+
       /*
         If m_fast_path_state doesn't have HAS_SLOW_PATH set and all "fast"
         path counters are 0 then we are about to use an unused MDL_lock
@@ -3106,6 +3401,13 @@ retry:
       threshold.
     */
 
+    /*
+      If the compare-and-swap has failed because of concurrent "fast path"
+      acquisitions and releases, we might have to shard the lock.
+    */
+    if (attempts > 1 && ! ticket->m_is_sharded)
+      lock->count_fast_path_contention();
+
     if (pinned)
       lf_hash_search_unpin(m_pins);
 
@@ -3329,7 +3631,19 @@ MDL_context::clone_ticket(MDL_request *mdl_request)
       invariant [INV1].
     */
     mysql_prlock_wrlock(&ticket->m_lock->m_rwlock);
-    ticket->m_lock->fast_path_state_add(unobtrusive_lock_increment);
+    if (mdl_request->ticket->m_is_sharded)
+    {
+      /*
+        The lock stays sharded while the ticket being cloned is counted in
+        the shard of this context, so the clone can be counted there too.
+      */
+      my_atomic_add64(
+        &ticket->m_lock->m_fast_path_shards[m_fast_path_shard].m_state,
+        unobtrusive_lock_increment);
+      ticket->m_is_sharded= true;
+    }
+    else
+      ticket->m_lock->fast_path_state_add(unobtrusive_lock_increment);
     mysql_prlock_unlock(&ticket->m_lock->m_rwlock);
     ticket->m_is_fast_path= true;
   }
@@ -3806,8 +4120,15 @@ MDL_context::upgrade_shared_lock(MDL_ticket *mdl_ticket,
       MDL_lock::m_rwlock, so nobody will see results of this decrement until
       m_rwlock is released.
     */
-    lock->fast_path_state_add(
-            -lock->get_unobtrusive_lock_increment(mdl_ticket->m_type));
+    if (mdl_ticket->m_is_sharded)
+    {
+      my_atomic_add64(&lock->m_fast_path_shards[m_fast_path_shard].m_state,
+                      -lock->get_unobtrusive_lock_increment(mdl_ticket->m_type));
+      mdl_ticket->m_is_sharded= false;
+    }
+    else
+      lock->fast_path_state_add(
+              -lock->get_unobtrusive_lock_increment(mdl_ticket->m_type));
     mdl_ticket->m_is_fast_path= false;
   }
   else
@@ -4123,7 +4444,18 @@ void MDL_context::release_lock(enum_mdl_duration duration, MDL_ticket *ticket)
   DBUG_ASSERT(this == ticket->get_ctx());
   mysql_mutex_assert_not_owner(&LOCK_open);
 
-  if (ticket->m_is_fast_path)
+  if (ticket->m_is_sharded)
+  {
+    /*
+      Lock was acquired on "fast path" and counted in the shard of this
+      context. The MDL_lock object stays used until it is drained, so
+      we don't need to count it as unused here.
+    */
+    lock->fast_path_shard_sub(m_fast_path_shard,
+                              lock->get_unobtrusive_lock_increment(
+                                ticket->get_type()));
+  }
+  else if (ticket->m_is_fast_path)
   {
     /*
       We are releasing ticket which represents lock request which was
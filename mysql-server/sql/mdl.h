@@ -672,6 +672,7 @@ private:
      m_ctx(ctx_arg),
      m_lock(NULL),
      m_is_fast_path(false),
+     m_is_sharded(false),
      m_psi(NULL)
   {}
 
@@ -714,6 +715,14 @@ private:
   */
   bool m_is_fast_path;
 
+  /**
+    Indicates that ticket corresponds to lock acquired using "fast path"
+    algorithm which is accounted for in the shard of the owning context
+    in MDL_lock::m_fast_path_shards rather than in
+    MDL_lock::m_fast_path_state. Implies m_is_fast_path.
+  */
+  bool m_is_sharded;
+
   PSI_metadata_lock *m_psi;
 
 private:
@@ -1048,6 +1057,12 @@ private:
     when searching for unused objects to free.
   */
   uint m_rand_state;
+  /**
+    Shard of MDL_lock::m_fast_path_shards in which "fast path" locks of
+    this context are counted when the lock is sharded. Contexts are
+    assigned to shards round-robin.
+  */
+  uint m_fast_path_shard;
 
 private:
   MDL_ticket *find_ticket(MDL_request *mdl_req,
@@ -52,6 +52,8 @@
                           // get_date_time_format_str
 #include "tztime.h"       // my_tz_free, my_tz_init, my_tz_SYSTEM
 #include "hostname.h"     // hostname_cache_free, hostname_cache_init
+#include "sql_plan_cache.h" // plan_cache_free, plan_cache_init
+#include "sp_cache.h"      // sp_cache_end, sp_cache_init
 #include "auth_common.h"  // set_default_auth_plugin
                           // acl_free, acl_init
                           // grant_free, grant_init
@@ -61,6 +63,7 @@
 #include "sql_test.h"     // mysql_print_status
 #include "item_create.h"  // item_create_cleanup, item_create_init
 #include "sql_servers.h"  // servers_free, servers_init
+#include "resource_groups.h" // resource_groups_init
 #include "init.h"         // unireg_init
 #include "derror.h"       // init_errmessage
 #include "derror.h"       // init_errmessage
@@ -70,6 +73,7 @@
 #include <m_ctype.h>
 #include <my_dir.h>
 #include <my_bit.h>
+#include <my_compress.h>
 #include "rpl_gtid.h"
 #include "rpl_gtid_persist.h"
 #include "rpl_slave.h"
@@ -408,6 +412,12 @@ uint protocol_version;
 uint lower_case_table_names;
 ulong tc_heuristic_recover= 0;
 ulong back_log, connect_timeout, server_id;
+ulong acceptor_threads= 1;
+ulonglong protocol_compression_algorithms;
+uint protocol_compression_level;
+int64 volatile compress_bytes_in= 0, compress_bytes_out= 0, compress_time= 0;
+int64 volatile uncompress_bytes_in= 0, uncompress_bytes_out= 0,
+               uncompress_time= 0;
 ulong table_cache_size, table_def_size;
 ulong table_cache_instances;
 ulong table_cache_size_per_instance;
@@ -701,6 +711,19 @@ Connection_acceptor<Mysqld_socket_listener> *mysqld_socket_acceptor= NULL;
 Connection_acceptor<Named_pipe_listener> *named_pipe_acceptor= NULL;
 Connection_acceptor<Shared_mem_listener> *shared_mem_acceptor= NULL;
 #endif
+#if !defined(_WIN32) && !defined(EMBEDDED_LIBRARY)
+/*
+  With --acceptor-threads=N, the acceptors of the N - 1 additional TCP/IP
+  listener sockets, each run by a thread of its own. All the listener
+  sockets are bound to the same port with SO_REUSEPORT, and the kernel
+  spreads the incoming connections over them.
+*/
+static std::vector<Connection_acceptor<Mysqld_socket_listener>*>
+  reuseport_acceptors;
+static std::vector<pthread_t> reuseport_acceptor_threads;
+// Number of running acceptor threads, protected by LOCK_socket_listener_active
+static uint reuseport_acceptors_running= 0;
+#endif
 
 Checkable_rwlock *global_sid_lock= NULL;
 Sid_map *global_sid_map= NULL;
@@ -949,7 +972,9 @@ static my_bool plugins_are_initialized= FALSE;
 static const char* default_dbug_option;
 #endif
 ulong query_cache_min_res_unit= QUERY_CACHE_MIN_RESULT_DATA_SIZE;
-Query_cache query_cache;
+ulong query_cache_partitions= 1;
+ulong query_cache_invalidation= QUERY_CACHE_INVALIDATION_TABLE;
+Partitioned_query_cache query_cache;
 
 my_bool opt_use_ssl= 1;
 char *opt_ssl_ca= NULL, *opt_ssl_capath= NULL, *opt_ssl_cert= NULL,
@@ -1100,6 +1125,111 @@ public:
   }
 };
 
+#ifndef _WIN32
+/**
+  Body of the threads of the acceptors of the additional TCP/IP listener
+  sockets.
+*/
+pthread_handler_t reuseport_conn_event_handler(void *arg)
+{
+  my_thread_init();
+
+  Connection_acceptor<Mysqld_socket_listener> *conn_acceptor=
+    static_cast<Connection_acceptor<Mysqld_socket_listener>*>(arg);
+  conn_acceptor->connection_event_loop();
+
+  mysql_mutex_lock(&LOCK_socket_listener_active);
+  reuseport_acceptors_running--;
+  mysql_cond_broadcast(&COND_socket_listener_active);
+  mysql_mutex_unlock(&LOCK_socket_listener_active);
+
+  my_thread_end();
+  return 0;
+}
+
+
+/**
+  Start a thread for each of the acceptors of the additional TCP/IP
+  listener sockets. If a thread cannot be created, the listener sockets
+  without a thread are closed, so that the kernel does not give them
+  connections that nobody accepts.
+*/
+static void start_reuseport_acceptors()
+{
+  for (size_t i= 0; i < reuseport_acceptors.size(); i++)
+  {
+    pthread_t thread_id;
+    int error;
+
+    mysql_mutex_lock(&LOCK_socket_listener_active);
+    reuseport_acceptors_running++;
+    mysql_mutex_unlock(&LOCK_socket_listener_active);
+
+    if ((error= mysql_thread_create(key_thread_acceptor, &thread_id, NULL,
+                                    reuseport_conn_event_handler,
+                                    reuseport_acceptors[i])))
+    {
+      sql_print_warning("Can't create acceptor thread (error %d, errno: %d). "
+                        "The server uses %u acceptor threads.",
+                        error, errno, static_cast<uint>(i + 1));
+      mysql_mutex_lock(&LOCK_socket_listener_active);
+      reuseport_acceptors_running--;
+      mysql_mutex_unlock(&LOCK_socket_listener_active);
+
+      for (size_t j= i; j < reuseport_acceptors.size(); j++)
+        delete reuseport_acceptors[j];
+      reuseport_acceptors.resize(i);
+      break;
+    }
+    reuseport_acceptor_threads.push_back(thread_id);
+  }
+}
+
+
+/**
+  Interrupt the threads of the acceptors of the additional TCP/IP
+  listener sockets and wait for them to exit. abort_loop must be set.
+*/
+static void stop_reuseport_acceptors()
+{
+  DBUG_ASSERT(abort_loop);
+
+  mysql_mutex_lock(&LOCK_socket_listener_active);
+  while (reuseport_acceptors_running > 0)
+  {
+    /*
+      SIGUSR1 interrupts poll() in the acceptor threads. Send it again
+      after a while, in case it came before a thread started to wait.
+    */
+    for (size_t i= 0; i < reuseport_acceptor_threads.size(); i++)
+      (void) pthread_kill(reuseport_acceptor_threads[i], SIGUSR1);
+
+    struct timespec abstime;
+    set_timespec_nsec(&abstime, 100000000ULL);
+    mysql_cond_timedwait(&COND_socket_listener_active,
+                         &LOCK_socket_listener_active, &abstime);
+  }
+  mysql_mutex_unlock(&LOCK_socket_listener_active);
+
+  for (size_t i= 0; i < reuseport_acceptor_threads.size(); i++)
+    (void) pthread_join(reuseport_acceptor_threads[i], NULL);
+  reuseport_acceptor_threads.clear();
+}
+
+
+/**
+  Close the additional TCP/IP listener sockets. Their threads must have
+  been stopped.
+*/
+static void delete_reuseport_acceptors()
+{
+  for (size_t i= 0; i < reuseport_acceptors.size(); i++)
+    delete reuseport_acceptors[i];
+  reuseport_acceptors.clear();
+}
+#endif // !_WIN32
+
+
 static void close_connections(void)
 {
   DBUG_ENTER("close_connections");
@@ -1115,6 +1245,9 @@ static void close_connections(void)
     delete mysqld_socket_acceptor;
     mysqld_socket_acceptor= NULL;
   }
+#ifndef _WIN32
+  delete_reuseport_acceptors();
+#endif
 #ifdef _WIN32
   if (named_pipe_acceptor != NULL)
   {
@@ -1360,6 +1493,7 @@ void clean_up(bool print_message)
   my_tz_free();
   my_dboptions_cache_free();
   ignore_db_dirs_free();
+  resource_groups_free();
 #ifndef NO_EMBEDDED_ACCESS_CHECKS
   servers_free(1);
   acl_free(1);
@@ -1367,6 +1501,8 @@ void clean_up(bool print_message)
 #endif
   query_cache.destroy();
   hostname_cache_free();
+  plan_cache_free();
+  sp_cache_end();
   item_func_sleep_free();
   lex_free();       /* Free some memory */
   item_create_cleanup();
@@ -1685,6 +1821,25 @@ static void network_init(void)
   unix_sock_name= mysqld_unix_port ? mysqld_unix_port : "";
 #endif
 
+  if (acceptor_threads > 1)
+  {
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+    if (Connection_handler_manager::thread_handling ==
+        Connection_handler_manager::SCHEDULER_NO_THREADS)
+    {
+      sql_print_warning("--acceptor-threads is ignored with "
+                        "--thread-handling=no-threads.");
+      acceptor_threads= 1;
+    }
+    else if (opt_disable_networking)
+      acceptor_threads= 1;
+#else
+    sql_print_warning("--acceptor-threads is not supported on this "
+                      "platform, using one acceptor thread.");
+    acceptor_threads= 1;
+#endif
+  }
+
   if (!opt_disable_networking || unix_sock_name != "")
   {
     std::string bind_addr_str= my_bind_addr_str ? my_bind_addr_str : "";
@@ -1693,7 +1848,8 @@ static void network_init(void)
       new (std::nothrow) Mysqld_socket_listener(bind_addr_str,
                                                 mysqld_port, back_log,
                                                 mysqld_port_timeout,
-                                                unix_sock_name);
+                                                unix_sock_name,
+                                                acceptor_threads > 1);
     if (mysqld_socket_listener == NULL)
       unireg_abort(1);
 
@@ -1711,6 +1867,36 @@ static void network_init(void)
       unireg_abort(1);
     }
 
+#ifndef _WIN32
+    /*
+      The additional acceptors only listen on TCP/IP. The unix socket
+      is listened on by the main thread.
+    */
+    for (ulong i= 1; i < acceptor_threads; i++)
+    {
+      Mysqld_socket_listener *reuseport_listener=
+        new (std::nothrow) Mysqld_socket_listener(bind_addr_str,
+                                                  mysqld_port, back_log,
+                                                  mysqld_port_timeout,
+                                                  "", true);
+      if (reuseport_listener == NULL)
+        unireg_abort(1);
+
+      Connection_acceptor<Mysqld_socket_listener> *reuseport_acceptor=
+        new (std::nothrow)
+        Connection_acceptor<Mysqld_socket_listener>(reuseport_listener);
+      if (reuseport_acceptor == NULL)
+      {
+        delete reuseport_listener;
+        unireg_abort(1);
+      }
+
+      reuseport_acceptors.push_back(reuseport_acceptor);
+      if (reuseport_acceptor->init_connection_acceptor())
+        unireg_abort(1);
+    }
+#endif // !_WIN32
+
     if (report_port == 0)
       report_port= mysqld_port;
 
@@ -2408,6 +2594,7 @@ SHOW_VAR com_status_vars[]= {
   {"alter_event",          (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_EVENT]), SHOW_LONG_STATUS},
   {"alter_function",       (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_FUNCTION]), SHOW_LONG_STATUS},
   {"alter_procedure",      (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_PROCEDURE]), SHOW_LONG_STATUS},
+  {"alter_resource_group", (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_RESOURCE_GROUP]), SHOW_LONG_STATUS},
   {"alter_server",         (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_SERVER]), SHOW_LONG_STATUS},
   {"alter_table",          (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_TABLE]), SHOW_LONG_STATUS},
   {"alter_tablespace",     (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_ALTER_TABLESPACE]), SHOW_LONG_STATUS},
@@ -2427,6 +2614,7 @@ SHOW_VAR com_status_vars[]= {
   {"create_function",      (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_SPFUNCTION]), SHOW_LONG_STATUS},
   {"create_index",         (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_INDEX]), SHOW_LONG_STATUS},
   {"create_procedure",     (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_PROCEDURE]), SHOW_LONG_STATUS},
+  {"create_resource_group", (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_RESOURCE_GROUP]), SHOW_LONG_STATUS},
   {"create_server",        (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_SERVER]), SHOW_LONG_STATUS},
   {"create_table",         (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_TABLE]), SHOW_LONG_STATUS},
   {"create_trigger",       (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_CREATE_TRIGGER]), SHOW_LONG_STATUS},
@@ -2442,6 +2630,7 @@ SHOW_VAR com_status_vars[]= {
   {"drop_function",        (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_FUNCTION]), SHOW_LONG_STATUS},
   {"drop_index",           (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_INDEX]), SHOW_LONG_STATUS},
   {"drop_procedure",       (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_PROCEDURE]), SHOW_LONG_STATUS},
+  {"drop_resource_group",  (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_RESOURCE_GROUP]), SHOW_LONG_STATUS},
   {"drop_server",          (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_SERVER]), SHOW_LONG_STATUS},
   {"drop_table",           (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_TABLE]), SHOW_LONG_STATUS},
   {"drop_trigger",         (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_DROP_TRIGGER]), SHOW_LONG_STATUS},
@@ -2483,6 +2672,7 @@ SHOW_VAR com_status_vars[]= {
   {"savepoint",            (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SAVEPOINT]), SHOW_LONG_STATUS},
   {"select",               (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SELECT]), SHOW_LONG_STATUS},
   {"set_option",           (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SET_OPTION]), SHOW_LONG_STATUS},
+  {"set_resource_group",   (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SET_RESOURCE_GROUP]), SHOW_LONG_STATUS},
   {"signal",               (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SIGNAL]), SHOW_LONG_STATUS},
   {"show_binlog_events",   (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SHOW_BINLOG_EVENTS]), SHOW_LONG_STATUS},
   {"show_binlogs",         (char*) offsetof(STATUS_VAR, com_stat[(uint) SQLCOM_SHOW_BINLOGS]), SHOW_LONG_STATUS},
@@ -3628,8 +3818,10 @@ static int init_server_components()
     all things are initialized so that unireg_abort() doesn't fail
   */
   mdl_init();
-  if (table_def_init() | hostname_cache_init(host_cache_size))
+  if (table_def_init() | hostname_cache_init(host_cache_size) |
+      plan_cache_init(plan_cache_size))
     unireg_abort(1);
+  sp_cache_init();
 
 #ifdef HAVE_MY_TIMER
   if (my_timer_initialize())
@@ -4646,6 +4838,9 @@ int mysqld_main(int argc, char **argv)
       delete mysqld_socket_acceptor;
       mysqld_socket_acceptor= NULL;
     }
+#ifndef _WIN32
+    delete_reuseport_acceptors();
+#endif
     exit(1);
   }
 
@@ -4655,6 +4850,12 @@ int mysqld_main(int argc, char **argv)
   if (!opt_bootstrap)
     servers_init(0);
 
+  if (resource_groups_init())
+  {
+    sql_print_error("Out of memory");
+    unireg_abort(1);
+  }
+
   if (!opt_noacl)
   {
 #ifdef HAVE_DLOPEN
@@ -4769,7 +4970,9 @@ int mysqld_main(int argc, char **argv)
   // Make it possible for the signal handler to kill the listener.
   socket_listener_active= true;
   mysql_mutex_unlock(&LOCK_socket_listener_active);
+  start_reuseport_acceptors();
   (void) mysqld_socket_acceptor->connection_event_loop();
+  stop_reuseport_acceptors();
 #endif /* _WIN32 */
 
   DBUG_PRINT("info", ("No longer listening for incoming connections"));
@@ -5641,6 +5844,15 @@ static int show_queries(THD *thd, SHOW_VAR *var, char *buff)
 }
 
 
+static int show_resource_group(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_CHAR;
+  var->value= buff;
+  get_resource_group_name(thd, buff);
+  return 0;
+}
+
+
 static int show_net_compression(THD *thd, SHOW_VAR *var, char *buff)
 {
   var->type= SHOW_MY_BOOL;
@@ -5648,6 +5860,19 @@ static int show_net_compression(THD *thd, SHOW_VAR *var, char *buff)
   return 0;
 }
 
+static int show_net_compression_algorithm(THD *thd, SHOW_VAR *var, char *buff)
+{
+  const mysql_compress_context *ctx=
+    thd->net.compress ? net_compress_context(&thd->net) : NULL;
+  var->type= SHOW_CHAR;
+  var->value= buff;
+  if (ctx)
+    strmov(buff, mysql_compression_algorithm_name(ctx->algorithm));
+  else
+    strmov(buff, thd->net.compress ? "zlib" : "");
+  return 0;
+}
+
 static int show_starttime(THD *thd, SHOW_VAR *var, char *buff)
 {
   var->type= SHOW_LONGLONG;
@@ -5884,6 +6109,74 @@ static int show_table_definitions(THD *thd, SHOW_VAR *var, char *buff)
   return 0;
 }
 
+/*
+  The query cache counters are summed over its partitions. Those which
+  FLUSH STATUS resets are reset by refresh_status().
+*/
+static int show_qcache_free_blocks(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.free_memory_blocks();
+  return 0;
+}
+
+static int show_qcache_free_memory(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.free_memory();
+  return 0;
+}
+
+static int show_qcache_hits(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.hits();
+  return 0;
+}
+
+static int show_qcache_inserts(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.inserts();
+  return 0;
+}
+
+static int show_qcache_lowmem_prunes(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.lowmem_prunes();
+  return 0;
+}
+
+static int show_qcache_not_cached(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.refused();
+  return 0;
+}
+
+static int show_qcache_queries_in_cache(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.queries_in_cache();
+  return 0;
+}
+
+static int show_qcache_total_blocks(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.total_blocks();
+  return 0;
+}
+
 #if defined(HAVE_OPENSSL) && !defined(EMBEDDED_LIBRARY)
 /* Functions relying on CTX */
 static int show_ssl_ctx_sess_accept(THD *thd, SHOW_VAR *var, char *buff)
@@ -6264,8 +6557,21 @@ SHOW_VAR status_vars[]= {
   {"Bytes_sent",               (char*) offsetof(STATUS_VAR, bytes_sent), SHOW_LONGLONG_STATUS},
   {"Com",                      (char*) com_status_vars, SHOW_ARRAY},
   {"Compression",              (char*) &show_net_compression, SHOW_FUNC},
+  {"Compression_algorithm",    (char*) &show_net_compression_algorithm, SHOW_FUNC},
+  {"Compression_bytes_in",     (char*) &compress_bytes_in,      SHOW_LONGLONG},
+  {"Compression_bytes_out",    (char*) &compress_bytes_out,     SHOW_LONGLONG},
+  {"Compression_time",         (char*) &compress_time,          SHOW_LONGLONG},
+  {"Decompression_bytes_in",   (char*) &uncompress_bytes_in,    SHOW_LONGLONG},
+  {"Decompression_bytes_out",  (char*) &uncompress_bytes_out,   SHOW_LONGLONG},
+  {"Decompression_time",       (char*) &uncompress_time,        SHOW_LONGLONG},
   {"Connections",              (char*) &show_thread_id_count, SHOW_FUNC},
 #ifndef EMBEDDED_LIBRARY
+  {"Connect_latency_under_100us", (char*) &Connection_handler_manager::connect_latency[0], SHOW_LONGLONG},
+  {"Connect_latency_under_1ms",   (char*) &Connection_handler_manager::connect_latency[1], SHOW_LONGLONG},
+  {"Connect_latency_under_10ms",  (char*) &Connection_handler_manager::connect_latency[2], SHOW_LONGLONG},
+  {"Connect_latency_under_100ms", (char*) &Connection_handler_manager::connect_latency[3], SHOW_LONGLONG},
+  {"Connect_latency_under_1s",    (char*) &Connection_handler_manager::connect_latency[4], SHOW_LONGLONG},
+  {"Connect_latency_over_1s",     (char*) &Connection_handler_manager::connect_latency[5], SHOW_LONGLONG},
   {"Connection_errors_accept",   (char*) &show_connection_errors_accept, SHOW_FUNC},
   {"Connection_errors_internal", (char*) &connection_errors_internal, SHOW_LONG},
   {"Connection_errors_max_connections", (char*) &show_connection_errors_max_connection, SHOW_FUNC},
@@ -6320,17 +6626,26 @@ SHOW_VAR status_vars[]= {
   {"Opened_files",             (char*) &my_file_total_opened, SHOW_LONG_NOFLUSH},
   {"Opened_tables",            (char*) offsetof(STATUS_VAR, opened_tables), SHOW_LONGLONG_STATUS},
   {"Opened_table_definitions", (char*) offsetof(STATUS_VAR, opened_shares), SHOW_LONGLONG_STATUS},
+  {"Plan_cache_hits",          (char*) offsetof(STATUS_VAR, plan_cache_hits), SHOW_LONGLONG_STATUS},
+  {"Plan_cache_misses",        (char*) offsetof(STATUS_VAR, plan_cache_misses), SHOW_LONGLONG_STATUS},
   {"Prepared_stmt_count",      (char*) &show_prepared_stmt_count, SHOW_FUNC},
-  {"Qcache_free_blocks",       (char*) &query_cache.free_memory_blocks, SHOW_LONG_NOFLUSH},
-  {"Qcache_free_memory",       (char*) &query_cache.free_memory, SHOW_LONG_NOFLUSH},
-  {"Qcache_hits",              (char*) &query_cache.hits,       SHOW_LONG},
-  {"Qcache_inserts",           (char*) &query_cache.inserts,    SHOW_LONG},
-  {"Qcache_lowmem_prunes",     (char*) &query_cache.lowmem_prunes, SHOW_LONG},
-  {"Qcache_not_cached",        (char*) &query_cache.refused,    SHOW_LONG},
-  {"Qcache_queries_in_cache",  (char*) &query_cache.queries_in_cache, SHOW_LONG_NOFLUSH},
-  {"Qcache_total_blocks",      (char*) &query_cache.total_blocks, SHOW_LONG_NOFLUSH},
+  {"Range_estimate_cache_hits", (char*) offsetof(STATUS_VAR, range_estimate_cache_hits), SHOW_LONGLONG_STATUS},
+  {"Range_estimate_cache_misses", (char*) offsetof(STATUS_VAR, range_estimate_cache_misses), SHOW_LONGLONG_STATUS},
+  {"Qcache_free_blocks",       (char*) &show_qcache_free_blocks, SHOW_FUNC},
+  {"Qcache_free_memory",       (char*) &show_qcache_free_memory, SHOW_FUNC},
+  {"Qcache_hits",              (char*) &show_qcache_hits,       SHOW_FUNC},
+  {"Qcache_inserts",           (char*) &show_qcache_inserts,    SHOW_FUNC},
+  {"Qcache_lowmem_prunes",     (char*) &show_qcache_lowmem_prunes, SHOW_FUNC},
+  {"Qcache_not_cached",        (char*) &show_qcache_not_cached, SHOW_FUNC},
+  {"Qcache_queries_in_cache",  (char*) &show_qcache_queries_in_cache, SHOW_FUNC},
+  {"Qcache_total_blocks",      (char*) &show_qcache_total_blocks, SHOW_FUNC},
   {"Queries",                  (char*) &show_queries,            SHOW_FUNC},
+  {"Query_alloc_blocks_allocated", (char*) offsetof(STATUS_VAR, query_alloc_blocks_allocated), SHOW_LONGLONG_STATUS},
+  {"Query_alloc_blocks_reused", (char*) offsetof(STATUS_VAR, query_alloc_blocks_reused), SHOW_LONGLONG_STATUS},
+  {"Query_template_hits",      (char*) offsetof(STATUS_VAR, query_template_hits), SHOW_LONGLONG_STATUS},
+  {"Query_template_misses",    (char*) offsetof(STATUS_VAR, query_template_misses), SHOW_LONGLONG_STATUS},
   {"Questions",                (char*) offsetof(STATUS_VAR, questions), SHOW_LONGLONG_STATUS},
+  {"Resource_group",           (char*) &show_resource_group,    SHOW_FUNC},
   {"Select_full_join",         (char*) offsetof(STATUS_VAR, select_full_join_count), SHOW_LONGLONG_STATUS},
   {"Select_full_range_join",   (char*) offsetof(STATUS_VAR, select_full_range_join_count), SHOW_LONGLONG_STATUS},
   {"Select_range",             (char*) offsetof(STATUS_VAR, select_range_count), SHOW_LONGLONG_STATUS},
@@ -6387,6 +6702,8 @@ SHOW_VAR status_vars[]= {
 #endif
 #endif
 #endif /* HAVE_OPENSSL */
+  {"Stored_program_shared_cache_hits", (char*) offsetof(STATUS_VAR, sp_shared_cache_hits), SHOW_LONGLONG_STATUS},
+  {"Stored_program_shared_cache_misses", (char*) offsetof(STATUS_VAR, sp_shared_cache_misses), SHOW_LONGLONG_STATUS},
   {"Table_locks_immediate",    (char*) &locks_immediate,        SHOW_LONG},
   {"Table_locks_waited",       (char*) &locks_waited,           SHOW_LONG},
   {"Table_open_cache_hits",    (char*) offsetof(STATUS_VAR, table_open_cache_hits), SHOW_LONGLONG_STATUS},
@@ -6396,6 +6713,8 @@ SHOW_VAR status_vars[]= {
   {"Tc_log_page_size",         (char*) &tc_log_page_size,       SHOW_LONG_NOFLUSH},
   {"Tc_log_page_waits",        (char*) &tc_log_page_waits,      SHOW_LONG},
 #ifndef EMBEDDED_LIBRARY
+  {"Thread_pool_stalls",       (char*) &Pool_of_threads_connection_handler::stalls, SHOW_LONG},
+  {"Thread_pool_threads",      (char*) &Pool_of_threads_connection_handler::threads, SHOW_LONG_NOFLUSH},
   {"Threads_cached",           (char*) &Per_thread_connection_handler::blocked_pthread_count, SHOW_LONG_NOFLUSH},
 #endif
   {"Threads_connected",        (char*) &Connection_handler_manager::connection_count, SHOW_INT},
@@ -7723,6 +8042,7 @@ void refresh_status(THD *thd)
 
   /* Reset the counters of all key caches (default and named). */
   process_key_caches(reset_key_cache_counters);
+  query_cache.reset_statistics();
   flush_status_time= time((time_t*) 0);
   mysql_mutex_unlock(&LOCK_status);
 
@@ -7987,7 +8307,7 @@ static PSI_cond_info all_server_conds[]=
 
 PSI_thread_key key_thread_bootstrap, key_thread_handle_manager, key_thread_main,
   key_thread_one_connection, key_thread_signal_hand,
-  key_thread_compress_gtid_table;
+  key_thread_compress_gtid_table, key_thread_acceptor;
 
 #ifdef HAVE_MY_TIMER
 PSI_thread_key key_thread_timer_notifier;
@@ -8009,7 +8329,8 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_main, "main", PSI_FLAG_GLOBAL},
   { &key_thread_one_connection, "one_connection", 0},
   { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL},
-  { &key_thread_compress_gtid_table, "compress_gtid_table", PSI_FLAG_GLOBAL}
+  { &key_thread_compress_gtid_table, "compress_gtid_table", PSI_FLAG_GLOBAL},
+  { &key_thread_acceptor, "acceptor", 0}
 };
 
 PSI_file_key key_file_map;
@@ -8322,6 +8643,9 @@ PSI_memory_key key_memory_handler_errmsgs;
 PSI_memory_key key_memory_handlerton;
 PSI_memory_key key_memory_XID;
 PSI_memory_key key_memory_host_cache_hostname;
+PSI_memory_key key_memory_plan_cache;
+PSI_memory_key key_memory_query_template_cache;
+PSI_memory_key key_memory_range_estimate_cache;
 PSI_memory_key key_memory_user_var_entry_value;
 PSI_memory_key key_memory_User_level_lock;
 PSI_memory_key key_memory_MYSQL_LOG_name;
@@ -8367,6 +8691,9 @@ PSI_memory_key key_memory_TABLE_sort_io_cache;
 PSI_memory_key key_memory_frm;
 PSI_memory_key key_memory_Unique_sort_buffer;
 PSI_memory_key key_memory_Unique_merge_buffer;
+PSI_memory_key key_memory_Unique_hash_set;
+PSI_memory_key key_memory_SJ_TMP_TABLE_hash_set;
+PSI_memory_key key_memory_subselect_hash_set;
 PSI_memory_key key_memory_TABLE;
 PSI_memory_key key_memory_frm_extra_segment_buff;
 PSI_memory_key key_memory_frm_form_pos;
@@ -8464,6 +8791,9 @@ static PSI_memory_info all_server_memory[]=
   { &key_memory_handlerton, "handlerton", 0},
   { &key_memory_XID, "XID", 0},
   { &key_memory_host_cache_hostname, "host_cache::hostname", 0},
+  { &key_memory_plan_cache, "plan_cache", 0},
+  { &key_memory_query_template_cache, "query_template_cache", 0},
+  { &key_memory_range_estimate_cache, "range_estimate_cache", 0},
   { &key_memory_user_var_entry_value, "user_var_entry::value", 0},
   { &key_memory_User_level_lock, "User_level_lock", 0},
   { &key_memory_MYSQL_LOG_name, "MYSQL_LOG::name", 0},
@@ -8514,6 +8844,9 @@ static PSI_memory_info all_server_memory[]=
   { &key_memory_frm, "frm", 0},
   { &key_memory_Unique_sort_buffer, "Unique::sort_buffer", 0},
   { &key_memory_Unique_merge_buffer, "Unique::merge_buffer", 0},
+  { &key_memory_Unique_hash_set, "Unique::hash_set", 0},
+  { &key_memory_SJ_TMP_TABLE_hash_set, "SJ_TMP_TABLE::hash_set", 0},
+  { &key_memory_subselect_hash_set, "subselect_hash_sj_engine::hash_set", 0},
   { &key_memory_TABLE, "TABLE", 0},
   { &key_memory_frm_extra_segment_buff, "frm::extra_segment_buff", 0},
   { &key_memory_frm_form_pos, "frm::form_pos", 0},
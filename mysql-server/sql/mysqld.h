@@ -203,6 +203,7 @@ extern ulong delayed_insert_threads, delayed_insert_writes;
 extern ulong delayed_rows_in_use,delayed_insert_errors;
 extern int32 slave_open_temp_tables;
 extern ulong query_cache_size, query_cache_min_res_unit;
+extern ulong query_cache_partitions, query_cache_invalidation;
 extern ulong slow_launch_time;
 extern ulong table_cache_size, table_def_size;
 extern ulong table_cache_size_per_instance, table_cache_instances;
@@ -262,6 +263,13 @@ extern TYPELIB gtid_mode_typelib;
 
 extern ulong stored_program_cache_size;
 extern ulong back_log;
+extern ulong acceptor_threads;
+extern ulonglong protocol_compression_algorithms;
+extern uint protocol_compression_level;
+/* Protocol compression throughput, maintained by net_serv.cc */
+extern int64 volatile compress_bytes_in, compress_bytes_out, compress_time;
+extern int64 volatile uncompress_bytes_in, uncompress_bytes_out,
+                      uncompress_time;
 extern char language[FN_REFLEN];
 extern "C" MYSQL_PLUGIN_IMPORT ulong server_id;
 extern time_t server_start_time, flush_status_time;
@@ -451,7 +459,7 @@ extern PSI_cond_key key_commit_order_manager_cond;
 extern PSI_thread_key key_thread_bootstrap,
   key_thread_handle_manager, key_thread_main,
   key_thread_one_connection, key_thread_signal_hand,
-  key_thread_compress_gtid_table;
+  key_thread_compress_gtid_table, key_thread_acceptor;
 
 #ifdef HAVE_MY_TIMER
 extern PSI_thread_key key_thread_timer_notifier;
@@ -522,6 +530,9 @@ extern PSI_memory_key key_memory_Gcalc_dyn_list_block;
 extern PSI_memory_key key_memory_Gis_read_stream_err_msg;
 extern PSI_memory_key key_memory_Geometry_objects_data;
 extern PSI_memory_key key_memory_host_cache_hostname;
+extern PSI_memory_key key_memory_plan_cache;
+extern PSI_memory_key key_memory_query_template_cache;
+extern PSI_memory_key key_memory_range_estimate_cache;
 extern PSI_memory_key key_memory_User_level_lock;
 extern PSI_memory_key key_memory_Filesort_info_record_pointers;
 extern PSI_memory_key key_memory_Sort_param_tmp_buffer;
@@ -595,6 +606,9 @@ extern PSI_memory_key key_memory_frm_form_pos;
 extern PSI_memory_key key_memory_frm_string;
 extern PSI_memory_key key_memory_Unique_sort_buffer;
 extern PSI_memory_key key_memory_Unique_merge_buffer;
+extern PSI_memory_key key_memory_Unique_hash_set;
+extern PSI_memory_key key_memory_SJ_TMP_TABLE_hash_set;
+extern PSI_memory_key key_memory_subselect_hash_set;
 extern PSI_memory_key key_memory_shared_memory_name;
 extern PSI_memory_key key_memory_opt_bin_logname;
 extern PSI_memory_key key_memory_Query_cache;
@@ -78,6 +78,13 @@ public:
   add_thd() inserts a THD into the set, and increments the counter.
   remove_thd() removes a THD from the set, and decrements the counter.
   Method remove_thd() also broadcasts COND_thd_list.
+
+  The THDs are spread over NUM_PARTITIONS partitions by thread id, each
+  with its own list and mutexes, so that connects and disconnects of
+  different threads do not serialize on one mutex, and a scan of the
+  THDs only blocks one partition at a time. The thread ids in use are
+  partitioned the same way, and new ids are taken from an atomic
+  counter.
 */
 
 class Global_THD_manager
@@ -190,7 +197,10 @@ public:
     @return my_thread_id Returns the thread id counter value
     @note                This is a dirty read.
   */
-  my_thread_id get_thread_id() const { return thread_id_counter; }
+  my_thread_id get_thread_id() const
+  {
+    return static_cast<my_thread_id>(thread_id_counter);
+  }
 
   /**
     Sets thread id counter value. Only used in testing for now.
@@ -203,7 +213,7 @@ public:
     @return uint Returns the count of items in global THD list
     @note        This is a dirty read.
   */
-  uint get_thd_count() const { return global_thd_count; }
+  uint get_thd_count() const { return static_cast<uint>(global_thd_count); }
 
   /**
     Waits until all thd are removed from global THD list. In other words,
@@ -214,13 +224,15 @@ public:
   /**
     This function calls func() for all thds in thd list after
     taking local copy of thd list. It acquires LOCK_thd_remove
-    to prevent removal from thd list.
+    to prevent removal from thd list. The partitions are copied and
+    processed one at a time.
     @param func Object of class which overrides operator()
   */
   void do_for_all_thd_copy(Do_THD_Impl *func);
 
   /**
-    This function calls func() for all thds in thd list.
+    This function calls func() for all thds in thd list, holding the
+    LOCK_thd_list of one partition at a time.
     @param func Object of class which overrides operator()
   */
   void do_for_all_thd(Do_THD_Impl *func);
@@ -234,32 +246,53 @@ public:
   */
   THD* find_thd(Find_THD_Impl *func);
 
+  /**
+    Returns a pointer to the THD with the given thread id, if operator()
+    returns true for it. Only the partition of the thread id is searched.
+    @param thread_id  thread id of the THD
+    @param func       Object of class which overrides operator()
+    @return THD
+      @retval THD* Matching THD
+      @retval NULL When THD is not found in the list
+  */
+  THD* find_thd(my_thread_id thread_id, Find_THD_Impl *func);
+
   // Declared static as it is referenced in handle_fatal_signal()
-  static int global_thd_count;
+  static volatile int32 global_thd_count;
+
+  /// Number of partitions of the THD list and of the thread ids
+  static const uint NUM_PARTITIONS= 8;
 
 private:
   Global_THD_manager();
   ~Global_THD_manager();
 
+  static uint partition(my_thread_id thread_id)
+  {
+    return thread_id % NUM_PARTITIONS;
+  }
+
+  THD* find_thd_in_partition(uint part, Find_THD_Impl *func);
+
   // Singleton instance.
   static Global_THD_manager *thd_manager;
 
-  // Array of current THDs. Protected by LOCK_thd_list.
-  typedef Prealloced_array<THD*, 500, true> THD_array;
-  THD_array thd_list;
+  // Arrays of current THDs. Protected by LOCK_thd_list.
+  typedef Prealloced_array<THD*, 64, true> THD_array;
+  THD_array *thd_list[NUM_PARTITIONS];
 
-  // Array of thread ID in current use. Protected by LOCK_thread_ids.
-  typedef Prealloced_array<my_thread_id, 1000, true> Thread_id_array;
-  Thread_id_array thread_ids;
+  // Arrays of thread ID in current use. Protected by LOCK_thread_ids.
+  typedef Prealloced_array<my_thread_id, 128, true> Thread_id_array;
+  Thread_id_array *thread_ids[NUM_PARTITIONS];
 
-  mysql_cond_t COND_thd_list;
+  mysql_cond_t COND_thd_list[NUM_PARTITIONS];
 
-  // Mutex that guards thd_list
-  mysql_mutex_t LOCK_thd_list;
-  // Mutex used to guard removal of elements from thd list.
-  mysql_mutex_t LOCK_thd_remove;
-  // Mutex protecting thread_ids
-  mysql_mutex_t LOCK_thread_ids;
+  // Mutexes that guard thd_list
+  mysql_mutex_t LOCK_thd_list[NUM_PARTITIONS];
+  // Mutexes used to guard removal of elements from thd list.
+  mysql_mutex_t LOCK_thd_remove[NUM_PARTITIONS];
+  // Mutexes protecting thread_ids
+  mysql_mutex_t LOCK_thread_ids[NUM_PARTITIONS];
 
   // Count of active threads which are running queries in the system.
   volatile int32 num_thread_running;
@@ -267,8 +300,8 @@ private:
   // Cumulative number of threads created by mysqld daemon.
   volatile int64 thread_created;
 
-  // Counter to assign thread id.
-  my_thread_id thread_id_counter;
+  // Counter to assign thread id. Incremented atomically.
+  volatile int32 thread_id_counter;
 
   // Used during unit test to bypass creating real THD object.
   bool unit_test;
@@ -40,6 +40,7 @@
 #include <my_sys.h>
 #include <m_string.h>
 #include <violite.h>
+#include <my_compress.h>
 #include <signal.h>
 #include <errno.h>
 #include "probes_mysql.h"
@@ -80,6 +81,7 @@ extern void query_cache_insert(const char *packet, ulong length,
                                unsigned pkt_nr);
 extern void thd_increment_bytes_sent(size_t length);
 extern void thd_increment_bytes_received(size_t length);
+#include "my_atomic.h"                          /* compression counters */
 
 /* Additional instrumentation hooks for the server */
 #include "mysql_com_server.h"
@@ -87,7 +89,20 @@ extern void thd_increment_bytes_received(size_t length);
 
 #define VIO_SOCKET_ERROR  ((size_t) -1)
 
+#ifndef _WIN32
+#include <sys/uio.h>
+/*
+  Part of the vio package (viosocket.c), which doesn't export it in
+  violite.h as no other client of it has a use for it.
+*/
+C_MODE_START
+size_t vio_writev(Vio *vio, const struct iovec *iov, int iovcnt);
+C_MODE_END
+#endif
+
 static my_bool net_write_buff(NET *, const uchar *, size_t);
+static my_bool net_write_buff_with_header(NET *, const uchar *,
+                                          const uchar *, size_t);
 
 /** Init with packet info. */
 
@@ -129,10 +144,56 @@ void net_end(NET *net)
   DBUG_ENTER("net_end");
   my_free(net->buff);
   net->buff=0;
+#ifdef HAVE_COMPRESS
+  mysql_compress_context *ctx= net_compress_context(net);
+  if (ctx)
+  {
+    mysql_compress_context_deinit(ctx);
+    my_free(ctx);
+    net->unused= NULL;
+  }
+#endif
   DBUG_VOID_RETURN;
 }
 
 
+/*
+  The compression context of a connection is kept in the otherwise
+  unused NET::unused pointer, so that the layout of NET does not change.
+*/
+
+mysql_compress_context *net_compress_context(NET *net)
+{
+  return reinterpret_cast<mysql_compress_context*>(net->unused);
+}
+
+
+my_bool net_set_compression(NET *net,
+                            enum enum_compression_algorithm algorithm,
+                            uint level)
+{
+  DBUG_ENTER("net_set_compression");
+#ifdef HAVE_COMPRESS
+  if (!mysql_compression_algorithm_supported(algorithm))
+    DBUG_RETURN(TRUE);
+
+  mysql_compress_context *ctx= net_compress_context(net);
+  if (ctx)
+    mysql_compress_context_deinit(ctx);
+  else if (!(ctx= (mysql_compress_context *)
+             my_malloc(key_memory_NET_compress_packet,
+                       sizeof(mysql_compress_context), MYF(MY_WME))))
+    DBUG_RETURN(TRUE);
+
+  mysql_compress_context_init(ctx, algorithm, level);
+  net->unused= reinterpret_cast<unsigned char*>(ctx);
+  DBUG_RETURN(FALSE);
+#else
+  DBUG_RETURN(TRUE);
+#endif
+}
+
+
 /** Realloc the packet buffer. */
 
 my_bool net_realloc(NET *net, size_t length)
@@ -291,8 +352,7 @@ my_bool my_net_write(NET *net, const uchar *packet, size_t len)
     const ulong z_size = MAX_PACKET_LENGTH;
     int3store(buff, z_size);
     buff[3]= (uchar) net->pkt_nr++;
-    if (net_write_buff(net, buff, NET_HEADER_SIZE) ||
-        net_write_buff(net, packet, z_size))
+    if (net_write_buff_with_header(net, buff, packet, z_size))
     {
       MYSQL_NET_WRITE_DONE(1);
       return 1;
@@ -303,15 +363,10 @@ my_bool my_net_write(NET *net, const uchar *packet, size_t len)
   /* Write last packet */
   int3store(buff, static_cast<uint>(len));
   buff[3]= (uchar) net->pkt_nr++;
-  if (net_write_buff(net, buff, NET_HEADER_SIZE))
-  {
-    MYSQL_NET_WRITE_DONE(1);
-    return 1;
-  }
 #ifndef DEBUG_DATA_PACKETS
   DBUG_DUMP("packet_header", buff, NET_HEADER_SIZE);
 #endif
-  rc= MY_TEST(net_write_buff(net,packet,len));
+  rc= MY_TEST(net_write_buff_with_header(net, buff, packet, len));
   MYSQL_NET_WRITE_DONE(rc);
   return rc;
 }
@@ -469,6 +524,29 @@ net_write_buff(NET *net, const uchar *packet, size_t len)
 }
 
 
+/**
+  Mark the network handler as unusable after a failed write.
+
+  @param  net     NET handler.
+*/
+
+static void net_set_write_error(NET *net)
+{
+  /* Socket should be closed. */
+  net->error= 2;
+
+  /* Interrupted by a timeout? */
+  if (vio_was_timeout(net->vio))
+    net->last_errno= ER_NET_WRITE_INTERRUPTED;
+  else
+    net->last_errno= ER_NET_ERROR_ON_WRITE;
+
+#ifdef MYSQL_SERVER
+  my_error(net->last_errno, MYF(0));
+#endif
+}
+
+
 /**
   Write a determined number of bytes to a network handler.
 
@@ -507,20 +585,7 @@ net_write_raw_loop(NET *net, const uchar *buf, size_t count)
 
   /* On failure, propagate the error code. */
   if (count)
-  {
-    /* Socket should be closed. */
-    net->error= 2;
-
-    /* Interrupted by a timeout? */
-    if (vio_was_timeout(net->vio))
-      net->last_errno= ER_NET_WRITE_INTERRUPTED;
-    else
-      net->last_errno= ER_NET_ERROR_ON_WRITE;
-
-#ifdef MYSQL_SERVER
-    my_error(net->last_errno, MYF(0));
-#endif
-  }
+    net_set_write_error(net);
 
   return MY_TEST(count);
 }
@@ -546,24 +611,51 @@ compress_packet(NET *net, const uchar *packet, size_t *length)
   uchar *compr_packet;
   size_t compr_length;
   const uint header_length= NET_HEADER_SIZE + COMP_HEADER_SIZE;
+  mysql_compress_context *ctx= net_compress_context(net);
+#ifdef MYSQL_SERVER
+  const ulonglong start= my_micro_time();
+  const size_t org_length= *length;
+#endif
 
-  compr_packet= (uchar *) my_malloc(key_memory_NET_compress_packet,
-                                    *length + header_length, MYF(MY_WME));
+  if (ctx)
+    compr_packet= mysql_compress_context_buffer(ctx, *length + header_length);
+  else
+    compr_packet= (uchar *) my_malloc(key_memory_NET_compress_packet,
+                                      *length + header_length, MYF(MY_WME));
 
   if (compr_packet == NULL)
     return NULL;
 
-  memcpy(compr_packet + header_length, packet, *length);
-
-  /* Compress the encapsulated packet. */
-  if (my_compress(compr_packet + header_length, length, &compr_length))
+  if (ctx)
   {
-    /*
-      If the length of the compressed packet is larger than the
-      original packet, the original packet is sent uncompressed.
-    */
-    compr_length= 0;
+    /* Compress straight from the packet, with the state of the context */
+    compr_length= my_compress_buffer(ctx, compr_packet + header_length,
+                                     *length, packet, *length);
+    if (compr_length)
+      swap_variables(size_t, *length, compr_length);
+    else
+      memcpy(compr_packet + header_length, packet, *length);
   }
+  else
+  {
+    memcpy(compr_packet + header_length, packet, *length);
+
+    /* Compress the encapsulated packet. */
+    if (my_compress(compr_packet + header_length, length, &compr_length))
+    {
+      /*
+        If the length of the compressed packet is larger than the
+        original packet, the original packet is sent uncompressed.
+      */
+      compr_length= 0;
+    }
+  }
+
+#ifdef MYSQL_SERVER
+  my_atomic_add64(&compress_bytes_in, (int64) org_length);
+  my_atomic_add64(&compress_bytes_out, (int64) *length);
+  my_atomic_add64(&compress_time, (int64) (my_micro_time() - start));
+#endif
 
   /* Length of the compressed (original) packet. */
   int3store(&compr_packet[NET_HEADER_SIZE], static_cast<uint>(compr_length));
@@ -629,18 +721,221 @@ net_write_packet(NET *net, const uchar *packet, size_t length)
 
 #ifdef HAVE_COMPRESS
   if (do_compress)
-    my_free((void *) packet);
+  {
+    mysql_compress_context *ctx= net_compress_context(net);
+    if (ctx)
+      mysql_compress_context_release(ctx, const_cast<uchar*>(packet));
+    else
+      my_free((void *) packet);
+  }
+#endif
+
+  net->reading_or_writing= 0;
+
+  DBUG_RETURN(res);
+}
+
+
+#ifndef _WIN32
+/**
+  Write the data of several buffers to a network handler, with as few
+  system calls as possible.
+
+  @param  net     NET handler.
+  @param  iov     The buffers. Modified to skip what has been written.
+  @param  iovcnt  The number of buffers.
+
+  @return TRUE on error, FALSE on success.
+*/
+
+static my_bool
+net_write_vector_loop(NET *net, struct iovec *iov, int iovcnt)
+{
+  unsigned int retry_count= 0;
+
+  while (iovcnt)
+  {
+    size_t sentcnt= vio_writev(net->vio, iov, iovcnt);
+
+    /* VIO_SOCKET_ERROR (-1) indicates an error. */
+    if (sentcnt == VIO_SOCKET_ERROR)
+    {
+      /* A recoverable I/O error occurred? */
+      if (net_should_retry(net, &retry_count))
+        continue;
+      else
+        break;
+    }
+
+#ifdef MYSQL_SERVER
+    thd_increment_bytes_sent(sentcnt);
 #endif
 
+    /* Skip the buffers that were written completely. */
+    while (iovcnt && sentcnt >= iov->iov_len)
+    {
+      sentcnt-= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt)
+    {
+      iov->iov_base= static_cast<char*>(iov->iov_base) + sentcnt;
+      iov->iov_len-= sentcnt;
+    }
+  }
+
+  /* On failure, propagate the error code. */
+  if (iovcnt)
+    net_set_write_error(net);
+
+  return MY_TEST(iovcnt);
+}
+
+
+/**
+  Write the data of several buffers to the network handler as if they
+  were one buffer passed to net_write_packet(). Only used without
+  compression, as a compressed packet has to be contiguous.
+
+  @param  net     NET handler.
+  @param  iov     The buffers. Modified to skip what has been written.
+  @param  iovcnt  The number of buffers.
+
+  @return TRUE on error, FALSE on success.
+*/
+
+static my_bool
+net_write_packet_vector(NET *net, struct iovec *iov, int iovcnt)
+{
+  my_bool res;
+  DBUG_ENTER("net_write_packet_vector");
+  DBUG_ASSERT(!net->compress);
+
+#if defined(MYSQL_SERVER)
+  for (int i= 0; i < iovcnt; i++)
+    query_cache_insert(static_cast<char*>(iov[i].iov_base),
+                       (ulong) iov[i].iov_len, net->pkt_nr);
+#endif
+
+  /* Socket can't be used */
+  if (net->error == 2)
+    DBUG_RETURN(TRUE);
+
+  net->reading_or_writing= 2;
+  res= net_write_vector_loop(net, iov, iovcnt);
   net->reading_or_writing= 0;
 
   DBUG_RETURN(res);
 }
+#endif /* _WIN32 */
+
+
+/**
+  Cache a packet header and the data following it in the write buffer.
+
+  If they don't fit into what is left of the buffer and the packet is
+  not compressed, the cached data, the header and the data are written
+  with one vectored write, instead of filling the buffer with a part of
+  the data and writing it before the rest. This avoids copying large
+  rows into the buffer, and saves a system call for the rest.
+
+  @param net     Network handler
+  @param header  Packet header of NET_HEADER_SIZE bytes
+  @param packet  Packet data
+  @param len     Length of packet data
+
+  @retval
+    0	ok
+  @retval
+    1	error
+*/
+
+static my_bool
+net_write_buff_with_header(NET *net, const uchar *header,
+                           const uchar *packet, size_t len)
+{
+#ifndef _WIN32
+  if (!net->compress &&
+      NET_HEADER_SIZE + len > (size_t) (net->buff_end - net->write_pos))
+  {
+    struct iovec iov[3];
+    int iovcnt= 0;
+
+    if (net->write_pos != net->buff)
+    {
+      iov[iovcnt].iov_base= net->buff;
+      iov[iovcnt++].iov_len= net->write_pos - net->buff;
+    }
+    iov[iovcnt].iov_base= const_cast<uchar*>(header);
+    iov[iovcnt++].iov_len= NET_HEADER_SIZE;
+    iov[iovcnt].iov_base= const_cast<uchar*>(packet);
+    iov[iovcnt++].iov_len= len;
+
+#ifdef DEBUG_DATA_PACKETS
+    DBUG_DUMP("data", packet, len);
+#endif
+    net->write_pos= net->buff;
+    return net_write_packet_vector(net, iov, iovcnt);
+  }
+#endif
+  return net_write_buff(net, header, NET_HEADER_SIZE) ||
+         net_write_buff(net, packet, len);
+}
 
 /*****************************************************************************
 ** Read something from server/clinet
 *****************************************************************************/
 
+#ifdef HAVE_COMPRESS
+/**
+  Uncompress a packet in place, like my_uncompress(), with the context
+  of the network handler if it has one.
+
+  @param          net      NET handler.
+  @param          packet   The compressed packet.
+  @param          len      Length of the compressed packet.
+  @param[in,out]  complen  Length of the original packet, 0 if the packet
+                           was sent uncompressed. Set to the length of
+                           the data.
+
+  @return TRUE on error, FALSE on success.
+*/
+
+static my_bool
+uncompress_packet(NET *net, uchar *packet, size_t len, size_t *complen)
+{
+  mysql_compress_context *ctx= net_compress_context(net);
+  my_bool error;
+#ifdef MYSQL_SERVER
+  const ulonglong start= my_micro_time();
+#endif
+
+  if (ctx == NULL || *complen == 0)
+    error= my_uncompress(packet, len, complen);
+  else
+  {
+    uchar *buffer= mysql_compress_context_buffer(ctx, *complen);
+    error= (buffer == NULL ||
+            my_uncompress_buffer(ctx, buffer, *complen, packet, len));
+    if (!error)
+      memcpy(packet, buffer, *complen);
+    if (buffer)
+      mysql_compress_context_release(ctx, buffer);
+  }
+
+#ifdef MYSQL_SERVER
+  if (!error)
+  {
+    my_atomic_add64(&uncompress_bytes_in, (int64) len);
+    my_atomic_add64(&uncompress_bytes_out, (int64) *complen);
+    my_atomic_add64(&uncompress_time, (int64) (my_micro_time() - start));
+  }
+#endif
+  return error;
+}
+#endif /* HAVE_COMPRESS */
+
 /**
   Read a determined number of bytes from a network handler.
 
@@ -997,8 +1292,8 @@ my_net_read(NET *net)
         MYSQL_NET_READ_DONE(1, 0);
         return packet_error;
       }
-      if (my_uncompress(net->buff + net->where_b, packet_len,
-                        &complen))
+      if (uncompress_packet(net, net->buff + net->where_b, packet_len,
+                            &complen))
       {
         net->error= 2;			/* caller will close socket */
         net->last_errno= ER_NET_UNCOMPRESS_ERROR;
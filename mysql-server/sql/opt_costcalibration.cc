@@ -0,0 +1,241 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "opt_costcalibration.h"
+#include "my_atomic.h"
+#include "key.h"                                // key_copy, key_restore
+#include "log.h"                                // sql_print_warning
+#include "opt_costconstantcache.h"              // Cost_constant_cache
+#include "opt_costconstants.h"                  // Cost_model_constants
+#include "sql_base.h"                           // open_and_lock_tables
+#include "sql_class.h"                          // THD
+#include "table.h"                              // TABLE
+#include "template_utils.h"                     // pointer_cast
+#include "transaction.h"                        // trans_commit_stmt
+
+extern Cost_constant_cache *cost_constant_cache;// defined in
+                                                // opt_costconstantcache.cc
+
+my_bool opt_cost_calibration= FALSE;
+
+/**
+  Number of operations of a kind that must have been measured before a
+  cost constant is calibrated from them.
+*/
+static const int64 MIN_CALIBRATION_SAMPLES= 1000;
+
+/// Number and total time of random reads, per storage engine slot
+static int64 volatile block_read_count[MAX_HA];
+static int64 volatile block_read_cycles[MAX_HA];
+
+/// Number and total time of condition evaluations
+static int64 volatile row_evaluate_count= 0;
+static int64 volatile row_evaluate_cycles= 0;
+
+
+void cost_calibration_reset()
+{
+  for (uint slot= 0; slot < MAX_HA; slot++)
+  {
+    my_atomic_store64(&block_read_count[slot], 0);
+    my_atomic_store64(&block_read_cycles[slot], 0);
+  }
+  my_atomic_store64(&row_evaluate_count, 0);
+  my_atomic_store64(&row_evaluate_cycles, 0);
+}
+
+
+void cost_calibration_add_block_read(const handlerton *ht,
+                                     const TABLE_SHARE *share,
+                                     ulonglong start)
+{
+  const ulonglong end= my_timer_cycles();
+  if (end <= start || share->tmp_table != NO_TMP_TABLE)
+    return;
+
+  const uint slot= ht->slot;
+  my_atomic_add64(&block_read_count[slot], 1);
+  my_atomic_add64(&block_read_cycles[slot], (int64) (end - start));
+}
+
+
+void cost_calibration_add_row_evaluate(ulonglong start)
+{
+  const ulonglong end= my_timer_cycles();
+  if (end <= start)
+    return;
+
+  my_atomic_add64(&row_evaluate_count, 1);
+  my_atomic_add64(&row_evaluate_cycles, (int64) (end - start));
+}
+
+
+/**
+  Insert or update the io_block_read_cost of a storage engine in the
+  engine_cost table.
+
+  @param table   the engine_cost table, opened for writing
+  @param engine  name of the storage engine
+  @param value   the cost
+
+  @returns handler error code
+*/
+
+static int store_io_block_read_cost(TABLE *table, const LEX_STRING &engine,
+                                    double value)
+{
+  static const char cost_name[]= "io_block_read_cost";
+  static const char comment[]= "calibrated by optimizer_cost_calibration";
+  uchar key[MAX_KEY_LENGTH];
+  struct timeval now= table->in_use->query_start_timeval();
+
+  /*
+    The engine constant table has the following columns:
+
+    engine_name VARCHAR(64) NOT NULL COLLATE utf8_general_ci,
+    device_type INTEGER NOT NULL,
+    cost_name   VARCHAR(64) NOT NULL COLLATE utf8_general_ci,
+    cost_value  FLOAT DEFAULT NULL,
+    last_update TIMESTAMP
+    comment     VARCHAR(1024) DEFAULT NULL,
+
+    with PRIMARY KEY (cost_name, engine_name, device_type).
+  */
+  empty_record(table);
+  table->field[0]->store(engine.str, engine.length, system_charset_info);
+  table->field[1]->store(0LL, true);
+  table->field[2]->store(cost_name, sizeof(cost_name) - 1,
+                         system_charset_info);
+  key_copy(key, table->record[0], table->key_info,
+           table->key_info->key_length);
+
+  int error= table->file->ha_index_read_idx_map(table->record[0], 0, key,
+                                                HA_WHOLE_KEY,
+                                                HA_READ_KEY_EXACT);
+  const bool found= (error == 0);
+  if (found)
+    store_record(table, record[1]);
+  else if (error == HA_ERR_KEY_NOT_FOUND || error == HA_ERR_END_OF_FILE)
+  {
+    empty_record(table);
+    key_restore(table->record[0], key, table->key_info,
+                table->key_info->key_length);
+  }
+  else
+    return error;
+
+  table->field[3]->set_notnull();
+  table->field[3]->store(value);
+  table->field[4]->store_timestamp(&now);
+  table->field[5]->set_notnull();
+  table->field[5]->store(comment, sizeof(comment) - 1, system_charset_info);
+
+  if (!found)
+    return table->file->ha_write_row(table->record[0]);
+
+  error= table->file->ha_update_row(table->record[1], table->record[0]);
+  if (error == HA_ERR_RECORD_IS_THE_SAME)
+    error= 0;
+  return error;
+}
+
+
+void store_calibrated_cost_constants()
+{
+  DBUG_ENTER("store_calibrated_cost_constants");
+
+  const int64 rows= my_atomic_load64(&row_evaluate_count);
+  if (!opt_cost_calibration || rows < MIN_CALIBRATION_SAMPLES)
+    DBUG_VOID_RETURN;
+
+  const double row_cycles=
+    static_cast<double>(my_atomic_load64(&row_evaluate_cycles)) / rows;
+  if (row_cycles <= 0.0)
+    DBUG_VOID_RETURN;                           /* purecov: inspected */
+
+  // The calibrated costs are relative to the current row_evaluate_cost
+  const Cost_model_constants *cost_constants=
+    cost_constant_cache->get_cost_constants();
+  const double row_evaluate_cost=
+    cost_constants->get_server_cost_constants()->row_evaluate_cost();
+  cost_constant_cache->release_cost_constants(cost_constants);
+
+  /*
+    Like read_cost_constants(), use a THD of our own, since the current
+    one may already have opened and closed tables.
+  */
+  THD *orig_thd= current_thd;
+  THD *thd= new THD;
+  thd->thread_stack= pointer_cast<char*>(&thd);
+  thd->store_globals();
+  thd->set_time();
+  // The measurements only apply to this server, don't replicate them
+  thd->variables.option_bits&= ~OPTION_BIN_LOG;
+
+  TABLE_LIST tables;
+  tables.init_one_table(C_STRING_WITH_LEN("mysql"),
+                        C_STRING_WITH_LEN("engine_cost"),
+                        "engine_cost", TL_WRITE);
+
+  int error= 0;
+  if (!open_and_lock_tables(thd, &tables, false, MYSQL_LOCK_IGNORE_TIMEOUT))
+  {
+    TABLE *table= tables.table;
+    table->use_all_columns();
+
+    for (uint slot= 0; slot < MAX_HA && !error; slot++)
+    {
+      const int64 reads= my_atomic_load64(&block_read_count[slot]);
+      if (hton2plugin[slot] == NULL || reads < MIN_CALIBRATION_SAMPLES)
+        continue;
+
+      const double read_cycles=
+        static_cast<double>(my_atomic_load64(&block_read_cycles[slot])) /
+        reads;
+      const double cost= row_evaluate_cost * read_cycles / row_cycles;
+      const LEX_STRING *engine= &hton2plugin[slot]->name;
+
+      if ((error= store_io_block_read_cost(table, *engine, cost)))
+        sql_print_warning("Failed to store the calibrated cost constants "
+                          "of the \"%s\" storage engine in the "
+                          "mysql.engine_cost table: error %d\n",
+                          engine->str, error);
+    }
+  }
+  else
+  {
+    error= 1;
+    sql_print_warning("Failed to open optimizer cost constant tables\n");
+  }
+
+  if (error)
+    trans_rollback_stmt(thd);
+  else
+    trans_commit_stmt(thd);
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+
+  delete thd;
+
+  // If the caller already had a THD, this must be restored
+  if (orig_thd)
+    orig_thd->store_globals();
+
+  // Start the next calibration period
+  if (!error)
+    cost_calibration_reset();
+
+  DBUG_VOID_RETURN;
+}
@@ -0,0 +1,88 @@
+#ifndef OPT_COSTCALIBRATION_INCLUDED
+#define OPT_COSTCALIBRATION_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Calibration of the storage engine cost constants from measurements.
+
+  The default io_block_read_cost assumes that reading a block is five
+  times as costly as evaluating the condition on a row. On fast storage,
+  or when the data is in the buffer pool, a read costs much less than
+  that. While @@optimizer_cost_calibration is ON, the server measures
+  the time of random reads through an index or by row position in each
+  storage engine, and the time of the evaluation of join conditions on a
+  row. The reads are measured above the engine, so buffer pool hits are
+  included in the average in the proportion they occur in the workload.
+
+  FLUSH OPTIMIZER_COSTS stores an io_block_read_cost for each engine
+  with enough measurements into mysql.engine_cost before the cost
+  constants are reloaded. The cost is row_evaluate_cost times the ratio
+  between the average read time and the average evaluation time.
+  Internal temporary tables are not measured.
+*/
+
+#include "my_global.h"
+#include "my_rdtsc.h"                           // my_timer_cycles
+
+struct handlerton;
+struct TABLE_SHARE;
+
+/// Whether the costs of reads and condition evaluations are measured
+extern my_bool opt_cost_calibration;
+
+/// Forget all measurements
+void cost_calibration_reset();
+
+/**
+  Start the measurement of an operation.
+
+  @returns the start time, or 0 if nothing is measured
+*/
+inline ulonglong cost_calibration_start()
+{
+  return opt_cost_calibration ? my_timer_cycles() : 0;
+}
+
+/**
+  Account for a random read.
+
+  @param ht     the storage engine of the handler the read was done with
+  @param share  the table that was read
+  @param start  value of cost_calibration_start() before the read
+*/
+void cost_calibration_add_block_read(const handlerton *ht,
+                                     const TABLE_SHARE *share,
+                                     ulonglong start);
+
+/**
+  Account for the evaluation of a condition on a row.
+
+  @param start  value of cost_calibration_start() before the evaluation
+*/
+void cost_calibration_add_row_evaluate(ulonglong start);
+
+/**
+  Store the calibrated engine cost constants into mysql.engine_cost, if
+  calibration is on and enough operations have been measured. Problems
+  are written to the error log.
+*/
+void store_calibrated_cost_constants();
+
+#endif /* OPT_COSTCALIBRATION_INCLUDED */
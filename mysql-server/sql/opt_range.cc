@@ -933,12 +933,45 @@ public:
   */
   bool use_index_statistics;
 
+  /**
+    Maximum number of bytes of mem_root, 0 for no limit. When it is
+    exceeded, the range optimizer gives up, see is_mem_exceeded().
+  */
+  ulonglong max_mem_size;
+  /// Whether max_mem_size has been exceeded
+  bool mem_exceeded;
+  /// mem_root->block_num when the memory use was last checked
+  uint mem_checked_blocks;
+
   bool statement_should_be_aborted() const
   {
     return
       thd->is_fatal_error ||
       thd->is_error() ||
-      alloced_sel_args > SEL_ARG::MAX_SEL_ARGS;
+      alloced_sel_args > SEL_ARG::MAX_SEL_ARGS ||
+      mem_exceeded;
+  }
+
+  /**
+    Check whether mem_root holds more than max_mem_size bytes. The
+    blocks of mem_root are only summed up when a block has been added
+    since the last check, so this is cheap enough to call for each
+    predicate, and for each value of an IN list.
+  */
+  bool is_mem_exceeded()
+  {
+    if (mem_exceeded || max_mem_size == 0 ||
+        mem_root->block_num == mem_checked_blocks)
+      return mem_exceeded;
+    mem_checked_blocks= mem_root->block_num;
+
+    ulonglong size= 0;
+    for (const USED_MEM *block= mem_root->used; block; block= block->next)
+      size+= block->size;
+    for (const USED_MEM *block= mem_root->free; block; block= block->next)
+      size+= block->size;
+    mem_exceeded= size > max_mem_size;
+    return mem_exceeded;
   }
 
   virtual ~RANGE_OPT_PARAM() {}
@@ -2854,6 +2887,9 @@ int test_quick_select(THD *thd, key_map keys_to_use,
     }
     param.key_parts_end=key_parts;
     param.alloced_sel_args= 0;
+    param.max_mem_size= thd->variables.range_optimizer_max_mem_size;
+    param.mem_exceeded= false;
+    param.mem_checked_blocks= 0;
 
     /* Calculate cost of full index read for the shortest covering index */
     if (!head->covering_keys.is_clear_all())
@@ -2889,6 +2925,22 @@ int test_quick_select(THD *thd, key_map keys_to_use,
         Opt_trace_array trace_setup_cond(trace, "setup_range_conditions");
         tree= get_mm_tree(&param, cond);
       }
+      if (param.mem_exceeded)
+      {
+        /*
+          The conditions have more ranges than can be analyzed within
+          @@range_optimizer_max_mem_size: fall back to a full scan.
+        */
+        push_warning_printf(thd, Sql_condition::SL_WARNING,
+                            ER_CAPACITY_EXCEEDED,
+                            ER(ER_CAPACITY_EXCEEDED),
+                            param.max_mem_size,
+                            "range_optimizer_max_mem_size",
+                            ER(ER_CAPACITY_EXCEEDED_IN_RANGE_OPTIMIZER));
+        trace_range.add("range_scan_possible", false).
+          add_alnum("cause", "memory_capacity_exceeded");
+        tree= NULL;
+      }
       if (tree)
       {
         if (tree->type == SEL_TREE::IMPOSSIBLE)
@@ -3329,6 +3381,9 @@ bool prune_partitions(THD *thd, TABLE *table, Item *pprune_cond)
   range_par->remove_jump_scans= FALSE;
   range_par->real_keynr[0]= 0;
   range_par->alloced_sel_args= 0;
+  range_par->max_mem_size= 0;
+  range_par->mem_exceeded= false;
+  range_par->mem_checked_blocks= 0;
 
   thd->no_errors=1;				// Don't warn about NULL
   thd->mem_root=&alloc;
@@ -6135,14 +6190,54 @@ static SEL_TREE *get_func_mm_tree_from_in_predicate(RANGE_OPT_PARAM *param,
   {
     // The expression is (<column>) IN (...)
     Field *field= static_cast<Item_field*>(predicand)->field;
+
+    if (op->array && op->array->result_type() != ROW_RESULT &&
+        op->array->used_count > 0)
+    {
+      /*
+        All values in the list are constants, which op->array holds
+        sorted. Build the tree from the distinct values in that order:
+        duplicates are skipped, each range is appended after the last
+        one of the SEL_ARG trees, and one Item is reused for all values
+        (created on the statement's mem_root, like for NOT IN above).
+        This keeps lists of many thousand values cheap to analyze.
+      */
+      MEM_ROOT *tmp_root= param->mem_root;
+      param->thd->mem_root= param->old_root;
+      Item *value_item= op->array->create_item();
+      param->thd->mem_root= tmp_root;
+
+      if (value_item)
+      {
+        SEL_TREE *tree= NULL;
+        for (uint i= 0; i < op->array->used_count; i++)
+        {
+          if (i > 0 && !op->array->compare_elems(i, i - 1))
+            continue;
+          if (param->is_mem_exceeded())
+            return NULL;
+          op->array->value_to_item(i, value_item);
+          SEL_TREE *value_tree= get_mm_parts(param, op, field,
+                                             Item_func::EQ_FUNC,
+                                             value_item, cmp_type);
+          tree= tree ? tree_or(param, tree, value_tree) : value_tree;
+          if (!tree)
+            return NULL;
+        }
+        return tree;
+      }
+    }
+
     SEL_TREE *tree= get_mm_parts(param, op, field, Item_func::EQ_FUNC,
                                  op->arguments()[1], cmp_type);
     if (tree)
     {
       Item **arg, **end;
       for (arg= op->arguments() + 2, end= arg + op->argument_count() - 2;
-           arg < end ; arg++)
+           arg < end && tree; arg++)
       {
+        if (param->is_mem_exceeded())
+          return NULL;
         tree= tree_or(param, tree, get_mm_parts(param, op, field,
                                                 Item_func::EQ_FUNC,
                                                 *arg, cmp_type));
@@ -6551,6 +6646,9 @@ static SEL_TREE *get_mm_tree(RANGE_OPT_PARAM *param,Item *cond)
     DBUG_RETURN(tree);
   }
 
+  if (param->is_mem_exceeded())
+    DBUG_RETURN(NULL);
+
   table_map ref_tables= 0;
   table_map param_comp= ~(param->prev_tables | param->read_tables |
 		          param->current_table);
@@ -24,6 +24,7 @@
 #include "unireg.h"                    // REQUIRED: for other includes
 #include "protocol.h"
 #include "sql_class.h"                          // THD
+#include "sql_cache.h"                          // query_cache
 #include <stdarg.h>
 
 using std::min;
@@ -204,6 +205,42 @@ bool net_send_error(NET *net, uint sql_errno, const char *err)
 }
 
 
+/**
+  Whether the responses in the network buffer can be held back instead
+  of being flushed, because the client pipelines commands (see
+  PROTOCOL_OPTION_PIPELINE) and has already sent the next one.
+  do_command() reads the next command after the responses, and they are
+  sent with those of the next command.
+
+  Responses are not held back with compression, or while the query cache
+  is enabled, as it stores and sends results bypassing the buffer.
+
+  @param thd  Thread handler
+
+  @retval TRUE   the responses can be held back
+  @retval FALSE  the responses must be flushed
+*/
+
+bool net_hold_responses(THD *thd)
+{
+  NET *net= &thd->net;
+  Vio *vio= net->vio;
+
+  if (!(thd->protocol_options & PROTOCOL_OPTION_PIPELINE) || !vio ||
+      net->compress || !query_cache.is_disabled())
+    return FALSE;
+
+  /* Named pipes and shared memory can't tell whether data is waiting */
+  const enum enum_vio_type type= vio_type(vio);
+  if (type != VIO_TYPE_TCPIP && type != VIO_TYPE_SOCKET &&
+      type != VIO_TYPE_SSL)
+    return FALSE;
+
+  /* Data already read into the buffers of the Vio is not seen by poll() */
+  return vio->has_data(vio) || vio_io_wait(vio, VIO_IO_EVENT_READ, 0) > 0;
+}
+
+
 /**
   Return OK to the client.
 
@@ -373,7 +410,7 @@ net_send_ok(THD *thd,
     DBUG_RETURN(1);
   }
   error= my_net_write(net, start, (size_t) (pos - start));
-  if (!error)
+  if (!error && !net_hold_responses(thd))
     error= net_flush(net);
 
   thd->get_stmt_da()->set_overwrite_status(false);
@@ -418,7 +455,7 @@ net_send_eof(THD *thd, uint server_status, uint statement_warn_count)
   {
     thd->get_stmt_da()->set_overwrite_status(true);
     error= write_eof_packet(thd, net, server_status, statement_warn_count);
-    if (!error)
+    if (!error && !net_hold_responses(thd))
       error= net_flush(net);
     thd->get_stmt_da()->set_overwrite_status(false);
     DBUG_PRINT("info", ("EOF sent, so no more error sending allowed"));
@@ -985,9 +1022,70 @@ err:
 bool Protocol::write()
 {
   DBUG_ENTER("Protocol::write");
+  if (packet == &m_net_row)
+    DBUG_RETURN(write_net_row());
   DBUG_RETURN(my_net_write(&thd->net, (uchar*) packet->ptr(),
                            packet->length()));
 }
+
+
+/**
+  Build the next row directly in the free space of the network buffer,
+  behind room for its packet header, instead of in the THD packet. Then
+  write() only has to fill in the header, and the row is not copied
+  before it is sent along with the other rows in the buffer.
+
+  Nothing changes if the packet is going to be compressed, or if too
+  little of the buffer is left. A row that outgrows the space is moved
+  to the heap by String::realloc(), and is sent with my_net_write().
+
+  Must be called before prepare_for_resend(), and be followed by
+  write() or end_net_row() before anything else is written to the
+  network.
+*/
+
+void Protocol::start_net_row()
+{
+  /* Rows smaller than this are not worth building in a fresh buffer */
+  static const size_t NET_ROW_MIN_SPACE= 256;
+  NET *net= &thd->net;
+
+  if (type() == PROTOCOL_LOCAL || !net->vio || net->compress)
+    return;
+
+  uchar *row= net->write_pos + NET_HEADER_SIZE;
+  if (row >= net->buff_end)
+    return;
+  /* In place rows are always sent as one packet */
+  const size_t space= min<size_t>(net->buff_end - row, MAX_PACKET_LENGTH - 1);
+  if (space < NET_ROW_MIN_SPACE + field_count / 8 + 2)
+    return;
+
+  m_net_row.set(reinterpret_cast<char*>(row), space, &my_charset_bin);
+  packet= &m_net_row;
+}
+
+
+/**
+  Send a row built by start_net_row().
+*/
+
+bool Protocol::write_net_row()
+{
+  NET *net= &thd->net;
+  uchar *header= net->write_pos;
+  const size_t length= m_net_row.length();
+
+  packet= &thd->packet;
+  if (m_net_row.ptr() != reinterpret_cast<char*>(header + NET_HEADER_SIZE))
+    return my_net_write(net, (uchar*) m_net_row.ptr(), length);
+
+  DBUG_ASSERT(header + NET_HEADER_SIZE + length <= net->buff_end);
+  int3store(header, static_cast<uint>(length));
+  header[3]= (uchar) net->pkt_nr++;
+  net->write_pos= header + NET_HEADER_SIZE + length;
+  return false;
+}
 #endif /* EMBEDDED_LIBRARY */
 
 
@@ -19,6 +19,15 @@
 #include "sql_error.h"
 #include "my_decimal.h"                         /* my_decimal */
 
+/*
+  Options of the protocol that the client has turned on for the session
+  with COM_SET_OPTION, in THD::protocol_options. See my_protocol_options.h.
+*/
+/** MYSQL_OPTION_PIPELINE_ON, see net_hold_responses() */
+#define PROTOCOL_OPTION_PIPELINE (1U << 0)
+/** MYSQL_OPTION_STMT_EXECUTE_BATCH_ON, see execute_batch() */
+#define PROTOCOL_OPTION_STMT_EXECUTE_BATCH (1U << 1)
+
 class i_string;
 class Field;
 class THD;
@@ -44,6 +53,14 @@ protected:
   char **next_field;
   MYSQL_FIELD *next_mysql_field;
   MEM_ROOT *alloc;
+#endif
+#ifndef EMBEDDED_LIBRARY
+  /**
+    Row built in the free space of the network buffer, see
+    start_net_row().
+  */
+  String m_net_row;
+  bool write_net_row();
 #endif
   bool net_store_data(const uchar *from, size_t length,
                       const CHARSET_INFO *fromcs, const CHARSET_INFO *tocs);
@@ -74,6 +91,18 @@ public:
   String *storage_packet() { return packet; }
   inline void free() { packet->free(); }
   virtual bool write();
+#ifndef EMBEDDED_LIBRARY
+  void start_net_row();
+  /// Build rows in the THD packet again, after an unsent row
+  void end_net_row()
+  {
+    if (packet == &m_net_row)
+      packet= &thd->packet;
+  }
+#else
+  void start_net_row() {}
+  void end_net_row() {}
+#endif
   inline  bool store(int from)
   { return store_long((longlong) from); }
   inline  bool store(uint32 from)
@@ -211,6 +240,7 @@ public:
 void send_warning(THD *thd, uint sql_errno, const char *err=0);
 bool net_send_error(THD *thd, uint sql_errno, const char *err);
 bool net_send_error(NET* net, uint sql_errno, const char* err);
+bool net_hold_responses(THD *thd);
 uchar *net_store_data(uchar *to,const uchar *from, size_t length);
 uchar *net_store_data(uchar *to,int32 from);
 uchar *net_store_data(uchar *to,longlong from);
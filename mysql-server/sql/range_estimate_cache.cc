@@ -0,0 +1,130 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "range_estimate_cache.h"
+#include "sql_class.h"                          // THD
+#include "handler.h"                            // handler
+#include "table.h"                              // TABLE_SHARE
+#include "mysqld.h"                             // key_memory_range_estimate_cache
+#include "my_md5.h"                             // compute_md5_hash
+
+ulong range_estimate_cache_time= 0;
+
+/// Number of estimates cached for each table
+static const uint RANGE_ESTIMATE_CACHE_SLOTS= 64;
+
+/// A cached estimate of the number of rows in a range
+struct Range_estimate
+{
+  /// Hash of the index number and the range, see make_range_digest()
+  uchar digest[MD5_HASH_SIZE];
+  /// my_micro_time() when the estimate was computed, 0 for an empty slot
+  ulonglong time;
+  ha_rows rows;
+};
+
+
+/// Append one end of a range to the buffer that is hashed
+static uchar *store_range_endpoint(uchar *pos, const key_range *endp)
+{
+  if (endp == NULL)
+  {
+    *pos++= 0;
+    return pos;
+  }
+  *pos++= 1;
+  *pos++= static_cast<uchar>(endp->flag);
+  int8store(pos, static_cast<ulonglong>(endp->keypart_map));
+  pos+= 8;
+  int2store(pos, endp->length);
+  pos+= 2;
+  memcpy(pos, endp->key, endp->length);
+  return pos + endp->length;
+}
+
+
+static void make_range_digest(uint keyno, const key_range *min_key,
+                              const key_range *max_key, uchar *digest)
+{
+  uchar buf[2 + 2 * (12 + MAX_KEY_LENGTH)];
+  uchar *pos= buf;
+  int2store(pos, keyno);
+  pos+= 2;
+  pos= store_range_endpoint(pos, min_key);
+  pos= store_range_endpoint(pos, max_key);
+  compute_md5_hash(reinterpret_cast<char*>(digest),
+                   reinterpret_cast<const char*>(buf),
+                   static_cast<int>(pos - buf));
+}
+
+
+ha_rows cached_records_in_range(handler *file, TABLE *table, uint keyno,
+                                key_range *min_key, key_range *max_key)
+{
+  TABLE_SHARE *const share= table->s;
+  const ulonglong max_age= range_estimate_cache_time * 1000ULL;
+
+  if (max_age == 0 || share->tmp_table != NO_TMP_TABLE ||
+#ifdef WITH_PARTITION_STORAGE_ENGINE
+      table->part_info != NULL ||
+#endif
+      (min_key && min_key->length > MAX_KEY_LENGTH) ||
+      (max_key && max_key->length > MAX_KEY_LENGTH))
+    return file->records_in_range(keyno, min_key, max_key);
+
+  uchar digest[MD5_HASH_SIZE];
+  make_range_digest(keyno, min_key, max_key, digest);
+  const uint slot= uint4korr(digest) % RANGE_ESTIMATE_CACHE_SLOTS;
+  THD *const thd= current_thd;
+  ulonglong now= my_micro_time();
+
+  mysql_mutex_lock(&share->LOCK_ha_data);
+  if (share->range_estimates == NULL)
+    share->range_estimates= static_cast<Range_estimate*>(
+      my_malloc(key_memory_range_estimate_cache,
+                RANGE_ESTIMATE_CACHE_SLOTS * sizeof(Range_estimate),
+                MYF(MY_ZEROFILL)));
+  Range_estimate *const entry=
+    share->range_estimates ? share->range_estimates + slot : NULL;
+  if (entry != NULL && entry->time != 0 && entry->time + max_age > now &&
+      memcmp(entry->digest, digest, MD5_HASH_SIZE) == 0)
+  {
+    const ha_rows rows= entry->rows;
+    mysql_mutex_unlock(&share->LOCK_ha_data);
+    thd->status_var.range_estimate_cache_hits++;
+    return rows;
+  }
+  mysql_mutex_unlock(&share->LOCK_ha_data);
+
+  thd->status_var.range_estimate_cache_misses++;
+  const ha_rows rows= file->records_in_range(keyno, min_key, max_key);
+  if (rows == HA_POS_ERROR || entry == NULL)
+    return rows;
+
+  now= my_micro_time();
+  mysql_mutex_lock(&share->LOCK_ha_data);
+  memcpy(entry->digest, digest, MD5_HASH_SIZE);
+  entry->time= now;
+  entry->rows= rows;
+  mysql_mutex_unlock(&share->LOCK_ha_data);
+  return rows;
+}
+
+
+void free_range_estimate_cache(TABLE_SHARE *share)
+{
+  my_free(share->range_estimates);
+  share->range_estimates= NULL;
+}
@@ -0,0 +1,64 @@
+#ifndef RANGE_ESTIMATE_CACHE_INCLUDED
+#define RANGE_ESTIMATE_CACHE_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Short-lived cache of the row estimates of index ranges.
+
+  The range optimizer estimates the number of rows in each range of each
+  candidate index with handler::records_in_range(), which for InnoDB is
+  a dive into the B-tree at both ends of the range. Statements that are
+  repeated with the same constants ask for the same estimates over and
+  over. Each TABLE_SHARE has a small cache of the estimates, keyed by
+  the MD5 hash of the index number and the range boundaries, that
+  answers such repeated requests without a dive.
+
+  An estimate is used for @@range_estimate_cache_time milliseconds after
+  it was computed, so the estimates follow changes of the data with that
+  delay. The cache is direct mapped: a new estimate replaces the one in
+  its slot. It is disabled when @@range_estimate_cache_time is 0, and is
+  not used for temporary and partitioned tables, whose estimates depend
+  on the session or on partition pruning.
+*/
+
+#include "my_global.h"
+#include "my_base.h"                            // ha_rows, key_range
+
+class handler;
+struct TABLE;
+struct TABLE_SHARE;
+
+extern ulong range_estimate_cache_time;
+
+/**
+  Get the number of rows in a range of an index, as
+  handler::records_in_range() does, from the estimate cache of the table
+  when possible.
+
+  @param file     handler of the table to call records_in_range() on
+  @param table    the table 'file' is open for
+*/
+ha_rows cached_records_in_range(handler *file, TABLE *table, uint keyno,
+                                key_range *min_key, key_range *max_key);
+
+/// Free the estimate cache of a table share
+void free_range_estimate_cache(TABLE_SHARE *share);
+
+#endif /* RANGE_ESTIMATE_CACHE_INCLUDED */
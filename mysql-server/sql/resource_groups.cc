@@ -0,0 +1,706 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "resource_groups.h"
+#include "my_atomic.h"
+#include "hash.h"                               // HASH
+#include "auth_common.h"                        // check_global_access
+#include "mysqld_thd_manager.h"                 // Global_THD_manager
+#include "sql_class.h"                          // THD
+#include "sql_parse.h"                          // Find_thd_with_id
+
+#ifdef __linux__
+#include <sched.h>                              // sched_getaffinity
+#include <sys/resource.h>                       // setpriority
+#include <sys/syscall.h>                        // SYS_gettid
+#endif
+
+/**
+  A resource group. The default group is not in the resource_groups hash.
+*/
+struct Resource_group
+{
+  /// Unique among the groups ever created, 0 for the default group
+  int64 id;
+  char name[NAME_LEN + 1];
+  size_t name_length;
+  /// The virtual CPUs of the group, empty for those of the default group
+  Vcpu_set vcpus;
+  int priority;
+};
+
+/// The groups created with CREATE RESOURCE GROUP, by name
+static HASH resource_groups;
+/// Protects resource_groups and changes of resource_groups_version
+static mysql_mutex_t LOCK_resource_groups;
+
+/// The CPUs and the priority of the server at startup
+static Resource_group default_group;
+/// Id of the next group created, protected by LOCK_resource_groups
+static int64 next_resource_group_id= 1;
+/// Number of virtual CPUs of the machine, up to MAX_VCPUS
+static uint vcpu_count= 0;
+/// Whether the server is allowed to raise the priority of its threads
+static bool thread_priority_supported= false;
+
+/**
+  Incremented when a group is created, altered or dropped, so that the
+  threads bound to the old version of a group are bound again. While it is
+  0, all threads are in the default group, and need not be bound.
+*/
+static int64 volatile resource_groups_version= 0;
+
+static uchar *resource_group_get_key(Resource_group *group, size_t *length,
+                                     my_bool not_used __attribute__((unused)))
+{
+  *length= group->name_length;
+  return (uchar*) group->name;
+}
+
+static PSI_memory_key key_memory_resource_groups;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_LOCK_resource_groups;
+
+static PSI_mutex_info all_resource_groups_mutexes[]=
+{
+  { &key_LOCK_resource_groups, "LOCK_resource_groups", PSI_FLAG_GLOBAL}
+};
+
+static PSI_memory_info all_resource_groups_memory[]=
+{
+  { &key_memory_resource_groups, "resource_groups", PSI_FLAG_GLOBAL}
+};
+
+static void init_resource_groups_psi_keys(void)
+{
+  const char* category= "sql";
+  int count;
+
+  count= array_elements(all_resource_groups_mutexes);
+  mysql_mutex_register(category, all_resource_groups_mutexes, count);
+
+  count= array_elements(all_resource_groups_memory);
+  mysql_memory_register(category, all_resource_groups_memory, count);
+}
+#endif /* HAVE_PSI_INTERFACE */
+
+
+/**
+  The group the current OS thread is bound to. This is kept per thread,
+  not per session: the thread pool runs a session on any of its threads,
+  and each thread for many sessions, which may be in other groups.
+*/
+struct Resource_group_binding
+{
+  /// Id of the group, valid only while version is the current one
+  int64 group_id;
+  /// resource_groups_version when the thread was bound, 0 if never
+  int64 version;
+};
+
+/// The Resource_group_binding of the current thread, NULL if never bound
+static thread_local_key_t THR_RESOURCE_GROUP_BINDING;
+
+static void free_resource_group_binding(void *binding)
+{
+  my_free(binding);
+}
+
+
+/**
+  Get the binding of the current thread, creating it if needed.
+
+  @returns the binding, NULL if out of memory
+*/
+
+static Resource_group_binding *current_thread_binding()
+{
+  Resource_group_binding *binding= static_cast<Resource_group_binding*>(
+    my_get_thread_local(THR_RESOURCE_GROUP_BINDING));
+  if (binding != NULL)
+    return binding;
+
+  binding= static_cast<Resource_group_binding*>(
+    my_malloc(key_memory_resource_groups, sizeof(Resource_group_binding),
+              MYF(MY_ZEROFILL)));
+  if (binding != NULL &&
+      my_set_thread_local(THR_RESOURCE_GROUP_BINDING, binding))
+  {
+    my_free(binding);
+    binding= NULL;
+  }
+  return binding;
+}
+
+
+bool resource_groups_init()
+{
+  DBUG_ENTER("resource_groups_init");
+
+#ifdef HAVE_PSI_INTERFACE
+  init_resource_groups_psi_keys();
+#endif
+
+  mysql_mutex_init(key_LOCK_resource_groups, &LOCK_resource_groups,
+                   MY_MUTEX_INIT_FAST);
+  if (my_hash_init(&resource_groups, system_charset_info, 16, 0, 0,
+                   (my_hash_get_key) resource_group_get_key, my_free, 0))
+    DBUG_RETURN(true);
+  if (my_create_thread_local_key(&THR_RESOURCE_GROUP_BINDING,
+                                 free_resource_group_binding))
+  {
+    my_hash_free(&resource_groups);
+    DBUG_RETURN(true);
+  }
+
+  default_group.id= 0;
+  strmov(default_group.name, "default");
+  default_group.name_length= strlen(default_group.name);
+  default_group.priority= 0;
+
+#ifdef __linux__
+  const long count= sysconf(_SC_NPROCESSORS_CONF);
+  vcpu_count= count > 0 ? std::min<ulong>(count, MAX_VCPUS) : 1;
+
+  // This is the main thread, which has the CPUs of the server
+  cpu_set_t cpu_set;
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set))
+    default_group.vcpus.set_prefix(vcpu_count);
+  else
+  {
+    for (uint cpu= 0; cpu < vcpu_count; cpu++)
+      if (CPU_ISSET(cpu, &cpu_set))
+        default_group.vcpus.set_bit(cpu);
+  }
+
+  errno= 0;
+  const int priority= getpriority(PRIO_PROCESS, 0);
+  if (errno == 0)
+    default_group.priority= priority;
+
+  /*
+    A thread can get a higher priority only with CAP_SYS_NICE, or with a
+    RLIMIT_NICE above it. Without it, a thread given a lower priority by a
+    group could not get the priority of the default group back, so the
+    priorities of groups are only used if this thread can raise its own
+    priority for a moment.
+  */
+  const id_t tid= (id_t) syscall(SYS_gettid);
+  if (default_group.priority > MIN_THREAD_PRIORITY &&
+      !setpriority(PRIO_PROCESS, tid, default_group.priority - 1))
+  {
+    thread_priority_supported= true;
+    (void) setpriority(PRIO_PROCESS, tid, default_group.priority);
+  }
+#endif
+
+  DBUG_RETURN(false);
+}
+
+
+void resource_groups_free()
+{
+  DBUG_ENTER("resource_groups_free");
+  if (!my_hash_inited(&resource_groups))
+    DBUG_VOID_RETURN;
+  my_hash_free(&resource_groups);
+  my_delete_thread_local_key(THR_RESOURCE_GROUP_BINDING);
+  mysql_mutex_destroy(&LOCK_resource_groups);
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Whether a name is that of the default group, which can be given as
+  DEFAULT, or as a quoted `default`.
+*/
+
+static bool is_default_group(const LEX_STRING &name)
+{
+  return name.str == NULL ||
+         !my_strcasecmp(system_charset_info, name.str, default_group.name);
+}
+
+
+static Resource_group *find_resource_group(const char *name, size_t length)
+{
+  mysql_mutex_assert_owner(&LOCK_resource_groups);
+  return (Resource_group*) my_hash_search(&resource_groups,
+                                          (const uchar*) name, length);
+}
+
+
+/**
+  Bind the current thread to the CPUs and the priority of a group.
+
+  @returns 0 if success, an errno otherwise
+*/
+
+static int bind_current_thread(const Resource_group &group)
+{
+#ifdef __linux__
+  const Vcpu_set &vcpus= group.vcpus.is_clear_all() ? default_group.vcpus :
+                                                      group.vcpus;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (uint cpu= 0; cpu < vcpu_count; cpu++)
+    if (vcpus.is_set(cpu))
+      CPU_SET(cpu, &cpu_set);
+
+  const int error= pthread_setaffinity_np(pthread_self(), sizeof(cpu_set),
+                                          &cpu_set);
+  if (error)
+    return error;
+
+  if (thread_priority_supported &&
+      setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), group.priority))
+    return errno;
+  return 0;
+#else
+  return ENOTSUP;
+#endif
+}
+
+
+/**
+  Bind the current thread to the resource group of a session. The sessions
+  of a group which no longer exists are put into the default group.
+
+  @param thd  session running on the current thread
+
+  @returns 0 if success, an errno otherwise
+*/
+
+static int apply_resource_group(THD *thd)
+{
+  char name[NAME_LEN + 1];
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  strmov(name, thd->resource_group_name);
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+
+  Resource_group group;
+  mysql_mutex_lock(&LOCK_resource_groups);
+  const int64 version= resource_groups_version;
+  const Resource_group *found= name[0] ?
+    find_resource_group(name, strlen(name)) : NULL;
+  group= found ? *found : default_group;
+  mysql_mutex_unlock(&LOCK_resource_groups);
+
+  /*
+    The thread may already be bound to the group by another session of it.
+    Otherwise don't try again before the groups change, even if binding
+    failed. A thread without a binding was never bound here, and has the
+    CPUs and the priority of the thread which created it.
+  */
+  int error= 0;
+  Resource_group_binding *binding= current_thread_binding();
+  if (binding == NULL || binding->version != version ||
+      binding->group_id != group.id)
+  {
+    error= bind_current_thread(group);
+    if (binding != NULL)
+    {
+      binding->group_id= group.id;
+      binding->version= version;
+    }
+  }
+
+  // Unless the session was moved to another group meanwhile
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  if (!strcmp(name, thd->resource_group_name))
+  {
+    if (!found)
+      thd->resource_group_name[0]= '\0';
+    my_atomic_store64(&thd->resource_group_id, group.id);
+    my_atomic_store64(&thd->resource_group_version, version);
+  }
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+  return error;
+}
+
+
+#ifndef DBUG_OFF
+/**
+  Whether the current thread has the CPUs of the group of a session.
+*/
+
+static bool thread_has_group_vcpus(THD *thd)
+{
+#ifdef __linux__
+  char name[NAME_LEN + 1];
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  strmov(name, thd->resource_group_name);
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+
+  mysql_mutex_lock(&LOCK_resource_groups);
+  const Resource_group *found= name[0] ?
+    find_resource_group(name, strlen(name)) : NULL;
+  const Vcpu_set vcpus= found && !found->vcpus.is_clear_all() ?
+                        found->vcpus : default_group.vcpus;
+  mysql_mutex_unlock(&LOCK_resource_groups);
+
+  cpu_set_t cpu_set;
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set))
+    return false;
+  for (uint cpu= 0; cpu < vcpu_count; cpu++)
+    if (vcpus.is_set(cpu) != (CPU_ISSET(cpu, &cpu_set) != 0))
+      return false;
+#endif
+  return true;
+}
+#endif /* DBUG_OFF */
+
+
+void resource_group_bind(THD *thd)
+{
+  const int64 version= my_atomic_load64(&resource_groups_version);
+  if (version != 0)
+  {
+    /*
+      Only the session itself changes its resource_group_id, and other
+      sessions moving it reset its resource_group_version, so the session
+      is bound to resource_group_id while that version is the current one.
+    */
+    const Resource_group_binding *binding=
+      static_cast<const Resource_group_binding*>(
+        my_get_thread_local(THR_RESOURCE_GROUP_BINDING));
+    if (binding == NULL || binding->version != version ||
+        my_atomic_load64(&thd->resource_group_version) != version ||
+        my_atomic_load64(&thd->resource_group_id) != binding->group_id)
+      (void) apply_resource_group(thd);
+  }
+
+  DBUG_EXECUTE_IF("resource_group_check_binding",
+                  DBUG_ASSERT(version == 0 || thread_has_group_vcpus(thd)););
+}
+
+
+void get_resource_group_name(THD *thd, char *buff)
+{
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  strmov(buff, thd->resource_group_name[0] ? thd->resource_group_name :
+                                             default_group.name);
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+}
+
+
+/**
+  Report an error if resource groups are not supported on this platform.
+*/
+
+static bool check_platform()
+{
+#ifdef __linux__
+  return false;
+#else
+  my_error(ER_NOT_SUPPORTED_YET, MYF(0), "resource groups on this platform");
+  return true;
+#endif
+}
+
+
+void Resource_group_options::reset()
+{
+  m_name= null_lex_str;
+  m_vcpus.clear_all();
+  m_priority= PRIORITY_NOT_SET;
+  m_thread_ids= NULL;
+}
+
+
+bool Resource_group_options::add_vcpus(ulong first, ulong last)
+{
+  if (first > last)
+  {
+    my_error(ER_INVALID_VCPU_RANGE, MYF(0), first, last);
+    return true;
+  }
+  if (last >= MAX_VCPUS)
+  {
+    my_error(ER_INVALID_VCPU_ID, MYF(0), last);
+    return true;
+  }
+  for (ulong cpu= first; cpu <= last; cpu++)
+    m_vcpus.set_bit(cpu);
+  return false;
+}
+
+
+bool Resource_group_options::add_thread_id(MEM_ROOT *mem_root,
+                                           ulong thread_id)
+{
+  if (m_thread_ids == NULL &&
+      !(m_thread_ids= new (mem_root)
+                      Mem_root_array<my_thread_id, true>(mem_root)))
+    return true;
+  return m_thread_ids->push_back(static_cast<my_thread_id>(thread_id));
+}
+
+
+bool Sql_cmd_common_resource_group::check_options(THD *thd) const
+{
+  if (check_platform() || check_global_access(thd, SUPER_ACL))
+    return true;
+
+  const LEX_STRING &name= m_options->m_name;
+  if (is_default_group(name))
+  {
+    my_error(ER_RESOURCE_GROUP_IS_DEFAULT, MYF(0));
+    return true;
+  }
+  if (name.length == 0)
+  {
+    my_error(ER_WRONG_VALUE, MYF(0), "resource group name", name.str);
+    return true;
+  }
+  if (name.length > NAME_LEN)
+  {
+    my_error(ER_TOO_LONG_IDENT, MYF(0), name.str);
+    return true;
+  }
+
+  const longlong priority= m_options->get_priority();
+  if (priority != Resource_group_options::PRIORITY_NOT_SET)
+  {
+    if (priority < MIN_THREAD_PRIORITY || priority > MAX_THREAD_PRIORITY)
+    {
+      my_error(ER_INVALID_THREAD_PRIORITY, MYF(0), priority, name.str,
+               MIN_THREAD_PRIORITY, MAX_THREAD_PRIORITY);
+      return true;
+    }
+    if (!thread_priority_supported && priority != default_group.priority)
+      push_warning_printf(thd, Sql_condition::SL_WARNING,
+                          ER_RESOURCE_GROUP_PRIORITY_IGNORED,
+                          ER(ER_RESOURCE_GROUP_PRIORITY_IGNORED), name.str);
+  }
+
+  const Vcpu_set &vcpus= m_options->get_vcpus();
+  for (uint cpu= vcpu_count; cpu < MAX_VCPUS; cpu++)
+  {
+    if (vcpus.is_set(cpu))
+    {
+      my_error(ER_INVALID_VCPU_ID, MYF(0), (ulong) cpu);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool Sql_cmd_create_resource_group::execute(THD *thd)
+{
+  DBUG_ENTER("Sql_cmd_create_resource_group::execute");
+
+  if (check_options(thd))
+    DBUG_RETURN(true);
+
+  const LEX_STRING &name= m_options->m_name;
+  mysql_mutex_lock(&LOCK_resource_groups);
+  if (find_resource_group(name.str, name.length))
+  {
+    mysql_mutex_unlock(&LOCK_resource_groups);
+    my_error(ER_RESOURCE_GROUP_EXISTS, MYF(0), name.str);
+    DBUG_RETURN(true);
+  }
+
+  Resource_group *group= static_cast<Resource_group*>(
+    my_malloc(key_memory_resource_groups, sizeof(Resource_group),
+              MYF(MY_WME)));
+  if (group == NULL)
+  {
+    mysql_mutex_unlock(&LOCK_resource_groups);
+    DBUG_RETURN(true);
+  }
+  new (group) Resource_group();
+  group->id= next_resource_group_id++;
+  strmake(group->name, name.str, name.length);
+  group->name_length= name.length;
+  group->vcpus= m_options->get_vcpus();
+  group->priority= m_options->get_priority() ==
+    Resource_group_options::PRIORITY_NOT_SET ?
+    0 : static_cast<int>(m_options->get_priority());
+
+  if (my_hash_insert(&resource_groups, (uchar*) group))
+  {
+    mysql_mutex_unlock(&LOCK_resource_groups);
+    my_free(group);
+    DBUG_RETURN(true);
+  }
+  my_atomic_add64(&resource_groups_version, 1);
+  mysql_mutex_unlock(&LOCK_resource_groups);
+
+  my_ok(thd);
+  DBUG_RETURN(false);
+}
+
+
+bool Sql_cmd_alter_resource_group::execute(THD *thd)
+{
+  DBUG_ENTER("Sql_cmd_alter_resource_group::execute");
+
+  if (check_options(thd))
+    DBUG_RETURN(true);
+
+  const LEX_STRING &name= m_options->m_name;
+  mysql_mutex_lock(&LOCK_resource_groups);
+  Resource_group *group= find_resource_group(name.str, name.length);
+  if (group == NULL)
+  {
+    mysql_mutex_unlock(&LOCK_resource_groups);
+    my_error(ER_RESOURCE_GROUP_NOT_EXISTS, MYF(0), name.str);
+    DBUG_RETURN(true);
+  }
+
+  if (!m_options->get_vcpus().is_clear_all())
+    group->vcpus= m_options->get_vcpus();
+  if (m_options->get_priority() != Resource_group_options::PRIORITY_NOT_SET)
+    group->priority= static_cast<int>(m_options->get_priority());
+  my_atomic_add64(&resource_groups_version, 1);
+  mysql_mutex_unlock(&LOCK_resource_groups);
+
+  my_ok(thd);
+  DBUG_RETURN(false);
+}
+
+
+bool Sql_cmd_drop_resource_group::execute(THD *thd)
+{
+  DBUG_ENTER("Sql_cmd_drop_resource_group::execute");
+
+  if (check_options(thd))
+    DBUG_RETURN(true);
+
+  const LEX_STRING &name= m_options->m_name;
+  mysql_mutex_lock(&LOCK_resource_groups);
+  Resource_group *group= find_resource_group(name.str, name.length);
+  if (group == NULL)
+  {
+    mysql_mutex_unlock(&LOCK_resource_groups);
+    my_error(ER_RESOURCE_GROUP_NOT_EXISTS, MYF(0), name.str);
+    DBUG_RETURN(true);
+  }
+
+  // The sessions of the group go to the default group when bound again
+  my_hash_delete(&resource_groups, (uchar*) group);
+  my_atomic_add64(&resource_groups_version, 1);
+  mysql_mutex_unlock(&LOCK_resource_groups);
+
+  my_ok(thd);
+  DBUG_RETURN(false);
+}
+
+
+bool Sql_cmd_set_resource_group::execute(THD *thd)
+{
+  DBUG_ENTER("Sql_cmd_set_resource_group::execute");
+
+  if (check_platform())
+    DBUG_RETURN(true);
+
+  const Mem_root_array<my_thread_id, true> *thread_ids=
+    m_options->get_thread_ids();
+  if (thread_ids != NULL && check_global_access(thd, SUPER_ACL))
+    DBUG_RETURN(true);
+
+  // The name of the group the sessions are moved into, empty for default
+  char name[NAME_LEN + 1]= "";
+  int priority= default_group.priority;
+  if (!is_default_group(m_options->m_name))
+  {
+    const LEX_STRING &group_name= m_options->m_name;
+    mysql_mutex_lock(&LOCK_resource_groups);
+    const Resource_group *group= find_resource_group(group_name.str,
+                                                     group_name.length);
+    if (group != NULL)
+    {
+      strmov(name, group->name);
+      priority= group->priority;
+    }
+    mysql_mutex_unlock(&LOCK_resource_groups);
+
+    if (group == NULL)
+    {
+      my_error(ER_RESOURCE_GROUP_NOT_EXISTS, MYF(0), group_name.str);
+      DBUG_RETURN(true);
+    }
+  }
+
+  if (thread_ids != NULL)
+  {
+    /*
+      Move the sessions with the given ids, which bind themselves to the
+      group at their next command. Check all ids first, so that nothing
+      is changed if one is wrong.
+    */
+    Global_THD_manager *thd_manager= Global_THD_manager::get_instance();
+    for (uint pass= 0; pass < 2; pass++)
+    {
+      for (size_t i= 0; i < thread_ids->size(); i++)
+      {
+        const my_thread_id id= thread_ids->at(i);
+        Find_thd_with_id find_thd_with_id(id);
+        THD *tmp= thd_manager->find_thd(id, &find_thd_with_id);
+        if (tmp == NULL)
+        {
+          if (pass == 0)
+          {
+            my_error(ER_NO_SUCH_THREAD, MYF(0), (ulong) id);
+            DBUG_RETURN(true);
+          }
+          continue;                             // Ended meanwhile
+        }
+        if (pass == 1)
+        {
+          strmov(tmp->resource_group_name, name);
+          my_atomic_store64(&tmp->resource_group_version, 0);
+        }
+        mysql_mutex_unlock(&tmp->LOCK_thd_data);
+      }
+    }
+    my_ok(thd);
+    DBUG_RETURN(false);
+  }
+
+  if (thread_priority_supported && priority < default_group.priority &&
+      check_global_access(thd, SUPER_ACL))
+    DBUG_RETURN(true);
+
+  // Move the session, and bind it now, to report failures
+  char old_name[NAME_LEN + 1];
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  strmov(old_name, thd->resource_group_name);
+  strmov(thd->resource_group_name, name);
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+
+  const int error= apply_resource_group(thd);
+  if (error)
+  {
+    mysql_mutex_lock(&thd->LOCK_thd_data);
+    strmov(thd->resource_group_name, old_name);
+    my_atomic_store64(&thd->resource_group_version, 0);
+    mysql_mutex_unlock(&thd->LOCK_thd_data);
+    resource_group_bind(thd);
+
+    char errbuf[MYSYS_STRERROR_SIZE];
+    my_error(ER_RESOURCE_GROUP_BIND_FAILED, MYF(0),
+             name[0] ? name : default_group.name, (ulong) thd->thread_id(),
+             my_strerror(errbuf, sizeof(errbuf), error));
+    DBUG_RETURN(true);
+  }
+
+  my_ok(thd);
+  DBUG_RETURN(false);
+}
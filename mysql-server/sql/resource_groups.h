@@ -0,0 +1,264 @@
+#ifndef RESOURCE_GROUPS_INCLUDED
+#define RESOURCE_GROUPS_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Resource groups: named sets of virtual CPUs with a thread priority,
+  which the threads of sessions are bound to.
+
+  @verbatim
+  CREATE RESOURCE GROUP name [VCPU [=] n[-m][, ...]] [THREAD_PRIORITY [=] n]
+  ALTER RESOURCE GROUP name [VCPU [=] n[-m][, ...]] [THREAD_PRIORITY [=] n]
+  DROP RESOURCE GROUP name
+  SET RESOURCE GROUP {name | DEFAULT} [FOR id[, ...]]
+  @endverbatim
+
+  The thread of a session in a group only runs on the CPUs of the group,
+  or on all CPUs of the server if the group has no VCPU list, and with the
+  priority of the group, a nice value from -20 (highest) to 19 (lowest).
+  Sessions which are in no group are in the default group, which has the
+  CPUs and the priority the server was started with. SET RESOURCE GROUP
+  moves the current session, or the sessions with the given processlist
+  ids, into a group; a user is put into a group with @@init_connect. The
+  sessions of a dropped group go back to the default group.
+
+  Creating, altering and dropping groups, and moving other sessions, needs
+  the SUPER privilege, as does moving the own session into a group with a
+  higher priority than the default group. The groups only live in memory;
+  they can be created at startup with --init-file.
+
+  A session is bound to its group by resource_group_bind() at the start of
+  each command, and a replication applier thread before each event or
+  transaction it applies. What each OS thread is bound to is kept per
+  thread, as the thread pool runs sessions of different groups on the
+  same thread. The thread is bound again when a group was changed, or when
+  it was last bound to another group than that of the session; otherwise
+  this only costs a few atomic reads. Sessions moved by another session
+  are thus bound at their next command.
+
+  Binding threads is only supported on Linux. Any thread may lower its
+  priority, but raising it again needs the CAP_SYS_NICE capability; if
+  the server does not have it, the priorities of groups are ignored.
+*/
+
+#include "my_global.h"
+#include "mem_root_array.h"                     // Mem_root_array
+#include "sql_bitmap.h"                         // Bitmap
+#include "sql_cmd.h"                            // Sql_cmd
+
+#include <algorithm>
+
+class THD;
+
+/// Number of virtual CPUs a resource group can use
+static const uint MAX_VCPUS= 1024;
+
+/// Range of the thread priorities of resource groups
+static const int MIN_THREAD_PRIORITY= -20;
+static const int MAX_THREAD_PRIORITY= 19;
+
+typedef Bitmap<MAX_VCPUS> Vcpu_set;
+
+
+/**
+  Resource group options as set by the parser.
+*/
+
+class Resource_group_options
+{
+public:
+  /// Name of the group, NULL for the default group in SET RESOURCE GROUP
+  LEX_STRING m_name;
+private:
+  /// The VCPU list, empty if not given
+  Vcpu_set m_vcpus;
+  /// The THREAD_PRIORITY, or PRIORITY_NOT_SET
+  longlong m_priority;
+  /// Processlist ids of SET RESOURCE GROUP ... FOR, NULL if not given
+  Mem_root_array<my_thread_id, true> *m_thread_ids;
+
+public:
+  static const longlong PRIORITY_NOT_SET= LLONG_MAX;
+
+  /**
+    Reset the options, to prepare them for a new statement.
+  */
+  void reset();
+
+  /**
+    Add the virtual CPUs first to last to the VCPU list.
+
+    @returns false if success, true (with an error) if the range is invalid
+  */
+  bool add_vcpus(ulong first, ulong last);
+
+  void set_priority(ulong priority, bool negative)
+  {
+    m_priority= std::min<ulong>(priority, INT_MAX32);
+    if (negative)
+      m_priority= -m_priority;
+  }
+
+  /**
+    Add a processlist id to the FOR list.
+
+    @returns false if success, true if out of memory
+  */
+  bool add_thread_id(MEM_ROOT *mem_root, ulong thread_id);
+
+  const Vcpu_set &get_vcpus() const { return m_vcpus; }
+  longlong get_priority() const { return m_priority; }
+  const Mem_root_array<my_thread_id, true> *get_thread_ids() const
+  { return m_thread_ids; }
+};
+
+
+/**
+  Create the default resource group from the CPUs and the priority of the
+  server, and find out whether thread priorities can be raised.
+
+  @returns false if success, true otherwise
+*/
+bool resource_groups_init();
+
+void resource_groups_free();
+
+/**
+  Bind the current thread to the resource group of a session, unless
+  the thread is bound to the current version of that group. Failures are
+  ignored, the thread then stays as it is.
+
+  @param thd  session running on the current thread
+*/
+void resource_group_bind(THD *thd);
+
+/**
+  Copy the name of the resource group of a session.
+
+  @param thd   the session
+  @param buff  buffer of at least NAME_LEN + 1 bytes
+*/
+void get_resource_group_name(THD *thd, char *buff);
+
+
+/**
+   This class has common code for the resource group statements.
+*/
+
+class Sql_cmd_common_resource_group : public Sql_cmd
+{
+protected:
+  /**
+    m_name of the options is the name of the group. The remaining options
+    are as set by the parser.
+  */
+  const Resource_group_options *m_options;
+
+  Sql_cmd_common_resource_group(const Resource_group_options *options)
+    : m_options(options)
+  { }
+
+  virtual ~Sql_cmd_common_resource_group()
+  { }
+
+  /**
+    Check the privileges, the name and the options of the statement.
+
+    @param thd  Thread context
+
+    @returns false if success, true (with an error) otherwise
+  */
+  bool check_options(THD *thd) const;
+};
+
+
+/**
+   This class implements the CREATE RESOURCE GROUP statement.
+*/
+
+class Sql_cmd_create_resource_group : public Sql_cmd_common_resource_group
+{
+public:
+  Sql_cmd_create_resource_group(const Resource_group_options *options)
+    : Sql_cmd_common_resource_group(options)
+  { }
+
+  enum_sql_command sql_command_code() const
+  { return SQLCOM_CREATE_RESOURCE_GROUP; }
+
+  bool execute(THD *thd);
+};
+
+
+/**
+   This class implements the ALTER RESOURCE GROUP statement. Options
+   which are not given are left as they are.
+*/
+
+class Sql_cmd_alter_resource_group : public Sql_cmd_common_resource_group
+{
+public:
+  Sql_cmd_alter_resource_group(const Resource_group_options *options)
+    : Sql_cmd_common_resource_group(options)
+  { }
+
+  enum_sql_command sql_command_code() const
+  { return SQLCOM_ALTER_RESOURCE_GROUP; }
+
+  bool execute(THD *thd);
+};
+
+
+/**
+   This class implements the DROP RESOURCE GROUP statement.
+*/
+
+class Sql_cmd_drop_resource_group : public Sql_cmd_common_resource_group
+{
+public:
+  Sql_cmd_drop_resource_group(const Resource_group_options *options)
+    : Sql_cmd_common_resource_group(options)
+  { }
+
+  enum_sql_command sql_command_code() const
+  { return SQLCOM_DROP_RESOURCE_GROUP; }
+
+  bool execute(THD *thd);
+};
+
+
+/**
+   This class implements the SET RESOURCE GROUP statement.
+*/
+
+class Sql_cmd_set_resource_group : public Sql_cmd_common_resource_group
+{
+public:
+  Sql_cmd_set_resource_group(const Resource_group_options *options)
+    : Sql_cmd_common_resource_group(options)
+  { }
+
+  enum_sql_command sql_command_code() const
+  { return SQLCOM_SET_RESOURCE_GROUP; }
+
+  bool execute(THD *thd);
+};
+
+#endif /* RESOURCE_GROUPS_INCLUDED */
@@ -59,6 +59,7 @@
 #include "rpl_mts_submode.h"
 #include "mysqld_thd_manager.h"                 // Global_THD_manager
 #include "rpl_slave_commit_order_manager.h"
+#include "resource_groups.h"                    // resource_group_bind
 
 #include <algorithm>
 
@@ -4837,6 +4838,7 @@ pthread_handler_t handle_slave_worker(void *arg)
 
   while (!error)
   {
+    resource_group_bind(thd);
     error= slave_worker_exec_job_group(w, rli);
   }
 
@@ -5982,7 +5984,10 @@ log '%s' at position %s, relay log '%s' position: %s", rli->get_rpl_log_name(),
         rli->get_group_master_log_name(), (ulong) rli->get_group_master_log_pos());
       saved_skip= 0;
     }
-    
+
+    /* The applier can be moved to a resource group with SET RESOURCE GROUP */
+    resource_group_bind(thd);
+
     if (exec_relay_log_event(thd,rli))
     {
       DBUG_PRINT("info", ("exec_relay_log_event() failed"));
@@ -1827,6 +1827,8 @@ sp_head *sp_find_routine(THD *thd, enum_sp_type type, sp_name *name,
   }
   if (!cache_only)
   {
+    if ((sp= sp_cache_checkout(thd, cp, type, name)))
+      DBUG_RETURN(sp);
     if (db_find_routine(thd, type, name, &sp) == SP_OK)
     {
       sp_cache_insert(cp, sp);
@@ -2136,6 +2138,9 @@ int sp_cache_routine(THD *thd, enum_sp_type type, sp_name *name,
       DBUG_RETURN(SP_OK);
   }
 
+  if ((*sp= sp_cache_checkout(thd, spc, type, name)))
+    DBUG_RETURN(SP_OK);
+
   switch ((ret= db_find_routine(thd, type, name, sp)))
   {
     case SP_OK:
@@ -24,6 +24,10 @@
   Cache of stored routines.
 */
 
+ulong stored_program_shared_cache_size= 0;
+
+static bool sp_shared_cache_put(sp_head *sp);
+
 extern "C"
 {
   static uchar *hash_get_key_for_sp_head(const uchar *ptr, size_t *plen,
@@ -38,7 +42,8 @@ extern "C"
   static void hash_free_sp_head(void *p)
   {
     sp_head *sp= (sp_head *)p;
-    delete sp;
+    if (!sp_shared_cache_put(sp))
+      delete sp;
   }
 }
 
@@ -93,6 +98,22 @@ public:
       my_hash_reset(&m_hashtable);
   }
 
+  /**
+    Remove at most 'count' routines from the cache. The routines are
+    handed to hash_free_sp_head(), which returns them to the shared cache.
+  */
+  void release(ulong count)
+  {
+    /*
+      my_hash_delete() moves the last element into the freed slot, so
+      walk backwards to visit every element once.
+    */
+    for (ulong idx= m_hashtable.records; idx > 0 && count > 0; count--)
+      my_hash_delete(&m_hashtable, my_hash_element(&m_hashtable, --idx));
+  }
+
+  ulong size() const { return m_hashtable.records; }
+
 private:
   /* All routines in this cache */
   HASH m_hashtable;
@@ -102,6 +123,197 @@ private:
 static int64 volatile Cversion= 0;
 
 
+/*
+  Shared cache of idle stored routines.
+
+  A parsed routine (sp_head with its instructions and their LEXes and
+  Items) is modified when it is executed, so it can't be run by several
+  connections at the same time. Instead, the connections share the
+  routines that are not in use: when a routine leaves a connection cache
+  at the end of a statement or at disconnect, it is kept here, and the
+  next connection that needs it takes it out instead of reading and
+  parsing mysql.proc again. A connection thus only holds the routines
+  used by its current statement, and the number of parsed copies of a
+  routine follows the number of connections executing it concurrently.
+
+  Routines are keyed by their qualified name, several idle copies of the
+  same routine may be kept. A routine is only reused if it is of the
+  current cache version, see sp_cache_invalidate().
+*/
+
+static HASH shared_routines;
+static mysql_mutex_t LOCK_sp_shared_cache;
+/// Cache version the shared cache was last purged of obsolete routines at
+static int64 shared_routines_version= 0;
+static bool sp_shared_cache_inited= false;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_LOCK_sp_shared_cache;
+
+static PSI_mutex_info sp_cache_mutexes[]=
+{
+  { &key_LOCK_sp_shared_cache, "LOCK_sp_shared_cache", PSI_FLAG_GLOBAL}
+};
+
+
+static void init_sp_cache_psi_keys()
+{
+  int count;
+
+  count= array_elements(sp_cache_mutexes);
+  mysql_mutex_register("sql", sp_cache_mutexes, count);
+}
+#endif
+
+
+void sp_cache_init()
+{
+#ifdef HAVE_PSI_INTERFACE
+  init_sp_cache_psi_keys();
+#endif
+
+  mysql_mutex_init(key_LOCK_sp_shared_cache, &LOCK_sp_shared_cache,
+                   MY_MUTEX_INIT_FAST);
+  my_hash_init(&shared_routines, system_charset_info, 0, 0, 0,
+               hash_get_key_for_sp_head, NULL, 0);
+  sp_shared_cache_inited= true;
+}
+
+
+/**
+  Delete all routines of the shared cache, or only the obsolete ones.
+  The caller must hold LOCK_sp_shared_cache.
+*/
+
+static void sp_shared_cache_purge(bool obsolete_only)
+{
+  int64 version= sp_cache_version();
+  for (ulong idx= shared_routines.records; idx > 0; )
+  {
+    sp_head *sp= (sp_head *) my_hash_element(&shared_routines, --idx);
+    if (!obsolete_only || sp->sp_cache_version() < version)
+    {
+      my_hash_delete(&shared_routines, (uchar *) sp);
+      delete sp;
+    }
+  }
+  shared_routines_version= version;
+}
+
+
+void sp_cache_end()
+{
+  if (sp_shared_cache_inited)
+  {
+    sp_shared_cache_inited= false;
+    sp_shared_cache_purge(false);
+    my_hash_free(&shared_routines);
+    mysql_mutex_destroy(&LOCK_sp_shared_cache);
+  }
+}
+
+
+/**
+  Delete routines from the shared cache until it holds no more than
+  @@stored_program_shared_cache routines. Called when the variable is set.
+*/
+
+void sp_cache_shrink_shared()
+{
+  if (!sp_shared_cache_inited)
+    return;
+
+  mysql_mutex_lock(&LOCK_sp_shared_cache);
+  if (shared_routines.records > stored_program_shared_cache_size)
+    sp_shared_cache_purge(true);
+  while (shared_routines.records > stored_program_shared_cache_size)
+  {
+    sp_head *sp= (sp_head *) my_hash_element(&shared_routines,
+                                             shared_routines.records - 1);
+    my_hash_delete(&shared_routines, (uchar *) sp);
+    delete sp;
+  }
+  mysql_mutex_unlock(&LOCK_sp_shared_cache);
+}
+
+
+/**
+  Keep a routine that has left a connection cache in the shared cache.
+
+  @returns true if the shared cache took over the routine, false if the
+           caller must delete it
+*/
+
+static bool sp_shared_cache_put(sp_head *sp)
+{
+  if (stored_program_shared_cache_size == 0 || !sp_shared_cache_inited ||
+      sp->is_invoked() || sp->sp_cache_version() < sp_cache_version())
+    return false;
+
+  bool taken= false;
+  mysql_mutex_lock(&LOCK_sp_shared_cache);
+  if (shared_routines.records >= stored_program_shared_cache_size &&
+      shared_routines_version < sp_cache_version())
+    sp_shared_cache_purge(true);
+  if (shared_routines.records < stored_program_shared_cache_size)
+    taken= !my_hash_insert(&shared_routines, (uchar *) sp);
+  mysql_mutex_unlock(&LOCK_sp_shared_cache);
+  return taken;
+}
+
+
+/**
+  Take a routine out of the shared cache and put it into a connection
+  cache.
+
+  @param thd   thread context
+  @param cp    the connection cache of routines of type 'type'
+  @param type  SP_TYPE_FUNCTION or SP_TYPE_PROCEDURE
+  @param name  name of the routine
+
+  @returns the routine, or NULL if the shared cache has no up to date
+           copy of it
+*/
+
+sp_head *sp_cache_checkout(THD *thd, sp_cache **cp, enum_sp_type type,
+                           sp_name *name)
+{
+  if (stored_program_shared_cache_size == 0 || !sp_shared_cache_inited)
+    return NULL;
+
+  sp_head *sp;
+  HASH_SEARCH_STATE state;
+  int64 version= sp_cache_version();
+  mysql_mutex_lock(&LOCK_sp_shared_cache);
+  for (sp= (sp_head *) my_hash_first(&shared_routines,
+                                     (uchar *) name->m_qname.str,
+                                     name->m_qname.length, &state);
+       sp != NULL;
+       sp= (sp_head *) my_hash_next(&shared_routines,
+                                    (uchar *) name->m_qname.str,
+                                    name->m_qname.length, &state))
+  {
+    if (sp->m_type == type && sp->sp_cache_version() == version)
+    {
+      my_hash_delete(&shared_routines, (uchar *) sp);
+      break;
+    }
+  }
+  mysql_mutex_unlock(&LOCK_sp_shared_cache);
+
+  if (sp == NULL)
+  {
+    thd->status_var.sp_shared_cache_misses++;
+    return NULL;
+  }
+  thd->status_var.sp_shared_cache_hits++;
+  DBUG_PRINT("info",("sp_cache: checked out: %.*s", (int) sp->m_qname.length,
+                     sp->m_qname.str));
+  sp_cache_insert(cp, sp);
+  return sp;
+}
+
+
 /*
   Clear the cache *cp and set *cp to NULL.
 
@@ -235,6 +447,10 @@ int64 sp_cache_version()
   Enforce that the current number of elements in the cache don't exceed
   the argument value by flushing the cache if necessary.
 
+  If the shared cache is enabled, the routines are first returned to it,
+  as far as it has room for them. This is called between statements,
+  when the connection doesn't use any routine.
+
   @param[in] c  Cache to check
   @param[in] upper_limit_for_elements  Soft upper limit for number of sp_head
                                        objects that can be stored in the cache.
@@ -242,6 +458,17 @@ int64 sp_cache_version()
 void
 sp_cache_enforce_limit(sp_cache *c, ulong upper_limit_for_elements)
 {
- if (c)
-   c->enforce_limit(upper_limit_for_elements);
+  if (!c)
+    return;
+
+  if (stored_program_shared_cache_size > 0 && sp_shared_cache_inited &&
+      c->size() > 0)
+  {
+    mysql_mutex_lock(&LOCK_sp_shared_cache);
+    ulong used= shared_routines.records;
+    mysql_mutex_unlock(&LOCK_sp_shared_cache);
+    if (used < stored_program_shared_cache_size)
+      c->release(stored_program_shared_cache_size - used);
+  }
+  c->enforce_limit(upper_limit_for_elements);
 }
@@ -18,17 +18,23 @@
 #define _SP_CACHE_H_
 
 #include "my_global.h"                          /* ulong */
+#include "sql_lex.h"                            /* enum_sp_type */
 
 /*
   Stored procedures/functions cache. This is used as follows:
    * Each thread has its own cache.
    * Each sp_head object is put into its thread cache before it is used, and
-     then remains in the cache until deleted.
+     then remains in the cache until deleted, or until it is returned to
+     the shared cache of idle routines (see sp_cache_checkout()).
 */
 
 class sp_head;
 class sp_cache;
 class sp_name;
+class THD;
+
+/// Soft upper limit for the number of routines in the shared cache
+extern ulong stored_program_shared_cache_size;
 
 /*
   Cache usage scenarios:
@@ -46,8 +52,16 @@ class sp_name;
 
   2. Before thread exit:
     sp_cache_clear();
+
+  3. When a routine is not in the thread cache, before loading it from
+     mysql.proc:
+    sp_cache_checkout();
 */
 
+void sp_cache_init();
+void sp_cache_end();
+void sp_cache_shrink_shared();
+
 void sp_cache_clear(sp_cache **cp);
 void sp_cache_insert(sp_cache **cp, sp_head *sp);
 sp_head *sp_cache_lookup(sp_cache **cp, sp_name *name);
@@ -55,5 +69,7 @@ void sp_cache_invalidate();
 void sp_cache_flush_obsolete(sp_cache **cp, sp_head **sp);
 int64 sp_cache_version();
 void sp_cache_enforce_limit(sp_cache *cp, ulong upper_limit_for_elements);
+sp_head *sp_cache_checkout(THD *thd, sp_cache **cp, enum_sp_type type,
+                           sp_name *name);
 
 #endif /* _SP_CACHE_H_ */
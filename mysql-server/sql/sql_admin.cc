@@ -29,6 +29,9 @@
 #include "sql_parse.h"                       // check_table_access
 #include "sql_admin.h"
 #include "table_trigger_dispatcher.h"        // Table_trigger_dispatcher
+#include "histograms.h"                      // update_histograms
+
+#include <algorithm>
 
 static int send_check_errmsg(THD *thd, TABLE_LIST* table,
 			     const char* operator_name, const char* errmsg)
@@ -1085,6 +1088,186 @@ bool mysql_preload_keys(THD* thd, TABLE_LIST* tables)
 }
 
 
+/**
+  Send a row of the result of ANALYZE TABLE ... UPDATE/DROP HISTOGRAM.
+
+  @returns true if the row could not be sent
+*/
+static bool send_histogram_message(THD *thd, const char *table_name,
+                                   const char *msg_type, const char *msg)
+{
+  Protocol *protocol= thd->protocol;
+  protocol->prepare_for_resend();
+  protocol->store(table_name, system_charset_info);
+  protocol->store(STRING_WITH_LEN("histogram"), system_charset_info);
+  protocol->store(msg_type, system_charset_info);
+  protocol->store(msg, system_charset_info);
+  return protocol->write();
+}
+
+
+/**
+  Build or remove the histograms of columns of a table.
+
+  The table is opened with a lock that blocks writes, so that concurrent
+  statements updating the histograms of the same table are serialized.
+  The share is removed from the table definition cache afterwards, so
+  that the next statement loads the new histograms.
+
+  @returns true on error; the error has been reported
+*/
+bool Sql_cmd_analyze_table::handle_histogram_command(THD *thd,
+                                                     TABLE_LIST *table)
+{
+  DBUG_ENTER("Sql_cmd_analyze_table::handle_histogram_command");
+
+  if (table->next_local != NULL)
+  {
+    my_error(ER_NOT_SUPPORTED_YET, MYF(0),
+             "histogram statistics on more than one table");
+    DBUG_RETURN(true);
+  }
+
+  table->lock_type= TL_READ_NO_INSERT;
+  table->mdl_request.set_type(MDL_SHARED_NO_WRITE);
+  table->required_type= FRMTYPE_TABLE;
+  if (open_temporary_tables(thd, table) ||
+      open_and_lock_tables(thd, table, TRUE, 0))
+    goto err;
+
+  if (table->table->s->tmp_table != NO_TMP_TABLE)
+  {
+    my_error(ER_NOT_SUPPORTED_YET, MYF(0),
+             "histogram statistics on temporary tables");
+    goto err;
+  }
+
+  {
+    List<Item> field_list;
+    Item *item;
+    field_list.push_back(item= new Item_empty_string("Table",
+                                                     NAME_CHAR_LEN * 2));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_empty_string("Op", 10));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_empty_string("Msg_type", 10));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_empty_string("Msg_text",
+                                                     SQL_ADMIN_MSG_TEXT_SIZE));
+    item->maybe_null= 1;
+    if (thd->protocol->send_result_set_metadata(&field_list,
+                                                Protocol::SEND_NUM_ROWS |
+                                                Protocol::SEND_EOF))
+      goto err;
+  }
+
+  {
+    char table_name[NAME_LEN * 2 + 2];
+    char msg[MYSQL_ERRMSG_SIZE];
+    TABLE *const tab= table->table;
+    const uint num_columns= m_histogram.columns->elements;
+    List_iterator<String> it(*m_histogram.columns);
+    String *column;
+
+    strxmov(table_name, table->db, ".", table->table_name, NullS);
+
+    if (m_histogram.command == Histogram_options::UPDATE)
+    {
+      Field **fields=
+        static_cast<Field**>(thd->alloc(num_columns * sizeof(Field*)));
+      uint num_fields= 0;
+      if (fields == NULL)
+        goto err;
+
+      while ((column= it++))
+      {
+        const char *name= column->c_ptr_safe();
+        Field *field= NULL;
+        for (Field **f= tab->field; *f != NULL; f++)
+        {
+          if (!my_strcasecmp(system_charset_info, (*f)->field_name, name))
+          {
+            field= *f;
+            break;
+          }
+        }
+
+        if (field == NULL || !histogram_supported_field(field))
+        {
+          my_snprintf(msg, sizeof(msg),
+                      field == NULL ?
+                      "The column '%s' does not exist." :
+                      "The column '%s' has an unsupported data type.",
+                      name);
+          if (send_histogram_message(thd, table_name, "error", msg))
+            goto err;
+          continue;
+        }
+        if (std::find(fields, fields + num_fields, field) ==
+            fields + num_fields)
+          fields[num_fields++]= field;
+      }
+
+      if (num_fields > 0 &&
+          update_histograms(thd, tab, fields, num_fields,
+                            m_histogram.num_buckets))
+        goto err;
+
+      for (uint i= 0; i < num_fields; i++)
+      {
+        my_snprintf(msg, sizeof(msg),
+                    "Histogram statistics created for column '%s'.",
+                    fields[i]->field_name);
+        if (send_histogram_message(thd, table_name, "status", msg))
+          goto err;
+      }
+    }
+    else
+    {
+      DBUG_ASSERT(m_histogram.command == Histogram_options::DROP);
+      bool *found= static_cast<bool*>(thd->calloc(num_columns * sizeof(bool)));
+      if (found == NULL ||
+          drop_histograms(thd, table->db, table->table_name,
+                          m_histogram.columns, found))
+        goto err;
+
+      for (uint i= 0; (column= it++); i++)
+      {
+        if (found[i])
+          my_snprintf(msg, sizeof(msg),
+                      "Histogram statistics removed for column '%s'.",
+                      column->c_ptr_safe());
+        else
+          my_snprintf(msg, sizeof(msg),
+                      "No histogram statistics found for column '%s'.",
+                      column->c_ptr_safe());
+        if (send_histogram_message(thd, table_name,
+                                   found[i] ? "status" : "error", msg))
+          goto err;
+      }
+    }
+  }
+
+  // Make the next statement load the new histograms
+  tdc_remove_table(thd, TDC_RT_REMOVE_UNUSED, table->db, table->table_name,
+                   FALSE);
+
+  if (trans_commit_stmt(thd) || trans_commit_implicit(thd))
+    goto err;
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+  my_eof(thd);
+  DBUG_RETURN(false);
+
+err:
+  trans_rollback_stmt(thd);
+  trans_rollback(thd);
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+  DBUG_RETURN(true);
+}
+
+
 bool Sql_cmd_analyze_table::execute(THD *thd)
 {
   TABLE_LIST *first_table= thd->lex->select_lex->get_table_list();
@@ -1096,9 +1279,12 @@ bool Sql_cmd_analyze_table::execute(THD *thd)
                          FALSE, UINT_MAX, FALSE))
     goto error;
   thd->enable_slow_log= opt_log_slow_admin_statements;
-  res= mysql_admin_table(thd, first_table, &thd->lex->check_opt,
-                         "analyze", lock_type, 1, 0, 0, 0,
-                         &handler::ha_analyze, 0);
+  if (m_histogram.command != Histogram_options::NONE)
+    res= handle_histogram_command(thd, first_table);
+  else
+    res= mysql_admin_table(thd, first_table, &thd->lex->check_opt,
+                           "analyze", lock_type, 1, 0, 0, 0,
+                           &handler::ha_analyze, 0);
   /* ! we write after unlocking the table */
   if (!res && !thd->lex->no_write_to_binlog)
   {
@@ -16,6 +16,8 @@
 #ifndef SQL_TABLE_MAINTENANCE_H
 #define SQL_TABLE_MAINTENANCE_H
 
+#include "sql_lex.h"                            // Histogram_options
+
 /* Must be able to hold ALTER TABLE t PARTITION BY ... KEY ALGORITHM = 1 ... */
 #define SQL_ADMIN_MSG_TEXT_SIZE 128 * 1024
 
@@ -35,6 +37,19 @@ public:
     Constructor, used to represent a ANALYZE TABLE statement.
   */
   Sql_cmd_analyze_table()
+  {
+    m_histogram.command= Histogram_options::NONE;
+    m_histogram.columns= NULL;
+    m_histogram.num_buckets= Histogram_options::default_num_buckets;
+  }
+
+  /**
+    Constructor, used to represent a ANALYZE TABLE ... UPDATE/DROP
+    HISTOGRAM statement.
+    @param histogram the histogram clause
+  */
+  explicit Sql_cmd_analyze_table(const Histogram_options &histogram)
+    : m_histogram(histogram)
   {}
 
   ~Sql_cmd_analyze_table()
@@ -46,6 +61,12 @@ public:
   {
     return SQLCOM_ANALYZE;
   }
+
+private:
+  bool handle_histogram_command(THD *thd, TABLE_LIST *table);
+
+  /// The histogram clause, if any
+  Histogram_options m_histogram;
 };
 
 
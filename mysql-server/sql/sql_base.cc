@@ -300,7 +300,11 @@ Repair_mrg_table_error_handler::handle_condition(THD *,
      variable for signaling when opening the share is completed.
   4) In particular the share->ref_count is updated each time
      a new table object is created that refers to a table share.
-     This update is protected by LOCK_open.
+     This update is protected by LOCK_open, except in open_table()
+     when the share is found in the table cache of the thread, which
+     holds references to it: the count is then incremented under the
+     lock of that cache only. So ref_count is changed atomically, and
+     it can't become zero or leave zero without LOCK_open.
   5) oldest_unused_share, end_of_unused_share and share->next
      and share->prev are variables to handle the lists of table
      share objects, these can only be read and manipulated while
@@ -713,7 +717,7 @@ TABLE_SHARE *get_table_share(THD *thd, TABLE_LIST *table_list,
     and TABLE_SHARE::wait_for_old_version. We must also set
     m_open_in_progress to indicate allocated but incomplete share.
   */
-  share->ref_count++;                           // Mark in use
+  share->increment_ref_count();                 // Mark in use
   share->m_open_in_progress= true;              // Mark being opened
 
   /*
@@ -755,7 +759,7 @@ TABLE_SHARE *get_table_share(THD *thd, TABLE_LIST *table_list,
   if (open_table_err)
   {
     *error= share->error;
-    share->ref_count--;
+    share->decrement_ref_count();
     (void) my_hash_delete(&table_def_cache, (uchar*) share);
     DEBUG_SYNC(thd, "get_share_after_destroy");
     DBUG_RETURN(0);
@@ -767,7 +771,7 @@ TABLE_SHARE *get_table_share(THD *thd, TABLE_LIST *table_list,
   share->m_psi= NULL;
 #endif
 
-  DBUG_PRINT("exit", ("share: 0x%lx  ref_count: %u",
+  DBUG_PRINT("exit", ("share: 0x%lx  ref_count: %d",
                       (ulong) share, share->ref_count));
 
   /* If debug, assert that the share is actually present in the cache */
@@ -796,9 +800,7 @@ found:
     DBUG_RETURN(0);
   }
 
-  ++share->ref_count;
-
-  if (share->ref_count == 1 && share->prev)
+  if (share->increment_ref_count() == 1 && share->prev)
   {
     /*
       Share was not used before and it was in the old_unused_share list
@@ -816,7 +818,7 @@ found:
          oldest_unused_share->next)
     my_hash_delete(&table_def_cache, (uchar*) oldest_unused_share);
 
-  DBUG_PRINT("exit", ("share: 0x%lx  ref_count: %u",
+  DBUG_PRINT("exit", ("share: 0x%lx  ref_count: %d",
                       (ulong) share, share->ref_count));
   DBUG_RETURN(share);
 }
@@ -929,14 +931,14 @@ void release_table_share(TABLE_SHARE *share)
 {
   DBUG_ENTER("release_table_share");
   DBUG_PRINT("enter",
-             ("share: 0x%lx  table: %s.%s  ref_count: %u  version: %lu",
+             ("share: 0x%lx  table: %s.%s  ref_count: %d  version: %lu",
               (ulong) share, share->db.str, share->table_name.str,
               share->ref_count, share->version));
 
   mysql_mutex_assert_owner(&LOCK_open);
 
   DBUG_ASSERT(share->ref_count);
-  if (!--share->ref_count)
+  if (!share->decrement_ref_count())
   {
     if (share->has_old_version() || table_def_shutdown_in_progress)
       my_hash_delete(&table_def_cache, (uchar*) share);
@@ -3236,11 +3238,25 @@ retry_share:
         found TABLE_SHARE for it. So let us try to create new TABLE
         for it. We start by incrementing share's reference count and
         checking its version.
+
+        The TABLE objects in this cache reference the share, so it can't
+        go away, and its version can't change while we hold the lock on
+        the cache. So unless the share has to be rechecked under
+        LOCK_open, it is enough to increment its reference count here.
       */
-      mysql_mutex_lock(&LOCK_open);
+      if (!(flags & MYSQL_OPEN_IGNORE_FLUSH) &&
+          (share->has_old_version() ||
+           (thd->open_tables &&
+            thd->open_tables->s->version != share->version)))
+      {
+        mysql_mutex_lock(&LOCK_open);
+        tc->unlock();
+        share->increment_ref_count();
+        goto share_found;
+      }
+      share->increment_ref_count();
       tc->unlock();
-      share->ref_count++;
-      goto share_found;
+      goto share_found_unlocked;
     }
     else
     {
@@ -3400,6 +3416,8 @@ share_found:
   }
 
   mysql_mutex_unlock(&LOCK_open);
+
+share_found_unlocked:
   DEBUG_SYNC(thd, "open_table_found_share");
 
   /* make a new table */
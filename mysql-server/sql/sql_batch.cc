@@ -0,0 +1,557 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Batch execution of single-table scan, filter and aggregate queries.
+*/
+
+#include "sql_batch.h"
+#include "sql_class.h"                          // THD
+#include "sql_optimizer.h"                      // JOIN
+#include "sql_executor.h"                       // QEP_TAB
+#include "item_cmpfunc.h"                       // Item_cond
+#include "item_sum.h"                           // Item_sum
+
+#include <functional>
+
+
+bool Batch_column::init(MEM_ROOT *mem_root, uint capacity)
+{
+  if (is_real)
+  {
+    if (!(real_values= static_cast<double*>(
+            alloc_root(mem_root, capacity * sizeof(double)))))
+      return true;
+  }
+  else if (!(int_values= static_cast<longlong*>(
+                 alloc_root(mem_root, capacity * sizeof(longlong)))))
+    return true;
+  if (field->real_maybe_null() &&
+      !(nulls= static_cast<bool*>(alloc_root(mem_root,
+                                             capacity * sizeof(bool)))))
+    return true;
+  return false;
+}
+
+
+/**
+  Keep the rows whose value compares as given with the constant.
+  Written without branches on the data, so that it compiles to a
+  tight loop.
+*/
+
+template <typename T, typename Cmp>
+static uint filter_values(const T *values, const bool *nulls, T constant,
+                          uint16 *rows, uint count, Cmp cmp)
+{
+  uint out= 0;
+  if (nulls == NULL)
+  {
+    for (uint i= 0; i < count; i++)
+    {
+      const uint16 row= rows[i];
+      rows[out]= row;
+      out+= cmp(values[row], constant);
+    }
+  }
+  else
+  {
+    for (uint i= 0; i < count; i++)
+    {
+      const uint16 row= rows[i];
+      rows[out]= row;
+      out+= !nulls[row] & cmp(values[row], constant);
+    }
+  }
+  return out;
+}
+
+
+template <typename T>
+static uint filter_values(Batch_predicate::enum_op op, const T *values,
+                          const bool *nulls, T constant,
+                          uint16 *rows, uint count)
+{
+  switch (op)
+  {
+  case Batch_predicate::EQ:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::equal_to<T>());
+  case Batch_predicate::NE:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::not_equal_to<T>());
+  case Batch_predicate::LT:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::less<T>());
+  case Batch_predicate::LE:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::less_equal<T>());
+  case Batch_predicate::GT:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::greater<T>());
+  case Batch_predicate::GE:
+    return filter_values(values, nulls, constant, rows, count,
+                         std::greater_equal<T>());
+  default:
+    DBUG_ASSERT(false);
+    return count;
+  }
+}
+
+
+/// Keep the rows where the NULL flag is 'null'
+static uint filter_nulls(const bool *nulls, bool null, uint16 *rows,
+                         uint count)
+{
+  if (nulls == NULL)
+    return null ? 0 : count;
+  uint out= 0;
+  for (uint i= 0; i < count; i++)
+  {
+    const uint16 row= rows[i];
+    rows[out]= row;
+    out+= nulls[row] == null;
+  }
+  return out;
+}
+
+
+void Batch_predicate::prepare()
+{
+  m_mode= COMPARE;
+  if (op == IS_NULL || op == IS_NOT_NULL)
+    return;
+
+  if (column->is_real)
+  {
+    m_real_value= value->val_real();
+    if (value->null_value)
+      m_mode= NEVER;
+    return;
+  }
+
+  m_int_value= value->val_int();
+  if (value->null_value)
+  {
+    m_mode= NEVER;
+    return;
+  }
+  /*
+    Both are compared in the domain of the column, which is possible
+    unless the signedness differs and the constant is out of range.
+    Then the constant is either above all (unsigned constant > LONGLONG_MAX)
+    or below all (negative constant) values of the column.
+  */
+  if (column->is_unsigned == MY_TEST(value->unsigned_flag) ||
+      m_int_value >= 0)
+    return;
+  const bool above_all= value->unsigned_flag;
+  switch (op)
+  {
+  case EQ:
+    m_mode= NEVER;
+    break;
+  case NE:
+    m_mode= NOT_NULL;
+    break;
+  case LT:
+  case LE:
+    m_mode= above_all ? NOT_NULL : NEVER;
+    break;
+  case GT:
+  case GE:
+    m_mode= above_all ? NEVER : NOT_NULL;
+    break;
+  default:
+    DBUG_ASSERT(false);
+  }
+}
+
+
+uint Batch_predicate::filter(uint16 *rows, uint count) const
+{
+  switch (op)
+  {
+  case IS_NULL:
+    return filter_nulls(column->nulls, true, rows, count);
+  case IS_NOT_NULL:
+    return filter_nulls(column->nulls, false, rows, count);
+  default:
+    break;
+  }
+
+  switch (m_mode)
+  {
+  case NEVER:
+    return 0;
+  case NOT_NULL:
+    return filter_nulls(column->nulls, false, rows, count);
+  case COMPARE:
+    break;
+  }
+
+  if (column->is_real)
+    return filter_values(op, column->real_values, column->nulls,
+                         m_real_value, rows, count);
+  if (column->is_unsigned)
+    return filter_values(op,
+                         reinterpret_cast<const ulonglong*>(column->int_values),
+                         column->nulls, static_cast<ulonglong>(m_int_value),
+                         rows, count);
+  return filter_values(op, column->int_values, column->nulls, m_int_value,
+                       rows, count);
+}
+
+
+/**
+  Check whether a column can be held in a Batch_column.
+
+  Integer columns other than YEAR and BIT, and floating point columns
+  without a fixed number of decimals (which are compared with rounding)
+  are supported.
+*/
+
+static bool is_batch_field(const Field *field)
+{
+  switch (field->type())
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    return true;
+  case MYSQL_TYPE_FLOAT:
+  case MYSQL_TYPE_DOUBLE:
+    return field->decimals() == NOT_FIXED_DEC;
+  default:
+    return false;
+  }
+}
+
+
+/// @returns the field of table that item refers to, or NULL
+static Field *batch_field(TABLE *table, Item *item)
+{
+  Item *real= item->real_item();
+  if (real->type() != Item::FIELD_ITEM)
+    return NULL;
+  Field *field= static_cast<Item_field*>(real)->field;
+  if (field->table != table || !is_batch_field(field))
+    return NULL;
+  return field;
+}
+
+
+/**
+  Check that an expression that is evaluated when the grouped row is sent
+  does not read the current row of the table: it may only be built from
+  constants and the aggregate functions of this query.
+*/
+
+static bool is_batch_output(JOIN *join, Item *item)
+{
+  if (item->const_item())
+    return true;
+  Item *real= item->real_item();
+  switch (real->type())
+  {
+  case Item::SUM_FUNC_ITEM:
+    for (Item_sum **func= join->sum_funcs; *func != NULL; func++)
+    {
+      if (*func == real)
+        return true;
+    }
+    return false;
+  case Item::FUNC_ITEM:
+  {
+    Item_func *func= static_cast<Item_func*>(real);
+    if (func->functype() == Item_func::FUNC_SP ||
+        func->functype() == Item_func::UDF_FUNC)
+      return false;
+    for (uint i= 0; i < func->argument_count(); i++)
+    {
+      if (!is_batch_output(join, func->arguments()[i]))
+        return false;
+    }
+    return true;
+  }
+  case Item::COND_ITEM:
+  {
+    List_iterator<Item> it(*static_cast<Item_cond*>(real)->argument_list());
+    Item *arg;
+    while ((arg= it++))
+    {
+      if (!is_batch_output(join, arg))
+        return false;
+    }
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+
+Batch_column *Batch_scan::add_column(MEM_ROOT *mem_root, Field *field)
+{
+  for (Batch_column **col= m_columns.begin(); col != m_columns.end(); ++col)
+  {
+    if ((*col)->field == field)
+      return *col;
+  }
+  Batch_column *col= new (mem_root) Batch_column(field);
+  if (col == NULL || col->init(mem_root, m_capacity) ||
+      m_columns.push_back(col))
+    return NULL;
+  return col;
+}
+
+
+/**
+  Compile a conjunct of the WHERE condition.
+
+  @returns true if the conjunct cannot be evaluated in batches
+*/
+
+bool Batch_scan::add_predicate(MEM_ROOT *mem_root, TABLE *table, Item *cond)
+{
+  if (cond->type() != Item::FUNC_ITEM)
+    return true;
+  Item_func *func= static_cast<Item_func*>(cond);
+  Item **args= func->arguments();
+
+  Batch_predicate::enum_op op;
+  switch (func->functype())
+  {
+  case Item_func::ISNULL_FUNC:
+  case Item_func::ISNOTNULL_FUNC:
+  {
+    Field *field= batch_field(table, args[0]);
+    Batch_column *col;
+    if (field == NULL || (col= add_column(mem_root, field)) == NULL)
+      return true;
+    op= func->functype() == Item_func::ISNULL_FUNC ?
+      Batch_predicate::IS_NULL : Batch_predicate::IS_NOT_NULL;
+    return m_predicates.push_back(Batch_predicate(col, NULL, op));
+  }
+  case Item_func::EQ_FUNC: op= Batch_predicate::EQ; break;
+  case Item_func::NE_FUNC: op= Batch_predicate::NE; break;
+  case Item_func::LT_FUNC: op= Batch_predicate::LT; break;
+  case Item_func::LE_FUNC: op= Batch_predicate::LE; break;
+  case Item_func::GT_FUNC: op= Batch_predicate::GT; break;
+  case Item_func::GE_FUNC: op= Batch_predicate::GE; break;
+  default:
+    return true;
+  }
+
+  Item *value= args[1];
+  Field *field= batch_field(table, args[0]);
+  if (field == NULL)
+  {
+    // constant <op> column: swap the operands
+    value= args[0];
+    field= batch_field(table, args[1]);
+    if (field == NULL)
+      return true;
+    switch (op)
+    {
+    case Batch_predicate::LT: op= Batch_predicate::GT; break;
+    case Batch_predicate::LE: op= Batch_predicate::GE; break;
+    case Batch_predicate::GT: op= Batch_predicate::LT; break;
+    case Batch_predicate::GE: op= Batch_predicate::LE; break;
+    default: break;
+    }
+  }
+
+  /*
+    The comparison must be done the way Arg_comparator would do it: as
+    integers for an integer column and an integer constant, as doubles
+    for a floating point column and an integer or floating point constant.
+    Temporal constants are compared differently and are not supported.
+  */
+  if (!value->const_item() || value->has_subquery() ||
+      value->has_stored_program() || value->is_temporal())
+    return true;
+  const Item_result value_type= value->result_type();
+  if (field->result_type() == INT_RESULT ?
+      value_type != INT_RESULT :
+      value_type != INT_RESULT && value_type != REAL_RESULT)
+    return true;
+
+  Batch_column *col= add_column(mem_root, field);
+  return col == NULL || m_predicates.push_back(Batch_predicate(col, value, op));
+}
+
+
+/**
+  Set up the evaluation of an aggregate function.
+
+  @returns true if the function cannot be evaluated in batches
+*/
+
+bool Batch_scan::add_sum_func(MEM_ROOT *mem_root, TABLE *table, Item_sum *item)
+{
+  switch (item->sum_func())
+  {
+  case Item_sum::COUNT_FUNC:
+  case Item_sum::SUM_FUNC:
+  case Item_sum::MIN_FUNC:
+  case Item_sum::MAX_FUNC:
+    break;
+  default:
+    return true;
+  }
+  if (item->get_arg_count() != 1)
+    return true;
+
+  Item *arg= item->get_arg(0);
+  Batch_column *col= NULL;
+  if (arg->basic_const_item())
+  {
+    // COUNT(*), COUNT(<constant>)
+    if (item->sum_func() != Item_sum::COUNT_FUNC)
+      return true;
+  }
+  else
+  {
+    Field *field= batch_field(table, arg);
+    if (field == NULL || (col= add_column(mem_root, field)) == NULL)
+      return true;
+  }
+  return m_sum_funcs.push_back(item) || m_sum_columns.push_back(col);
+}
+
+
+Batch_scan *Batch_scan::create(JOIN *join)
+{
+  THD *const thd= join->thd;
+  const uint capacity= thd->variables.executor_batch_size;
+  DBUG_ENTER("Batch_scan::create");
+
+  /*
+    One table read with a full table scan, and a single group sent
+    directly to the client.
+  */
+  if (capacity == 0 || join->primary_tables != 1 ||
+      join->const_tables != 0 || join->tmp_tables != 0 ||
+      !join->implicit_grouping || join->select_distinct ||
+      join->rollup.state != ROLLUP::STATE_NONE ||
+      join->sum_funcs == NULL || join->sum_funcs[0] == NULL)
+    DBUG_RETURN(NULL);
+
+  QEP_TAB *const tab= join->qep_tab;
+  TABLE *const table= tab->table();
+  if (tab->next_select != end_send_group ||
+      tab->type() != JT_ALL || tab->quick() != NULL || tab->dynamic_range() ||
+      tab->filesort != NULL || tab->op != NULL ||
+      tab->materialize_table != NULL || tab->keep_current_rowid ||
+      tab->starts_weedout() || tab->do_firstmatch() || tab->do_loosescan() ||
+      tab->last_inner() != NO_PLAN_IDX)
+    DBUG_RETURN(NULL);
+
+  /*
+    Rows that do not match are not unlocked as in evaluate_join_record(),
+    so locking reads are left to the row path.
+  */
+  if (table->reginfo.lock_type != TL_READ &&
+      table->reginfo.lock_type != TL_READ_HIGH_PRIORITY &&
+      table->reginfo.lock_type != TL_READ_NO_INSERT)
+    DBUG_RETURN(NULL);
+
+  // The grouped row must not depend on the last row read
+  List_iterator<Item> it(join->all_fields);
+  Item *item;
+  while ((item= it++))
+  {
+    if (!is_batch_output(join, item))
+      DBUG_RETURN(NULL);
+  }
+  if (join->having_cond && !is_batch_output(join, join->having_cond))
+    DBUG_RETURN(NULL);
+
+  MEM_ROOT *const mem_root= thd->mem_root;
+  Batch_scan *scan= new (mem_root) Batch_scan(mem_root, capacity);
+  if (scan == NULL ||
+      !(scan->m_selection= static_cast<uint16*>(
+          alloc_root(mem_root, capacity * sizeof(uint16)))))
+    DBUG_RETURN(NULL);
+
+  for (Item_sum **func= join->sum_funcs; *func != NULL; func++)
+  {
+    if (scan->add_sum_func(mem_root, table, *func))
+      DBUG_RETURN(NULL);
+  }
+
+  Item *const cond= tab->condition();
+  if (cond != NULL)
+  {
+    if (cond->type() == Item::COND_ITEM &&
+        static_cast<Item_cond*>(cond)->functype() == Item_func::COND_AND_FUNC)
+    {
+      List_iterator<Item> li(*static_cast<Item_cond*>(cond)->argument_list());
+      Item *conjunct;
+      while ((conjunct= li++))
+      {
+        if (scan->add_predicate(mem_root, table, conjunct))
+          DBUG_RETURN(NULL);
+      }
+    }
+    else if (scan->add_predicate(mem_root, table, cond))
+      DBUG_RETURN(NULL);
+  }
+
+  DBUG_PRINT("info", ("Batch scan of %u columns, %u predicates",
+                      (uint) scan->m_columns.size(),
+                      (uint) scan->m_predicates.size()));
+  DBUG_RETURN(scan);
+}
+
+
+bool Batch_scan::init()
+{
+  m_rows= 0;
+  m_found= false;
+  for (Batch_predicate *pred= m_predicates.begin();
+       pred != m_predicates.end(); ++pred)
+    pred->prepare();
+  for (Item_sum **func= m_sum_funcs.begin(); func != m_sum_funcs.end(); ++func)
+    (*func)->aggregator_clear();
+  return current_thd->is_error();
+}
+
+
+void Batch_scan::process()
+{
+  uint count= m_rows;
+  m_rows= 0;
+  if (count == 0)
+    return;
+
+  for (uint i= 0; i < count; i++)
+    m_selection[i]= static_cast<uint16>(i);
+  for (const Batch_predicate *pred= m_predicates.begin();
+       pred != m_predicates.end() && count > 0; ++pred)
+    count= pred->filter(m_selection, count);
+  if (count == 0)
+    return;
+
+  m_found= true;
+  for (size_t i= 0; i < m_sum_funcs.size(); i++)
+    m_sum_funcs[i]->add_batch(m_sum_columns[i], m_selection, count);
+}
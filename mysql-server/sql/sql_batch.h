@@ -0,0 +1,224 @@
+#ifndef SQL_BATCH_INCLUDED
+#define SQL_BATCH_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Batch execution of single-table scan, filter and aggregate queries.
+
+  A query like
+
+    SELECT COUNT(*), SUM(a), MAX(b) FROM t1 WHERE c > 10 AND d <> 5
+
+  is normally executed by sub_select() and evaluate_join_record(), which
+  evaluate the WHERE condition and every aggregate function once per row
+  through the Item tree. When such a query reads one table with a full
+  table scan, Batch_scan takes over: the columns referenced by the query
+  are copied into vectors of up to @@executor_batch_size rows, and the
+  condition and the aggregate functions are evaluated over whole vectors
+  with tight loops. Queries using anything else run on the row path.
+
+  @see sub_select_batch()
+*/
+
+#include "my_global.h"
+#include "sql_alloc.h"                          // Sql_alloc
+#include "mem_root_array.h"                     // Mem_root_array
+#include "field.h"                              // Field
+
+class Item;
+class Item_sum;
+class JOIN;
+
+/**
+  The values of one column for a batch of rows.
+
+  Only integer and floating point columns are supported; an integer
+  column keeps its values as longlong, which holds the bit pattern of
+  the value for an UNSIGNED BIGINT column.
+*/
+
+class Batch_column : public Sql_alloc
+{
+public:
+  explicit Batch_column(Field *field_arg)
+    : field(field_arg),
+      is_real(field_arg->result_type() == REAL_RESULT),
+      is_unsigned(MY_TEST(field_arg->flags & UNSIGNED_FLAG)),
+      int_values(NULL), real_values(NULL), nulls(NULL)
+  {}
+
+  /// Allocate the vectors. @returns true if out of memory
+  bool init(MEM_ROOT *mem_root, uint capacity);
+
+  /// Copy the value of the column in the current row into row number 'row'
+  void load(uint row)
+  {
+    if (nulls != NULL && (nulls[row]= field->is_null()))
+      return;
+    if (is_real)
+      real_values[row]= field->val_real();
+    else
+      int_values[row]= field->val_int();
+  }
+
+  bool is_null(uint row) const { return nulls != NULL && nulls[row]; }
+
+  /// @returns the number of the given rows that are not NULL
+  uint count_not_null(const uint16 *rows, uint count) const
+  {
+    if (nulls == NULL)
+      return count;
+    uint result= 0;
+    for (uint i= 0; i < count; i++)
+      result+= !nulls[rows[i]];
+    return result;
+  }
+
+  Field *const field;
+  const bool is_real;
+  const bool is_unsigned;
+  longlong *int_values;
+  double *real_values;
+  /// NULL flag of each row, or NULL if the column is NOT NULL
+  bool *nulls;
+};
+
+
+/**
+  A comparison of a column with a constant, or a NULL test of a column,
+  that is evaluated over a batch. The WHERE condition of a batch scan is
+  a conjunction of these.
+*/
+
+class Batch_predicate
+{
+public:
+  enum enum_op { EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL };
+
+  Batch_predicate()
+    : column(NULL), value(NULL), op(EQ), m_mode(COMPARE),
+      m_int_value(0), m_real_value(0.0)
+  {}
+  Batch_predicate(Batch_column *column_arg, Item *value_arg, enum_op op_arg)
+    : column(column_arg), value(value_arg), op(op_arg), m_mode(COMPARE),
+      m_int_value(0), m_real_value(0.0)
+  {}
+
+  /**
+    Evaluate the constant. Done once per execution, since the constant
+    may depend on parameters or outer references fixed for the execution.
+  */
+  void prepare();
+
+  /**
+    Remove the rows for which the predicate is not TRUE.
+
+    @param[in,out] rows   indexes of the rows in the batch
+    @param         count  number of elements in rows
+
+    @returns the number of rows that are left
+  */
+  uint filter(uint16 *rows, uint count) const;
+
+  Batch_column *column;
+  Item *value;                          ///< NULL for IS [NOT] NULL
+  enum_op op;
+
+private:
+  /**
+    How prepare() has resolved the predicate: by comparing each value, or
+    (for NULL constants and constants outside the range of the column) to
+    a test that does not depend on the value.
+  */
+  enum enum_mode { COMPARE, NOT_NULL, NEVER };
+  enum_mode m_mode;
+  longlong m_int_value;
+  double m_real_value;
+};
+
+
+/**
+  Execution state of a query that is run by sub_select_batch().
+*/
+
+class Batch_scan : public Sql_alloc
+{
+public:
+  /**
+    Check whether the query of a join can be executed in batches, and if
+    so, set up the column vectors and compile the WHERE condition.
+
+    @param join  the join, after make_tmp_tables_info()
+
+    @returns the batch scan, or NULL if the row path must be used
+  */
+  static Batch_scan *create(JOIN *join);
+
+  /**
+    Prepare for a new scan: evaluate constants and clear the aggregate
+    functions.
+
+    @returns true on error
+  */
+  bool init();
+
+  /**
+    Copy the columns of the current row of the table into the batch.
+
+    @returns true if the batch is full and must be processed
+  */
+  bool add_row()
+  {
+    for (Batch_column **col= m_columns.begin(); col != m_columns.end(); ++col)
+      (*col)->load(m_rows);
+    return ++m_rows == m_capacity;
+  }
+
+  /// Filter the rows of the batch and aggregate the remaining ones
+  void process();
+
+  /// @returns true if any row has passed the WHERE condition
+  bool found_rows() const { return m_found; }
+
+private:
+  Batch_scan(MEM_ROOT *mem_root, uint capacity)
+    : m_columns(mem_root), m_predicates(mem_root), m_sum_funcs(mem_root),
+      m_sum_columns(mem_root), m_selection(NULL), m_capacity(capacity),
+      m_rows(0), m_found(false)
+  {}
+
+  Batch_column *add_column(MEM_ROOT *mem_root, Field *field);
+  bool add_predicate(MEM_ROOT *mem_root, TABLE *table, Item *cond);
+  bool add_sum_func(MEM_ROOT *mem_root, TABLE *table, Item_sum *item);
+
+  Mem_root_array<Batch_column*, true> m_columns;
+  Mem_root_array<Batch_predicate, true> m_predicates;
+  Mem_root_array<Item_sum*, true> m_sum_funcs;
+  /// Column of the argument of each function, NULL for constants
+  Mem_root_array<Batch_column*, true> m_sum_columns;
+  /// Selection vector, indexes of the rows that are left after filtering
+  uint16 *m_selection;
+  const uint m_capacity;
+  /// Number of rows in the batch
+  uint m_rows;
+  bool m_found;
+};
+
+#endif /* SQL_BATCH_INCLUDED */
@@ -268,7 +268,18 @@ are stored in one block.
 
 If join_results allocated new block(s) then we need call pack_cache again.
 
-7. Interface
+7. Partitions
+The cache can be split into @@query_cache_partitions partitions
+(class Query_cache), each with its own memory, hashes and lock, and
+with an equal share of @@query_cache_size. A query is stored in and
+looked up in the partition selected by a hash of the query text and the
+current database. The functions below are called on the global
+Partitioned_query_cache object, which dispatches them to the partitions. A
+table is invalidated in the partitions that may have cached queries
+using it, which are looked up without a lock; see the description of
+Partitioned_query_cache.
+
+8. Interface
 The query cache interfaces with the rest of the server code through 7
 functions:
  1. Query_cache::send_result_to_client
@@ -344,6 +355,10 @@ TODO list:
 #include "../storage/myisammrg/myrg_def.h"
 #include "probes_mysql.h"
 #include "transaction.h"
+#include "my_murmur3.h"                         // murmur3_32
+#ifdef WITH_PARTITION_STORAGE_ENGINE
+#include "partition_info.h"                     // partition_info
+#endif
 
 #ifdef EMBEDDED_LIBRARY
 #include "emb_qcache.h"
@@ -991,8 +1006,8 @@ Query_cache::insert(Query_cache_tls *query_cache_tls,
     header->result(result);
     DBUG_PRINT("qcache", ("free query 0x%lx", (ulong) query_block));
     // The following call will remove the lock on query_block
-    query_cache.free_query(query_block);
-    query_cache.refused++;
+    free_query(query_block);
+    refused++;
     // append_result_data no success => we need unlock
     unlock();
     DBUG_VOID_RETURN;
@@ -1103,9 +1118,9 @@ void Query_cache::end_of_result(THD *thd)
     }
     last_result_block= header->result()->prev;
     allign_size= ALIGN_SIZE(last_result_block->used);
-    len= max(query_cache.min_allocation_unit, allign_size);
-    if (last_result_block->length >= query_cache.min_allocation_unit + len)
-      query_cache.split_block(last_result_block,len);
+    len= max(min_allocation_unit, allign_size);
+    if (last_result_block->length >= min_allocation_unit + len)
+      split_block(last_result_block,len);
 
     header->found_rows(limit_found_rows);
     header->result()->type= Query_cache_block::RESULT;
@@ -1174,6 +1189,7 @@ Query_cache::Query_cache(ulong query_cache_limit_arg,
    query_cache_limit(query_cache_limit_arg),
    queries_in_cache(0), hits(0), inserts(0), refused(0),
    total_blocks(0), lowmem_prunes(0), m_query_cache_is_disabled(FALSE),
+   m_owner(NULL), m_partition_no(0),
    min_allocation_unit(ALIGN_SIZE(min_allocation_unit_arg)),
    min_result_data_size(ALIGN_SIZE(min_result_data_size_arg)),
    def_query_hash_size(ALIGN_SIZE(def_query_hash_size_arg)),
@@ -1417,6 +1433,7 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 	inserts++;
 	queries_in_cache++;
 	thd->query_cache_tls.first_query_block= query_block;
+	thd->query_cache_tls.partition= this;
 	header->writer(&thd->query_cache_tls);
 	header->tables_type(tables_type);
 
@@ -1817,7 +1834,8 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
                       table_list.db, table_list.alias,
                       (ulong) engine_data, (ulong) table->engine_data()));
           invalidate_table_internal(thd, (uchar *) table->db(),
-                                    table->key_length());
+                                    table->key_length(),
+                                    QUERY_CACHE_ALL_PARTS);
         }
         else
           thd->lex->safe_to_cache_query= 0;       // Don't try to cache this
@@ -1903,153 +1921,6 @@ err:
 }
 
 
-/**
-  Remove all cached queries that use the given table.
-
-  @param thd                 Thread handle
-  @param table_used          TABLE_LIST representing the table to be
-                             invalidated.
-  @param using_transactions  If we are inside a transaction only add
-                             the table to a list of changed tables for now,
-                             don't invalidate directly. The table will instead
-                             be invalidated once the transaction commits.
-*/
-
-void Query_cache::invalidate_single(THD *thd, TABLE_LIST *table_used,
-                                    my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate_single (table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  DBUG_ASSERT(!using_transactions || table_used->table!=0);
-  if (table_used->derived)
-    DBUG_VOID_RETURN;
-  if (using_transactions &&
-      (table_used->table->file->table_cache_type() ==
-       HA_CACHE_TBL_TRANSACT))
-    /*
-      table_used->table can't be 0 in transaction.
-      Only 'drop' invalidate not opened table, but 'drop'
-      force transaction finish.
-    */
-    thd->add_changed_table(table_used->table);
-  else
-    invalidate_table(thd, table_used);
-
-  DBUG_VOID_RETURN;
-}
-
-/**
-  Remove all cached queries that use any of the tables in the list.
-
-  @see Query_cache::invalidate_single().
-*/
-
-void Query_cache::invalidate(THD *thd, TABLE_LIST *tables_used,
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  for (; tables_used; tables_used= tables_used->next_local)
-    invalidate_single(thd, tables_used, using_transactions);
-
-  DEBUG_SYNC(thd, "wait_after_query_cache_invalidate");
-
-  DBUG_VOID_RETURN;
-}
-
-void Query_cache::invalidate(CHANGED_TABLE_LIST *tables_used)
-{
-  DBUG_ENTER("Query_cache::invalidate (changed table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  THD *thd= current_thd;
-  for (; tables_used; tables_used= tables_used->next)
-  {
-    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table_list);
-    invalidate_table(thd, (uchar*) tables_used->key, tables_used->key_length);
-    DBUG_PRINT("qcache", ("db: %s  table: %s", tables_used->key,
-                          tables_used->key+
-                          strlen(tables_used->key)+1));
-  }
-  DBUG_VOID_RETURN;
-}
-
-
-/*
-  Invalidate locked for write
-
-  SYNOPSIS
-    Query_cache::invalidate_locked_for_write()
-    tables_used - table list
-
-  NOTE
-    can be used only for opened tables
-*/
-void Query_cache::invalidate_locked_for_write(TABLE_LIST *tables_used)
-{
-  DBUG_ENTER("Query_cache::invalidate_locked_for_write");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  THD *thd= current_thd;
-  for (; tables_used; tables_used= tables_used->next_local)
-  {
-    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table);
-    if (tables_used->lock_type >= TL_WRITE_ALLOW_WRITE &&
-        tables_used->table)
-    {
-      invalidate_table(thd, tables_used->table);
-    }
-  }
-  DBUG_VOID_RETURN;
-}
-
-/*
-  Remove all cached queries that uses the given table
-*/
-
-void Query_cache::invalidate(THD *thd, TABLE *table, 
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (table)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  if (using_transactions && 
-      (table->file->table_cache_type() == HA_CACHE_TBL_TRANSACT))
-    thd->add_changed_table(table);
-  else
-    invalidate_table(thd, table);
-
-
-  DBUG_VOID_RETURN;
-}
-
-void Query_cache::invalidate(THD *thd, const char *key, uint32  key_length,
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (key)");
-  if (is_disabled())
-   DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  if (using_transactions) // used for innodb => has_transactions() is TRUE
-    thd->add_changed_table(key, key_length);
-  else
-    invalidate_table(thd, (uchar*)key, key_length);
-
-  DBUG_VOID_RETURN;
-}
-
-
 /**
    Remove all cached queries that uses the given database.
 */
@@ -2128,20 +1999,6 @@ void Query_cache::invalidate(const char *db)
 }
 
 
-void Query_cache::invalidate_by_MyISAM_filename(const char *filename)
-{
-  DBUG_ENTER("Query_cache::invalidate_by_MyISAM_filename");
-
-  /* Calculate the key outside the lock to make the lock shorter */
-  char key[MAX_DBKEY_LENGTH];
-  size_t db_length;
-  size_t key_length= filename_2_table_key(key, filename, &db_length);
-  THD *thd= current_thd;
-  invalidate_table(thd,(uchar *)key, key_length);
-  DBUG_EXECUTE("check_querycache", check_integrity(LOCK_WHILE_CHECKING););
-  DBUG_VOID_RETURN;
-}
-
   /* Remove all queries from cache */
 
 void Query_cache::flush()
@@ -2249,7 +2106,7 @@ void Query_cache::init()
     be used.
   */
   if (global_system_variables.query_cache_type == 0)
-    query_cache.disable_query_cache();
+    disable_query_cache();
 
   DBUG_VOID_RETURN;
 }
@@ -2908,32 +2765,16 @@ my_bool Query_cache::allocate_data_chain(Query_cache_block **result_block,
   Tables management
 *****************************************************************************/
 
-/*
-  Invalidate the first table in the table_list
-*/
-
-void Query_cache::invalidate_table(THD *thd, TABLE_LIST *table_list)
-{
-  if (table_list->table != 0)
-    invalidate_table(thd, table_list->table);	// Table is open
-  else
-  {
-    const char *key;
-    size_t key_length;
-    key_length= get_table_def_key(table_list, &key);
-
-    // We don't store temporary tables => no key_length+=4 ...
-    invalidate_table(thd, (uchar *)key, key_length);
-  }
-}
+/**
+  Invalidate the queries that use a table.
 
-void Query_cache::invalidate_table(THD *thd, TABLE *table)
-{
-  invalidate_table(thd, (uchar*) table->s->table_cache_key.str,
-                   table->s->table_cache_key.length);
-}
+  @param parts  The queries which do not use any of these partitions of
+                the table are kept, see
+                Query_cache_block_table::used_parts
+*/
 
-void Query_cache::invalidate_table(THD *thd, uchar * key, size_t key_length)
+void Query_cache::invalidate_table(THD *thd, uchar * key, size_t key_length,
+                                   ulonglong parts)
 {
   DEBUG_SYNC(thd, "wait_in_query_cache_invalidate1");
 
@@ -2946,7 +2787,7 @@ void Query_cache::invalidate_table(THD *thd, uchar * key, size_t key_length)
   DEBUG_SYNC(thd, "wait_in_query_cache_invalidate2");
 
   if (query_cache_size > 0)
-    invalidate_table_internal(thd, key, key_length);
+    invalidate_table_internal(thd, key, key_length, parts);
 
   unlock();
 }
@@ -2961,14 +2802,18 @@ void Query_cache::invalidate_table(THD *thd, uchar * key, size_t key_length)
 */
 
 void
-Query_cache::invalidate_table_internal(THD *thd, uchar *key, size_t key_length)
+Query_cache::invalidate_table_internal(THD *thd, uchar *key, size_t key_length,
+                                       ulonglong parts)
 {
   Query_cache_block *table_block=
     (Query_cache_block*)my_hash_search(&tables, key, key_length);
   if (table_block)
   {
     Query_cache_block_table *list_root= table_block->table(0);
-    invalidate_query_block_list(thd, list_root);
+    if (parts == QUERY_CACHE_ALL_PARTS)
+      invalidate_query_block_list(thd, list_root);
+    else
+      invalidate_query_block_list(thd, list_root, parts);
   }
 }
 
@@ -2996,6 +2841,99 @@ Query_cache::invalidate_query_block_list(THD *thd,
   }
 }
 
+
+/**
+  Invalidate the queries in a linked list of query cache blocks that use
+  one of the given partitions of the table.
+
+  A query may use the table more than once, and is invalidated if any of
+  its nodes in the list uses one of the partitions. Freeing a query
+  unlinks all its nodes, and freeing the last query of the list frees
+  the table block, including list_root.
+
+  @param[in,out] thd Thread context.
+  @param[in,out] list_root A pointer to a circular list of query blocks.
+  @param         parts     Partitions of the table that have changed
+*/
+
+void
+Query_cache::invalidate_query_block_list(THD *thd,
+                                         Query_cache_block_table *list_root,
+                                         ulonglong parts)
+{
+  Query_cache_block_table *node;
+
+  /* Make every node of a query to invalidate match 'parts' */
+  for (node= list_root->next; node != list_root; node= node->next)
+  {
+    if ((node->used_parts & parts) == 0)
+      continue;
+    Query_cache_block *query_block= node->block();
+    Query_cache_block_table *query_node= query_block->table(0);
+    for (TABLE_COUNTER_TYPE i= 0; i < query_block->n_tables; i++, query_node++)
+    {
+      if (query_node->parent == node->parent)
+        query_node->used_parts= QUERY_CACHE_ALL_PARTS;
+    }
+  }
+
+  int32 matches= 0;
+  for (node= list_root->next; node != list_root; node= node->next)
+  {
+    if (node->used_parts & parts)
+      matches++;
+  }
+  if (matches == 0)
+    return;
+  if (matches == list_root->block()->table()->m_cached_query_count)
+  {
+    invalidate_query_block_list(thd, list_root);
+    return;
+  }
+
+  /*
+    Some queries are kept, so the list is never empty, and the nodes up
+    to 'prev', which all belong to kept queries, are not unlinked.
+  */
+  Query_cache_block_table *prev= list_root;
+  while (prev->next != list_root)
+  {
+    node= prev->next;
+    if (node->used_parts & parts)
+    {
+      Query_cache_block *query_block= node->block();
+      BLOCK_LOCK_WR(query_block);
+      free_query(query_block);
+    }
+    else
+      prev= node;
+  }
+}
+
+/**
+  The partitions of a table that the current statement has locked, which
+  are all partitions it reads or changes, as a value for
+  Query_cache_block_table::used_parts.
+*/
+
+static ulonglong locked_parts(TABLE *table)
+{
+#ifdef WITH_PARTITION_STORAGE_ENGINE
+  partition_info *part_info= table->part_info;
+  if (part_info != NULL && part_info->bitmaps_are_initialized)
+  {
+    ulonglong parts= 0;
+    for (uint i= bitmap_get_first_set(&part_info->lock_partitions);
+         i != MY_BIT_NONE;
+         i= bitmap_get_next_set(&part_info->lock_partitions, i))
+      parts|= 1ULL << (i % 64);
+    return parts;
+  }
+#endif
+  return QUERY_CACHE_ALL_PARTS;
+}
+
+
 /*
   Register given table list begining with given position in tables table of
   block
@@ -3030,6 +2968,7 @@ Query_cache::register_tables_from_list(TABLE_LIST *tables_used,
       continue;
     }
     block_table->n= n;
+    block_table->used_parts= QUERY_CACHE_ALL_PARTS;
     if (tables_used->view)
     {
       const char *key;
@@ -3052,6 +2991,7 @@ Query_cache::register_tables_from_list(TABLE_LIST *tables_used,
     }
     else
     {
+      block_table->used_parts= locked_parts(tables_used->table);
       DBUG_PRINT("qcache",
                  ("table: %s  db: %s  openinfo:  0x%lx  keylen: %lu  key: 0x%lx",
                   tables_used->table->s->table_name.str,
@@ -3086,6 +3026,7 @@ Query_cache::register_tables_from_list(TABLE_LIST *tables_used,
           size_t key_length= filename_2_table_key(key, table->table->filename,
                                                   &db_length);
           (++block_table)->n= ++n;
+          block_table->used_parts= QUERY_CACHE_ALL_PARTS;
           /*
             There are not callback function for for MyISAM, and engine data
           */
@@ -3157,6 +3098,10 @@ Query_cache::insert_table(size_t key_len, const char *key,
 
   THD *thd= current_thd;
 
+  /* Let invalidation find this partition before the table is in it */
+  if (m_owner != NULL)
+    m_owner->add_table_partition(key, key_len, m_partition_no);
+
   Query_cache_block *table_block= 
     (Query_cache_block *) my_hash_search(&tables, (uchar*) key, key_len);
 
@@ -4299,6 +4244,525 @@ size_t Query_cache::filename_2_table_key (char *key, const char *path,
                                   filename, NAME_LEN) - key) + 1);
 }
 
+/*****************************************************************************
+  Partitioned_query_cache methods
+*****************************************************************************/
+
+void Partitioned_query_cache::init()
+{
+  DBUG_ENTER("Partitioned_query_cache::init");
+  DBUG_ASSERT(query_cache_partitions >= 1 &&
+              query_cache_partitions <= MAX_PARTITIONS);
+  m_partitions= new (std::nothrow) Query_cache[query_cache_partitions];
+  if (m_partitions == NULL)
+    DBUG_VOID_RETURN;                           // The cache stays disabled
+  m_partition_count= static_cast<uint>(query_cache_partitions);
+  for (uint i= 0; i < m_partition_count; i++)
+  {
+    Query_cache *partition= &m_partitions[i];
+    partition->m_owner= this;
+    partition->m_partition_no= i;
+    partition->result_size_limit(query_cache_limit);
+    partition->set_min_res_unit(m_min_res_unit);
+    partition->init();
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Resize the cache, giving each partition an equal share of the size.
+
+  @return the sum of the sizes of the partitions
+*/
+
+ulong Partitioned_query_cache::resize(ulong query_cache_size_arg)
+{
+  ulong new_query_cache_size= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    new_query_cache_size+=
+      m_partitions[i].resize(query_cache_size_arg / m_partition_count);
+  query_cache_size= new_query_cache_size;
+  return new_query_cache_size;
+}
+
+
+void Partitioned_query_cache::result_size_limit(ulong limit)
+{
+  query_cache_limit= limit;
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].result_size_limit(limit);
+}
+
+
+ulong Partitioned_query_cache::set_min_res_unit(ulong size)
+{
+  m_min_res_unit= size;
+  for (uint i= 0; i < m_partition_count; i++)
+    m_min_res_unit= m_partitions[i].set_min_res_unit(size);
+  return m_min_res_unit;
+}
+
+
+/**
+  The partition in which the current query of a thread is stored and
+  looked up: the key of a query in a partition begins with the query
+  text and the current database, so the partition is chosen by a hash
+  of them.
+*/
+
+Query_cache *Partitioned_query_cache::get_partition(THD *thd)
+{
+  if (m_partition_count == 1)
+    return m_partitions;
+  const LEX_CSTRING query= thd->query();
+  const LEX_CSTRING db= thd->db();
+  uint32 hash= murmur3_32(reinterpret_cast<const uchar*>(query.str),
+                          query.length, 0);
+  if (db.length)
+    hash= murmur3_32(reinterpret_cast<const uchar*>(db.str), db.length, hash);
+  return &m_partitions[hash % m_partition_count];
+}
+
+
+void Partitioned_query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
+{
+  /* See the note on query_cache_size in Query_cache::store_query() */
+  if (m_partitions == NULL || query_cache_size == 0)
+    return;
+  get_partition(thd)->store_query(thd, tables_used);
+}
+
+
+int Partitioned_query_cache::send_result_to_client(THD *thd,
+                                                   const LEX_CSTRING &sql)
+{
+  if (m_partitions == NULL)
+    return 0;
+  return get_partition(thd)->send_result_to_client(thd, sql);
+}
+
+
+void Partitioned_query_cache::insert(Query_cache_tls *query_cache_tls,
+                                     const char *packet, ulong length,
+                                     unsigned pkt_nr)
+{
+  if (query_cache_tls->partition != NULL)
+    query_cache_tls->partition->insert(query_cache_tls, packet, length,
+                                       pkt_nr);
+}
+
+
+void Partitioned_query_cache::end_of_result(THD *thd)
+{
+  if (thd->query_cache_tls.partition != NULL)
+    thd->query_cache_tls.partition->end_of_result(thd);
+}
+
+
+void Partitioned_query_cache::abort(Query_cache_tls *query_cache_tls)
+{
+  if (query_cache_tls->partition != NULL)
+    query_cache_tls->partition->abort(query_cache_tls);
+}
+
+
+/**
+  Remove all cached queries that use the given table.
+
+  @param thd                 Thread handle
+  @param table_used          TABLE_LIST representing the table to be
+                             invalidated.
+  @param using_transactions  If we are inside a transaction only add
+                             the table to a list of changed tables for now,
+                             don't invalidate directly. The table will instead
+                             be invalidated once the transaction commits.
+*/
+
+void Partitioned_query_cache::invalidate_single(THD *thd,
+                                                TABLE_LIST *table_used,
+                                                my_bool using_transactions)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate_single (table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  DBUG_ASSERT(!using_transactions || table_used->table!=0);
+  if (table_used->derived)
+    DBUG_VOID_RETURN;
+  if (using_transactions &&
+      (table_used->table->file->table_cache_type() ==
+       HA_CACHE_TBL_TRANSACT))
+    /*
+      table_used->table can't be 0 in transaction.
+      Only 'drop' invalidate not opened table, but 'drop'
+      force transaction finish.
+    */
+    thd->add_changed_table(table_used->table);
+  else
+    invalidate_table(thd, table_used);
+
+  DBUG_VOID_RETURN;
+}
+
+/**
+  Remove all cached queries that use any of the tables in the list.
+
+  @see Partitioned_query_cache::invalidate_single().
+*/
+
+void Partitioned_query_cache::invalidate(THD *thd, TABLE_LIST *tables_used,
+                                         my_bool using_transactions)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate (table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  for (; tables_used; tables_used= tables_used->next_local)
+    invalidate_single(thd, tables_used, using_transactions);
+
+  DEBUG_SYNC(thd, "wait_after_query_cache_invalidate");
+
+  DBUG_VOID_RETURN;
+}
+
+void Partitioned_query_cache::invalidate(CHANGED_TABLE_LIST *tables_used)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate (changed table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  THD *thd= current_thd;
+  for (; tables_used; tables_used= tables_used->next)
+  {
+    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table_list);
+    invalidate_table(thd, (uchar*) tables_used->key, tables_used->key_length,
+                     QUERY_CACHE_ALL_PARTS);
+    DBUG_PRINT("qcache", ("db: %s  table: %s", tables_used->key,
+                          tables_used->key+
+                          strlen(tables_used->key)+1));
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Invalidate locked for write
+
+  SYNOPSIS
+    Partitioned_query_cache::invalidate_locked_for_write()
+    tables_used - table list
+
+  NOTE
+    can be used only for opened tables
+*/
+void
+Partitioned_query_cache::invalidate_locked_for_write(TABLE_LIST *tables_used)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate_locked_for_write");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  THD *thd= current_thd;
+  for (; tables_used; tables_used= tables_used->next_local)
+  {
+    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table);
+    if (tables_used->lock_type >= TL_WRITE_ALLOW_WRITE &&
+        tables_used->table)
+    {
+      invalidate_table(thd, tables_used->table);
+    }
+  }
+  DBUG_VOID_RETURN;
+}
+
+/*
+  Remove all cached queries that uses the given table
+*/
+
+void Partitioned_query_cache::invalidate(THD *thd, TABLE *table,
+                                         my_bool using_transactions)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate (table)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  if (using_transactions &&
+      (table->file->table_cache_type() == HA_CACHE_TBL_TRANSACT))
+    thd->add_changed_table(table);
+  else
+    invalidate_table(thd, table);
+
+
+  DBUG_VOID_RETURN;
+}
+
+void Partitioned_query_cache::invalidate(THD *thd, const char *key,
+                                         uint32  key_length,
+                                         my_bool using_transactions)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate (key)");
+  if (is_disabled())
+   DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  if (using_transactions) // used for innodb => has_transactions() is TRUE
+    thd->add_changed_table(key, key_length);
+  else
+    invalidate_table(thd, (uchar*)key, key_length, QUERY_CACHE_ALL_PARTS);
+
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+   Remove all cached queries that uses the given database.
+*/
+
+void Partitioned_query_cache::invalidate(const char *db)
+{
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].invalidate(db);
+}
+
+
+void Partitioned_query_cache::invalidate_by_MyISAM_filename(const char *filename)
+{
+  DBUG_ENTER("Partitioned_query_cache::invalidate_by_MyISAM_filename");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  /* Calculate the key outside the lock to make the lock shorter */
+  char key[MAX_DBKEY_LENGTH];
+  size_t db_length;
+  size_t key_length= Query_cache::filename_2_table_key(key, filename,
+                                                       &db_length);
+  THD *thd= current_thd;
+  invalidate_table(thd, (uchar *)key, key_length, QUERY_CACHE_ALL_PARTS);
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Invalidate the first table in the table_list
+*/
+
+void Partitioned_query_cache::invalidate_table(THD *thd,
+                                               TABLE_LIST *table_list)
+{
+  if (table_list->table != 0)
+    invalidate_table(thd, table_list->table);	// Table is open
+  else
+  {
+    const char *key;
+    size_t key_length;
+    key_length= get_table_def_key(table_list, &key);
+
+    // We don't store temporary tables => no key_length+=4 ...
+    invalidate_table(thd, (uchar *)key, key_length, QUERY_CACHE_ALL_PARTS);
+  }
+}
+
+
+/**
+  Invalidate the queries that use an open table.
+
+  With @@query_cache_invalidation=PARTITION, the queries that do not use
+  any of the partitions locked by a data change statement are kept: the
+  statement can not have changed the other partitions. Other statements
+  may change the definition or the numbering of the partitions, and
+  invalidate all queries using the table.
+*/
+
+void Partitioned_query_cache::invalidate_table(THD *thd, TABLE *table)
+{
+  ulonglong parts= QUERY_CACHE_ALL_PARTS;
+#ifdef WITH_PARTITION_STORAGE_ENGINE
+  if (query_cache_invalidation == QUERY_CACHE_INVALIDATION_PARTITION &&
+      thd != NULL && table->part_info != NULL)
+  {
+    switch (thd->lex->sql_command)
+    {
+    case SQLCOM_INSERT:
+    case SQLCOM_INSERT_SELECT:
+    case SQLCOM_REPLACE:
+    case SQLCOM_REPLACE_SELECT:
+    case SQLCOM_UPDATE:
+    case SQLCOM_UPDATE_MULTI:
+    case SQLCOM_DELETE:
+    case SQLCOM_DELETE_MULTI:
+    case SQLCOM_LOAD:
+      parts= locked_parts(table);
+      break;
+    default:
+      break;
+    }
+  }
+#endif
+  invalidate_table(thd, (uchar*) table->s->table_cache_key.str,
+                   table->s->table_cache_key.length, parts);
+}
+
+
+void Partitioned_query_cache::invalidate_table(THD *thd,
+                                               uchar *key, size_t key_length,
+                                               ulonglong parts)
+{
+  const ulonglong map=
+    static_cast<ulonglong>(my_atomic_load64(&m_table_map[table_bucket(
+                             reinterpret_cast<const char*>(key),
+                             key_length)]));
+  for (uint i= 0; i < m_partition_count; i++)
+  {
+    if (map & (1ULL << i))
+      m_partitions[i].invalidate_table(thd, key, key_length, parts);
+  }
+}
+
+
+uint Partitioned_query_cache::table_bucket(const char *key,
+                                           size_t key_length)
+{
+  return murmur3_32(reinterpret_cast<const uchar*>(key), key_length, 0) %
+         TABLE_MAP_SIZE;
+}
+
+
+void Partitioned_query_cache::add_table_partition(const char *key,
+                                                  size_t key_length,
+                                                  uint partition_no)
+{
+  volatile int64 *bucket= &m_table_map[table_bucket(key, key_length)];
+  const int64 bit= static_cast<int64>(1ULL << partition_no);
+  int64 map= my_atomic_load64(bucket);
+  while (!(map & bit) && !my_atomic_cas64(bucket, &map, map | bit))
+  {}
+}
+
+
+void Partitioned_query_cache::flush()
+{
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].flush();
+}
+
+
+void Partitioned_query_cache::pack(ulong join_limit, uint iteration_limit)
+{
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].pack(join_limit, iteration_limit);
+}
+
+
+void Partitioned_query_cache::destroy()
+{
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].destroy();
+  delete [] m_partitions;
+  m_partitions= NULL;
+  m_partition_count= 0;
+}
+
+
+void Partitioned_query_cache::wreck(uint line, const char *message)
+{
+  for (uint i= 0; i < m_partition_count; i++)
+    m_partitions[i].wreck(line, message);
+}
+
+
+ulong Partitioned_query_cache::free_memory() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].free_memory;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::queries_in_cache() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].queries_in_cache;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::hits() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].hits;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::inserts() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].inserts;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::refused() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].refused;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::free_memory_blocks() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].free_memory_blocks;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::total_blocks() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].total_blocks;
+  return sum;
+}
+
+
+ulong Partitioned_query_cache::lowmem_prunes() const
+{
+  ulong sum= 0;
+  for (uint i= 0; i < m_partition_count; i++)
+    sum+= m_partitions[i].lowmem_prunes;
+  return sum;
+}
+
+
+/**
+  Reset the counters which FLUSH STATUS resets. Like for other global
+  status variables, this is done without locking the partitions.
+*/
+
+void Partitioned_query_cache::reset_statistics()
+{
+  for (uint i= 0; i < m_partition_count; i++)
+  {
+    Query_cache *partition= &m_partitions[i];
+    partition->hits= 0;
+    partition->inserts= 0;
+    partition->lowmem_prunes= 0;
+    partition->refused= 0;
+  }
+}
+
 /****************************************************************************
   Functions to be used when debugging
 ****************************************************************************/
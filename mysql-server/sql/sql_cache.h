@@ -70,12 +70,23 @@ typedef ulonglong sql_mode_t;
 
 #define TABLE_COUNTER_TYPE size_t
 
+/* Query_cache_block_table::used_parts of a query using all partitions */
+#define QUERY_CACHE_ALL_PARTS (~(ulonglong) 0)
+
+/* Values of @@query_cache_invalidation */
+enum enum_query_cache_invalidation
+{
+  QUERY_CACHE_INVALIDATION_TABLE,
+  QUERY_CACHE_INVALIDATION_PARTITION
+};
+
 struct Query_cache_block;
 struct Query_cache_block_table;
 struct Query_cache_table;
 struct Query_cache_query;
 struct Query_cache_result;
 class Query_cache;
+class Partitioned_query_cache;
 struct Query_cache_tls;
 struct LEX;
 class THD;
@@ -113,6 +124,12 @@ struct Query_cache_block_table
   */
   Query_cache_table *parent;
 
+  /**
+    The partitions of a partitioned table that the query uses, partition
+    i being bit i % 64. All bits are set for other tables.
+  */
+  ulonglong used_parts;
+
   /**
     A method to calculate the address of the query cache block
     owning this node. The purpose of this calculation is to 
@@ -280,8 +297,16 @@ struct Query_cache_memory_bin_step
   }
 };
 
+/**
+  One partition of the query cache. Each partition has its own memory,
+  hashes of queries and tables, and lock.
+
+  @see Partitioned_query_cache
+*/
+
 class Query_cache
 {
+  friend class Partitioned_query_cache;
 public:
   /* Info */
   ulong query_cache_size, query_cache_limit;
@@ -300,8 +325,13 @@ private:
 
   bool m_query_cache_is_disabled;
 
+  /// The cache which this is a partition of, and the partition number
+  Partitioned_query_cache *m_owner;
+  uint m_partition_no;
+
   void free_query_internal(Query_cache_block *point);
-  void invalidate_table_internal(THD *thd, uchar *key, size_t key_length);
+  void invalidate_table_internal(THD *thd, uchar *key, size_t key_length,
+                                 ulonglong parts);
   void disable_query_cache(void) { m_query_cache_is_disabled= TRUE; }
 
 protected:
@@ -357,12 +387,13 @@ protected:
 			      ulong data_len,
 			      Query_cache_block *query_block,
 			      my_bool first_block);
-  void invalidate_table(THD *thd, TABLE_LIST *table);
-  void invalidate_table(THD *thd, TABLE *table);
-  void invalidate_table(THD *thd, uchar *key, size_t key_length);
-  void invalidate_table(THD *thd, Query_cache_block *table_block);
+  void invalidate_table(THD *thd, uchar *key, size_t key_length,
+                        ulonglong parts);
   void invalidate_query_block_list(THD *thd, 
                                    Query_cache_block_table *list_root);
+  void invalidate_query_block_list(THD *thd,
+                                   Query_cache_block_table *list_root,
+                                   ulonglong parts);
 
   TABLE_COUNTER_TYPE
     register_tables_from_list(TABLE_LIST *tables_used,
@@ -464,24 +495,9 @@ protected:
   */
   int send_result_to_client(THD *thd, const LEX_CSTRING &sql);
 
-  /* Remove all queries that use the given table */
-  void invalidate_single(THD* thd, TABLE_LIST *table_used,
-                         my_bool using_transactions);
-  /* Remove all queries that uses any of the listed following tables */
-  void invalidate(THD* thd, TABLE_LIST *tables_used,
-		  my_bool using_transactions);
-  void invalidate(CHANGED_TABLE_LIST *tables_used);
-  void invalidate_locked_for_write(TABLE_LIST *tables_used);
-  void invalidate(THD* thd, TABLE *table, my_bool using_transactions);
-  void invalidate(THD *thd, const char *key, uint32  key_length,
-		  my_bool using_transactions);
-
   /* Remove all queries that uses any of the tables in following database */
   void invalidate(const char *db);
 
-  /* Remove all queries that uses any of the listed following table */
-  void invalidate_by_MyISAM_filename(const char *filename);
-
   void flush();
   void pack(ulong join_limit = QUERY_CACHE_PACK_LIMIT,
 	    uint iteration_limit = QUERY_CACHE_PACK_ITERATION);
@@ -544,5 +560,142 @@ struct Query_cache_query_flags
 };
 #define QUERY_CACHE_FLAGS_SIZE sizeof(Query_cache_query_flags)
 
-extern Query_cache query_cache;
+
+/**
+  The query cache, split into partitions that are locked independently.
+
+  A query is stored in and looked up in the partition selected by a hash
+  of the query text and the current database, so that lookups and stores
+  of different queries are spread over the partitions instead of all
+  waiting for one lock. Results of a query are written to the partition
+  it was registered in, which is remembered in Query_cache_tls.
+
+  A change to a table must invalidate the queries using the table in
+  every partition. To avoid locking partitions which have never cached a
+  query on the table, m_table_map keeps, for each table key hash bucket,
+  a bitmap of the partitions that have registered a table in the bucket.
+  The bits are set before a table is registered and are never cleared,
+  so the map can be read without a lock: it may only give false
+  positives.
+
+  With @@query_cache_invalidation=PARTITION, a data change statement
+  which locks only some partitions of a partitioned table invalidates
+  only the queries which used one of those partitions; see
+  Query_cache_block_table::used_parts.
+*/
+
+class Partitioned_query_cache
+{
+public:
+  /// Maximum value of @@query_cache_partitions
+  static const uint MAX_PARTITIONS= 64;
+
+  /* Info */
+  ulong query_cache_size, query_cache_limit;
+
+  Partitioned_query_cache()
+    : query_cache_size(0), query_cache_limit(ULONG_MAX),
+      m_min_res_unit(QUERY_CACHE_MIN_RESULT_DATA_SIZE),
+      m_partitions(NULL), m_partition_count(0)
+  {
+    for (uint i= 0; i < TABLE_MAP_SIZE; i++)
+      m_table_map[i]= 0;
+  }
+
+  bool is_disabled(void)
+  {
+    return m_partitions == NULL || m_partitions[0].is_disabled();
+  }
+
+  /* initialize @@query_cache_partitions partitions */
+  void init();
+  /* resize query cache (return real query size, 0 if disabled) */
+  ulong resize(ulong query_cache_size);
+  /* set limit on result size */
+  void result_size_limit(ulong limit);
+  /* set minimal result data allocation unit size */
+  ulong set_min_res_unit(ulong size);
+
+  /* register query in cache */
+  void store_query(THD *thd, TABLE_LIST *used_tables);
+
+  /*
+    Check if the query is in the cache and if this is true send the
+    data to client.
+  */
+  int send_result_to_client(THD *thd, const LEX_CSTRING &sql);
+
+  /* Remove all queries that use the given table */
+  void invalidate_single(THD* thd, TABLE_LIST *table_used,
+                         my_bool using_transactions);
+  /* Remove all queries that uses any of the listed following tables */
+  void invalidate(THD* thd, TABLE_LIST *tables_used,
+		  my_bool using_transactions);
+  void invalidate(CHANGED_TABLE_LIST *tables_used);
+  void invalidate_locked_for_write(TABLE_LIST *tables_used);
+  void invalidate(THD* thd, TABLE *table, my_bool using_transactions);
+  void invalidate(THD *thd, const char *key, uint32  key_length,
+		  my_bool using_transactions);
+
+  /* Remove all queries that uses any of the tables in following database */
+  void invalidate(const char *db);
+
+  /* Remove all queries that uses any of the listed following table */
+  void invalidate_by_MyISAM_filename(const char *filename);
+
+  void flush();
+  void pack(ulong join_limit = QUERY_CACHE_PACK_LIMIT,
+	    uint iteration_limit = QUERY_CACHE_PACK_ITERATION);
+
+  void destroy();
+
+  void insert(Query_cache_tls *query_cache_tls,
+              const char *packet,
+              ulong length,
+              unsigned pkt_nr);
+
+  void end_of_result(THD *thd);
+  void abort(Query_cache_tls *query_cache_tls);
+
+  /* statistics, summed over the partitions */
+  ulong free_memory() const;
+  ulong queries_in_cache() const;
+  ulong hits() const;
+  ulong inserts() const;
+  ulong refused() const;
+  ulong free_memory_blocks() const;
+  ulong total_blocks() const;
+  ulong lowmem_prunes() const;
+  /* reset the statistics counted since the last FLUSH STATUS */
+  void reset_statistics();
+
+  /* Switch all partitions off, see Query_cache::wreck() */
+  void wreck(uint line, const char *message);
+
+  /*
+    Note that a partition is about to register a table. Called by
+    Query_cache::insert_table().
+  */
+  void add_table_partition(const char *key, size_t key_length,
+                           uint partition_no);
+
+private:
+  /// Number of table key hash buckets in m_table_map
+  static const uint TABLE_MAP_SIZE= 1024;
+
+  Query_cache *get_partition(THD *thd);
+  void invalidate_table(THD *thd, TABLE_LIST *table_list);
+  void invalidate_table(THD *thd, TABLE *table);
+  void invalidate_table(THD *thd, uchar *key, size_t key_length,
+                        ulonglong parts);
+  static uint table_bucket(const char *key, size_t key_length);
+
+  ulong m_min_res_unit;
+  Query_cache *m_partitions;
+  uint m_partition_count;
+  /// Partitions that have registered a table with a key in each bucket
+  volatile int64 m_table_map[TABLE_MAP_SIZE];
+};
+
+extern Partitioned_query_cache query_cache;
 #endif
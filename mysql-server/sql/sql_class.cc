@@ -51,6 +51,7 @@
 
 #include "sp_rcontext.h"
 #include "sp_cache.h"
+#include "sql_query_template.h"                 // query_template_cache_clear
 #include "transaction.h"
 #include "debug_sync.h"
 #include "sql_parse.h"                          // is_update_query
@@ -62,6 +63,7 @@
 #include "sql_timer.h"                          // thd_timer_destroy
 #include "parse_tree_nodes.h"
 #include "sql_prepare.h"                  // Prepared_statement
+#include "thr_malloc.h"                    // free_root_retain
 
 #include <mysql/psi/mysql_statement.h>
 #include "mysql/psi/mysql_ps.h"
@@ -1183,10 +1185,14 @@ THD::THD(bool enable_plugins)
   is_operating_gtid_table= false;
   m_row_count_func= -1;
   statement_id_counter= 0UL;
+  resource_group_name[0]= '\0';
+  resource_group_version= 0;
+  resource_group_id= 0;
   // Must be reset to handle error with THD's created for init of mysqld
   lex->thd= NULL;
   lex->set_current_select(0);
   utime_after_lock= 0L;
+  accept_utime= 0;
   current_linfo =  0;
   slave_thread = 0;
   memset(&variables, 0, sizeof(variables));
@@ -1210,6 +1216,7 @@ THD::THD(bool enable_plugins)
   net.vio=0;
 #endif
   client_capabilities= 0;                       // minimalistic client
+  protocol_options= 0;
   system_thread= NON_SYSTEM_THREAD;
   cleanup_done= 0;
   m_release_resources_done= false;
@@ -1244,6 +1251,7 @@ THD::THD(bool enable_plugins)
 
   sp_proc_cache= NULL;
   sp_func_cache= NULL;
+  query_template_cache= NULL;
 
   /* Protocol */
   protocol= &protocol_text;			// Default protocol
@@ -1686,6 +1694,7 @@ void THD::cleanup_connection(void)
                (my_hash_free_key) free_user_var, 0);
   sp_cache_clear(&sp_proc_cache);
   sp_cache_clear(&sp_func_cache);
+  query_template_cache_clear(&query_template_cache);
 
   clear_error();
   // clear the warnings
@@ -1772,6 +1781,7 @@ void THD::cleanup(void)
   close_temporary_tables(this);
   sp_cache_clear(&sp_proc_cache);
   sp_cache_clear(&sp_func_cache);
+  query_template_cache_clear(&query_template_cache);
 
   /*
     Actions above might generate events for the binary log, so we
@@ -2315,6 +2325,20 @@ void THD::cleanup_after_query()
 #endif
 }
 
+
+/**
+  Free the memory of the statement in mem_root at the end of a command.
+  Blocks of it are kept for the next statements, up to
+  query_alloc_retain_size bytes.
+*/
+
+void THD::free_query_mem_root()
+{
+  free_root_retain(mem_root, variables.query_alloc_retain_size,
+                   &status_var.query_alloc_blocks_allocated,
+                   &status_var.query_alloc_blocks_reused);
+}
+
 LEX_CSTRING *
 make_lex_string_root(MEM_ROOT *mem_root,
                      LEX_CSTRING *lex_str, const char* str, size_t length,
@@ -2730,10 +2754,12 @@ bool select_send::send_data(List<Item> &items)
   */
   ha_release_temporary_latches(thd);
 
+  protocol->start_net_row();
   protocol->prepare_for_resend();
   if (protocol->send_result_set_row(&items))
   {
     protocol->remove_last_row();
+    protocol->end_net_row();
     DBUG_RETURN(TRUE);
   }
 
@@ -2742,6 +2768,7 @@ bool select_send::send_data(List<Item> &items)
   if (thd->vio_ok())
     DBUG_RETURN(protocol->write());
 
+  protocol->end_net_row();
   DBUG_RETURN(0);
 }
 
@@ -86,6 +86,7 @@ class Query_log_event;
 class Load_log_event;
 class sp_rcontext;
 class sp_cache;
+class Query_template_cache;
 class Parser_state;
 class Rows_log_event;
 class Sroutine_hash_entry;
@@ -394,6 +395,7 @@ class MY_LOCALE;
 */
 
 struct Query_cache_block;
+class Query_cache;
 
 struct Query_cache_tls
 {
@@ -402,12 +404,18 @@ struct Query_cache_tls
     functions and methods to maintain proper locking.
   */
   Query_cache_block *first_query_block;
+  /*
+    The query cache partition in which the last query stored by the
+    thread was registered, NULL if none. first_query_block, if not NULL,
+    belongs to this partition.
+  */
+  Query_cache *partition;
   void set_first_query_block(Query_cache_block *first_query_block_arg)
   {
     first_query_block= first_query_block_arg;
   }
 
-  Query_cache_tls() :first_query_block(NULL) {}
+  Query_cache_tls() :first_query_block(NULL), partition(NULL) {}
 };
 
 #include "sql_lex.h"				/* Must be here */
@@ -457,6 +465,7 @@ typedef struct system_variables
   ulong auto_increment_increment, auto_increment_offset;
   ulong bulk_insert_buff_size;
   uint  eq_range_index_dive_limit;
+  uint  executor_batch_size;
   ulong join_buff_size;
   ulong lock_wait_timeout;
   ulong max_allowed_packet;
@@ -478,8 +487,11 @@ typedef struct system_variables
   ulong net_write_timeout;
   ulong optimizer_prune_level;
   ulong optimizer_search_depth;
+  ulong optimizer_dp_join_limit;
+  ulong optimizer_dp_max_plans;
   ulong preload_buff_size;
   ulong profiling_history_size;
+  ulong query_template_cache_size;
   ulong read_buff_size;
   ulong read_rnd_buff_size;
   ulong div_precincrement;
@@ -488,8 +500,10 @@ typedef struct system_variables
   ulong default_week_format;
   ulong max_seeks_for_key;
   ulong range_alloc_block_size;
+  ulonglong range_optimizer_max_mem_size;
   ulong query_alloc_block_size;
   ulong query_prealloc_size;
+  ulong query_alloc_retain_size;
   ulong trans_alloc_block_size;
   ulong trans_prealloc_size;
   ulong group_concat_max_len;
@@ -608,6 +622,16 @@ typedef struct system_status_var
   ulonglong table_open_cache_hits;
   ulonglong table_open_cache_misses;
   ulonglong table_open_cache_overflows;
+  ulonglong plan_cache_hits;
+  ulonglong plan_cache_misses;
+  ulonglong range_estimate_cache_hits;
+  ulonglong range_estimate_cache_misses;
+  ulonglong sp_shared_cache_hits;
+  ulonglong sp_shared_cache_misses;
+  ulonglong query_template_hits;
+  ulonglong query_template_misses;
+  ulonglong query_alloc_blocks_allocated;
+  ulonglong query_alloc_blocks_reused;
   ulonglong select_full_join_count;
   ulonglong select_full_range_join_count;
   ulonglong select_range_count;
@@ -1759,6 +1783,7 @@ public:
   const char *where;
 
   ulong client_capabilities;		/* What the client supports */
+  uint protocol_options;                /* PROTOCOL_OPTION_xxx in use */
   ulong max_client_packet_length;
 
   HASH		handler_tables_hash;
@@ -1790,6 +1815,8 @@ public:
   struct timeval user_time;
   // track down slow pthread_create
   ulonglong  thr_create_utime;
+  // when the connection was accepted, 0 if not a client connection
+  ulonglong  accept_utime;
   ulonglong  start_utime, utime_after_lock;
 
   /**
@@ -2400,6 +2427,21 @@ public:
   ulong      statement_id_counter;
   ulong	     rand_saved_seed1, rand_saved_seed2;
   pthread_t  real_id;                           /* For debugging */
+  /**
+    Name of the resource group of the session, empty for the default
+    group. Protected by LOCK_thd_data. @see resource_groups.h
+  */
+  char       resource_group_name[NAME_LEN + 1];
+  /**
+    Version of the resource groups when the session was last bound to its
+    group, 0 if it must be bound again. Set under LOCK_thd_data.
+  */
+  volatile int64 resource_group_version;
+  /**
+    Id of the resource group the session was last bound to, valid while
+    resource_group_version is current. Only set by the session itself.
+  */
+  volatile int64 resource_group_id;
   /**
     This counter is 32 bit because of the client protocol.
 
@@ -2626,6 +2668,8 @@ public:
   sp_rcontext *sp_runtime_ctx;
   sp_cache   *sp_proc_cache;
   sp_cache   *sp_func_cache;
+  /** Prepared templates of text queries, see sql_query_template.h */
+  Query_template_cache *query_template_cache;
 
   /** number of name_const() substitutions, see sp_head.cc:subst_spvars() */
   uint       query_name_consts;
@@ -2745,6 +2789,7 @@ public:
   void init_for_queries(Relay_log_info *rli= NULL);
   void cleanup_connection(void);
   void cleanup_after_query();
+  void free_query_mem_root();
   bool store_globals();
   bool restore_globals();
 
@@ -4410,6 +4455,7 @@ public:
 
 class select_union :public select_result_interceptor
 {
+protected:
   Temp_table_param tmp_table_param;
 public:
   TABLE *table;
@@ -94,6 +94,10 @@ enum enum_sql_command {
   SQLCOM_GET_DIAGNOSTICS,
   SQLCOM_ALTER_USER,
   SQLCOM_EXPLAIN_OTHER,
+  SQLCOM_CREATE_RESOURCE_GROUP,
+  SQLCOM_ALTER_RESOURCE_GROUP,
+  SQLCOM_DROP_RESOURCE_GROUP,
+  SQLCOM_SET_RESOURCE_GROUP,
 
   /*
     When a command is added here, be sure it's also added in mysqld.cc
@@ -23,8 +23,10 @@
 
 #include "hash.h"                       // HASH
 #include "m_string.h"                   // my_stpcpy
+#include "my_compress.h"                // CLIENT_ANY_COMPRESSION
 #include "probes_mysql.h"               // MYSQL_CONNECTION_START
 #include "auth_common.h"                // SUPER_ACL
+#include "connection_handler_manager.h" // Connection_handler_manager
 #include "hostname.h"                   // Host_errors
 #include "log.h"                        // sql_print_information
 #include "mysqld.h"                     // LOCK_user_conn
@@ -774,7 +776,8 @@ static void prepare_new_connection_state(THD* thd)
 {
   Security_context *sctx= thd->security_ctx;
 
-  if (thd->client_capabilities & CLIENT_COMPRESS)
+  /* The algorithm was set up when the handshake response was parsed */
+  if (thd->client_capabilities & CLIENT_ANY_COMPRESSION)
     thd->net.compress=1;        // Use compression
 
   // Initializing session system variables.
@@ -850,6 +853,10 @@ bool thd_prepare_connection(THD *thd)
                          (char *) thd->security_ctx->host_or_ip);
 
   prepare_new_connection_state(thd);
+
+  if (thd->accept_utime != 0)
+    Connection_handler_manager::add_connect_latency(my_micro_time() -
+                                                    thd->accept_utime);
   return FALSE;
 }
 
@@ -415,6 +415,9 @@ bool mysql_derived_materialize(THD *thd, LEX *lex, TABLE_LIST *derived)
     DBUG_ASSERT(join && join->optimized);
 
     unit->set_limit(first_select);
+    // The LIMIT of the outer query block may have been pushed down
+    if (join->derived_pushed_limit < unit->select_limit_cnt)
+      unit->select_limit_cnt= join->derived_pushed_limit;
     if (unit->select_limit_cnt == HA_POS_ERROR)
       first_select->options&= ~OPTION_FOUND_ROWS;
 
@@ -39,6 +39,9 @@
 #include "records.h"          // rr_sequential
 #include "opt_explain_format.h" // Explain_format_flags
 #include "debug_sync.h"
+#include "sql_batch.h"        // Batch_scan
+#include "key_hash_set.h"     // Key_hash_set
+#include "opt_costcalibration.h" // cost_calibration_start
 
 #include <algorithm>
 using std::max;
@@ -83,6 +86,7 @@ static bool remove_dup_with_hash_index(THD *thd,TABLE *table,
 static int join_read_linked_first(QEP_TAB *tab);
 static int join_read_linked_next(READ_RECORD *info);
 static int do_sj_reset(SJ_TMP_TABLE *sj_tbl);
+static int sj_weedout_write_row(THD *thd, SJ_TMP_TABLE *sjtbl);
 static bool cmp_buffer_with_ref(THD *thd, TABLE *table, TABLE_REF *tab_ref);
 
 /**
@@ -809,6 +813,51 @@ void setup_tmptable_write_func(QEP_TAB *tab)
 }
 
 
+/**
+  @brief Set up filtering of the rows written to a tmp table that is
+  sorted with a LIMIT
+
+  @param tab  QEP_TAB of the last tmp table, after the sorting of the
+              tmp table has been added
+
+  @details
+  When the join result is written to a tmp table which is then sorted
+  with a LIMIT, filesort() keeps only the first LIMIT rows in a priority
+  queue, but every row of the join is written to the tmp table first.
+  With a Top_n_filter, end_write() keeps the keys of the first LIMIT rows
+  written so far, and does not write rows that sort after all of them.
+
+  This requires that every row written to the tmp table is a candidate
+  for the result: no rows may be removed as duplicates or by a condition
+  evaluated when the tmp table is sorted, and SQL_CALC_FOUND_ROWS must
+  not count them.
+
+  @return
+    true  error
+    false ok
+*/
+
+bool setup_tmptable_top_n_filter(QEP_TAB *tab)
+{
+  JOIN *const join= tab->join();
+  TABLE *const table= tab->table();
+  Filesort *const fsort= tab->filesort;
+
+  if (fsort == NULL || fsort->limit == HA_POS_ERROR || fsort->limit == 0 ||
+      tab->op == NULL || tab->op->type() != QEP_operation::OT_TMP_TABLE ||
+      static_cast<QEP_tmp_table *>(tab->op)->get_write_func() != end_write)
+    return false;
+
+  if (table->group || table->distinct || table->hash_field ||
+      tab->distinct || join->select_distinct || tab->condition() ||
+      (join->select_options & OPTION_FOUND_ROWS))
+    return false;
+
+  tab->top_n_filter= Top_n_filter::create(join->thd, table, fsort);
+  return tab->top_n_filter == NULL && join->thd->is_error();
+}
+
+
 /**
   @details
   Rows produced by a join sweep may end up in a temporary table or be sent
@@ -1282,6 +1331,89 @@ sub_select(JOIN *join, QEP_TAB *const qep_tab,bool end_of_records)
 }
 
 
+/**
+  Scan a table and aggregate its rows in batches.
+
+  Used instead of sub_select() as JOIN::first_select when
+  Batch_scan::create() has accepted the query. The rows are read as in
+  sub_select(), but rather than evaluating the condition and the aggregate
+  functions for each row, the columns they use are copied into the batch,
+  and the condition and the functions are evaluated for many rows at a
+  time. The single group is sent by end_send_group() at end of records.
+
+  @param join           join being executed
+  @param qep_tab        the table to scan
+  @param end_of_records TRUE <=> send the group
+
+  @return one of enum_nested_loop_state
+*/
+
+enum_nested_loop_state
+sub_select_batch(JOIN *join, QEP_TAB *const qep_tab, bool end_of_records)
+{
+  DBUG_ENTER("sub_select_batch");
+
+  if (end_of_records)
+    DBUG_RETURN((*qep_tab->next_select)(join, qep_tab + 1, end_of_records));
+
+  Batch_scan *const batch= join->batch_scan;
+  READ_RECORD *info= &qep_tab->read_record;
+  qep_tab->table()->null_row= 0;
+
+  if (qep_tab->prepare_scan() || batch->init())
+    DBUG_RETURN(NESTED_LOOP_ERROR);
+
+  join->thd->get_stmt_da()->reset_current_row_for_condition();
+
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  bool in_first_read= true;
+  const bool pfs_batch_update= qep_tab->pfs_batch_update(join);
+  if (pfs_batch_update)
+    qep_tab->table()->file->start_psi_batch_mode();
+  for (;;)
+  {
+    int error;
+    if (in_first_read)
+    {
+      in_first_read= false;
+      error= (*qep_tab->read_first_record)(qep_tab);
+    }
+    else
+      error= info->read_record(info);
+
+    if (error > 0 || (join->thd->is_error()))   // Fatal error
+    {
+      rc= NESTED_LOOP_ERROR;
+      break;
+    }
+    if (error < 0)
+      break;
+    if (join->thd->killed)                      // Aborted by user
+    {
+      join->thd->send_kill_message();
+      rc= NESTED_LOOP_KILLED;
+      break;
+    }
+    join->examined_rows++;
+    join->thd->get_stmt_da()->inc_current_row_for_condition();
+    if (batch->add_row())
+      batch->process();
+  }
+
+  if (pfs_batch_update)
+    qep_tab->table()->file->end_psi_batch_mode();
+
+  if (rc == NESTED_LOOP_OK)
+  {
+    batch->process();
+    /* Let end_send_group() send the group instead of the empty result */
+    if (batch->found_rows())
+      join->first_record= true;
+  }
+  DBUG_RETURN(rc);
+}
+
+
 /**
   @brief Prepare table to be scanned.
 
@@ -1326,6 +1458,11 @@ bool QEP_TAB::prepare_scan()
     rowids) in the temporary table. This records the fact that we've seen 
     this record combination and also tells us if we've seen it before.
 
+    While the tuples fit in memory, they are looked up and stored in
+    sjtbl->hash_set instead, without any handler calls. When the set can
+    not grow any more, its tuples are written to the temporary table,
+    which is used until the next do_sj_reset().
+
   RETURN
     -1  Error
     1   The row combination is a duplicate (discard it)
@@ -1391,14 +1528,55 @@ int do_sj_dups_weedout(THD *thd, SJ_TMP_TABLE *sjtbl)
     }
   }
 
+  if (!sjtbl->use_hash_set)
+    DBUG_RETURN(sj_weedout_write_row(thd, sjtbl));
+
+  switch (sjtbl->hash_set->insert(nulls_ptr))
+  {
+  case Key_hash_set::KEY_INSERTED:
+    DBUG_RETURN(0);
+  case Key_hash_set::KEY_EXISTS:
+    DBUG_RETURN(1);
+  case Key_hash_set::SET_FULL:
+    break;
+  }
+
+  /*
+    Spill the set: write the current tuple, which is not in the set, then
+    the tuples of the set, to the temporary table.
+  */
+  sjtbl->use_hash_set= false;
+  if ((error= sj_weedout_write_row(thd, sjtbl)) < 0)
+    DBUG_RETURN(error);
+  const uchar *key;
+  for (ulong pos= 0; (key= sjtbl->hash_set->next_key(&pos)); )
+  {
+    memcpy(nulls_ptr, key, sjtbl->hash_set->key_size());
+    if (sj_weedout_write_row(thd, sjtbl) < 0)
+      DBUG_RETURN(-1);
+  }
+  sjtbl->hash_set->free();
+  DBUG_RETURN(error);
+}
+
+
+/**
+  SemiJoinDuplicateElimination: Write the rowid tuple in the record of the
+  temporary table to the table.
+
+  @returns as do_sj_dups_weedout()
+*/
+
+static int sj_weedout_write_row(THD *thd, SJ_TMP_TABLE *sjtbl)
+{
   if (!check_unique_constraint(sjtbl->tmp_table, 0))
-      DBUG_RETURN(1);
-  error= sjtbl->tmp_table->file->ha_write_row(sjtbl->tmp_table->record[0]);
+    return 1;
+  int error= sjtbl->tmp_table->file->ha_write_row(sjtbl->tmp_table->record[0]);
   if (error)
   {
     /* If this is a duplicate error, return immediately */
     if (sjtbl->tmp_table->file->is_ignorable_error(error))
-      DBUG_RETURN(1);
+      return 1;
     /*
       Other error than duplicate error: Attempt to create a temporary table.
     */
@@ -1406,10 +1584,10 @@ int do_sj_dups_weedout(THD *thd, SJ_TMP_TABLE *sjtbl)
     if (create_ondisk_from_heap(thd, sjtbl->tmp_table,
                                 sjtbl->start_recinfo, &sjtbl->recinfo,
                                 error, TRUE, &is_duplicate))
-      DBUG_RETURN(-1);
-    DBUG_RETURN(is_duplicate ? 1 : 0);
+      return -1;
+    return is_duplicate ? 1 : 0;
   }
-  DBUG_RETURN(0);
+  return 0;
 }
 
 
@@ -1422,7 +1600,12 @@ static int do_sj_reset(SJ_TMP_TABLE *sj_tbl)
   DBUG_ENTER("do_sj_reset");
   if (sj_tbl->tmp_table)
   {
-    int rc= sj_tbl->tmp_table->file->ha_delete_all_rows();
+    int rc= 0;
+    /* The table has no rows unless the hash set has been spilled into it */
+    if (!sj_tbl->use_hash_set)
+      rc= sj_tbl->tmp_table->file->ha_delete_all_rows();
+    if (sj_tbl->hash_set)
+      sj_tbl->use_hash_set= !sj_tbl->hash_set->init();
     DBUG_RETURN(rc);
   }
   sj_tbl->have_confluent_row= FALSE;
@@ -1460,7 +1643,10 @@ evaluate_join_record(JOIN *join, QEP_TAB *const qep_tab)
 
   if (condition)
   {
+    const ulonglong start= cost_calibration_start();
     found= MY_TEST(condition->val_int());
+    if (start)
+      cost_calibration_add_row_evaluate(start);
 
     if (join->thd->killed)
     {
@@ -3249,6 +3435,9 @@ end_write(JOIN *join, QEP_TAB *const qep_tab, bool end_of_records)
       int error;
       join->found_records++;
 
+      if (qep_tab->top_n_filter && qep_tab->top_n_filter->skip_row())
+        goto end; // Sorts after LIMIT rows already written
+
       if (!check_unique_constraint(table, tmp_tbl->hidden_field_count))
         goto end; // skip it
 
@@ -4475,6 +4664,8 @@ QEP_tmp_table::prepare_tmp_table()
     (void) table->file->extra(HA_EXTRA_WRITE_CACHE);
     empty_record(table);
   }
+  if (qep_tab->top_n_filter)
+    qep_tab->top_n_filter->reset();
   /* If it wasn't already, start index scan for grouping using table index. */
   if (!table->file->inited &&
       ((table->group &&
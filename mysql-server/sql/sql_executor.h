@@ -24,6 +24,7 @@
 class JOIN;
 class JOIN_TAB;
 class QEP_TAB;
+class Key_hash_set;
 typedef struct st_table_ref TABLE_REF;
 typedef struct st_position POSITION;
 
@@ -75,12 +76,15 @@ typedef enum_nested_loop_state
   executing. If a join table is on the inner side of the outer join, we
   assume that its rowid can be NULL and provide means to store this rowid in
   the tuple.
+
+  While the rowid tuples fit in memory, they are kept in a hash set rather
+  than in the temptable, see do_sj_dups_weedout().
 */
 
 class SJ_TMP_TABLE : public Sql_alloc
 {
 public:
-  SJ_TMP_TABLE():hash_field(NULL)
+  SJ_TMP_TABLE():hash_field(NULL), hash_set(NULL), use_hash_set(false)
   {}
   /*
     Array of pointers to tables whose rowids compose the temporary table
@@ -131,6 +135,13 @@ public:
   SJ_TMP_TABLE *next; 
   /* Calc hash instead of too long key */
   Field_longlong *hash_field;
+
+  /*
+    The rowid tuples seen since the last do_sj_reset(), when use_hash_set
+    is TRUE. Otherwise the set has been spilled into tmp_table.
+  */
+  Key_hash_set *hash_set;
+  bool use_hash_set;
 };
 
 
@@ -258,6 +269,8 @@ public:
   {
     write_func= new_write_func;
   }
+  /** write_func getter */
+  Next_select_func get_write_func() const { return write_func; }
 
 private:
   /** Write function that would be used for saving records in tmp table. */
@@ -268,6 +281,7 @@ private:
 
 
 void setup_tmptable_write_func(QEP_TAB *tab);
+bool setup_tmptable_top_n_filter(QEP_TAB *tab);
 enum_nested_loop_state sub_select_op(JOIN *join, QEP_TAB *qep_tab, bool
                                         end_of_records);
 enum_nested_loop_state end_send_group(JOIN *join, QEP_TAB *qep_tab,
@@ -276,6 +290,8 @@ enum_nested_loop_state end_write_group(JOIN *join, QEP_TAB *qep_tab,
                                        bool end_of_records);
 enum_nested_loop_state sub_select(JOIN *join,QEP_TAB *qep_tab, bool
                                   end_of_records);
+enum_nested_loop_state sub_select_batch(JOIN *join, QEP_TAB *qep_tab,
+                                        bool end_of_records);
 enum_nested_loop_state
 evaluate_join_record(JOIN *join, QEP_TAB *qep_tab, int error);
 
@@ -328,6 +344,7 @@ bool check_unique_constraint(TABLE *table, int hidden_field_count);
 ulonglong unique_hash(Field *field, ulonglong *hash);
 
 class Opt_trace_object;
+class Top_n_filter;
 
 class QEP_TAB : public Sql_alloc, public QEP_shared_owner
 {
@@ -363,6 +380,7 @@ public:
     op(NULL),
     tmp_table_param(NULL),
     filesort(NULL),
+    top_n_filter(NULL),
     fields(NULL),
     all_fields(NULL),
     ref_array(NULL),
@@ -568,6 +586,12 @@ public:
   /* Sorting related info */
   Filesort *filesort;
 
+  /**
+    Filter for the rows written to this tmp table when it is sorted with
+    a LIMIT, see setup_tmptable_top_n_filter()
+  */
+  Top_n_filter *top_n_filter;
+
   /**
     List of topmost expressions in the select list. The *next* JOIN TAB
     in the plan should use it to obtain correct values. Same applicable to
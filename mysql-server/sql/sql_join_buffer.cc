@@ -866,6 +866,13 @@ uint JOIN_CACHE_BKA::aux_buffer_incr()
   TABLE_REF *ref= &qep_tab->ref();
   TABLE *tab= qep_tab->table();
 
+  /*
+    The default MRR implementation reading keys in sorted batches needs
+    space for one range per record.
+  */
+  if (mrr_mode & HA_MRR_SORT_KEYS)
+    return handler::mrr_sort_keys_entry_size(&tab->key_info[ref->key]);
+
   if (records == 1)
     incr=  ref->key_length + tab->file->ref_length;
   /*
@@ -890,6 +897,13 @@ uint JOIN_CACHE_BKA::aux_buffer_incr()
 
 uint JOIN_CACHE_BKA::aux_buffer_min_size() const
 {
+  if (mrr_mode & HA_MRR_SORT_KEYS)
+  {
+    const TABLE *tab= qep_tab->table();
+    /* Sorting pays off only for batches of at least two keys */
+    return 2 * handler::mrr_sort_keys_entry_size(
+                 &tab->key_info[qep_tab->ref().key]);
+  }
   /*
     For DS-MRR to work, the sort buffer must have space to store the
     reference (or primary key) for at least one record.
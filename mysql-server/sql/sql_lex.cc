@@ -434,6 +434,7 @@ void LEX::reset()
   context_analysis_only= 0;
   derived_tables= 0;
   safe_to_cache_query= true;
+  has_plan_cache_key= false;
   leaf_tables_insert= NULL;
   parsing_options.reset();
   empty_field_list_on_rset= false;
@@ -461,6 +462,7 @@ void LEX::reset()
   allow_sum_func= 0;
   in_sum_func= NULL;
   server_options.reset();
+  resource_group_options.reset();
   explain_format= NULL;
   is_lex_started= true;
   used_tables= 0;
@@ -1388,7 +1390,13 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
       const char *start;
       if (use_mb(cs))
       {
-	result_state= IDENT_QUOTED;
+        /*
+          An ASCII character is a character of its own in all client
+          character sets, so identifiers of ASCII characters, which most
+          are, are scanned without multi-byte checks, and are returned
+          as IDENT since they need no conversion.
+        */
+	result_state= (lip->yyGetLast() & 0x80) ? IDENT_QUOTED : IDENT;
         switch (my_mbcharlen(cs, lip->yyGetLast()))
         {
         case 1:
@@ -1409,6 +1417,9 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
         }
         while (ident_map[c=lip->yyGet()])
         {
+          if (!(c & 0x80))
+            continue;
+          result_state= IDENT_QUOTED;
           switch (my_mbcharlen(cs, c))
           {
           case 1:
@@ -1555,9 +1566,12 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
       result_state= IDENT;
       if (use_mb(cs))
       {
-	result_state= IDENT_QUOTED;
+        // ASCII characters need no multi-byte checks, see MY_LEX_IDENT
         while (ident_map[c=lip->yyGet()])
         {
+          if (!(c & 0x80))
+            continue;
+          result_state= IDENT_QUOTED;
           switch (my_mbcharlen(cs, c))
           {
           case 1:
@@ -28,9 +28,11 @@
 #include "mem_root_array.h"
 #include "sql_alter.h"                // Alter_info
 #include "sql_servers.h"
+#include "resource_groups.h"          // Resource_group_options
 #include "trigger_def.h"              // enum_trigger_action_time_type
 #include "xa.h"                       // XID, xa_option_words
 #include "prealloced_array.h"
+#include "my_md5.h"                   // MD5_HASH_SIZE
 
 /* YACC and LEX Definitions */
 
@@ -1187,6 +1189,23 @@ struct Proc_analyse_params
 };
 
 
+/**
+  Histogram clause of ANALYZE TABLE
+*/
+
+struct Histogram_options
+{
+  enum enum_command { NONE, UPDATE, DROP };
+
+  enum_command command;
+  List<String> *columns; //< the columns of UPDATE/DROP HISTOGRAM ON
+  uint num_buckets; //< maximum number of buckets of each histogram
+
+  static const uint default_num_buckets= 100;
+  static const uint max_num_buckets= 1024;
+};
+
+
 struct Select_lock_type
 {
   bool is_set;
@@ -1342,6 +1361,7 @@ union YYSTYPE {
   class PT_group *group;
   class PT_order *order;
   struct Proc_analyse_params procedure_analyse_params;
+  struct Histogram_options histogram_options;
   class PT_procedure_analyse *procedure_analyse;
   Select_lock_type select_lock_type;
   class PT_union_order_or_limit *union_order_or_limit;
@@ -2704,6 +2724,7 @@ public:
   LEX_MASTER_INFO mi;				// used by CHANGE MASTER
   LEX_SLAVE_CONNECTION slave_connection;
   Server_options server_options;
+  Resource_group_options resource_group_options;
   USER_RESOURCES mqh;
   LEX_RESET_SLAVE reset_slave_info;
   ulong type;
@@ -2761,6 +2782,12 @@ public:
 
   enum enum_yes_no_unknown tx_chain, tx_release;
   bool safe_to_cache_query;
+  /**
+    Hash identifying the statement in the plan cache, valid if
+    has_plan_cache_key is true. @see sql_plan_cache.h
+  */
+  uchar plan_cache_key[MD5_HASH_SIZE];
+  bool has_plan_cache_key;
   bool subqueries;
 private:
   bool ignore;
@@ -178,6 +178,27 @@ JOIN::optimize()
 
   tables_list= select_lex->get_table_list();
 
+  // Conditions and LIMIT pushed down from the outer query block, if any
+  if (derived_pushed_cond != NULL)
+  {
+    if (where_cond == NULL)
+      where_cond= derived_pushed_cond;
+    else
+    {
+      Item *cond= new Item_cond_and(where_cond, derived_pushed_cond);
+      if (cond == NULL || cond->fix_fields(thd, &cond))
+        DBUG_RETURN(1);
+      where_cond= cond;
+    }
+  }
+  if (derived_pushed_limit < unit->select_limit_cnt)
+    unit->select_limit_cnt= derived_pushed_limit;
+
+  if (select_lex->materialized_table_count &&
+      thd->optimizer_switch_flag(OPTIMIZER_SWITCH_DERIVED_CONDITION_PUSHDOWN) &&
+      push_down_to_derived_tables())
+    DBUG_RETURN(1);
+
   /* dump_TABLE_LIST_graph(select_lex, select_lex->leaf_tables); */
   /*
     Run optimize phase for all derived tables/views used in this SELECT,
@@ -2195,6 +2216,351 @@ bool JOIN::prune_table_partitions()
 #endif
 
 
+/**
+  Get an argument of a condition on a materialized derived table for the
+  rewrite of the condition to the query block of the derived table.
+
+  @param thd      thread handle
+  @param arg      the argument
+  @param derived  the derived table
+
+  @returns the argument itself if it is a constant, a new Item_field for the
+           column of the query block if it is a column of the derived
+           table, or NULL if it is neither
+*/
+
+static Item *derived_cond_arg(THD *thd, Item *arg, TABLE_LIST *derived)
+{
+  if (arg->cols() != 1 || arg->has_subquery() || arg->has_stored_program() ||
+      arg->with_sum_func)
+    return NULL;
+  if (arg->const_item())
+    return arg;
+
+  Item *const real_arg= arg->real_item();
+  if (real_arg->type() != Item::FIELD_ITEM)
+    return NULL;
+  Field *const field= down_cast<Item_field *>(real_arg)->field;
+  if (field->table != derived->table)
+    return NULL;
+
+  // The columns of the derived table are the items of the SELECT list
+  SELECT_LEX *const sl= derived->get_unit()->first_select();
+  if (field->field_index >= sl->item_list.elements)
+    return NULL;
+  List_iterator<Item> it(sl->item_list);
+  Item *item= NULL;
+  for (uint i= 0; i <= field->field_index; i++)
+    item= it++;
+
+  item= item->real_item();
+  if (item->type() != Item::FIELD_ITEM)
+    return NULL;
+  Item_field *const column= down_cast<Item_field *>(item);
+  if (!column->field->eq_def(field))
+    return NULL;
+
+  /*
+    In a grouped query block, only a condition on a grouping column
+    removes the same groups before grouping as after.
+  */
+  if (sl->group_list.elements > 0 || sl->with_sum_func)
+  {
+    ORDER *group;
+    for (group= sl->group_list.first; group; group= group->next)
+    {
+      Item *const group_item= (*group->item)->real_item();
+      if (group_item->type() == Item::FIELD_ITEM &&
+          down_cast<Item_field *>(group_item)->field == column->field)
+        break;
+    }
+    if (group == NULL)
+      return NULL;
+  }
+
+  return new Item_field(thd, column);
+}
+
+
+/**
+  Check that comparing the first argument with each of the others compares
+  the same way as the comparison of all arguments together of BETWEEN or
+  IN: same result type, and for strings the collation of the first
+  argument wins.
+*/
+
+static bool same_comparison_type(Item **args, uint count)
+{
+  const Item_result type= args[0]->result_type();
+  for (uint i= 1; i < count; i++)
+  {
+    if (args[i]->result_type() != type)
+      return false;
+    if (type == STRING_RESULT &&
+        args[i]->collation.collation != args[0]->collation.collation &&
+        args[i]->collation.derivation <= args[0]->collation.derivation)
+      return false;
+  }
+  return true;
+}
+
+
+/**
+  Rewrite a condition on a materialized derived table to a condition on
+  the columns of the query block of the derived table.
+
+  Conjunctions and disjunctions of comparisons, NULL tests and LIKE of
+  columns and constants are rewritten. BETWEEN and IN are rewritten to
+  comparisons, when those compare the same way.
+
+  @param thd      thread handle
+  @param cond     the condition, which only refers to the derived table
+  @param derived  the derived table
+
+  @returns the new condition, not fixed, or NULL if the condition can not
+           be rewritten
+*/
+
+static Item *derived_cond_rewrite(THD *thd, Item *cond, TABLE_LIST *derived)
+{
+  if (cond->type() == Item::COND_ITEM)
+  {
+    Item_cond *const cond_item= down_cast<Item_cond *>(cond);
+    List<Item> new_args;
+    List_iterator<Item> li(*cond_item->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      Item *const new_item= derived_cond_rewrite(thd, item, derived);
+      if (new_item == NULL || new_args.push_back(new_item))
+        return NULL;
+    }
+    if (cond_item->functype() == Item_func::COND_AND_FUNC)
+      return new Item_cond_and(new_args);
+    if (cond_item->functype() == Item_func::COND_OR_FUNC)
+      return new Item_cond_or(new_args);
+    return NULL;
+  }
+  if (cond->type() != Item::FUNC_ITEM)
+    return NULL;
+
+  Item_func *const func= down_cast<Item_func *>(cond);
+  Item **const args= func->arguments();
+  switch (func->functype())
+  {
+  case Item_func::EQ_FUNC:
+  case Item_func::EQUAL_FUNC:
+  case Item_func::NE_FUNC:
+  case Item_func::LT_FUNC:
+  case Item_func::LE_FUNC:
+  case Item_func::GT_FUNC:
+  case Item_func::GE_FUNC:
+  {
+    Item *const a= derived_cond_arg(thd, args[0], derived);
+    Item *const b= derived_cond_arg(thd, args[1], derived);
+    if (a == NULL || b == NULL)
+      return NULL;
+    switch (func->functype())
+    {
+    case Item_func::EQ_FUNC:    return new Item_func_eq(a, b);
+    case Item_func::EQUAL_FUNC: return new Item_func_equal(a, b);
+    case Item_func::NE_FUNC:    return new Item_func_ne(a, b);
+    case Item_func::LT_FUNC:    return new Item_func_lt(a, b);
+    case Item_func::LE_FUNC:    return new Item_func_le(a, b);
+    case Item_func::GT_FUNC:    return new Item_func_gt(a, b);
+    default:                    return new Item_func_ge(a, b);
+    }
+  }
+  case Item_func::ISNULL_FUNC:
+  case Item_func::ISNOTNULL_FUNC:
+  {
+    Item *const a= derived_cond_arg(thd, args[0], derived);
+    if (a == NULL)
+      return NULL;
+    if (func->functype() == Item_func::ISNULL_FUNC)
+      return new Item_func_isnull(a);
+    return new Item_func_isnotnull(a);
+  }
+  case Item_func::LIKE_FUNC:
+  {
+    Item_func_like *const like= down_cast<Item_func_like *>(func);
+    Item *const a= derived_cond_arg(thd, args[0], derived);
+    Item *const b= derived_cond_arg(thd, args[1], derived);
+    if (a == NULL || b == NULL)
+      return NULL;
+    return new Item_func_like(a, b, like->get_escape_item(),
+                              like->escape_was_used_in_parsing());
+  }
+  case Item_func::BETWEEN:
+  {
+    // a BETWEEN b AND c  =>  a >= b AND a <= c
+    if (down_cast<Item_func_between *>(func)->negated ||
+        !same_comparison_type(args, 3))
+      return NULL;
+    Item *const a1= derived_cond_arg(thd, args[0], derived);
+    Item *const a2= derived_cond_arg(thd, args[0], derived);
+    Item *const b= derived_cond_arg(thd, args[1], derived);
+    Item *const c= derived_cond_arg(thd, args[2], derived);
+    if (a1 == NULL || a2 == NULL || b == NULL || c == NULL)
+      return NULL;
+    Item *const ge= new Item_func_ge(a1, b);
+    Item *const le= new Item_func_le(a2, c);
+    if (ge == NULL || le == NULL)
+      return NULL;
+    return new Item_cond_and(ge, le);
+  }
+  case Item_func::IN_FUNC:
+  {
+    // a IN (b, c, ...)  =>  a = b OR a = c OR ...
+    if (down_cast<Item_func_in *>(func)->negated ||
+        !same_comparison_type(args, func->argument_count()))
+      return NULL;
+    List<Item> equalities;
+    for (uint i= 1; i < func->argument_count(); i++)
+    {
+      Item *const a= derived_cond_arg(thd, args[0], derived);
+      Item *const b= derived_cond_arg(thd, args[i], derived);
+      if (a == NULL || b == NULL)
+        return NULL;
+      Item *const eq= new Item_func_eq(a, b);
+      if (eq == NULL || equalities.push_back(eq))
+        return NULL;
+    }
+    return new Item_cond_or(equalities);
+  }
+  default:
+    return NULL;
+  }
+}
+
+
+/**
+  Collect the conjuncts of a condition that can be pushed down to a
+  materialized derived table, rewritten by derived_cond_rewrite().
+
+  @param thd          thread handle
+  @param cond         the condition
+  @param derived      the derived table
+  @param[out] pushed  the rewritten conjuncts
+
+  @returns true if out of memory
+*/
+
+static bool collect_derived_conds(THD *thd, Item *cond, TABLE_LIST *derived,
+                                  List<Item> *pushed)
+{
+  if (cond->type() == Item::COND_ITEM &&
+      down_cast<Item_cond *>(cond)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List_iterator<Item> li(*down_cast<Item_cond *>(cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (collect_derived_conds(thd, item, derived, pushed))
+        return true;
+    }
+    return false;
+  }
+
+  if (cond->used_tables() != derived->map() || cond->has_subquery() ||
+      cond->has_stored_program())
+    return false;
+  Item *const new_cond= derived_cond_rewrite(thd, cond, derived);
+  return new_cond != NULL && pushed->push_back(new_cond);
+}
+
+
+/**
+  Push conditions of the WHERE clause, and the LIMIT, of this query block
+  down to the query blocks of the materialized derived tables and views it
+  reads, so that fewer rows are materialized.
+
+  A conjunct of the WHERE condition that only refers to a derived table is
+  rewritten to the columns of the query block of the derived table, see
+  derived_cond_rewrite(), and added to its WHERE condition. The conjunct
+  is kept in the WHERE condition of this query block too. Nothing is
+  pushed to a derived table that is an inner table of an outer join or a
+  semi-join, or whose query expression is a UNION, has a LIMIT, ROLLUP,
+  or side effects that depend on the rows it reads.
+
+  The LIMIT is pushed down if this is the outermost query block, it reads
+  only the derived table and returns each row it reads: it has no WHERE,
+  HAVING, grouping, DISTINCT, ORDER BY or SQL_CALC_FOUND_ROWS.
+
+  @returns false if success, true if error
+*/
+
+bool JOIN::push_down_to_derived_tables()
+{
+  DBUG_ENTER("JOIN::push_down_to_derived_tables");
+  Opt_trace_context *const trace= &thd->opt_trace;
+
+  const bool push_limit= thd->lex->sql_command == SQLCOM_SELECT &&
+                         unit->outer_select() == NULL &&
+                         !unit->is_union() &&
+                         unit->select_limit_cnt != HA_POS_ERROR &&
+                         select_lex->leaf_table_count == 1 &&
+                         where_cond == NULL && having_cond == NULL &&
+                         select_lex->group_list.elements == 0 &&
+                         select_lex->order_list.elements == 0 &&
+                         !select_lex->with_sum_func && !select_distinct &&
+                         !(select_options & OPTION_FOUND_ROWS);
+
+  for (TABLE_LIST *tl= select_lex->leaf_tables; tl; tl= tl->next_leaf)
+  {
+    if (!tl->uses_materialization() || tl->embedding || tl->outer_join)
+      continue;
+
+    SELECT_LEX_UNIT *const derived_unit= tl->get_unit();
+    SELECT_LEX *const derived_select= derived_unit->first_select();
+    JOIN *const derived_join= derived_select->join;
+    if (derived_unit->is_union() || derived_join == NULL ||
+        derived_select->select_limit != NULL ||
+        derived_select->offset_limit != NULL ||
+        derived_select->olap != UNSPECIFIED_OLAP_TYPE ||
+        (derived_select->uncacheable &
+         (UNCACHEABLE_SIDEEFFECT | UNCACHEABLE_RAND)))
+      continue;
+
+    List<Item> pushed;
+    if (where_cond != NULL &&
+        collect_derived_conds(thd, where_cond, tl, &pushed))
+      DBUG_RETURN(true);
+
+    if (!pushed.is_empty())
+    {
+      Item *cond= pushed.elements == 1 ? pushed.head() :
+                                         new Item_cond_and(pushed);
+      // Count the new conditions in the query block of the derived table
+      SELECT_LEX *const save_select= thd->lex->current_select();
+      thd->lex->set_current_select(derived_select);
+      const bool error= cond == NULL || cond->fix_fields(thd, &cond);
+      thd->lex->set_current_select(save_select);
+      if (error)
+        DBUG_RETURN(true);
+      derived_join->derived_pushed_cond= cond;
+
+      Opt_trace_object trace_wrapper(trace);
+      Opt_trace_object trace_pushdown(trace, "derived_condition_pushdown");
+      trace_pushdown.add_utf8_table(tl->table).
+        add("pushed_condition", cond);
+    }
+
+    if (push_limit)
+    {
+      derived_join->derived_pushed_limit= unit->select_limit_cnt;
+
+      Opt_trace_object trace_wrapper(trace);
+      Opt_trace_object trace_pushdown(trace, "derived_limit_pushdown");
+      trace_pushdown.add_utf8_table(tl->table).
+        add("pushed_limit", unit->select_limit_cnt);
+    }
+  }
+
+  DBUG_RETURN(false);
+}
+
+
 /**
   A helper function to check whether it's better to use range than ref.
 
@@ -2942,15 +3308,48 @@ static bool setup_join_buffering(JOIN_TAB *tab, JOIN *join,
     rows= tab->table()->file->multi_range_read_info(tab->ref().key, 10, 20,
                                                   &bufsz,
                                                   &join_cache_flags, &cost);
+    if (rows != HA_POS_ERROR &&
+        (join_cache_flags & HA_MRR_USE_DEFAULT_IMPL))
+    {
+      /*
+        The default MRR implementation only pays off for BKA if it can
+        look up the keys of a join buffer in key order. Whether that saves
+        I/O depends on the number of keys in a buffer, so ask again with
+        an estimate of it: the rows of the preceding tables, limited by
+        what fits in the join buffer.
+      */
+      const TABLE_REF &ref= tab->ref();
+      const double prefix_rows=
+        join->best_ref[tableno - 1]->position()->prefix_rowcount;
+      const uint entry_size= ref.key_length +
+        handler::mrr_sort_keys_entry_size(&tab->table()->key_info[ref.key]);
+      const double buffer_keys=
+        static_cast<double>(join->thd->variables.join_buff_size) / entry_size;
+      const double n_keys= max(2.0, min(prefix_rows, buffer_keys));
+      rec_per_key_t rec_per_key=
+        tab->table()->key_info[ref.key].records_per_key(ref.key_parts - 1);
+      set_if_bigger(rec_per_key, 1.0f);
+
+      Cost_estimate sort_keys_cost;
+      bufsz= join->thd->variables.join_buff_size;
+      join_cache_flags= HA_MRR_NO_NULL_ENDPOINTS |
+                        (join_cache_flags & HA_MRR_INDEX_ONLY);
+      rows= tab->table()->file->
+        multi_range_read_info(ref.key, static_cast<uint>(n_keys),
+                              static_cast<uint>(n_keys * rec_per_key),
+                              &bufsz, &join_cache_flags, &sort_keys_cost);
+    }
     /*
       Cannot use BKA/BKA_UNIQUE if
       1. MRR scan cannot be performed, or
-      2. MRR default implementation is used
+      2. MRR default implementation is used, and it does not read the
+         keys in sorted batches
       Cannot use BKA if
       3. HA_MRR_NO_ASSOCIATION flag is set
     */
     if ((rows == HA_POS_ERROR) ||                               // 1
-        (join_cache_flags & HA_MRR_USE_DEFAULT_IMPL) ||    // 2
+        ((join_cache_flags & HA_MRR_USE_DEFAULT_IMPL) &&        // 2
+         !(join_cache_flags & HA_MRR_SORT_KEYS)) ||
         ((join_cache_flags & HA_MRR_NO_ASSOCIATION) &&     // 3
          !use_bka_unique))
       goto no_join_cache;
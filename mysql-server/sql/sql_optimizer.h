@@ -31,6 +31,7 @@
 #include "sql_select.h"
 
 class Cost_model_server;
+class Batch_scan;
 
 
 typedef struct st_sargable_param
@@ -157,6 +158,8 @@ public:
 
 
   Next_select_func first_select;
+  /// Set if first_select is sub_select_batch, @see Batch_scan
+  Batch_scan *batch_scan;
   /**
     The cost of best complete join plan found so far during optimization,
     after optimization phase - cost of picked join order (not taking into
@@ -376,6 +379,20 @@ public:
   */
   Item       *having_cond;
   Item       *having_for_explain;    ///< Saved optimized HAVING for EXPLAIN
+  /**
+    If this query block is the query expression of a materialized derived
+    table: conditions of the outer query block on the derived table,
+    rewritten to the columns of this query block. Set by
+    push_down_to_derived_tables() of the outer query block, and added to
+    where_cond by optimize().
+  */
+  Item       *derived_pushed_cond;
+  /**
+    If this query block is the query expression of a materialized derived
+    table: the number of rows the outer query block reads from the derived
+    table at most, because of its LIMIT, or HA_POS_ERROR.
+  */
+  ha_rows    derived_pushed_limit;
   /**
     Pointer set to select_lex->get_table_list() at the start of
     optimization. May be changed (to NULL) only if opt_sum_query() optimizes
@@ -468,6 +485,8 @@ public:
       crash if they are used before that.
     */
     where_cond= having_cond= having_for_explain= (Item*)1;
+    derived_pushed_cond= NULL;
+    derived_pushed_limit= HA_POS_ERROR;
     tables_list= (TABLE_LIST*)1;
 
     select_options= select_options_arg;
@@ -507,6 +526,7 @@ public:
     /* can help debugging (makes smaller test cases): */
     DBUG_EXECUTE_IF("no_const_tables",no_const_tables= TRUE;);
     first_select= sub_select;
+    batch_scan= NULL;
     set_group_rpa= false;
     group_sent= 0;
     plan_state= NO_PLAN;
@@ -715,6 +735,7 @@ private:
 #ifdef WITH_PARTITION_STORAGE_ENGINE
   bool prune_table_partitions();
 #endif
+  bool push_down_to_derived_tables();
 public:
   /**
     TRUE if the query contains an aggregate function but has no GROUP
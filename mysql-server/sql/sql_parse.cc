@@ -67,6 +67,7 @@
 #include "sql_load.h"         // mysql_load
 #include "sql_servers.h"      // create_servers, alter_servers,
                               // drop_servers, servers_reload
+#include "resource_groups.h"  // resource_group_bind
 #include "sql_handler.h"      // mysql_ha_open, mysql_ha_close,
                               // mysql_ha_read
 #include "sql_binlog.h"       // mysql_client_binlog_statement
@@ -104,6 +105,9 @@
 #include "sql_timer.h"   // thd_timer_set, thd_timer_reset
 #include "sp_rcontext.h"
 #include "parse_location.h"
+#include "sql_plan_cache.h"   // plan_cache_set_digest_key
+#include "sql_query_template.h" // query_template_execute
+#include "my_protocol_options.h" // MYSQL_OPTION_PIPELINE_ON
 
 #include <algorithm>
 using std::max;
@@ -707,6 +711,7 @@ bool do_command(THD *thd)
   ulong packet_length;
   NET *net= &thd->net;
   enum enum_server_command command;
+  size_t held_length;
 
   DBUG_ENTER("do_command");
 
@@ -762,10 +767,31 @@ bool do_command(THD *thd)
     In particular, a new instrumented statement is started.
     See init_net_server_extension()
   */
+
+  /*
+    Responses held back by net_hold_responses() are at the start of the
+    network buffer: read the command after them, without counting them
+    against max_allowed_packet. The buffer may be reallocated by the read.
+  */
+  held_length= net->write_pos - net->buff;
+  if (held_length)
+  {
+    DBUG_ASSERT(!net->compress && net->where_b == 0);
+    net->where_b= held_length;
+    net->max_packet_size+= held_length;
+  }
+
   thd->m_server_idle= true;
   packet_length= my_net_read(net);
   thd->m_server_idle= false;
 
+  if (held_length)
+  {
+    net->where_b= 0;
+    net->max_packet_size-= held_length;
+    net->write_pos= net->buff + held_length;
+  }
+
   if (packet_length == packet_error)
   {
     DBUG_PRINT("info",("Got error %d reading command from socket %s",
@@ -834,6 +860,14 @@ bool do_command(THD *thd)
                                  static_cast<size_t>(packet_length-1));
 
 out:
+  /*
+    Send the held back responses, unless the client has already sent the
+    next command. Not all commands send a response of their own.
+  */
+  if (net->write_pos != net->buff &&
+      (return_value || !net_hold_responses(thd)))
+    (void) net_flush(net);
+
   /* The statement instrumentation must be closed in all cases. */
   DBUG_ASSERT(thd->m_digest == NULL);
   DBUG_ASSERT(thd->m_statement_psi == NULL);
@@ -1054,6 +1088,8 @@ bool dispatch_command(enum enum_server_command command, THD *thd,
                                                com_statement_info[command].m_key);
 
   thd->set_command(command);
+  /* Bind the thread to a resource group changed since the last command */
+  resource_group_bind(thd);
   /*
     Commands which always take a long time are logged into
     the slow log only if opt_log_slow_admin_statements is set.
@@ -1639,6 +1675,24 @@ bool dispatch_command(enum enum_server_command command, THD *thd,
       thd->client_capabilities&= ~CLIENT_MULTI_STATEMENTS;
       my_eof(thd);
       break;
+#ifndef EMBEDDED_LIBRARY
+    case MYSQL_OPTION_PIPELINE_ON:
+      thd->protocol_options|= PROTOCOL_OPTION_PIPELINE;
+      my_eof(thd);
+      break;
+    case MYSQL_OPTION_PIPELINE_OFF:
+      thd->protocol_options&= ~PROTOCOL_OPTION_PIPELINE;
+      my_eof(thd);
+      break;
+    case MYSQL_OPTION_STMT_EXECUTE_BATCH_ON:
+      thd->protocol_options|= PROTOCOL_OPTION_STMT_EXECUTE_BATCH;
+      my_eof(thd);
+      break;
+    case MYSQL_OPTION_STMT_EXECUTE_BATCH_OFF:
+      thd->protocol_options&= ~PROTOCOL_OPTION_STMT_EXECUTE_BATCH;
+      my_eof(thd);
+      break;
+#endif
     default:
       my_message(ER_UNKNOWN_COM_ERROR, ER(ER_UNKNOWN_COM_ERROR), MYF(0));
       break;
@@ -1697,7 +1751,7 @@ done:
 
   thd_manager->dec_thread_running();
   thd->packet.shrink(thd->variables.net_buffer_length);	// Reclaim some memory
-  free_root(thd->mem_root,MYF(MY_KEEP_PREALLOC));
+  thd->free_query_mem_root();
 
   /* DTRACE instrumentation, end */
   if (MYSQL_QUERY_DONE_ENABLED() && command == COM_QUERY)
@@ -4801,6 +4855,10 @@ end_with_restore_list:
   case SQLCOM_CREATE_SERVER:
   case SQLCOM_ALTER_SERVER:
   case SQLCOM_DROP_SERVER:
+  case SQLCOM_CREATE_RESOURCE_GROUP:
+  case SQLCOM_ALTER_RESOURCE_GROUP:
+  case SQLCOM_DROP_RESOURCE_GROUP:
+  case SQLCOM_SET_RESOURCE_GROUP:
   case SQLCOM_SIGNAL:
   case SQLCOM_RESIGNAL:
   case SQLCOM_GET_DIAGNOSTICS:
@@ -5322,14 +5380,20 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
   {
     LEX *lex= thd->lex;
 
-    bool err= parse_sql(thd, parser_state, NULL);
+    // The plan cache identifies text queries by their digest
+    if (plan_cache_size > 0)
+      parser_state->m_input.m_compute_digest= true;
+
+    // Statements executed from a cached template are not parsed
+    const bool from_template= query_template_execute(thd, parser_state);
+    bool err= !from_template && parse_sql(thd, parser_state, NULL);
 
     const char *found_semicolon= parser_state->m_lip.found_semicolon;
     size_t      qlen= found_semicolon
                       ? (found_semicolon - thd->query().str)
                       : thd->query().length;
 
-    if (!err)
+    if (!err && !from_template)
     {
       /*
         See whether we can do any query rewriting. opt_general_log_raw only controls
@@ -5374,8 +5438,10 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
                                 command_name[COM_QUERY].length);
     }
 
-    if (!err)
+    if (!err && !from_template)
     {
+      plan_cache_set_digest_key(thd);
+
       thd->m_statement_psi= MYSQL_REFINE_STATEMENT(thd->m_statement_psi,
                                                    sql_statement_info[thd->lex->sql_command].m_key);
 
@@ -5473,7 +5539,7 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
 	}
       }
     }
-    else
+    else if (err)
     {
       /* Instrument this broken statement as "statement/sql/error" */
       thd->m_statement_psi= MYSQL_REFINE_STATEMENT(thd->m_statement_psi,
@@ -6319,7 +6385,7 @@ uint kill_one_thread(THD *thd, my_thread_id id, bool only_kill_query)
 
   DBUG_ENTER("kill_one_thread");
   DBUG_PRINT("enter", ("id=%u only_kill=%d", id, only_kill_query));
-  tmp= Global_THD_manager::get_instance()->find_thd(&find_thd_with_id);
+  tmp= Global_THD_manager::get_instance()->find_thd(id, &find_thd_with_id);
   if (tmp)
   {
     /*
@@ -6980,6 +7046,42 @@ bool check_host_name(const LEX_CSTRING &str)
 extern int MYSQLparse(class THD *thd); // from sql_yacc.cc
 
 
+/**
+  Set the lexer of a parser state up to compute the digest of the
+  statement, if the caller or the performance schema wants it.
+
+  @param thd           Thread context.
+  @param parser_state  Parser state of the statement.
+*/
+
+void start_statement_digest(THD *thd, Parser_state *parser_state)
+{
+  parser_state->m_digest_psi= NULL;
+  parser_state->m_lip.m_digest= NULL;
+
+  if (thd->m_digest != NULL)
+  {
+    thd->m_digest->reset();
+
+    /* Start Digest */
+    parser_state->m_digest_psi= MYSQL_DIGEST_START(thd->m_statement_psi);
+
+    if (parser_state->m_input.m_compute_digest ||
+       (parser_state->m_digest_psi != NULL))
+    {
+      /*
+        If either:
+        - the caller wants to compute a digest
+        - the performance schema wants to compute a digest
+        set the digest listener in the lexer.
+      */
+      parser_state->m_lip.m_digest= thd->m_digest;
+      parser_state->m_lip.m_digest->m_digest_storage.m_charset_number= thd->charset()->number;
+    }
+  }
+}
+
+
 /**
   This is a wrapper of MYSQLparse(). All the code should call parse_sql()
   instead of MYSQLparse().
@@ -7044,29 +7146,7 @@ bool parse_sql(THD *thd,
 
   thd->m_parser_state= parser_state;
 
-  parser_state->m_digest_psi= NULL;
-  parser_state->m_lip.m_digest= NULL;
-
-  if (thd->m_digest != NULL)
-  {
-    thd->m_digest->reset();
-
-    /* Start Digest */
-    parser_state->m_digest_psi= MYSQL_DIGEST_START(thd->m_statement_psi);
-
-    if (parser_state->m_input.m_compute_digest ||
-       (parser_state->m_digest_psi != NULL))
-    {
-      /*
-        If either:
-        - the caller wants to compute a digest
-        - the performance schema wants to compute a digest
-        set the digest listener in the lexer.
-      */
-      parser_state->m_lip.m_digest= thd->m_digest;
-      parser_state->m_lip.m_digest->m_digest_storage.m_charset_number= thd->charset()->number;
-    }
-  }
+  start_statement_digest(thd, parser_state);
 
   /* Parse the query. */
 
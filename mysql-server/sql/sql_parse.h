@@ -45,6 +45,7 @@ bool mysql_insert_select_prepare(THD *thd);
 bool parse_sql(THD *thd,
                Parser_state *parser_state,
                Object_creation_ctx *creation_ctx);
+void start_statement_digest(THD *thd, Parser_state *parser_state);
 
 uint kill_one_thread(THD *thd, ulong id, bool only_kill_query);
 
@@ -0,0 +1,158 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "sql_plan_cache.h"
+#include "sql_class.h"                          // THD
+#include "sql_lex.h"                            // LEX, SELECT_LEX
+#include "sql_digest.h"                         // compute_digest_md5
+#include "mysqld.h"                             // key_memory_plan_cache
+
+ulong plan_cache_size= 0;
+
+/// A cached join order of a query block
+class Plan_cache_entry : public hash_filo_element
+{
+public:
+  uchar key[PLAN_CACHE_KEY_SIZE];
+  table_map const_tables;
+  uint count;
+  Plan_cache_table tables[MAX_TABLES];
+};
+
+static hash_filo *plan_cache;
+
+
+bool plan_cache_init(uint size)
+{
+  Plan_cache_entry tmp;
+  uint key_offset= (uint) ((char*) (&tmp.key) - (char*) &tmp);
+
+  if (!(plan_cache= new hash_filo(size,
+                                  key_offset, PLAN_CACHE_KEY_SIZE,
+                                  NULL, (my_hash_free_key) my_free,
+                                  &my_charset_bin)))
+    return true;
+
+  plan_cache->clear();
+
+  return false;
+}
+
+
+void plan_cache_free()
+{
+  delete plan_cache;
+  plan_cache= NULL;
+}
+
+
+void plan_cache_resize(uint size)
+{
+  plan_cache->resize(size);
+}
+
+
+void plan_cache_set_digest_key(THD *thd)
+{
+  LEX *lex= thd->lex;
+  lex->has_plan_cache_key= false;
+  if (plan_cache_size == 0 || thd->m_digest == NULL)
+    return;
+
+  const sql_digest_storage *digest= &thd->m_digest->m_digest_storage;
+  // A truncated digest may be shared by different statements
+  if (digest->m_full || digest->m_byte_count == 0)
+    return;
+  compute_digest_md5(digest, lex->plan_cache_key);
+  lex->has_plan_cache_key= true;
+}
+
+
+void plan_cache_set_text_key(THD *thd, const char *text, size_t length)
+{
+  LEX *lex= thd->lex;
+  lex->has_plan_cache_key= false;
+  if (plan_cache_size == 0)
+    return;
+
+  compute_md5_hash((char *) lex->plan_cache_key, text, length);
+  lex->has_plan_cache_key= true;
+}
+
+
+bool plan_cache_make_key(THD *thd, const SELECT_LEX *select_lex, uchar *key)
+{
+  const LEX *lex= thd->lex;
+  if (plan_cache_size == 0 || !lex->has_plan_cache_key)
+    return false;
+
+  memset(key, 0, PLAN_CACHE_KEY_SIZE);
+  memcpy(key, lex->plan_cache_key, MD5_HASH_SIZE);
+  int4store(key + MD5_HASH_SIZE, select_lex->select_number);
+  if (thd->db().str != NULL)
+    memcpy(key + MD5_HASH_SIZE + 4, thd->db().str,
+           MY_MIN(thd->db().length, NAME_LEN));
+  return true;
+}
+
+
+bool plan_cache_get(const uchar *key, table_map *const_tables, uint count,
+                    Plan_cache_table *tables)
+{
+  bool found= false;
+  mysql_mutex_lock(&plan_cache->lock);
+  Plan_cache_entry *entry=
+    (Plan_cache_entry*) plan_cache->search(const_cast<uchar*>(key),
+                                           PLAN_CACHE_KEY_SIZE);
+  if (entry != NULL && entry->count == count)
+  {
+    *const_tables= entry->const_tables;
+    memcpy(tables, entry->tables, count * sizeof(Plan_cache_table));
+    found= true;
+  }
+  mysql_mutex_unlock(&plan_cache->lock);
+  return found;
+}
+
+
+void plan_cache_put(const uchar *key, table_map const_tables, uint count,
+                    const Plan_cache_table *tables)
+{
+  DBUG_ASSERT(count <= MAX_TABLES);
+  mysql_mutex_lock(&plan_cache->lock);
+  Plan_cache_entry *entry=
+    (Plan_cache_entry*) plan_cache->search(const_cast<uchar*>(key),
+                                           PLAN_CACHE_KEY_SIZE);
+  if (entry == NULL && plan_cache->size() > 0)
+  {
+    entry= (Plan_cache_entry*) my_malloc(key_memory_plan_cache,
+                                         sizeof(Plan_cache_entry),
+                                         MYF(0));
+    if (entry != NULL)
+    {
+      memcpy(entry->key, key, PLAN_CACHE_KEY_SIZE);
+      // add() frees the entry if the insert fails
+      if (plan_cache->add(entry))
+        entry= NULL;
+    }
+  }
+  if (entry != NULL)
+  {
+    entry->const_tables= const_tables;
+    entry->count= count;
+    memcpy(entry->tables, tables, count * sizeof(Plan_cache_table));
+  }
+  mysql_mutex_unlock(&plan_cache->lock);
+}
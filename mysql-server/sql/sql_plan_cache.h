@@ -0,0 +1,107 @@
+#ifndef SQL_PLAN_CACHE_INCLUDED
+#define SQL_PLAN_CACHE_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Server wide cache of join orders.
+
+  The greedy search of the join optimizer is the most expensive part of
+  optimizing a join of many tables, and it is repeated every time a
+  statement is executed. The plan cache keeps the join order chosen for
+  each query block of a statement, so that later executions of the same
+  statement, in any session, only have to compute the access paths for
+  that order, like for a STRAIGHT_JOIN.
+
+  A statement is identified by the MD5 hash of its normalized digest for
+  text queries, and of its text for prepared statements, together with
+  the current database. A cached order is used only if the query block
+  has the same tables as when it was cached, each table has the same
+  TABLE_SHARE version, that is, it has not been altered, analyzed or
+  flushed since, the same tables are const tables, and the order is
+  valid for the outer join dependencies of the query block; otherwise the
+  greedy search is done and its result replaces the cached order.
+
+  The cache holds at most @@plan_cache_size query blocks, and the least
+  recently used one is replaced when it is full. It is disabled when
+  @@plan_cache_size is 0.
+*/
+
+#include "my_global.h"
+#include "hash_filo.h"                          // hash_filo_element
+#include "my_md5.h"                             // MD5_HASH_SIZE
+#include "mysql_com.h"                          // NAME_LEN
+
+class THD;
+typedef class st_select_lex SELECT_LEX;
+
+/// Size of the key of a query block: statement hash, select number, db
+#define PLAN_CACHE_KEY_SIZE (MD5_HASH_SIZE + 4 + NAME_LEN + 1)
+
+/// A table of a cached join order
+struct Plan_cache_table
+{
+  /// TABLE_LIST::tableno() of the table in its query block
+  uint tableno;
+  /// TABLE_SHARE::get_table_ref_version() when the order was cached
+  ulonglong version;
+};
+
+extern ulong plan_cache_size;
+
+bool plan_cache_init(uint size);
+void plan_cache_free();
+void plan_cache_resize(uint size);
+
+/**
+  Identify the current statement in the plan cache by the digest the
+  parser has computed for it. Nothing is cached for the statement if
+  there is no complete digest.
+*/
+void plan_cache_set_digest_key(THD *thd);
+
+/// Identify a prepared statement in the plan cache by its text
+void plan_cache_set_text_key(THD *thd, const char *text, size_t length);
+
+/**
+  Compute the key of a query block of the current statement.
+
+  @returns false if the statement can not use the plan cache
+*/
+bool plan_cache_make_key(THD *thd, const SELECT_LEX *select_lex,
+                         uchar *key);
+
+/**
+  Look up the join order of a query block.
+
+  @param       key           key from plan_cache_make_key()
+  @param[out]  const_tables  table map of the const tables
+  @param       count         number of tables in the order
+  @param[out]  tables        the tables, in join order
+
+  @returns false if no order of 'count' tables is cached for the key
+*/
+bool plan_cache_get(const uchar *key, table_map *const_tables, uint count,
+                    Plan_cache_table *tables);
+
+/// Store or replace the join order of a query block
+void plan_cache_put(const uchar *key, table_map const_tables, uint count,
+                    const Plan_cache_table *tables);
+
+#endif /* SQL_PLAN_CACHE_INCLUDED */
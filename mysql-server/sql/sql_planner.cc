@@ -31,6 +31,7 @@
 #include "opt_trace.h"
 #include "sql_executor.h"
 #include "merge_sort.h"
+#include "sql_plan_cache.h"
 #include <my_bit.h>
 
 #include <algorithm>
@@ -1371,13 +1372,24 @@ float calculate_condition_filter(const JOIN_TAB *const tab,
     /*
       Get filtering effect for predicates that are not already
       reflected in 'filter'. The below call gets this filtering effect
-      based on index statistics and guesstimates.
+      based on histograms, index statistics and guesstimates.
     */
-    filter*=
-           tab->join()->where_cond->get_filtering_effect(tab->table_ref->map(),
-                                                         used_tables,
-                                                         &table->tmp_set,
-                                                         tab->records());
+    Item *const where_cond= tab->join()->where_cond;
+    if (table->s->histograms != NULL)
+    {
+      // The predicates that use a histogram are traced in this array
+      Opt_trace_array trace_histograms(&tab->join()->thd->opt_trace,
+                                       "histogram_filtering");
+      filter*= where_cond->get_filtering_effect(tab->table_ref->map(),
+                                                used_tables,
+                                                &table->tmp_set,
+                                                tab->records());
+    }
+    else
+      filter*= where_cond->get_filtering_effect(tab->table_ref->map(),
+                                                used_tables,
+                                                &table->tmp_set,
+                                                tab->records());
   }
 
   /*
@@ -1858,12 +1870,37 @@ bool Optimize_table_order::choose_table_order()
                            Item::enum_walk(Item::WALK_POSTFIX), NULL);
   }
 
+  /*
+    The plan cache is used for complete plans of more than one table.
+    optimize_straight_join() does not handle semi-join nests.
+  */
+  uchar plan_key[PLAN_CACHE_KEY_SIZE];
+  const bool use_plan_cache=
+    !straight_join && !emb_sjm_nest && !has_sj &&
+    join->tables - join->const_tables > 1 &&
+    plan_cache_make_key(thd, join->select_lex, plan_key);
+
   if (straight_join)
     optimize_straight_join(join_tables);
+  else if (use_plan_cache && use_cached_order(plan_key, join_tables))
+  {
+    thd->status_var.plan_cache_hits++;
+    optimize_straight_join(join_tables);
+  }
   else
   {
-    if (greedy_search(join_tables))
+    /*
+      Use the dynamic programming search for joins of a moderate number
+      of tables, and fall back to the greedy search if it fails.
+    */
+    if ((!use_dp_search() || dp_search(join_tables)) &&
+        greedy_search(join_tables))
       DBUG_RETURN(true);
+    if (use_plan_cache)
+    {
+      thd->status_var.plan_cache_misses++;
+      cache_order(plan_key);
+    }
   }
 
   // Remaining part of this function not needed when processing semi-join nests.
@@ -1878,6 +1915,91 @@ bool Optimize_table_order::choose_table_order()
 }
 
 
+/**
+  Arrange join->best_ref in the join order that the plan cache holds for
+  the query block, if it is still valid.
+
+  The order is used only if the query block has the same non-const
+  tables, each with the same TABLE_SHARE version as when the order was
+  cached, and the same const tables, and if every table comes after the
+  tables it depends on and does not interleave with outer join nests.
+  Any such order gives correct results; the checks on tables and
+  versions make it likely that it is still a good one.
+
+  @param key          key of the query block in the plan cache
+  @param join_tables  the tables involved in order selection
+
+  @return true if join->best_ref has been arranged in the cached order
+*/
+
+bool Optimize_table_order::use_cached_order(const uchar *key,
+                                            table_map join_tables)
+{
+  const uint count= join->tables - join->const_tables;
+  table_map const_tables;
+  Plan_cache_table cached[MAX_TABLES];
+  if (!plan_cache_get(key, &const_tables, count, cached) ||
+      const_tables != join->const_table_map)
+    return false;
+
+  JOIN_TAB *order[MAX_TABLES];
+  table_map remaining_tables= join_tables;
+  bool valid= true;
+  for (uint i= 0; i < count && valid; i++)
+  {
+    JOIN_TAB *tab= NULL;
+    for (uint j= join->const_tables; j < join->tables; j++)
+    {
+      if (join->best_ref[j]->table_ref->tableno() == cached[i].tableno)
+      {
+        tab= join->best_ref[j];
+        break;
+      }
+    }
+    valid= tab != NULL &&
+           (remaining_tables & tab->table_ref->map()) &&
+           tab->table()->s->get_table_ref_version() == cached[i].version &&
+           !(remaining_tables & tab->dependent) &&
+           !check_interleaving_with_nj(tab);
+    if (valid)
+    {
+      order[i]= tab;
+      remaining_tables&= ~tab->table_ref->map();
+    }
+  }
+
+  // Undo the nested join state of check_interleaving_with_nj()
+  join->select_lex->reset_nj_counters();
+  cur_embedding_map= 0;
+
+  if (!valid)
+    return false;
+  memcpy(join->best_ref + join->const_tables, order,
+         count * sizeof(JOIN_TAB*));
+  return true;
+}
+
+
+/**
+  Store the join order chosen by greedy_search() in the plan cache.
+
+  @param key  key of the query block in the plan cache
+*/
+
+void Optimize_table_order::cache_order(const uchar *key)
+{
+  const uint count= join->tables - join->const_tables;
+  Plan_cache_table tables[MAX_TABLES];
+  for (uint i= 0; i < count; i++)
+  {
+    const JOIN_TAB *tab= join->best_positions[join->const_tables + i].table;
+    tables[i].tableno= tab->table_ref->tableno();
+    tables[i].version= tab->table()->s->get_table_ref_version();
+  }
+  plan_cache_put(key, join->const_table_map, count, tables);
+}
+
+
 /**
   Heuristic procedure to automatically guess a reasonable degree of
   exhaustiveness for the greedy search procedure.
@@ -2262,6 +2384,272 @@ bool Optimize_table_order::greedy_search(table_map remaining_tables)
 }
 
 
+/**
+  Whether the join order should be chosen by dp_search() rather than by
+  greedy_search().
+
+  The dynamic programming search extends partial plans independently of
+  the order of their tables, so it is only used when the validity and
+  cost of a plan do not depend on state that follows the table order:
+  there must be no semi-join nests, and no join nests, whose
+  interleaving is checked by check_interleaving_with_nj(). Outer joins of
+  single tables are handled through the table dependencies.
+*/
+
+bool Optimize_table_order::use_dp_search() const
+{
+  const uint count= join->tables - join->const_tables;
+  if (count < 2 || count > thd->variables.optimizer_dp_join_limit ||
+      emb_sjm_nest || has_sj)
+    return false;
+
+  for (uint i= join->const_tables; i < join->tables; i++)
+  {
+    if (join->best_ref[i]->table_ref->embedding != NULL)
+      return false;
+  }
+  return true;
+}
+
+
+/// A partial join order of dp_search()
+struct Dp_plan
+{
+  /// The tables of the plan
+  table_map tables;
+  /// Cost of the plan
+  double cost;
+  /// Number of rows produced by the plan
+  double rowcount;
+  /// The last table of the plan
+  JOIN_TAB *last;
+  /// Index of the plan without 'last' among the plans one table smaller
+  uint prefix;
+};
+
+
+/// Order plans by their tables, and plans of the same tables by cost
+static bool dp_plan_tables_less(const Dp_plan &a, const Dp_plan &b)
+{
+  if (a.tables != b.tables)
+    return a.tables < b.tables;
+  return a.cost < b.cost;
+}
+
+
+static bool dp_plan_cost_less(const Dp_plan &a, const Dp_plan &b)
+{
+  return a.cost < b.cost;
+}
+
+
+/**
+  Find the join order with dynamic programming over left-deep plans.
+
+  The plans of k+1 tables are built by extending each plan of k tables
+  with each table that may follow it, and only the cheapest plan of each
+  set of tables is kept. A plan is only extended with tables connected
+  to it by a join condition, unless there are none, so that cross
+  products are not considered when they are not needed. When there are
+  more than @@optimizer_dp_max_plans plans of a size, only the cheapest
+  ones are extended, which bounds the search to
+
+    number of tables ^ 2 * @@optimizer_dp_max_plans
+
+  calls of best_access_path().
+
+  The tables of the cheapest complete plan are arranged in
+  join->best_ref, and the plan is then finalized by
+  optimize_straight_join().
+
+  @param join_tables  the tables involved in order selection
+
+  @return false if successful, true if error
+*/
+
+bool Optimize_table_order::dp_search(table_map join_tables)
+{
+  DBUG_ENTER("Optimize_table_order::dp_search");
+  const uint first= join->const_tables;
+  const uint count= join->tables - first;
+  JOIN_TAB **const tabs= join->best_ref + first;
+  const Cost_model_server *const cost_model= join->cost_model();
+  const size_t max_plans= thd->variables.optimizer_dp_max_plans;
+  Opt_trace_context *const trace= &thd->opt_trace;
+
+  /*
+    Tables are connected if a condition of the WHERE clause, a key
+    lookup or an outer join dependency refers to both.
+  */
+  table_map connected[MAX_TABLES];
+  for (uint i= 0; i < count; i++)
+  {
+    const JOIN_TAB *const tab= tabs[i];
+    connected[i]= tab->dependent & join_tables;
+    for (const Key_use *keyuse= tab->keyuse();
+         keyuse && keyuse->table_ref == tab->table_ref; keyuse++)
+      connected[i]|= keyuse->used_tables & join_tables;
+  }
+  if (join->where_cond)
+  {
+    Item *cond= join->where_cond;
+    List<Item> single;
+    List<Item> *conds= &single;
+    if (cond->type() == Item::COND_ITEM &&
+        down_cast<Item_cond*>(cond)->functype() == Item_func::COND_AND_FUNC)
+      conds= down_cast<Item_cond*>(cond)->argument_list();
+    else if (single.push_back(cond))
+      DBUG_RETURN(true);
+    List_iterator<Item> it(*conds);
+    Item *item;
+    while ((item= it++))
+    {
+      const table_map map= item->used_tables() & join_tables;
+      if (my_count_bits(map) < 2)
+        continue;
+      for (uint i= 0; i < count; i++)
+      {
+        if (map & tabs[i]->table_ref->map())
+          connected[i]|= map;
+      }
+    }
+  }
+  for (uint i= 0; i < count; i++)
+  {
+    for (uint j= 0; j < count; j++)
+    {
+      if (connected[j] & tabs[i]->table_ref->map())
+        connected[i]|= tabs[j]->table_ref->map();
+    }
+    connected[i]&= ~tabs[i]->table_ref->map();
+  }
+
+  // levels[k] holds the plans of k+1 tables
+  typedef Mem_root_array<Dp_plan, true> Dp_plans;
+  Dp_plans **const levels=
+    static_cast<Dp_plans**>(thd->alloc(count * sizeof(Dp_plans*)));
+  Dp_plans candidates(thd->mem_root);
+  if (levels == NULL)
+    DBUG_RETURN(true);
+  ha_rows pruned_plans= 0;
+
+  for (uint level= 0; level < count; level++)
+  {
+    const uint idx= first + level;
+    const Dp_plans *const prefixes= level > 0 ? levels[level - 1] : NULL;
+    const size_t num_prefixes= level > 0 ? prefixes->size() : 1;
+    candidates.clear();
+
+    for (size_t p= 0; p < num_prefixes; p++)
+    {
+      const Dp_plan *const prefix= prefixes ? &prefixes->at(p) : NULL;
+      const table_map prefix_tables= prefix ? prefix->tables : 0;
+      const table_map remaining_tables= join_tables & ~prefix_tables;
+
+      /*
+        Set up join->positions for the prefix as best_access_path() and
+        set_prefix_join_cost() expect it.
+      */
+      if (prefix)
+      {
+        const Dp_plan *plan= prefix;
+        for (uint l= level; l-- > 0; )
+        {
+          join->positions[first + l].table= plan->last;
+          if (l > 0)
+            plan= &levels[l - 1]->at(plan->prefix);
+        }
+        join->positions[idx - 1].prefix_rowcount= prefix->rowcount;
+        join->positions[idx - 1].prefix_cost= prefix->cost;
+      }
+
+      // Only extend with connected tables, unless there are none
+      bool only_connected= false;
+      for (uint i= 0; i < count && prefix; i++)
+      {
+        const JOIN_TAB *const tab= tabs[i];
+        if ((remaining_tables & tab->table_ref->map()) &&
+            !(tab->dependent & remaining_tables) &&
+            (connected[i] & prefix_tables))
+        {
+          only_connected= true;
+          break;
+        }
+      }
+
+      for (uint i= 0; i < count; i++)
+      {
+        JOIN_TAB *const tab= tabs[i];
+        if (!(remaining_tables & tab->table_ref->map()) ||
+            (tab->dependent & remaining_tables) ||
+            (only_connected && !(connected[i] & prefix_tables)))
+          continue;
+
+        Opt_trace_object trace_one_table(trace);
+        if (unlikely(trace->is_started()))
+        {
+          trace_plan_prefix(join, idx, excluded_tables);
+          trace_one_table.add_utf8_table(tab->table());
+        }
+        POSITION *const position= join->positions + idx;
+        best_access_path(tab, remaining_tables, idx, false,
+                         prefix ? prefix->rowcount : 1.0, position);
+        position->set_prefix_join_cost(idx, cost_model);
+        trace_one_table.
+          add("condition_filtering_pct", position->filter_effect * 100).
+          add("rows_for_plan", position->prefix_rowcount).
+          add("cost_for_plan", position->prefix_cost);
+
+        Dp_plan plan;
+        plan.tables= prefix_tables | tab->table_ref->map();
+        plan.cost= position->prefix_cost;
+        plan.rowcount= position->prefix_rowcount;
+        plan.last= tab;
+        plan.prefix= static_cast<uint>(p);
+        if (candidates.push_back(plan))
+          DBUG_RETURN(true);
+      }
+    }
+    if (candidates.empty())
+      DBUG_RETURN(true);
+
+    // Keep the cheapest plan of each set of tables
+    std::sort(candidates.begin(), candidates.end(), dp_plan_tables_less);
+    Dp_plans *const plans= new (thd->mem_root) Dp_plans(thd->mem_root);
+    if (plans == NULL || plans->reserve(candidates.size()))
+      DBUG_RETURN(true);
+    for (size_t c= 0; c < candidates.size(); c++)
+    {
+      if (c == 0 || candidates[c].tables != candidates[c - 1].tables)
+        plans->push_back(candidates[c]);
+    }
+    if (plans->size() > max_plans)
+    {
+      std::sort(plans->begin(), plans->end(), dp_plan_cost_less);
+      pruned_plans+= plans->size() - max_plans;
+      plans->chop(max_plans);
+    }
+    levels[level]= plans;
+  }
+
+  // Arrange best_ref in the order of the cheapest complete plan
+  const Dp_plans *const complete= levels[count - 1];
+  const Dp_plan *best=
+    std::min_element(complete->begin(), complete->end(), dp_plan_cost_less);
+  for (uint l= count; l-- > 0; )
+  {
+    tabs[l]= best->last;
+    if (l > 0)
+      best= &levels[l - 1]->at(best->prefix);
+  }
+
+  Opt_trace_object(trace).add("dp_search_pruned_plans", pruned_plans);
+
+  optimize_straight_join(join_tables);
+  DBUG_RETURN(false);
+}
+
+
 /**
   Calculate a cost of given partial join order
  
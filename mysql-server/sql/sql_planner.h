@@ -38,7 +38,8 @@ class Opt_trace_object;
   optimal plan based on the inputs and the environment, such as prune level
   and greedy optimizer search depth. For more information, see the
   function headers for the private functions greedy_search(),
-  best_extension_by_limited_search() and eq_ref_extension_by_limited_search().
+  best_extension_by_limited_search(), eq_ref_extension_by_limited_search()
+  and dp_search().
 */
 
 class Optimize_table_order
@@ -135,7 +136,11 @@ private:
   void backout_nj_state(const table_map remaining_tables,
                         const JOIN_TAB *tab);
   void optimize_straight_join(table_map join_tables);
+  bool use_cached_order(const uchar *key, table_map join_tables);
+  void cache_order(const uchar *key);
   bool greedy_search(table_map remaining_tables);
+  bool use_dp_search() const;
+  bool dp_search(table_map join_tables);
   bool best_extension_by_limited_search(table_map remaining_tables,
                                         uint idx,
                                         uint current_search_depth);
@@ -105,6 +105,7 @@ When one supplies long data for a placeholder:
 #include "sql_view.h"           // create_view_precheck
 #include "transaction.h"        // trans_rollback_implicit
 #include "mysql/psi/mysql_ps.h" // MYSQL_EXECUTE_PS
+#include "sql_plan_cache.h"     // plan_cache_set_text_key
 
 #ifdef EMBEDDED_LIBRARY
 /* include MYSQL_BIND headers */
@@ -224,8 +225,12 @@ static inline void rewrite_query_if_needed(THD *thd)
   Side-effect: query may be written to general log if it's open.
 
   @param thd                thread handle
+  @param command            COM_STMT_EXECUTE, or COM_QUERY for a statement
+                            executed from its query template
 */
-static inline void log_execute_line(THD *thd)
+static inline void log_execute_line(THD *thd,
+                                    enum_server_command command=
+                                      COM_STMT_EXECUTE)
 {
   /*
     Do not print anything if this is an SQL prepared statement and
@@ -236,12 +241,16 @@ static inline void log_execute_line(THD *thd)
   if (thd->sp_runtime_ctx != NULL)
     return;
 
+  /* With --log-raw, dispatch_command() has logged the query already */
+  if (command == COM_QUERY && opt_general_log_raw)
+    return;
+
   if (thd->rewritten_query.length())
-    query_logger.general_log_write(thd, COM_STMT_EXECUTE,
+    query_logger.general_log_write(thd, command,
                                    thd->rewritten_query.c_ptr_safe(),
                                    thd->rewritten_query.length());
   else
-    query_logger.general_log_write(thd, COM_STMT_EXECUTE,
+    query_logger.general_log_write(thd, command,
                                    thd->query().str, thd->query().length);
 }
 
@@ -678,8 +687,8 @@ static void set_param_str(Item_param *param, uchar **pos, ulong len)
 
 #undef get_param_length
 
-static void setup_one_conversion_function(THD *thd, Item_param *param,
-                                          uchar param_type)
+void setup_one_conversion_function(THD *thd, Item_param *param,
+                                   uchar param_type)
 {
   switch (param_type) {
   case MYSQL_TYPE_TINY:
@@ -805,7 +814,8 @@ PSI_prepared_stmt* Prepared_statement::get_PS_prepared_stmt()
   Routines to assign parameters from data supplied by the client.
 
     Update the parameter markers by reading data from the packet and
-    and generate a valid query for logging.
+    and generate a valid query for logging. On success, the read
+    position is moved past the data of the parameters.
 
   @note
     with_log is set when one of slow or general logs are open.
@@ -840,11 +850,12 @@ PSI_prepared_stmt* Prepared_statement::get_PS_prepared_stmt()
 */
 
 bool Prepared_statement::insert_params(uchar *null_array,
-                                       uchar *read_pos, uchar *data_end,
+                                       uchar **read_pos_arg, uchar *data_end,
                                        String *query)
 {
   Item_param **begin= param_array;
   Item_param **end= begin + param_count;
+  uchar *read_pos= *read_pos_arg;
   size_t length= 0;
   String str;
   const String *res;
@@ -904,6 +915,7 @@ bool Prepared_statement::insert_params(uchar *null_array,
         DBUG_RETURN(1);                           /* out of memory */
     }
   }
+  *read_pos_arg= read_pos;
   DBUG_RETURN(0);
 }
 
@@ -2598,7 +2610,15 @@ void mysqld_stmt_execute(THD *thd, char *packet_arg, size_t packet_length)
 
   MYSQL_EXECUTE_PS(thd->m_statement_psi, stmt->m_prepared_stmt);
 
-  stmt->execute_loop(&expanded_query, open_cursor, packet, packet_end);
+#ifndef EMBEDDED_LIBRARY
+  /* Older clients always send an iteration count of 1 */
+  const ulong iterations= uint4korr(packet_arg + 5);
+  if (iterations > 1 &&
+      (thd->protocol_options & PROTOCOL_OPTION_STMT_EXECUTE_BATCH))
+    stmt->execute_batch(&expanded_query, iterations, packet, packet_end);
+  else
+#endif
+    stmt->execute_loop(&expanded_query, open_cursor, packet, packet_end);
   thd->protocol= save_protocol;
 
   sp_cache_enforce_limit(thd->sp_proc_cache, stored_program_cache_size);
@@ -3274,9 +3294,11 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
   /*
     If this is an SQLCOM_PREPARE, we also increase Com_prepare_sql.
     However, it seems handy if com_stmt_prepare is increased always,
-    no matter what kind of prepare is processed.
+    no matter what kind of prepare is processed. Query templates are
+    prepared on behalf of text queries, and are not counted.
   */
-  thd->status_var.com_stmt_prepare++;
+  if (!is_query_template())
+    thd->status_var.com_stmt_prepare++;
 
   if (! (lex= new (mem_root) st_lex_local))
     DBUG_RETURN(TRUE);
@@ -3327,6 +3349,10 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
 
   lex->set_trg_event_type_for_tables();
 
+  // The plan cache identifies prepared statements by their text
+  if (!error)
+    plan_cache_set_text_key(thd, thd->query().str, thd->query().length);
+
   /*
     Pre-clear the diagnostics area unless a warning was thrown
     during parsing.
@@ -3365,6 +3391,10 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
   if (error == 0)
     error= check_prepared_statement(this);
 
+  /* The tables of a query template are still open to check its shape */
+  if (error == 0 && is_query_template() && query_template_has_shape(lex))
+    flags|= (uint) HAS_TEMPLATE_SHAPE;
+
   /*
     Currently CREATE PROCEDURE/TRIGGER/EVENT are prohibited in prepared
     statements: ensure we have no memory leak here if by someone tries
@@ -3435,9 +3465,10 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
       Do not print anything if this is an SQL prepared statement and
       we're inside a stored procedure (also called Dynamic SQL) --
       sub-statements inside stored procedures are not logged into
-      the general log.
+      the general log. Query templates are not logged either, their
+      statements are.
     */
-    if (thd->sp_runtime_ctx == NULL)
+    if (thd->sp_runtime_ctx == NULL && !is_query_template())
     {
       if (thd->rewritten_query.length())
         query_logger.general_log_write(thd, COM_STMT_PREPARE,
@@ -3461,8 +3492,9 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
                          '?' placeholders will be replaced with
                          their values in case of success.
                          The result is used for logging and replication
-  @param packet          pointer to execute packet.
-                         NULL in case of SQL PS
+  @param[in,out] packet  position of the parameters in the execute
+                         packet, moved past them. Points to NULL in case
+                         of SQL PS
   @param packet_end      end of the packet. NULL in case of SQL PS
 
   @todo Use a paremeter source class family instead of 'if's, and
@@ -3475,9 +3507,9 @@ bool Prepared_statement::prepare(const char *packet, size_t packet_len)
 
 bool
 Prepared_statement::set_parameters(String *expanded_query,
-                                   uchar *packet, uchar *packet_end)
+                                   uchar **packet, uchar *packet_end)
 {
-  bool is_sql_ps= packet == NULL;
+  bool is_sql_ps= *packet == NULL;
   bool res= FALSE;
 
   if (is_sql_ps)
@@ -3489,8 +3521,8 @@ Prepared_statement::set_parameters(String *expanded_query,
   else if (param_count)
   {
 #ifndef EMBEDDED_LIBRARY
-    uchar *null_array= packet;
-    res= (setup_conversion_functions(this, &packet, packet_end) ||
+    uchar *null_array= *packet;
+    res= (setup_conversion_functions(this, packet, packet_end) ||
           insert_params(null_array, packet, packet_end, expanded_query));
 #else
     /*
@@ -3540,11 +3572,6 @@ Prepared_statement::execute_loop(String *expanded_query,
                                  uchar *packet,
                                  uchar *packet_end)
 {
-  const int MAX_REPREPARE_ATTEMPTS= 3;
-  Reprepare_observer reprepare_observer;
-  bool error;
-  int reprepare_attempt= 0;
-
   /* Check if we got an error when sending long data */
   if (state == Query_arena::STMT_ERROR)
   {
@@ -3554,9 +3581,102 @@ Prepared_statement::execute_loop(String *expanded_query,
 
   DBUG_ASSERT(!thd->get_stmt_da()->is_set());
 
-  if (set_parameters(expanded_query, packet, packet_end))
+  if (set_parameters(expanded_query, &packet, packet_end))
     return TRUE;
 
+  return execute_with_reprepare(expanded_query, open_cursor);
+}
+
+
+#ifndef EMBEDDED_LIBRARY
+/**
+  Execute a prepared statement once for each of several sets of
+  parameters from a COM_STMT_EXECUTE packet, see
+  PROTOCOL_OPTION_STMT_EXECUTE_BATCH. Each execution is a statement of
+  its own, as if the client had sent a COM_STMT_EXECUTE for every set,
+  but only one OK packet is sent, with the sum of the affected rows and
+  the first generated id.
+
+  Only statements that modify rows and do not return a result set can be
+  executed in a batch, and their parameters must not use long data.
+
+  The parameter sets follow each other in the packet, each in the format
+  of the parameters of a COM_STMT_EXECUTE packet. The types of the
+  parameters are usually only given with the first set.
+
+  @param expanded_query  see execute_loop()
+  @param iterations      the number of parameter sets
+  @param packet          the first parameter set
+  @param packet_end      end of the packet
+
+  @retval  TRUE    an error occurred; the statements of the previous sets
+                   have been executed
+  @retval  FALSE   success
+*/
+
+bool
+Prepared_statement::execute_batch(String *expanded_query, ulong iterations,
+                                  uchar *packet, uchar *packet_end)
+{
+  ha_rows affected_rows= 0;
+  ulonglong first_insert_id= 0;
+
+  if (state == Query_arena::STMT_ERROR)
+  {
+    my_message(last_errno, last_error, MYF(0));
+    return TRUE;
+  }
+
+  bool long_data= false;
+  for (uint i= 0; i < param_count; i++)
+    long_data|= param_array[i]->state == Item_param::LONG_DATA_VALUE;
+
+  if (param_count == 0 || long_data ||
+      !(sql_command_flags[lex->sql_command] & CF_HAS_ROW_COUNT))
+  {
+    my_error(ER_WRONG_ARGUMENTS, MYF(0), "mysqld_stmt_execute");
+    reset_stmt_params(this);
+    return TRUE;
+  }
+
+  for (ulong i= 0; i < iterations; i++)
+  {
+    if (i > 0)
+      mysql_reset_thd_for_next_command(thd);
+
+    DBUG_ASSERT(!thd->get_stmt_da()->is_set());
+
+    if (set_parameters(expanded_query, &packet, packet_end) ||
+        execute_with_reprepare(expanded_query, false))
+      return TRUE;
+
+    DBUG_ASSERT(thd->get_stmt_da()->is_ok());
+    affected_rows+= thd->get_stmt_da()->affected_rows();
+    if (first_insert_id == 0)
+      first_insert_id= thd->get_stmt_da()->last_insert_id();
+  }
+
+  thd->get_stmt_da()->reset_diagnostics_area();
+  my_ok(thd, affected_rows, first_insert_id);
+  return FALSE;
+}
+#endif
+
+
+/**
+  Execute a prepared statement whose parameters have been set, see
+  execute_loop().
+*/
+
+bool
+Prepared_statement::execute_with_reprepare(String *expanded_query,
+                                           bool open_cursor)
+{
+  const int MAX_REPREPARE_ATTEMPTS= 3;
+  Reprepare_observer reprepare_observer;
+  bool error;
+  int reprepare_attempt= 0;
+
   if (unlikely(thd->security_ctx->password_expired && 
                !lex->is_set_password_sql))
   {
@@ -3611,6 +3731,38 @@ reexecute:
 }
 
 
+/**
+  Execute a text query from its query template: the literals of the query
+  become the values of the parameters of the template. The query is
+  logged and binlogged with its own text.
+
+  @param literals  the literals of the query, see query_template_split()
+
+  @return TRUE if an error, FALSE if success
+*/
+
+bool
+Prepared_statement::execute_query_template(
+  const Query_template_literals &literals)
+{
+  DBUG_ASSERT(is_query_template() && literals.size() == param_count);
+  DBUG_ASSERT(!thd->get_stmt_da()->is_set());
+
+  String expanded_query;
+  expanded_query.set(thd->query().str, thd->query().length, thd->charset());
+
+  if (query_template_bind(thd, param_array, literals))
+  {
+    reset_stmt_params(this);
+    if (!thd->is_error())
+      my_error(ER_OUT_OF_RESOURCES, MYF(0));
+    return TRUE;
+  }
+
+  return execute_with_reprepare(&expanded_query, false);
+}
+
+
 bool
 Prepared_statement::execute_server_runnable(Server_runnable *server_runnable)
 {
@@ -3671,6 +3823,8 @@ Prepared_statement::reprepare()
   Prepared_statement copy(thd);
 
   copy.set_sql_prepare(); /* To suppress sending metadata to the client. */
+  if (is_query_template())
+    copy.set_query_template();
 
   thd->status_var.com_stmt_reprepare++;
 
@@ -3693,6 +3847,9 @@ Prepared_statement::reprepare()
 
     swap_prepared_statement(&copy);
     swap_parameter_array(param_array, copy.param_array, param_count);
+    /* The shape of a query template may change with its tables */
+    flags= (flags & ~ (uint) HAS_TEMPLATE_SHAPE) |
+           (copy.flags & (uint) HAS_TEMPLATE_SHAPE);
 #ifndef DBUG_OFF
     is_reprepared= TRUE;
 #endif
@@ -3826,7 +3983,9 @@ bool Prepared_statement::execute(String *expanded_query, bool open_cursor)
     { saved_cur_db_name_buf, sizeof(saved_cur_db_name_buf) };
   bool cur_db_changed;
 
-  thd->status_var.com_stmt_execute++;
+  /* A statement executed from its query template counts as itself */
+  if (!is_query_template())
+    thd->status_var.com_stmt_execute++;
 
   /*
     Reset the diagnostics area.
@@ -3944,9 +4103,11 @@ bool Prepared_statement::execute(String *expanded_query, bool open_cursor)
     /*
       Try to find it in the query cache, if not, execute it.
       Note that multi-statements cannot exist here (they are not supported in
-      prepared statements).
+      prepared statements). The statements of query templates have been
+      looked up by mysql_parse() already.
     */
-    if (query_cache.send_result_to_client(thd, thd->query()) <= 0)
+    if (is_query_template() ||
+        query_cache.send_result_to_client(thd, thd->query()) <= 0)
     {
       PSI_statement_locker *parent_locker;
       MYSQL_QUERY_EXEC_START(const_cast<char*>(thd->query().str),
@@ -3979,7 +4140,8 @@ bool Prepared_statement::execute(String *expanded_query, bool open_cursor)
         a hash of that hash.
       */
       rewrite_query_if_needed(thd);
-      log_execute_line(thd);
+      log_execute_line(thd, is_query_template() ? COM_QUERY :
+                                                  COM_STMT_EXECUTE);
 
       error= mysql_execute_command(thd);
       thd->m_statement_psi= parent_locker;
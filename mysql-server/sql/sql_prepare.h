@@ -16,6 +16,7 @@
    51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA */
 
 #include "sql_class.h"  // Query_arena
+#include "sql_query_template.h"  // Query_template_literals
 
 struct LEX;
 
@@ -74,6 +75,8 @@ void mysqld_stmt_fetch(THD *thd, char *packet, size_t packet_length);
 void mysqld_stmt_reset(THD *thd, char *packet, size_t packet_length);
 void mysql_stmt_get_longdata(THD *thd, char *pos, size_t packet_length);
 void reinit_stmt_before_use(THD *thd, LEX *lex);
+void setup_one_conversion_function(THD *thd, Item_param *param,
+                                   uchar param_type);
 
 /**
   Execute a fragment of server code in an isolated context, so that
@@ -393,7 +396,9 @@ class Prepared_statement: public Query_arena
   enum flag_values
   {
     IS_IN_USE= 1,
-    IS_SQL_PREPARE= 2
+    IS_SQL_PREPARE= 2,
+    IS_QUERY_TEMPLATE= 4,
+    HAS_TEMPLATE_SHAPE= 8
   };
 
 public:
@@ -455,10 +460,21 @@ public:
   bool is_in_use() const { return flags & (uint) IS_IN_USE; }
   bool is_sql_prepare() const { return flags & (uint) IS_SQL_PREPARE; }
   void set_sql_prepare() { flags|= (uint) IS_SQL_PREPARE; }
+  /// Whether this is a template of text queries, see sql_query_template.h
+  bool is_query_template() const { return flags & (uint) IS_QUERY_TEMPLATE; }
+  void set_query_template() { flags|= (uint) IS_QUERY_TEMPLATE; }
+  /// Whether the prepared template passed query_template_has_shape()
+  bool has_template_shape() const
+  { return flags & (uint) HAS_TEMPLATE_SHAPE; }
   bool prepare(const char *packet, size_t packet_length);
   bool execute_loop(String *expanded_query,
                     bool open_cursor,
                     uchar *packet_arg, uchar *packet_end_arg);
+  bool execute_query_template(const Query_template_literals &literals);
+#ifndef EMBEDDED_LIBRARY
+  bool execute_batch(String *expanded_query, ulong iterations,
+                     uchar *packet, uchar *packet_end);
+#endif
   bool execute_server_runnable(Server_runnable *server_runnable);
 #ifdef HAVE_PSI_PS_INTERFACE
   PSI_prepared_stmt* get_PS_prepared_stmt();
@@ -469,7 +485,8 @@ private:
   void setup_set_params();
   bool set_db(const LEX_CSTRING &db_length);
   bool set_parameters(String *expanded_query,
-                      uchar *packet, uchar *packet_end);
+                      uchar **packet, uchar *packet_end);
+  bool execute_with_reprepare(String *expanded_query, bool open_cursor);
   bool execute(String *expanded_query, bool open_cursor);
   bool reprepare();
   bool validate_metadata(Prepared_statement  *copy);
@@ -477,7 +494,7 @@ private:
   bool insert_params_from_vars(List<LEX_STRING>& varnames,
                                String *query);
 #ifndef EMBEDDED_LIBRARY
-  bool insert_params(uchar *null_array, uchar *read_pos, uchar *data_end,
+  bool insert_params(uchar *null_array, uchar **read_pos, uchar *data_end,
                      String *query);
 #else
   bool emb_insert_params(String *query);
@@ -180,7 +180,8 @@ template <class T> bool valid_buffer_range(T jump,
 #define OPTIMIZER_SWITCH_SUBQ_MAT_COST_BASED       (1ULL << 14)
 #define OPTIMIZER_SWITCH_USE_INDEX_EXTENSIONS      (1ULL << 15)
 #define OPTIMIZER_SWITCH_COND_FANOUT_FILTER        (1ULL << 16)
-#define OPTIMIZER_SWITCH_LAST                      (1ULL << 17)
+#define OPTIMIZER_SWITCH_DERIVED_CONDITION_PUSHDOWN (1ULL << 17)
+#define OPTIMIZER_SWITCH_LAST                      (1ULL << 18)
 
 #define OPTIMIZER_SWITCH_DEFAULT (OPTIMIZER_SWITCH_INDEX_MERGE | \
                                   OPTIMIZER_SWITCH_INDEX_MERGE_UNION | \
@@ -0,0 +1,609 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "sql_query_template.h"
+#include "sql_class.h"                          // THD
+#include "sql_lex.h"                            // LEX, MYSQLlex
+#include "sql_prepare.h"                        // Prepared_statement
+#include "sql_parse.h"                          // start_statement_digest
+#include "sql_audit.h"                          // mysql_audit_general_log
+#include "mysqld.h"                             // key_memory_query_template_cache
+#include "item_cmpfunc.h"                       // Item_cond
+#include "item_func.h"                          // mqh_used
+#include "hash.h"                               // HASH
+#include "mysql/psi/mysql_statement.h"          // MYSQL_REFINE_STATEMENT
+
+#include "sql_yacc.h"
+
+
+enum_query_template_split
+query_template_split(THD *thd, Parser_state *parser_state,
+                     String *text, Query_template_literals *literals)
+{
+  Lex_input_stream *lip= &parser_state->m_lip;
+  YYSTYPE yylval;
+  YYLTYPE yylloc;
+  bool has_template;
+  bool has_shape= true;
+  bool is_select;
+  const char *copied= lip->get_buf();
+
+  thd->m_parser_state= parser_state;
+
+  int token= MYSQLlex(&yylval, &yylloc, thd);
+  is_select= token == SELECT_SYM;
+  has_template= is_select || token == INSERT || token == UPDATE_SYM ||
+                token == DELETE_SYM;
+
+  while (has_template && has_shape)
+  {
+    int last_token= token;
+    Query_template_literal literal;
+
+    token= MYSQLlex(&yylval, &yylloc, thd);
+    if (token == END_OF_INPUT)
+      break;
+
+    switch (token) {
+    case NUM:
+    case LONG_NUM:
+      literal.type= Query_template_literal::INT;
+      break;
+    case ULONGLONG_NUM:
+      literal.type= Query_template_literal::UINT;
+      break;
+    case DECIMAL_NUM:
+      literal.type= Query_template_literal::DECIMAL;
+      break;
+    case FLOAT_NUM:
+      literal.type= Query_template_literal::REAL;
+      break;
+    case TEXT_STRING:
+      /*
+        A string with a character set introducer, and a temporal literal,
+        are not values of type VARCHAR: keep them in the template.
+      */
+      if (last_token == UNDERSCORE_CHARSET || last_token == DATE_SYM ||
+          last_token == TIME_SYM || last_token == TIMESTAMP)
+        continue;
+      literal.type= Query_template_literal::STRING;
+      break;
+    case INTO:
+      // SELECT ... INTO has no result set
+      has_template= !is_select;
+      continue;
+    case SELECT_SYM:                            // Subquery, INSERT ... SELECT
+    case UNION_SYM:
+    case JOIN_SYM:
+    case GROUP_SYM:
+    case ORDER_SYM:
+    case HAVING:
+    case PROCEDURE_SYM:
+      // See query_template_has_shape(), the rest need not be lexed
+      has_shape= false;
+      continue;
+    case ';':                                   // Multiple statements
+    case '?':
+    case PARAM_MARKER:
+    case ABORT_SYM:                             // Syntax error
+      has_template= false;
+      continue;
+    default:
+      continue;
+    }
+
+    literal.value= yylval.lex_str;
+    if (text->append(copied, yylloc.raw.start - copied) ||
+        text->append('?') ||
+        literals->push_back(literal))
+      has_template= false;
+    copied= yylloc.raw.end;
+  }
+
+  if (has_template && has_shape &&
+      text->append(copied, lip->get_end_of_query() - copied))
+    has_template= false;
+
+  thd->m_parser_state= NULL;
+  if (!has_template)
+    return QUERY_TEMPLATE_NONE;
+  return has_shape ? QUERY_TEMPLATE_SPLIT : QUERY_TEMPLATE_NO_SHAPE;
+}
+
+
+bool query_template_bind(THD *thd, Item_param **params,
+                         const Query_template_literals &literals)
+{
+  for (size_t i= 0; i < literals.size(); i++)
+  {
+    Item_param *param= params[i];
+    const LEX_STRING &value= literals[i].value;
+    int error;
+
+    param->unsigned_flag= false;
+    switch (literals[i].type) {
+    case Query_template_literal::UINT:
+      param->unsigned_flag= true;
+      // Fall through
+    case Query_template_literal::INT:
+      setup_one_conversion_function(thd, param, MYSQL_TYPE_LONGLONG);
+      param->set_int(my_strtoll10(value.str, NULL, &error),
+                     static_cast<uint32>(value.length));
+      break;
+    case Query_template_literal::DECIMAL:
+      setup_one_conversion_function(thd, param, MYSQL_TYPE_NEWDECIMAL);
+      param->set_decimal(value.str, value.length);
+      break;
+    case Query_template_literal::REAL:
+      {
+        char *end= value.str + value.length;
+        setup_one_conversion_function(thd, param, MYSQL_TYPE_DOUBLE);
+        param->set_double(my_strntod(&my_charset_bin, value.str,
+                                     value.length, &end, &error));
+        break;
+      }
+    case Query_template_literal::STRING:
+      setup_one_conversion_function(thd, param, MYSQL_TYPE_VARCHAR);
+      if (param->set_str(value.str, value.length) ||
+          param->convert_str_value(thd))
+        return true;
+      break;
+    }
+  }
+  return false;
+}
+
+
+/**
+  Check whether a condition has an equality with a constant on each
+  column of the primary key of a table.
+*/
+
+static bool is_primary_key_lookup(TABLE *table, Item *cond)
+{
+  if (cond == NULL || !cond->fixed || table->s->primary_key == MAX_KEY)
+    return false;
+
+  const KEY *key= &table->key_info[table->s->primary_key];
+  key_part_map found= 0;
+
+  List<Item> single;
+  List<Item> *conjuncts= &single;
+  if (cond->type() == Item::COND_ITEM &&
+      static_cast<Item_cond*>(cond)->functype() == Item_func::COND_AND_FUNC)
+    conjuncts= static_cast<Item_cond*>(cond)->argument_list();
+  else if (single.push_back(cond))
+    return false;
+
+  List_iterator<Item> it(*conjuncts);
+  Item *item;
+  while ((item= it++))
+  {
+    if (item->type() != Item::FUNC_ITEM ||
+        static_cast<Item_func*>(item)->functype() != Item_func::EQ_FUNC)
+      continue;
+    Item **args= static_cast<Item_func*>(item)->arguments();
+    for (uint side= 0; side < 2; side++)
+    {
+      Item *column= args[side]->real_item();
+      if (column->type() != Item::FIELD_ITEM ||
+          !args[1 - side]->const_during_execution())
+        continue;
+      const Field *field= static_cast<Item_field*>(column)->field;
+      if (field == NULL || field->table != table)
+        continue;
+      for (uint part= 0; part < key->user_defined_key_parts; part++)
+      {
+        if (key->key_part[part].fieldnr == field->field_index + 1)
+          found|= (key_part_map) 1 << part;
+      }
+    }
+  }
+  return found == make_prev_keypart_map(key->user_defined_key_parts);
+}
+
+
+bool query_template_has_shape(LEX *lex)
+{
+  TABLE_LIST *table= lex->query_tables;
+  SELECT_LEX *select_lex= lex->select_lex;
+
+  if (table == NULL || table->next_global != NULL || table->table == NULL ||
+      table->is_view_or_derived() || table->schema_table != NULL ||
+      lex->uses_stored_routines() || lex->describe || lex->proc_analyse ||
+      select_lex->next_select() != NULL ||
+      select_lex->first_inner_unit() != NULL ||
+      select_lex->group_list.elements != 0 ||
+      select_lex->order_list.elements != 0)
+    return false;
+
+  switch (lex->sql_command) {
+  case SQLCOM_INSERT:
+    return true;
+  case SQLCOM_SELECT:
+    {
+      if (select_lex->having_cond() != NULL)
+        return false;
+      List_iterator<Item> it(select_lex->item_list);
+      Item *item;
+      while ((item= it++))
+      {
+        if (item->real_item()->type() != Item::FIELD_ITEM)
+          return false;
+      }
+      break;
+    }
+  case SQLCOM_UPDATE:
+  case SQLCOM_DELETE:
+    break;
+  default:
+    return false;
+  }
+  return is_primary_key_lookup(table->table, select_lex->where_cond());
+}
+
+
+/// A template in the cache of a session
+struct Query_template_entry
+{
+  /// db, @@sql_mode and character sets, then the template or stripped text
+  char *key;
+  size_t key_length;
+  /// The prepared template, NULL for the stripped text of a statement
+  Prepared_statement *stmt;
+};
+
+
+extern "C"
+{
+  static uchar *get_query_template_key(const uchar *ptr, size_t *length,
+                                       my_bool first)
+  {
+    const Query_template_entry *entry=
+      reinterpret_cast<const Query_template_entry*>(ptr);
+    *length= entry->key_length;
+    return reinterpret_cast<uchar*>(entry->key);
+  }
+
+
+  static void free_query_template(void *ptr)
+  {
+    Query_template_entry *entry= static_cast<Query_template_entry*>(ptr);
+    delete entry->stmt;
+    my_free(entry);
+  }
+}
+
+
+class Query_template_cache
+{
+public:
+  Query_template_cache()
+  {
+    my_hash_init(&m_hash, &my_charset_bin, 0, 0, 0,
+                 get_query_template_key, free_query_template, 0);
+  }
+
+  ~Query_template_cache()
+  {
+    my_hash_free(&m_hash);
+  }
+
+  Query_template_entry *lookup(const String &key)
+  {
+    return reinterpret_cast<Query_template_entry*>(
+      my_hash_search(&m_hash, reinterpret_cast<const uchar*>(key.ptr()),
+                     key.length()));
+  }
+
+  /**
+    Add a template, emptying the cache first if it is full.
+
+    @returns false if success, true if out of memory; the statement is
+             then deleted
+  */
+  bool insert(const String &key, Prepared_statement *stmt, ulong max_size)
+  {
+    Query_template_entry *entry;
+    char *key_buff;
+
+    if (m_hash.records >= max_size)
+      my_hash_reset(&m_hash);
+
+    if (!my_multi_malloc(key_memory_query_template_cache, MYF(MY_WME),
+                         &entry, sizeof(Query_template_entry),
+                         &key_buff, key.length(),
+                         NullS))
+    {
+      delete stmt;
+      return true;
+    }
+    memcpy(key_buff, key.ptr(), key.length());
+    entry->key= key_buff;
+    entry->key_length= key.length();
+    entry->stmt= stmt;
+
+    if (my_hash_insert(&m_hash, reinterpret_cast<uchar*>(entry)))
+    {
+      free_query_template(entry);
+      return true;
+    }
+    return false;
+  }
+
+private:
+  HASH m_hash;
+};
+
+
+void query_template_cache_clear(Query_template_cache **cache)
+{
+  delete *cache;
+  *cache= NULL;
+}
+
+
+/**
+  Prepare a template, without reporting any error or warning.
+
+  @returns the prepared template, or NULL if it could not be prepared or
+           does not have the shape to be executed in place of statements
+*/
+
+static Prepared_statement *prepare_template(THD *thd, const char *text,
+                                            size_t length, size_t literals)
+{
+  Prepared_statement *stmt= new Prepared_statement(thd);
+  if (stmt == NULL)
+    return NULL;
+
+  stmt->set_sql_prepare();                      // Send no metadata
+  stmt->set_query_template();
+
+  Diagnostics_area prepare_da(false);
+  thd->push_diagnostics_area(&prepare_da, false);
+  bool error= stmt->prepare(text, length);
+  thd->pop_diagnostics_area();
+
+  if (error && thd->is_fatal_error)
+    thd->get_stmt_da()->set_error_status(prepare_da.mysql_errno(),
+                                         prepare_da.message_text(),
+                                         prepare_da.returned_sqlstate());
+
+  if (error || !stmt->has_template_shape() || stmt->param_count != literals)
+  {
+    delete stmt;
+    return NULL;
+  }
+  return stmt;
+}
+
+
+/// What a key of the cache of templates is followed by
+enum enum_query_template_key
+{
+  /// The template, for a prepared template
+  TEMPLATE_KEY,
+  /// The statement without numbers and strings, for a template without shape
+  STRIPPED_KEY
+};
+
+
+/**
+  Start a key of the cache of templates with what the meaning of the text
+  that follows depends on.
+*/
+
+static bool append_key_header(THD *thd, enum_query_template_key kind,
+                              String *key)
+{
+  char header[13];
+  header[0]= static_cast<char>(kind);
+  int8store(header + 1, thd->variables.sql_mode);
+  int2store(header + 9, thd->variables.character_set_client->number);
+  int2store(header + 11, thd->variables.collation_connection->number);
+  return key->append(header, sizeof(header)) ||
+         key->append(thd->db().str, thd->db().length) ||
+         key->append('\0');
+}
+
+
+/**
+  Append the text of the current statement to a key, without the digits
+  of its numbers and the contents of its strings. This is much cheaper
+  than lexing the statement, as it only looks at quotes and digits.
+
+  The statements of a template all have the same stripped text. Others
+  may have it too, e.g. statements whose templates only differ in their
+  temporal literals, or in comments; they can be told apart by their
+  templates only.
+*/
+
+static bool append_stripped_text(THD *thd, String *key)
+{
+  const uchar *ident_map= thd->charset()->ident_map;
+  const bool backslash_escapes=
+    !(thd->variables.sql_mode & MODE_NO_BACKSLASH_ESCAPES);
+  const bool double_quoted_strings=
+    !(thd->variables.sql_mode & MODE_ANSI_QUOTES);
+  const char *pos= thd->query().str;
+  const char *end= pos + thd->query().length;
+  const char *copied= pos;
+  bool in_ident= false;
+
+  while (pos < end)
+  {
+    const char c= *pos++;
+    if (c == '\'' || (c == '"' && double_quoted_strings))
+    {
+      // Skip the string, the quotes are kept
+      if (key->append(copied, pos - copied))
+        return true;
+      while (pos < end && *pos != c)
+        pos+= (*pos == '\\' && backslash_escapes && pos + 1 < end) ? 2 : 1;
+      copied= pos;
+      if (pos < end)
+        pos++;
+      in_ident= false;
+    }
+    else if (c == '`')
+    {
+      // Identifiers are kept, digits included
+      while (pos < end && *pos++ != '`')
+      {}
+      in_ident= true;
+    }
+    else if (my_isdigit(&my_charset_latin1, c) && !in_ident)
+    {
+      if (key->append(copied, pos - 1 - copied))
+        return true;
+      while (pos < end && my_isdigit(&my_charset_latin1, *pos))
+        pos++;
+      copied= pos;
+    }
+    else
+      in_ident= ident_map[static_cast<uchar>(c)];
+  }
+  return copied < end && key->append(copied, end - copied);
+}
+
+
+bool query_template_execute(THD *thd, Parser_state *parser_state)
+{
+  const ulong size= thd->variables.query_template_cache_size;
+
+  if (size == 0)
+  {
+    query_template_cache_clear(&thd->query_template_cache);
+    return false;
+  }
+
+  if (thd->slave_thread || thd->get_command() != COM_QUERY)
+    return false;
+#ifndef NO_EMBEDDED_ACCESS_CHECKS
+  // Statements counted by check_mqh() are parsed
+  if (mqh_used && thd->get_user_connect())
+    return false;
+#endif
+
+  if (thd->query_template_cache == NULL &&
+      (thd->query_template_cache= new Query_template_cache) == NULL)
+    return false;
+  Query_template_cache *cache= thd->query_template_cache;
+
+  /*
+    A statement whose template is known not to have the shape is only
+    lexed by the parser.
+  */
+  char stripped_key_buff[STRING_BUFFER_USUAL_SIZE * 4];
+  String stripped_key(stripped_key_buff, sizeof(stripped_key_buff),
+                      &my_charset_bin);
+  if (append_key_header(thd, STRIPPED_KEY, &stripped_key) ||
+      append_stripped_text(thd, &stripped_key))
+    return false;
+  if (cache->lookup(stripped_key) != NULL)
+  {
+    thd->status_var.query_template_misses++;
+    return false;
+  }
+
+  start_statement_digest(thd, parser_state);
+
+  char key_buff[STRING_BUFFER_USUAL_SIZE * 4];
+  String key(key_buff, sizeof(key_buff), &my_charset_bin);
+  const size_t key_header_length=
+    append_key_header(thd, TEMPLATE_KEY, &key) ? 0 : key.length();
+  Query_template_literals literals(thd->mem_root);
+  enum_query_template_split split= QUERY_TEMPLATE_NONE;
+
+  Diagnostics_area *parser_da= thd->get_parser_da();
+  thd->push_diagnostics_area(parser_da, false);
+  parser_da->reset_diagnostics_area();
+  parser_da->reset_condition_info(thd);
+
+  if (key_header_length != 0)
+    split= query_template_split(thd, parser_state, &key, &literals);
+  if (parser_da->current_statement_cond_count() != 0 ||
+      parser_da->is_error())
+    split= QUERY_TEMPLATE_NONE;
+
+  thd->pop_diagnostics_area();
+
+  Prepared_statement *stmt= NULL;
+  bool has_shape= split != QUERY_TEMPLATE_NO_SHAPE;
+
+  if (split != QUERY_TEMPLATE_NONE)
+  {
+    Query_template_entry *entry= has_shape ? cache->lookup(key) : NULL;
+
+    // The shape may have changed when the template was reprepared
+    if (entry != NULL && entry->stmt->has_template_shape())
+    {
+      thd->status_var.query_template_hits++;
+      stmt= entry->stmt;
+    }
+    else
+    {
+      thd->status_var.query_template_misses++;
+      has_shape= has_shape && entry == NULL;
+      /*
+        Preparing opens and closes the tables, which must not end the
+        statement of an ongoing transaction or LOCK TABLES.
+      */
+      if (has_shape && !thd->in_active_multi_stmt_transaction() &&
+          !thd->locked_tables_mode)
+      {
+        stmt= prepare_template(thd, key.ptr() + key_header_length,
+                               key.length() - key_header_length,
+                               literals.size());
+        if (thd->is_error())
+          return true;                          // Fatal error when preparing
+        if (thd->killed)
+        {
+          delete stmt;
+          stmt= NULL;
+        }
+        else if (stmt == NULL)
+          has_shape= false;
+        else if (cache->insert(key, stmt, size))
+          stmt= NULL;
+      }
+    }
+
+    if (!has_shape)
+      (void) cache->insert(stripped_key, NULL, size);
+  }
+
+  if (stmt == NULL)
+  {
+    parser_state->reset(thd->query().str, thd->query().length);
+    return false;
+  }
+
+  thd->m_statement_psi=
+    MYSQL_REFINE_STATEMENT(thd->m_statement_psi,
+                           sql_statement_info[stmt->lex->sql_command].m_key);
+  if (parser_state->m_digest_psi != NULL)
+    MYSQL_DIGEST_END(parser_state->m_digest_psi,
+                     &thd->m_digest->m_digest_storage);
+
+  /* Audit_log notification when general log is disabled */
+  if (!opt_general_log && !opt_general_log_raw)
+    mysql_audit_general_log(thd, command_name[COM_QUERY].str,
+                            command_name[COM_QUERY].length);
+
+  (void) stmt->execute_query_template(literals);
+  return true;
+}
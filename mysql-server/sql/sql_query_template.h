@@ -0,0 +1,149 @@
+#ifndef SQL_QUERY_TEMPLATE_INCLUDED
+#define SQL_QUERY_TEMPLATE_INCLUDED
+
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Per session cache of prepared statement templates, which lets the
+  single-row statements of OLTP applications skip the parser.
+
+  The template of a statement is its text with each number and string
+  literal replaced by a parameter marker, '?'. It is found while the
+  statement is lexed for its digest, before it is parsed: the tokens
+  that the digest reduces to a value are the literals. Statements which
+  only differ in their literals thus have the same template.
+
+  The template of a SELECT, INSERT, UPDATE or DELETE is prepared, like
+  by PREPARE, the first time a session sees it, and kept if the prepared
+  statement reads or changes a single base table, and the SELECT, UPDATE
+  or DELETE finds its rows by equalities on all the columns of the
+  primary key. Later statements with the same template do not go through
+  the parser: their literals become the values of the parameters of the
+  prepared template, which is then executed like by EXECUTE. They are
+  logged and binlogged with their own text, and count as the statement
+  they are, not as executions of a prepared statement.
+
+  Statements whose tokens show that they can't have that shape (joins,
+  unions, subqueries, GROUP BY, ORDER BY, HAVING) are not prepared. The
+  statements of templates which do not have the shape are remembered by
+  their text without its numbers and strings, which is found without
+  lexing: they are then only lexed by the parser, and not split again.
+  Templates are prepared outside of multi-statement transactions and
+  LOCK TABLES only, and are keyed by the current database, @@sql_mode and
+  the character sets of the session. A template is reprepared when one
+  of its tables has changed, as any prepared statement.
+
+  The cache holds at most @@query_template_cache_size templates, it is
+  emptied when it is full. It is disabled when the size is 0.
+*/
+
+#include "my_global.h"
+#include "mem_root_array.h"                     // Mem_root_array
+
+class THD;
+class Item_param;
+class Parser_state;
+class Query_template_cache;
+class String;
+struct LEX;
+
+/// A literal of a statement, the value of a parameter of its template
+struct Query_template_literal
+{
+  enum enum_type { INT, UINT, DECIMAL, REAL, STRING };
+
+  enum_type type;
+  /**
+    The text of a number, or the value of a string, escapes removed, in
+    @@character_set_client. Allocated in the memory root of the statement.
+  */
+  LEX_STRING value;
+};
+
+typedef Mem_root_array<Query_template_literal, true> Query_template_literals;
+
+/// What query_template_split() found a statement to be
+enum enum_query_template_split
+{
+  /// Not a single SELECT, INSERT, UPDATE or DELETE, or not lexed
+  QUERY_TEMPLATE_NONE,
+  /// A statement whose tokens show that it can't be executed from a template
+  QUERY_TEMPLATE_NO_SHAPE,
+  /// A statement which may be executed from its template
+  QUERY_TEMPLATE_SPLIT
+};
+
+/**
+  Lex a statement and split it into its template and its literals.
+
+  The tokens are read with MYSQLlex(), so the digest of the statement is
+  computed if the lexer of the parser state has been set up for it. The
+  parser state is used up; it must be reset before the statement can be
+  parsed.
+
+  @param          thd           current thread
+  @param          parser_state  parser state, initialized with the statement
+  @param[in,out]  text          the template is appended to it
+  @param[out]     literals      the literals, in the order of their markers
+
+  @returns QUERY_TEMPLATE_SPLIT if the statement is a single SELECT,
+           INSERT, UPDATE or DELETE, the template and the literals are
+           then complete
+*/
+enum_query_template_split
+query_template_split(THD *thd, Parser_state *parser_state,
+                     String *text, Query_template_literals *literals);
+
+/**
+  Set the parameters of a prepared template to the literals of a
+  statement, as if they had been sent by a client with COM_STMT_EXECUTE.
+
+  @param thd       current thread
+  @param params    the parameters of the template
+  @param literals  the literals, one per parameter
+
+  @returns false if success, true if out of memory
+*/
+bool query_template_bind(THD *thd, Item_param **params,
+                         const Query_template_literals &literals);
+
+/**
+  Check, while its tables are open, whether a prepared template is a
+  single-table statement which can be executed in place of its
+  statements.
+*/
+bool query_template_has_shape(LEX *lex);
+
+/**
+  Execute the current statement from its prepared template, if the
+  template is cached or can be prepared. This is called by mysql_parse()
+  for each statement of a COM_QUERY, before the statement is parsed.
+
+  @param thd           current thread
+  @param parser_state  parser state, initialized with the statement
+
+  @returns true if the statement has been executed, successfully or not;
+           false if it has to be parsed, the parser state is then reset
+*/
+bool query_template_execute(THD *thd, Parser_state *parser_state);
+
+/// Free the templates of a session, and the cache
+void query_template_cache_clear(Query_template_cache **cache);
+
+#endif /* SQL_QUERY_TEMPLATE_INCLUDED */
@@ -29,6 +29,7 @@
 #include "rpl_mi.h"
 #include "debug_sync.h"
 #include "connection_handler_impl.h"
+#include "opt_costcalibration.h"       // store_calibrated_cost_constants
 #include "opt_costconstantcache.h"     // reload_optimizer_cost_constants
 
 
@@ -337,7 +338,10 @@ bool reload_acl_and_cache(THD *thd, unsigned long options,
    }
 #endif
   if (options & REFRESH_OPTIMIZER_COSTS)
+  {
+    store_calibrated_cost_constants();
     reload_optimizer_cost_constants();
+  }
 #ifdef HAVE_REPLICATION
  if (options & REFRESH_SLAVE)
  {
@@ -44,6 +44,8 @@
 #include "sql_join_buffer.h"     // JOIN_CACHE
 #include "sql_optimizer.h"       // JOIN
 #include "sql_tmp_table.h"       // tmp tables
+#include "sql_batch.h"           // Batch_scan
+#include "key_hash_set.h"        // Key_hash_set
 #include "debug_sync.h"          // DEBUG_SYNC
 
 #include <algorithm>
@@ -554,6 +556,16 @@ static bool setup_semijoin_dups_elimination(JOIN *join, ulonglong options,
           if (sjtbl->tmp_table->hash_field)
             sjtbl->tmp_table->file->ha_index_init(0, 0);
           join->sj_tmp_tables.push_back(sjtbl->tmp_table);
+          /*
+            Rowid tuples are kept in memory as long as an in-memory
+            temptable could hold them.
+          */
+          if (!(sjtbl->hash_set= new (thd->mem_root)
+                Key_hash_set(key_memory_SJ_TMP_TABLE_hash_set,
+                             sjtbl->rowid_len + sjtbl->null_bytes,
+                             min(thd->variables.tmp_table_size,
+                                 thd->variables.max_heap_table_size))))
+            DBUG_RETURN(TRUE); /* purecov: inspected */
         }
         else
         {
@@ -2330,6 +2342,14 @@ void QEP_TAB::cleanup()
   // Delete parts specific of QEP_TAB:
   delete filesort;
   filesort= NULL;
+  if (flush_weedout_table)
+  {
+    delete flush_weedout_table->hash_set;
+    flush_weedout_table->hash_set= NULL;
+    flush_weedout_table->use_hash_set= false;
+  }
+  delete top_n_filter;
+  top_n_filter= NULL;
   end_read_record(&read_record);
   if (quick_optim() != quick())
     delete quick_optim();
@@ -3801,12 +3821,21 @@ bool JOIN::make_tmp_tables_info()
     }
   }
   fields= curr_fields_list;
+  /*
+    The sort order of the last tmp table refers to its fields only while
+    its slice of the ref array is current.
+  */
+  if (qep_tab && tmp_tables &&
+      setup_tmptable_top_n_filter(&qep_tab[primary_tables + tmp_tables - 1]))
+    DBUG_RETURN(true);
   // Reset before execution
   set_items_ref_array(items0);
   if (qep_tab)
   {
     qep_tab[primary_tables + tmp_tables - 1].next_select=
       get_end_select_func();
+    if ((batch_scan= Batch_scan::create(this)))
+      first_select= sub_select_batch;
   }
   group= has_group_by;
 
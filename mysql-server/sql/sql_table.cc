@@ -55,6 +55,7 @@
 #include "sql_resolver.h"              // setup_order, fix_inner_refs
 #include "table_cache.h"
 #include "sql_trigger.h"               // change_trigger_table_name
+#include "histograms.h"                // rename_histograms
 #include <mysql/psi/mysql_table.h>
 
 #include <algorithm>
@@ -2520,6 +2521,7 @@ int mysql_rm_table_no_locks(THD *thd, TABLE_LIST *tables, bool if_exists,
         {
           non_tmp_table_deleted= TRUE;
           new_error= drop_all_triggers(thd, db, table->table_name);
+          drop_all_histograms(db, table->table_name);
         }
         error|= new_error;
         /* Invalidate even if we failed to delete the .FRM file. */
@@ -5259,6 +5261,12 @@ mysql_rename_table(handlerton *base, const char *old_db,
     }
   }
   delete file;
+  /*
+    The histograms follow the table when it is renamed by the user. A
+    copying ALTER TABLE moves them once the new table has its final name.
+  */
+  if (!error && !(flags & (FN_FROM_IS_TMP | FN_TO_IS_TMP)))
+    rename_histograms(old_db, old_name, new_db, new_name);
   if (error == HA_ERR_WRONG_COMMAND)
     my_error(ER_NOT_SUPPORTED_YET, MYF(0), "ALTER TABLE");
   else if (error)
@@ -8867,6 +8875,10 @@ bool mysql_alter_table(THD *thd, const char *new_db, const char *new_name,
     goto err_with_mdl;
   }
 
+  if (alter_ctx.is_table_renamed())
+    rename_histograms(alter_ctx.db, alter_ctx.table_name,
+                      alter_ctx.new_db, alter_ctx.new_alias);
+
   // ALTER TABLE succeeded, delete the backup of the old table.
   if (quick_rm_table(thd, old_db_type, alter_ctx.db, backup_name, FN_IS_TMP))
   {
@@ -79,7 +79,8 @@ static bool
 timer_notify(THD_timer_info *thd_timer)
 {
   Find_thd_with_id find_thd_with_id(thd_timer->thread_id);
-  THD *thd= Global_THD_manager::get_instance()->find_thd(&find_thd_with_id);
+  THD *thd= Global_THD_manager::get_instance()->find_thd(thd_timer->thread_id,
+                                                         &find_thd_with_id);
 
   DBUG_ASSERT(!thd_timer->destroy || !thd_timer->thread_id);
   /*
@@ -492,6 +492,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  AND_AND_SYM                   /* OPERATOR */
 %token  AND_SYM                       /* SQL-2003-R */
 %token  ANY_SYM                       /* SQL-2003-R */
+%token  APPROX_COUNT_DISTINCT_SYM     /* MYSQL-FUNC */
 %token  AS                            /* SQL-2003-R */
 %token  ASC                           /* SQL-2003-N */
 %token  ASCII_SYM                     /* MYSQL-FUNC */
@@ -519,6 +520,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  BOOL_SYM
 %token  BOTH                          /* SQL-2003-R */
 %token  BTREE_SYM
+%token  BUCKETS_SYM
 %token  BY                            /* SQL-2003-R */
 %token  BYTE_SYM
 %token  CACHE_SYM
@@ -686,6 +688,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  HELP_SYM
 %token  HEX_NUM
 %token  HIGH_PRIORITY
+%token  HISTOGRAM_SYM
 %token  HOST_SYM
 %token  HOSTS_SYM
 %token  HOUR_MICROSECOND_SYM
@@ -930,6 +933,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  RESET_SYM
 %token  RESIGNAL_SYM                  /* SQL-2003-R */
 %token  RESOURCES
+%token  RESOURCE_SYM                  /* MYSQL */
 %token  RESTORE_SYM
 %token  RESTRICT
 %token  RESUME_SYM
@@ -1036,6 +1040,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  TEXT_SYM
 %token  THAN_SYM
 %token  THEN_SYM                      /* SQL-2003-R */
+%token  THREAD_PRIORITY_SYM           /* MYSQL */
 %token  TIMESTAMP                     /* SQL-2003-R */
 %token  TIMESTAMP_ADD
 %token  TIMESTAMP_DIFF
@@ -1087,6 +1092,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  VARIABLES
 %token  VARIANCE_SYM
 %token  VARYING                       /* SQL-2003-R */
+%token  VCPU_SYM                      /* MYSQL */
 %token  VAR_SAMP_SYM
 %token  VIEW_SYM                      /* SQL-2003-N */
 %token  WAIT_SYM
@@ -1334,6 +1340,10 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
         key_using_alg
         part_column_list
         server_options_list server_option
+        opt_resource_group_vcpu_list vcpu_range_list vcpu_range
+        opt_resource_group_priority opt_resource_group_thread_list
+        resource_group_thread_list resource_group_thread
+        set_resource_group_stmt
         definer_opt no_definer definer get_diagnostics
 END_OF_INPUT
 
@@ -1437,6 +1447,10 @@ END_OF_INPUT
 
 %type <procedure_analyse_params> opt_procedure_analyse_params
 
+%type <histogram_options> opt_histogram
+
+%type <ulong_num> opt_histogram_buckets
+
 %type <procedure_analyse> opt_procedure_analyse_clause
 
 %type <select_lock_type> opt_select_lock_type
@@ -1627,6 +1641,7 @@ statement:
         | savepoint
         | select                { CONTEXTUALIZE($1); }
         | set                   { CONTEXTUALIZE($1); }
+        | set_resource_group_stmt
         | signal_stmt
         | show
         | slave
@@ -2283,6 +2298,49 @@ create:
             Lex->m_sql_cmd=
               new (YYTHD->mem_root) Sql_cmd_create_server(&Lex->server_options);
           }
+        | CREATE RESOURCE_SYM GROUP_SYM ident
+          opt_resource_group_vcpu_list opt_resource_group_priority
+          {
+            Lex->sql_command= SQLCOM_CREATE_RESOURCE_GROUP;
+            Lex->resource_group_options.m_name= $4;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+              Sql_cmd_create_resource_group(&Lex->resource_group_options);
+          }
+        ;
+
+opt_resource_group_vcpu_list:
+          /* empty */ {}
+        | VCPU_SYM opt_equal vcpu_range_list {}
+        ;
+
+vcpu_range_list:
+          vcpu_range
+        | vcpu_range_list ',' vcpu_range
+        ;
+
+vcpu_range:
+          ulong_num
+          {
+            if (Lex->resource_group_options.add_vcpus($1, $1))
+              MYSQL_YYABORT;
+          }
+        | ulong_num '-' ulong_num
+          {
+            if (Lex->resource_group_options.add_vcpus($1, $3))
+              MYSQL_YYABORT;
+          }
+        ;
+
+opt_resource_group_priority:
+          /* empty */ {}
+        | THREAD_PRIORITY_SYM opt_equal ulong_num
+          {
+            Lex->resource_group_options.set_priority($3, false);
+          }
+        | THREAD_PRIORITY_SYM opt_equal '-' ulong_num
+          {
+            Lex->resource_group_options.set_priority($4, true);
+          }
         ;
 
 server_options_list:
@@ -7432,6 +7490,14 @@ alter:
             lex->m_sql_cmd=
               new (YYTHD->mem_root) Sql_cmd_alter_server(&Lex->server_options);
           }
+        | ALTER RESOURCE_SYM GROUP_SYM ident
+          opt_resource_group_vcpu_list opt_resource_group_priority
+          {
+            Lex->sql_command= SQLCOM_ALTER_RESOURCE_GROUP;
+            Lex->resource_group_options.m_name= $4;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+              Sql_cmd_alter_resource_group(&Lex->resource_group_options);
+          }
         | ALTER USER clear_privileges alter_user_list
           {
             Lex->sql_command= SQLCOM_ALTER_USER;
@@ -8362,17 +8428,51 @@ analyze:
             /* Will be overriden during execution. */
             YYPS->m_lock_type= TL_UNLOCK;
           }
-          table_list
+          table_list opt_histogram
           {
             THD *thd= YYTHD;
             LEX* lex= thd->lex;
             DBUG_ASSERT(!lex->m_sql_cmd);
-            lex->m_sql_cmd= new (thd->mem_root) Sql_cmd_analyze_table();
+            lex->m_sql_cmd= new (thd->mem_root) Sql_cmd_analyze_table($6);
             if (lex->m_sql_cmd == NULL)
               MYSQL_YYABORT;
           }
         ;
 
+opt_histogram:
+          /* empty */
+          {
+            $$.command= Histogram_options::NONE;
+            $$.columns= NULL;
+            $$.num_buckets= Histogram_options::default_num_buckets;
+          }
+        | UPDATE_SYM HISTOGRAM_SYM ON using_list opt_histogram_buckets
+          {
+            $$.command= Histogram_options::UPDATE;
+            $$.columns= $4;
+            $$.num_buckets= $5;
+          }
+        | DROP HISTOGRAM_SYM ON using_list
+          {
+            $$.command= Histogram_options::DROP;
+            $$.columns= $4;
+            $$.num_buckets= Histogram_options::default_num_buckets;
+          }
+        ;
+
+opt_histogram_buckets:
+          /* empty */ { $$= Histogram_options::default_num_buckets; }
+        | WITH ulong_num BUCKETS_SYM
+          {
+            if ($2 < 1 || $2 > Histogram_options::max_num_buckets)
+            {
+              my_error(ER_WRONG_ARGUMENTS, MYF(0), "WITH ... BUCKETS");
+              MYSQL_YYABORT;
+            }
+            $$= $2;
+          }
+        ;
+
 binlog_base64_event:
           BINLOG_SYM TEXT_STRING_sys
           {
@@ -9685,6 +9785,10 @@ sum_expr:
           {
             $$= new Item_sum_count(@$, $4);
           }
+        | APPROX_COUNT_DISTINCT_SYM '(' expr_list ')'
+          {
+            $$= NEW_PTN Item_sum_approx_count_distinct(@$, $3);
+          }
         | MIN_SYM '(' in_sum_expr ')'
           {
             $$= NEW_PTN Item_sum_min(@$, $3);
@@ -10872,6 +10976,13 @@ drop:
             Lex->m_sql_cmd=
               new (YYTHD->mem_root) Sql_cmd_drop_server($4, $3);
           }
+        | DROP RESOURCE_SYM GROUP_SYM ident
+          {
+            Lex->sql_command= SQLCOM_DROP_RESOURCE_GROUP;
+            Lex->resource_group_options.m_name= $4;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+              Sql_cmd_drop_resource_group(&Lex->resource_group_options);
+          }
         ;
 
 table_list:
@@ -12946,6 +13057,7 @@ keyword_sp:
         | BOOL_SYM                 {}
         | BOOLEAN_SYM              {}
         | BTREE_SYM                {}
+        | BUCKETS_SYM              {}
         | CASCADED                 {}
         | CATALOG_NAME_SYM         {}
         | CHAIN_SYM                {}
@@ -13027,6 +13139,7 @@ keyword_sp:
         | GRANTS                   {}
         | GLOBAL_SYM               {}
         | HASH_SYM                 {}
+        | HISTOGRAM_SYM            {}
         | HOSTS_SYM                {}
         | HOUR_SYM                 {}
         | IDENTIFIED_SYM           {}
@@ -13157,6 +13270,7 @@ keyword_sp:
         | REPLICATE_WILD_IGNORE_TABLE {}
         | REPLICATE_REWRITE_DB     {}
         | RESOURCES                {}
+        | RESOURCE_SYM             {}
         | RESUME_SYM               {}
         | RETURNED_SQLSTATE_SYM    {}
         | RETURNS_SYM              {}
@@ -13213,6 +13327,7 @@ keyword_sp:
         | TEMPTABLE_SYM            {}
         | TEXT_SYM                 {}
         | THAN_SYM                 {}
+        | THREAD_PRIORITY_SYM      {}
         | TRANSACTION_SYM          {}
         | TRIGGERS_SYM             {}
         | TIMESTAMP                {}
@@ -13233,6 +13348,7 @@ keyword_sp:
         | USE_FRM                  {}
         | VALIDATION_SYM           {}
         | VARIABLES                {}
+        | VCPU_SYM                 {}
         | VIEW_SYM                 {}
         | VALUE_SYM                {}
         | WARNINGS                 {}
@@ -13262,6 +13378,46 @@ set:
         ;
 
 
+/*
+  SET RESOURCE GROUP, which is not a SQLCOM_SET_OPTION statement.
+*/
+
+set_resource_group_stmt:
+          SET RESOURCE_SYM GROUP_SYM ident opt_resource_group_thread_list
+          {
+            Lex->sql_command= SQLCOM_SET_RESOURCE_GROUP;
+            Lex->resource_group_options.m_name= $4;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+              Sql_cmd_set_resource_group(&Lex->resource_group_options);
+          }
+        | SET RESOURCE_SYM GROUP_SYM DEFAULT opt_resource_group_thread_list
+          {
+            Lex->sql_command= SQLCOM_SET_RESOURCE_GROUP;
+            Lex->resource_group_options.m_name= null_lex_str;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+              Sql_cmd_set_resource_group(&Lex->resource_group_options);
+          }
+        ;
+
+opt_resource_group_thread_list:
+          /* empty */ {}
+        | FOR_SYM resource_group_thread_list {}
+        ;
+
+resource_group_thread_list:
+          resource_group_thread
+        | resource_group_thread_list ',' resource_group_thread
+        ;
+
+resource_group_thread:
+          ulong_num
+          {
+            if (Lex->resource_group_options.add_thread_id(YYTHD->mem_root,
+                                                          $1))
+              MYSQL_YYABORT;
+          }
+        ;
+
 // Start of option value list
 start_option_value_list:
           option_value_no_option_type option_value_list_continued
@@ -55,6 +55,10 @@
 #include "sql_base.h"                           // close_cached_tables
 #include "debug_sync.h"                         // DEBUG_SYNC
 #include "hostname.h"                           // host_cache_size
+#include "sql_plan_cache.h"                     // plan_cache_size
+#include "sp_cache.h"             // stored_program_shared_cache_size
+#include "range_estimate_cache.h"               // range_estimate_cache_time
+#include "opt_costcalibration.h"                // opt_cost_calibration
 #include "sql_show.h"                           // opt_ignore_db_dirs
 #include "table_cache.h"                        // Table_cache_manager
 #include "connection_handler_impl.h"            // Per_thread_connection_handler
@@ -651,6 +655,15 @@ static Sys_var_ulong Sys_back_log(
        READ_ONLY GLOBAL_VAR(back_log), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, 65535), DEFAULT(0), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_acceptor_threads(
+       "acceptor_threads", "The number of threads that accept TCP/IP "
+       "connections. With more than one, each thread has a listener socket "
+       "of its own, bound to the TCP/IP port with SO_REUSEPORT. Note that "
+       "SO_REUSEPORT lets another server started by the same user bind to "
+       "the same port",
+       READ_ONLY GLOBAL_VAR(acceptor_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 64), DEFAULT(1), BLOCK_SIZE(1));
+
 static Sys_var_charptr Sys_basedir(
        "basedir", "Path to installation directory. All paths are "
        "usually resolved relative to this",
@@ -2360,6 +2373,60 @@ static Sys_var_ulong Sys_optimizer_search_depth(
        SESSION_VAR(optimizer_search_depth), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, MAX_TABLES+1), DEFAULT(MAX_TABLES+1), BLOCK_SIZE(1));
 
+static bool fix_optimizer_cost_calibration(sys_var *, THD *, enum_var_type)
+{
+  // Measurements from an earlier calibration period may be stale
+  if (opt_cost_calibration)
+    cost_calibration_reset();
+  return false;
+}
+
+static Sys_var_mybool Sys_optimizer_cost_calibration(
+       "optimizer_cost_calibration",
+       "Measure the time of random reads in each storage engine and of "
+       "the evaluation of join conditions. FLUSH OPTIMIZER_COSTS then "
+       "stores an io_block_read_cost calibrated from the measurements "
+       "for each storage engine in the mysql.engine_cost table",
+       GLOBAL_VAR(opt_cost_calibration), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL),
+       ON_UPDATE(fix_optimizer_cost_calibration));
+
+static Sys_var_ulong Sys_optimizer_dp_join_limit(
+       "optimizer_dp_join_limit",
+       "The join order of query blocks with at most this many non-constant "
+       "tables is chosen by a dynamic programming search over all join "
+       "orders instead of the greedy search. Query blocks with semi-joins "
+       "or nested joins always use the greedy search. If set to 0, the "
+       "dynamic programming search is not used",
+       SESSION_VAR(optimizer_dp_join_limit), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, MAX_TABLES), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_optimizer_dp_max_plans(
+       "optimizer_dp_max_plans",
+       "Maximum number of partial join orders of each size that the "
+       "dynamic programming search keeps. When there are more, only the "
+       "cheapest ones are extended further, which bounds the optimization "
+       "time of joins of many tables",
+       SESSION_VAR(optimizer_dp_max_plans), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 1000000), DEFAULT(1000), BLOCK_SIZE(1));
+
+static bool fix_plan_cache_size(sys_var *, THD *, enum_var_type)
+{
+  plan_cache_resize(plan_cache_size);
+  return false;
+}
+
+static Sys_var_ulong Sys_plan_cache_size(
+       "plan_cache_size",
+       "The number of query blocks whose join order is kept in the plan "
+       "cache. Later executions of the same statement, in any session, use "
+       "the cached order instead of searching for the best one. 0 disables "
+       "the plan cache",
+       GLOBAL_VAR(plan_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024*1024), DEFAULT(0), BLOCK_SIZE(1),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL),
+       ON_UPDATE(fix_plan_cache_size));
+
 static const char *optimizer_switch_names[]=
 {
   "index_merge", "index_merge_union", "index_merge_sort_union",
@@ -2368,7 +2435,8 @@ static const char *optimizer_switch_names[]=
   "block_nested_loop", "batched_key_access",
   "materialization", "semijoin", "loosescan", "firstmatch",
   "subquery_materialization_cost_based",
-  "use_index_extensions", "condition_fanout_filter", "default", NullS
+  "use_index_extensions", "condition_fanout_filter",
+  "derived_condition_pushdown", "default", NullS
 };
 static Sys_var_flagset Sys_optimizer_switch(
        "optimizer_switch",
@@ -2379,7 +2447,8 @@ static Sys_var_flagset Sys_optimizer_switch(
        ", materialization, semijoin, loosescan, firstmatch,"
        " subquery_materialization_cost_based"
        ", block_nested_loop, batched_key_access, use_index_extensions, "
-       "condition_fanout_filter} and val is one of {on, off, default}",
+       "condition_fanout_filter, derived_condition_pushdown} and val is "
+       "one of {on, off, default}",
        SESSION_VAR(optimizer_switch), CMD_LINE(REQUIRED_ARG),
        optimizer_switch_names, DEFAULT(OPTIMIZER_SWITCH_DEFAULT),
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL), ON_UPDATE(NULL));
@@ -2485,6 +2554,27 @@ static Sys_var_uint Sys_protocol_version(
        READ_ONLY GLOBAL_VAR(protocol_version), NO_CMD_LINE,
        VALID_RANGE(0, ~0), DEFAULT(PROTOCOL_VERSION), BLOCK_SIZE(1));
 
+static const char *protocol_compression_algorithm_names[]=
+{ "zlib", "lz4", "zstd", NULL };
+
+static Sys_var_set Sys_protocol_compression_algorithms(
+       "protocol_compression_algorithms",
+       "The compression algorithms the server offers to clients that use "
+       "the compressed protocol. Syntax: "
+       "protocol-compression-algorithms=value[,value...], where \"value\" "
+       "could be zlib, lz4 or zstd. Algorithms the server was built without "
+       "are not offered",
+       GLOBAL_VAR(protocol_compression_algorithms), CMD_LINE(REQUIRED_ARG),
+       protocol_compression_algorithm_names, DEFAULT(7));
+
+static Sys_var_uint Sys_protocol_compression_level(
+       "protocol_compression_level",
+       "The level the server compresses packets of new connections with. "
+       "0 for the default level of the algorithm. zlib levels go up to 9, "
+       "zstd levels up to 22; LZ4 has a single level",
+       GLOBAL_VAR(protocol_compression_level), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 22), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_proxy_user Sys_proxy_user(
        "proxy_user", "The proxy user account name used when logging in",
        IN_SYSTEM_CHARSET);
@@ -2614,6 +2704,15 @@ static Sys_var_uint Sys_eq_range_index_dive_limit(
        SESSION_VAR(eq_range_index_dive_limit), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, UINT_MAX32), DEFAULT(200), BLOCK_SIZE(1));
 
+static Sys_var_uint Sys_executor_batch_size(
+       "executor_batch_size",
+       "Number of rows read at a time into column vectors by a full scan "
+       "of a single table, when the WHERE condition and the aggregate "
+       "functions of the query can be evaluated over whole vectors. "
+       "If set to 0, rows are always processed one at a time.",
+       SESSION_VAR(executor_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, UINT_MAX16), DEFAULT(1024), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_range_alloc_block_size(
        "range_alloc_block_size",
        "Allocation block size for storing ranges during optimization",
@@ -2621,6 +2720,24 @@ static Sys_var_ulong Sys_range_alloc_block_size(
        VALID_RANGE(RANGE_ALLOC_BLOCK_SIZE, ULONG_MAX),
        DEFAULT(RANGE_ALLOC_BLOCK_SIZE), BLOCK_SIZE(1024));
 
+static Sys_var_ulonglong Sys_range_optimizer_max_mem_size(
+       "range_optimizer_max_mem_size",
+       "Maximum amount of memory used by the range optimizer for a table. "
+       "If the conditions on the table need more memory to be analyzed, "
+       "no range access is considered for the table. "
+       "If set to 0, there is no limit",
+       SESSION_VAR(range_optimizer_max_mem_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONGLONG_MAX), DEFAULT(8388608), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_range_estimate_cache_time(
+       "range_estimate_cache_time",
+       "The number of milliseconds for which the estimated number of rows "
+       "in an index range is cached, so that the range optimizer does not "
+       "ask the storage engine again for the same range. 0 disables the "
+       "cache",
+       GLOBAL_VAR(range_estimate_cache_time), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 3600 * 1000), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_multi_range_count(
        "multi_range_count",
        "Number of key ranges to request at once. "
@@ -2656,6 +2773,24 @@ static Sys_var_ulong Sys_query_prealloc_size(
        BLOCK_SIZE(1024), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(fix_thd_mem_root));
 
+static Sys_var_ulong Sys_query_alloc_retain_size(
+       "query_alloc_retain_size",
+       "Blocks allocated for query parsing and execution are kept for "
+       "the next statements of the session, up to this many bytes in "
+       "total with the persistent buffer",
+       SESSION_VAR(query_alloc_retain_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(64 * 1024),
+       BLOCK_SIZE(1024), NO_MUTEX_GUARD, NOT_IN_BINLOG);
+
+static Sys_var_ulong Sys_query_template_cache_size(
+       "query_template_cache_size",
+       "The number of statement templates a session keeps prepared. A "
+       "single-table SELECT, UPDATE or DELETE by primary key, or INSERT, "
+       "is executed from the template of its text with the literals "
+       "replaced by parameters, without being parsed. 0 disables the cache",
+       SESSION_VAR(query_template_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024*1024), DEFAULT(0), BLOCK_SIZE(1));
+
 #if defined (_WIN32) && !defined (EMBEDDED_LIBRARY)
 static Sys_var_mybool Sys_shared_memory(
        "shared_memory", "Enable the shared memory",
@@ -2740,15 +2875,60 @@ static Sys_var_ulong Sys_trans_prealloc_size(
 #ifndef EMBEDDED_LIBRARY
 static const char *thread_handling_names[]=
 {
-  "one-thread-per-connection", "no-threads", "loaded-dynamically",
-  0
+  "one-thread-per-connection", "no-threads", "pool-of-threads",
+  "loaded-dynamically", 0
 };
 static Sys_var_enum Sys_thread_handling(
        "thread_handling",
        "Define threads usage for handling queries, one of "
-       "one-thread-per-connection, no-threads, loaded-dynamically"
+       "one-thread-per-connection, no-threads, pool-of-threads, "
+       "loaded-dynamically"
        , READ_ONLY GLOBAL_VAR(Connection_handler_manager::thread_handling),
        CMD_LINE(REQUIRED_ARG), thread_handling_names, DEFAULT(0));
+
+static Sys_var_ulong Sys_thread_pool_size(
+       "thread_pool_size",
+       "Number of thread groups of the pool-of-threads thread handling. "
+       "Each group has a listener thread that waits for commands from "
+       "its connections, and a limited number of worker threads that "
+       "run commands at the same time",
+       READ_ONLY GLOBAL_VAR(Pool_of_threads_connection_handler::pool_size),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(1, 128), DEFAULT(16),
+       BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_thread_pool_oversubscribe(
+       "thread_pool_oversubscribe",
+       "Number of worker threads of a thread group, in addition to the "
+       "first one, that may run commands at the same time. Worker "
+       "threads that wait for locks, I/O or sleeps are not counted",
+       GLOBAL_VAR(Pool_of_threads_connection_handler::oversubscribe),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(0, 1000), DEFAULT(3),
+       BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_thread_pool_stall_limit(
+       "thread_pool_stall_limit",
+       "Number of milliseconds after which a thread group is considered "
+       "stalled if none of its queued commands has been started. One "
+       "more worker thread of a stalled group may run commands",
+       GLOBAL_VAR(Pool_of_threads_connection_handler::stall_limit),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(10, 60000), DEFAULT(500),
+       BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_thread_pool_max_threads(
+       "thread_pool_max_threads",
+       "Maximum number of threads of the pool-of-threads thread handling",
+       GLOBAL_VAR(Pool_of_threads_connection_handler::max_pool_threads),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(1, 100000), DEFAULT(100000),
+       BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_thread_pool_high_prio_tickets(
+       "thread_pool_high_prio_tickets",
+       "Number of consecutive commands of a connection in a transaction "
+       "that the pool-of-threads thread handling runs before commands "
+       "of other connections. Set to 0 to disable the priority",
+       GLOBAL_VAR(Pool_of_threads_connection_handler::high_prio_tickets),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(0, UINT_MAX32), DEFAULT(UINT_MAX32),
+       BLOCK_SIZE(1));
 #endif // !EMBEDDED_LIBRARY
 
 static bool fix_query_cache_size(sys_var *self, THD *thd, enum_var_type type)
@@ -2774,11 +2954,41 @@ static Sys_var_ulong Sys_query_cache_size(
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(fix_query_cache_size));
 
+static bool fix_query_cache_limit(sys_var *self, THD *thd, enum_var_type type)
+{
+  query_cache.result_size_limit(query_cache.query_cache_limit);
+  return false;
+}
 static Sys_var_ulong Sys_query_cache_limit(
        "query_cache_limit",
        "Don't cache results that are bigger than this",
        GLOBAL_VAR(query_cache.query_cache_limit), CMD_LINE(REQUIRED_ARG),
-       VALID_RANGE(0, ULONG_MAX), DEFAULT(1024*1024), BLOCK_SIZE(1));
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(1024*1024), BLOCK_SIZE(1),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_query_cache_limit));
+
+static Sys_var_ulong Sys_query_cache_partitions(
+       "query_cache_partitions",
+       "The number of partitions the query cache is split into. Each "
+       "partition has its own lock and an equal share of query_cache_size, "
+       "and a query is cached in the partition selected by a hash of its "
+       "text",
+       READ_ONLY GLOBAL_VAR(query_cache_partitions), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, Partitioned_query_cache::MAX_PARTITIONS), DEFAULT(1),
+       BLOCK_SIZE(1));
+
+static const char *query_cache_invalidation_names[]=
+  { "TABLE", "PARTITION", 0 };
+static Sys_var_enum Sys_query_cache_invalidation(
+       "query_cache_invalidation",
+       "TABLE = A change to a table invalidates all cached results using "
+       "the table. PARTITION = An INSERT, UPDATE, DELETE, REPLACE or LOAD "
+       "DATA statement outside of a multi-statement transaction changing a "
+       "partitioned table only invalidates the cached results using one of "
+       "the partitions the statement locked",
+       GLOBAL_VAR(query_cache_invalidation), CMD_LINE(REQUIRED_ARG),
+       query_cache_invalidation_names,
+       DEFAULT(QUERY_CACHE_INVALIDATION_TABLE));
 
 static bool fix_qcache_min_res_unit(sys_var *self, THD *thd, enum_var_type type)
 {
@@ -4691,6 +4901,22 @@ static Sys_var_ulong Sys_sp_cache_size(
        GLOBAL_VAR(stored_program_cache_size), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(256, 512 * 1024), DEFAULT(256), BLOCK_SIZE(1));
 
+static bool fix_sp_shared_cache_size(sys_var *, THD *, enum_var_type)
+{
+  sp_cache_shrink_shared();
+  return false;
+}
+
+static Sys_var_ulong Sys_sp_shared_cache_size(
+       "stored_program_shared_cache",
+       "The soft upper limit for number of stored routines that are not in "
+       "use and are kept for all connections, to be reused without parsing "
+       "them again. Set to 0 to disable the shared cache.",
+       GLOBAL_VAR(stored_program_shared_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 512 * 1024), DEFAULT(0), BLOCK_SIZE(1),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL),
+       ON_UPDATE(fix_sp_shared_cache_size));
+
 static bool check_pseudo_slave_mode(sys_var *self, THD *thd, set_var *var)
 {
   longlong previous_val= thd->variables.pseudo_slave_mode;
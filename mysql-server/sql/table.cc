@@ -41,6 +41,8 @@
 #include "table_cache.h"         // table_cache_manager
 #include "sql_view.h"
 #include "debug_sync.h"
+#include "histograms.h"          // load_histograms
+#include "range_estimate_cache.h" // free_range_estimate_cache
 
 /* INFORMATION_SCHEMA name */
 LEX_STRING INFORMATION_SCHEMA_NAME= {C_STRING_WITH_LEN("information_schema")};
@@ -488,6 +490,7 @@ void TABLE_SHARE::destroy()
   /* The mutex is initialized only for shares that are part of the TDC */
   if (tmp_table == NO_TMP_TABLE)
     mysql_mutex_destroy(&LOCK_ha_data);
+  free_range_estimate_cache(this);
   my_hash_free(&name_hash);
 
   plugin_unlock(NULL, db_plugin);
@@ -783,6 +786,8 @@ int open_table_def(THD *thd, TABLE_SHARE *share, uint db_flags)
     error= open_binary_frm(thd, share, head, file);
     *root_ptr= old_root;
     error_given= 1;
+    if (!error && !share->tmp_table)
+      load_histograms(thd, share);
   }
   else if (table_type == 2)
   {
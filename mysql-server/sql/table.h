@@ -33,6 +33,7 @@
 #include "sql_sort.h"
 #include "table_id.h"
 #include "opt_costmodel.h"
+#include "my_atomic.h"                  /* my_atomic_add32 */
 
 /* Structs that defines the TABLE */
 
@@ -51,6 +52,8 @@ class ACL_internal_table_access;
 class Field;
 class Field_temporal_with_date_and_time;
 class Table_cache_element;
+class Histogram;
+struct Range_estimate;
 
 /*
   Used to identify NESTED_JOIN structures within a join (applicable to
@@ -588,6 +591,16 @@ struct TABLE_SHARE
   const CHARSET_INFO *table_charset;	/* Default charset of string fields */
 
   MY_BITMAP all_set;
+  /**
+    Histograms of the columns, indexed by field number, or NULL if the
+    table has no histograms. See histograms.h.
+  */
+  Histogram **histograms;
+  /**
+    Cached row estimates of index ranges, protected by LOCK_ha_data, or
+    NULL. See range_estimate_cache.h.
+  */
+  Range_estimate *range_estimates;
   /*
     Key which is used for looking-up table in table cache and in the list
     of thread's temporary tables. Has the form of:
@@ -626,7 +639,11 @@ struct TABLE_SHARE
   enum row_type row_type;		/* How rows are stored */
   enum tmp_table_type tmp_table;
 
-  uint ref_count;                       /* How many TABLE objects uses this */
+  /*
+    How many TABLE objects uses this. Changed with increment_ref_count()
+    and decrement_ref_count() only, see sql_base.cc.
+  */
+  volatile int32 ref_count;
   uint key_block_size;			/* create key_block_size, if used */
   uint stats_sample_pages;		/* number of pages to sample during
 					stats estimation, if used, otherwise 0. */
@@ -787,6 +804,31 @@ struct TABLE_SHARE
   }
 
 
+  /**
+    Add a reference to the share.
+
+    Under LOCK_open, or, if the share has TABLE objects in a table cache
+    instance, under the lock of that instance. In the latter case
+    ref_count can't drop to zero concurrently, so the share is neither
+    freed nor linked into the list of unused shares.
+
+    @return the new reference count
+  */
+  inline int32 increment_ref_count()
+  {
+    return my_atomic_add32(&ref_count, 1) + 1;
+  }
+
+  /**
+    Remove a reference to the share. Under LOCK_open.
+
+    @return the new reference count
+  */
+  inline int32 decrement_ref_count()
+  {
+    return my_atomic_add32(&ref_count, -1) - 1;
+  }
+
   /** Is this table share being expelled from the table definition cache?  */
   inline bool has_old_version() const
   {
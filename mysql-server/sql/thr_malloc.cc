@@ -35,6 +35,7 @@ void init_sql_alloc(PSI_memory_key key,
   mem_root->error_handler=sql_alloc_error_handler;
 }
 
+
 void *sql_alloc(size_t Size)
 {
   MEM_ROOT *root= *my_pthread_get_THR_MALLOC();
@@ -25,6 +25,11 @@ typedef struct st_mem_root MEM_ROOT;
 
 void init_sql_alloc(PSI_memory_key key,
                     MEM_ROOT *root, uint block_size, uint pre_alloc_size);
+C_MODE_START
+/* In mysys/my_alloc.c, a variant of free_root() */
+void free_root_retain(MEM_ROOT *root, size_t retain_size,
+                      ulonglong *allocated_blocks, ulonglong *reused_blocks);
+C_MODE_END
 
 void *sql_alloc(size_t);
 void *sql_calloc(size_t);
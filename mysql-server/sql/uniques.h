@@ -20,6 +20,7 @@
 #include "prealloced_array.h"
 #include "sql_array.h"
 #include "sql_sort.h"
+#include "key_hash_set.h"
 
 class Cost_model_table;
 
@@ -29,6 +30,12 @@ class Cost_model_table;
    it's dumped to the file. User can request sorted values, or
    just iterate through them. In the last case tree merging is performed in
    memory simultaneously with iteration, so it should be ~2-3x faster.
+
+   If enable_hash_set() has been called, values are put into an open
+   addressing hash set instead, as long as the set fits into
+   max_in_memory_size. When it does not fit any more, or when sorted
+   values are requested, the hash set is moved into the TREE and the
+   above algorithm takes over.
  */
 
 class Unique :public Sql_alloc
@@ -42,15 +49,26 @@ class Unique :public Sql_alloc
   bool flush();
   uint size;
 
+  /* Hash set, see enable_hash_set() */
+  Key_hash_set hash_set;
+  bool hash_set_enabled;
+  bool use_hash_set;
+  bool spill_hash_set();
+  bool hash_set_add(const uchar *key);
+
 public:
   ulong elements;
   Unique(qsort_cmp2 comp_func, void *comp_func_fixed_arg,
 	 uint size_arg, ulonglong max_in_memory_size_arg);
   ~Unique();
-  ulong elements_in_tree() { return tree.elements_in_tree; }
+  ulong elements_in_tree()
+  { return use_hash_set ? hash_set.elements() : tree.elements_in_tree; }
+  bool enable_hash_set();
   inline bool unique_add(void *ptr)
   {
     DBUG_ENTER("unique_add");
+    if (use_hash_set)
+      DBUG_RETURN(hash_set_add(static_cast<const uchar*>(ptr)));
     DBUG_PRINT("info", ("tree %u - %lu", tree.elements_in_tree, max_elements));
     if (tree.elements_in_tree > max_elements && flush())
       DBUG_RETURN(1);
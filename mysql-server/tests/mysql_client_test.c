@@ -25,6 +25,7 @@
 */
 
 #include "mysql_client_fw.c"
+#include <my_protocol_options.h>
 
 /* Query processing */
 
@@ -19864,6 +19865,240 @@ static void test_bug17512527()
 }
 
 
+#ifndef EMBEDDED_LIBRARY
+
+/*
+  Turn a protocol option of my_protocol_options.h on or off for the
+  session.
+*/
+
+static int set_protocol_option(MYSQL *lmysql, uint option)
+{
+  return mysql_set_server_option(lmysql, (enum enum_mysql_set_option) option);
+}
+
+
+/*
+  The protocol options are turned on and off with COM_SET_OPTION, and
+  unknown options are refused.
+*/
+
+static void test_protocol_options()
+{
+  MYSQL *lmysql;
+  int rc;
+
+  myheader("test_protocol_options");
+
+  lmysql= client_connect(0, MYSQL_PROTOCOL_DEFAULT, 0);
+
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_PIPELINE_ON);
+  myquery2(lmysql, rc);
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_STMT_EXECUTE_BATCH_ON);
+  myquery2(lmysql, rc);
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_PIPELINE_OFF);
+  myquery2(lmysql, rc);
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_STMT_EXECUTE_BATCH_OFF);
+  myquery2(lmysql, rc);
+
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_STMT_EXECUTE_BATCH_OFF + 1);
+  DIE_UNLESS(rc != 0);
+  DIE_UNLESS(mysql_errno(lmysql) == ER_UNKNOWN_COM_ERROR);
+
+  /* The session still works */
+  rc= mysql_query(lmysql, "SELECT 1");
+  myquery2(lmysql, rc);
+  mysql_free_result(mysql_store_result(lmysql));
+  mysql_close(lmysql);
+}
+
+
+/*
+  Store a set of two INT parameters of a COM_STMT_EXECUTE packet, the
+  second one NULL if it is negative.
+*/
+
+static uchar *store_int_params(uchar *pos, int a, int b, my_bool types)
+{
+  *pos++= b < 0 ? 2 : 0;                        /* NULL bitmap */
+  *pos++= types;                                /* new_params_bound_flag */
+  if (types)
+  {
+    int2store(pos, MYSQL_TYPE_LONG);
+    int2store(pos + 2, MYSQL_TYPE_LONG);
+    pos+= 4;
+  }
+  int4store(pos, a);
+  pos+= 4;
+  if (b >= 0)
+  {
+    int4store(pos, b);
+    pos+= 4;
+  }
+  return pos;
+}
+
+
+/*
+  Execute a prepared statement for several sets of parameters with one
+  COM_STMT_EXECUTE.
+*/
+
+static void test_stmt_execute_batch()
+{
+  MYSQL *lmysql;
+  MYSQL_STMT *stmt;
+  MYSQL_RES *result;
+  MYSQL_ROW row;
+  uchar buff[128];
+  uchar *pos;
+  const char *insert_text= "INSERT INTO t1 VALUES (?, ?)";
+  const char *select_text= "SELECT ?, ?";
+  int rc;
+
+  myheader("test_stmt_execute_batch");
+
+  lmysql= client_connect(0, MYSQL_PROTOCOL_DEFAULT, 0);
+
+  rc= mysql_query(lmysql, "DROP TABLE IF EXISTS t1");
+  myquery2(lmysql, rc);
+  rc= mysql_query(lmysql, "CREATE TABLE t1 (a INT, b INT)");
+  myquery2(lmysql, rc);
+
+  stmt= mysql_stmt_init(lmysql);
+  check_stmt(stmt);
+  rc= mysql_stmt_prepare(stmt, insert_text, strlen(insert_text));
+  check_execute(stmt, rc);
+
+  /* Three sets of parameters, the types are only sent with the first one */
+  int4store(buff, stmt->stmt_id);
+  buff[4]= 0;                                   /* flags */
+  int4store(buff + 5, 3);                       /* iteration count */
+  pos= store_int_params(buff + 9, 1, 10, 1);
+  pos= store_int_params(pos, 2, -1, 0);
+  pos= store_int_params(pos, 3, 30, 0);
+
+  /* Until the client asks for batches, only the first set is used */
+  rc= simple_command(lmysql, COM_STMT_EXECUTE, buff, (ulong) (pos - buff), 1);
+  DIE_UNLESS(rc == 0);
+  rc= mysql_read_query_result(lmysql);
+  myquery2(lmysql, rc);
+  DIE_UNLESS(mysql_affected_rows(lmysql) == 1);
+
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_STMT_EXECUTE_BATCH_ON);
+  myquery2(lmysql, rc);
+
+  rc= simple_command(lmysql, COM_STMT_EXECUTE, buff, (ulong) (pos - buff), 1);
+  DIE_UNLESS(rc == 0);
+  rc= mysql_read_query_result(lmysql);
+  myquery2(lmysql, rc);
+  DIE_UNLESS(mysql_affected_rows(lmysql) == 3);
+
+  rc= mysql_query(lmysql,
+                  "SELECT COUNT(*), COUNT(b), SUM(a), SUM(b) FROM t1");
+  myquery2(lmysql, rc);
+  result= mysql_store_result(lmysql);
+  mytest(result);
+  row= mysql_fetch_row(result);
+  DIE_UNLESS(strcmp(row[0], "4") == 0);
+  DIE_UNLESS(strcmp(row[1], "3") == 0);
+  DIE_UNLESS(strcmp(row[2], "7") == 0);
+  DIE_UNLESS(strcmp(row[3], "50") == 0);
+  mysql_free_result(result);
+  mysql_stmt_close(stmt);
+
+  /* Statements that return a result set can't be executed in a batch */
+  stmt= mysql_stmt_init(lmysql);
+  check_stmt(stmt);
+  rc= mysql_stmt_prepare(stmt, select_text, strlen(select_text));
+  check_execute(stmt, rc);
+
+  int4store(buff, stmt->stmt_id);
+  pos= store_int_params(buff + 9, 1, 2, 1);
+  pos= store_int_params(pos, 3, 4, 0);
+  int4store(buff + 5, 2);
+
+  rc= simple_command(lmysql, COM_STMT_EXECUTE, buff, (ulong) (pos - buff), 1);
+  DIE_UNLESS(rc == 0);
+  rc= mysql_read_query_result(lmysql);
+  DIE_UNLESS(rc != 0);
+  DIE_UNLESS(mysql_errno(lmysql) == ER_WRONG_ARGUMENTS);
+  mysql_stmt_close(stmt);
+
+  rc= mysql_query(lmysql, "DROP TABLE t1");
+  myquery2(lmysql, rc);
+  mysql_close(lmysql);
+}
+
+
+/*
+  Send several commands before reading their responses, which must come
+  back in order.
+*/
+
+static void test_pipelined_commands()
+{
+  MYSQL *lmysql;
+  NET *net;
+  MYSQL_RES *result;
+  MYSQL_ROW row;
+  const char *queries[]=
+  {
+    "INSERT INTO t1 VALUES (1)",
+    "INSERT INTO t1 VALUES (2), (3)",
+    "UPDATE t1 SET a= a * 10",
+    "DELETE FROM t1 WHERE a > 10"
+  };
+  const my_ulonglong affected_rows[]= { 1, 2, 3, 2 };
+  uint i;
+  int rc;
+
+  myheader("test_pipelined_commands");
+
+  lmysql= client_connect(0, MYSQL_PROTOCOL_DEFAULT, 0);
+  rc= set_protocol_option(lmysql, MYSQL_OPTION_PIPELINE_ON);
+  myquery2(lmysql, rc);
+
+  rc= mysql_query(lmysql, "DROP TABLE IF EXISTS t1");
+  myquery2(lmysql, rc);
+  rc= mysql_query(lmysql, "CREATE TABLE t1 (a INT)");
+  myquery2(lmysql, rc);
+
+  net= &lmysql->net;
+  for (i= 0; i < array_elements(queries); i++)
+  {
+    net->pkt_nr= 0;
+    rc= net_write_command(net, COM_QUERY, (uchar*) "", 0,
+                          (uchar*) queries[i], strlen(queries[i]));
+    DIE_UNLESS(rc == 0);
+  }
+
+  for (i= 0; i < array_elements(queries); i++)
+  {
+    /* The packets of each response are numbered from 1 */
+    net->pkt_nr= 1;
+    rc= mysql_read_query_result(lmysql);
+    myquery2(lmysql, rc);
+    DIE_UNLESS(mysql_affected_rows(lmysql) == affected_rows[i]);
+  }
+
+  rc= mysql_query(lmysql, "SELECT COUNT(*), SUM(a) FROM t1");
+  myquery2(lmysql, rc);
+  result= mysql_store_result(lmysql);
+  mytest(result);
+  row= mysql_fetch_row(result);
+  DIE_UNLESS(strcmp(row[0], "1") == 0);
+  DIE_UNLESS(strcmp(row[1], "10") == 0);
+  mysql_free_result(result);
+
+  rc= mysql_query(lmysql, "DROP TABLE t1");
+  myquery2(lmysql, rc);
+  mysql_close(lmysql);
+}
+
+#endif /* EMBEDDED_LIBRARY */
+
+
 static struct my_tests_st my_tests[]= {
   { "disable_query_logs", disable_query_logs },
   { "test_view_sp_list_fields", test_view_sp_list_fields },
@@ -20141,6 +20376,11 @@ static struct my_tests_st my_tests[]= {
   { "test_bug17309863", test_bug17309863},
 #endif
   { "test_bug17512527", test_bug17512527},
+#ifndef EMBEDDED_LIBRARY
+  { "test_protocol_options", test_protocol_options },
+  { "test_stmt_execute_batch", test_stmt_execute_batch },
+  { "test_pipelined_commands", test_pipelined_commands },
+#endif
   { 0, 0 }
 };
 
@@ -0,0 +1,172 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "histograms.h"
+#include "sql_string.h"
+#include "thr_malloc.h"
+
+namespace histograms_unittest {
+
+class HistogramTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    init_sql_alloc(PSI_NOT_INSTRUMENTED, &m_mem_root, 1024, 0);
+  }
+
+  virtual void TearDown()
+  {
+    free_root(&m_mem_root, MYF(0));
+  }
+
+  double selectivity(const Histogram &histogram, Histogram::enum_operator op,
+                     double value)
+  {
+    return histogram.get_selectivity(op, &value, 1);
+  }
+
+  MEM_ROOT m_mem_root;
+};
+
+
+TEST_F(HistogramTest, Singleton)
+{
+  double values[]= { 3, 1, 3, 2, 1, 3 };
+  Histogram histogram(&m_mem_root);
+  ASSERT_FALSE(histogram.build(values, 6, 2, 10));
+  EXPECT_EQ(Histogram::SINGLETON, histogram.get_type());
+  EXPECT_EQ(3U, histogram.get_num_buckets());
+  EXPECT_DOUBLE_EQ(0.25, histogram.get_null_fraction());
+
+  EXPECT_DOUBLE_EQ(0.375, selectivity(histogram, Histogram::EQUALS_TO, 3));
+  EXPECT_DOUBLE_EQ(0.0, selectivity(histogram, Histogram::EQUALS_TO, 4));
+  EXPECT_DOUBLE_EQ(0.0, selectivity(histogram, Histogram::EQUALS_TO, 1.5));
+  EXPECT_DOUBLE_EQ(0.5, selectivity(histogram, Histogram::NOT_EQUALS_TO, 1));
+  EXPECT_DOUBLE_EQ(0.375, selectivity(histogram, Histogram::LESS_THAN, 3));
+  EXPECT_DOUBLE_EQ(0.75,
+                   selectivity(histogram, Histogram::LESS_THAN_OR_EQUAL, 3));
+  EXPECT_DOUBLE_EQ(0.375, selectivity(histogram, Histogram::GREATER_THAN, 2));
+  EXPECT_DOUBLE_EQ(0.75,
+                   selectivity(histogram, Histogram::GREATER_THAN_OR_EQUAL, 0));
+  EXPECT_DOUBLE_EQ(0.25, histogram.get_selectivity(Histogram::IS_NULL,
+                                                   NULL, 0));
+  EXPECT_DOUBLE_EQ(0.75, histogram.get_selectivity(Histogram::IS_NOT_NULL,
+                                                   NULL, 0));
+
+  // Values in the list more than once are counted once
+  const double list[]= { 1, 2, 1 };
+  EXPECT_DOUBLE_EQ(0.375, histogram.get_selectivity(Histogram::IN_LIST,
+                                                    list, 3));
+  EXPECT_DOUBLE_EQ(0.375, histogram.get_selectivity(Histogram::NOT_IN_LIST,
+                                                    list, 3));
+}
+
+
+TEST_F(HistogramTest, EquiHeight)
+{
+  double values[1000];
+  for (int i= 0; i < 1000; i++)
+    values[i]= 1000 - i;
+  Histogram histogram(&m_mem_root);
+  ASSERT_FALSE(histogram.build(values, 1000, 0, 10));
+  EXPECT_EQ(Histogram::EQUI_HEIGHT, histogram.get_type());
+  EXPECT_EQ(10U, histogram.get_num_buckets());
+  EXPECT_DOUBLE_EQ(1.0, histogram.get_bucket(0).lower);
+  EXPECT_DOUBLE_EQ(100.0, histogram.get_bucket(0).upper);
+  EXPECT_DOUBLE_EQ(100.0, histogram.get_bucket(0).num_distinct);
+  EXPECT_DOUBLE_EQ(1.0, histogram.get_bucket(9).cumulative_frequency);
+
+  EXPECT_NEAR(0.001, selectivity(histogram, Histogram::EQUALS_TO, 500), 1e-9);
+  EXPECT_NEAR(0.0495, selectivity(histogram, Histogram::LESS_THAN, 50.5),
+              1e-9);
+  EXPECT_NEAR(0.9, selectivity(histogram, Histogram::GREATER_THAN, 100),
+              1e-9);
+  EXPECT_DOUBLE_EQ(0.0, selectivity(histogram, Histogram::LESS_THAN, 0));
+  EXPECT_DOUBLE_EQ(1.0, selectivity(histogram, Histogram::LESS_THAN, 2000));
+
+  const double range[]= { 101, 300 };
+  EXPECT_NEAR(0.2, histogram.get_selectivity(Histogram::BETWEEN, range, 2),
+              1e-9);
+  EXPECT_NEAR(0.8, histogram.get_selectivity(Histogram::NOT_BETWEEN,
+                                             range, 2), 1e-9);
+}
+
+
+TEST_F(HistogramTest, EqualValuesInOneBucket)
+{
+  // 500 rows with the same value must not be split between buckets
+  double values[1000];
+  for (int i= 0; i < 1000; i++)
+    values[i]= i < 500 ? 7 : i;
+  Histogram histogram(&m_mem_root);
+  ASSERT_FALSE(histogram.build(values, 1000, 0, 10));
+  EXPECT_EQ(Histogram::EQUI_HEIGHT, histogram.get_type());
+  for (size_t i= 1; i < histogram.get_num_buckets(); i++)
+    EXPECT_LT(histogram.get_bucket(i - 1).upper,
+              histogram.get_bucket(i).lower);
+  EXPECT_NEAR(0.5, selectivity(histogram, Histogram::EQUALS_TO, 7), 1e-9);
+}
+
+
+TEST_F(HistogramTest, StoreAndLoad)
+{
+  double values[300];
+  for (int i= 0; i < 300; i++)
+    values[i]= (i % 150) * 0.25 - 10;
+  Histogram histogram(&m_mem_root);
+  ASSERT_FALSE(histogram.build(values, 300, 17, 20));
+
+  String text;
+  ASSERT_FALSE(histogram.store(&text));
+  Histogram loaded(&m_mem_root);
+  ASSERT_FALSE(loaded.load(text.ptr(), text.length()));
+
+  EXPECT_EQ(histogram.get_type(), loaded.get_type());
+  EXPECT_DOUBLE_EQ(histogram.get_null_fraction(), loaded.get_null_fraction());
+  ASSERT_EQ(histogram.get_num_buckets(), loaded.get_num_buckets());
+  for (size_t i= 0; i < histogram.get_num_buckets(); i++)
+  {
+    EXPECT_DOUBLE_EQ(histogram.get_bucket(i).lower,
+                     loaded.get_bucket(i).lower);
+    EXPECT_DOUBLE_EQ(histogram.get_bucket(i).upper,
+                     loaded.get_bucket(i).upper);
+    EXPECT_NEAR(histogram.get_bucket(i).cumulative_frequency,
+                loaded.get_bucket(i).cumulative_frequency, 1e-12);
+    EXPECT_DOUBLE_EQ(histogram.get_bucket(i).num_distinct,
+                     loaded.get_bucket(i).num_distinct);
+  }
+}
+
+
+TEST_F(HistogramTest, LoadInvalid)
+{
+  Histogram histogram(&m_mem_root);
+  const char *overlapping= "equi-height 0 2 1 5 0.5 5 5 9 1 4";
+  EXPECT_TRUE(histogram.load(overlapping, strlen(overlapping)));
+  const char *truncated= "singleton 0 2 1 1 0.5 1";
+  EXPECT_TRUE(histogram.load(truncated, strlen(truncated)));
+  const char *unknown_type= "compressed 0 0";
+  EXPECT_TRUE(histogram.load(unknown_type, strlen(unknown_type)));
+  const char *valid= "singleton 0.5 2 1 1 0.25 1 2 2 0.5 1";
+  EXPECT_FALSE(histogram.load(valid, strlen(valid)));
+  EXPECT_EQ(2U, histogram.get_num_buckets());
+}
+
+}
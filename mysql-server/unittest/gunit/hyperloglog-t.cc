@@ -0,0 +1,119 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "hyperloglog.h"
+
+namespace hyperloglog_unittest {
+
+/*
+  Relative error allowed in the tests: about five standard errors of
+  a sketch with 2^14 registers.
+*/
+const double max_error= 0.04;
+
+void expect_close(ulonglong expected, ulonglong actual)
+{
+  EXPECT_NEAR(static_cast<double>(expected), static_cast<double>(actual),
+              max_error * expected);
+}
+
+
+TEST(HyperloglogTest, Empty)
+{
+  Hyperloglog hll;
+  EXPECT_EQ(0U, hll.estimate());
+}
+
+
+TEST(HyperloglogTest, Duplicates)
+{
+  Hyperloglog hll;
+  for (int i= 0; i < 100000; i++)
+    hll.add(Hyperloglog::mix(i % 10));
+  EXPECT_EQ(10U, hll.estimate());
+}
+
+
+TEST(HyperloglogTest, SmallAndLargeCardinalities)
+{
+  const ulonglong cardinalities[]= { 100, 1000, 20000, 100000, 1000000 };
+  for (size_t c= 0; c < array_elements(cardinalities); c++)
+  {
+    Hyperloglog hll;
+    for (ulonglong i= 0; i < cardinalities[c]; i++)
+      hll.add(Hyperloglog::mix(i));
+    expect_close(cardinalities[c], hll.estimate());
+  }
+}
+
+
+TEST(HyperloglogTest, Clear)
+{
+  Hyperloglog hll;
+  for (ulonglong i= 0; i < 1000; i++)
+    hll.add(Hyperloglog::mix(i));
+  hll.clear();
+  EXPECT_EQ(0U, hll.estimate());
+}
+
+
+/*
+  Merging the sketches of two overlapping streams gives the sketch of
+  the union, identical to adding all values to one sketch.
+*/
+TEST(HyperloglogTest, Merge)
+{
+  Hyperloglog left, right, all;
+  for (ulonglong i= 0; i < 60000; i++)
+  {
+    left.add(Hyperloglog::mix(i));
+    all.add(Hyperloglog::mix(i));
+  }
+  for (ulonglong i= 40000; i < 100000; i++)
+  {
+    right.add(Hyperloglog::mix(i));
+    all.add(Hyperloglog::mix(i));
+  }
+  left.merge(right);
+  EXPECT_EQ(0, memcmp(left.registers(), all.registers(),
+                      Hyperloglog::serialized_size()));
+  expect_close(100000, left.estimate());
+}
+
+
+TEST(HyperloglogTest, SaveAndLoad)
+{
+  Hyperloglog hll;
+  for (ulonglong i= 0; i < 5000; i++)
+    hll.add(Hyperloglog::mix(i));
+
+  Hyperloglog copy;
+  copy.load(hll.registers());
+  EXPECT_EQ(hll.estimate(), copy.estimate());
+}
+
+
+TEST(HyperloglogTest, CombineIsOrderSensitive)
+{
+  const ulonglong a= Hyperloglog::mix(1);
+  const ulonglong b= Hyperloglog::mix(2);
+  EXPECT_NE(Hyperloglog::combine(a, b), Hyperloglog::combine(b, a));
+}
+
+}
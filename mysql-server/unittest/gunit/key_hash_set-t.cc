@@ -0,0 +1,115 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "key_hash_set.h"
+
+namespace key_hash_set_unittest {
+
+const ulonglong max_size= 1024 * 1024;
+
+const uchar *key(const longlong &value)
+{
+  return reinterpret_cast<const uchar*>(&value);
+}
+
+
+TEST(KeyHashSetTest, InsertAndLookup)
+{
+  Key_hash_set set(PSI_NOT_INSTRUMENTED, sizeof(longlong), max_size);
+  EXPECT_FALSE(set.is_initialized());
+  ASSERT_FALSE(set.init());
+  EXPECT_TRUE(set.is_initialized());
+
+  for (longlong i= 0; i < 10000; i++)
+  {
+    const longlong value= i * 7 - 500;
+    EXPECT_EQ(Key_hash_set::KEY_INSERTED, set.insert(key(value)));
+  }
+  EXPECT_EQ(10000U, set.elements());
+  for (longlong i= 0; i < 10000; i++)
+  {
+    const longlong value= i * 7 - 500;
+    EXPECT_EQ(Key_hash_set::KEY_EXISTS, set.insert(key(value)));
+    EXPECT_TRUE(set.contains(key(value)));
+    const longlong other= value + 1;
+    EXPECT_FALSE(set.contains(key(other)));
+  }
+  EXPECT_EQ(10000U, set.elements());
+}
+
+
+TEST(KeyHashSetTest, Iterate)
+{
+  Key_hash_set set(PSI_NOT_INSTRUMENTED, sizeof(longlong), max_size);
+  ASSERT_FALSE(set.init());
+  longlong sum= 0;
+  for (longlong i= 1; i <= 3000; i++)
+  {
+    set.insert(key(i));
+    sum+= i;
+  }
+
+  ulong pos= 0;
+  ulong count= 0;
+  const uchar *k;
+  while ((k= set.next_key(&pos)))
+  {
+    longlong value;
+    memcpy(&value, k, sizeof(value));
+    sum-= value;
+    count++;
+  }
+  EXPECT_EQ(3000U, count);
+  EXPECT_EQ(0, sum);
+}
+
+
+TEST(KeyHashSetTest, Full)
+{
+  // Room for MIN_CAPACITY slots only, so the set holds half as many keys
+  const ulonglong limit= Key_hash_set::MIN_CAPACITY * (sizeof(longlong) + 1);
+  Key_hash_set set(PSI_NOT_INSTRUMENTED, sizeof(longlong), limit);
+  ASSERT_FALSE(set.init());
+
+  longlong i= 0;
+  for (; i < static_cast<longlong>(Key_hash_set::MIN_CAPACITY / 2); i++)
+    EXPECT_EQ(Key_hash_set::KEY_INSERTED, set.insert(key(i)));
+  EXPECT_EQ(Key_hash_set::SET_FULL, set.insert(key(i)));
+  EXPECT_FALSE(set.contains(key(i)));
+
+  // Duplicates are still detected when the set is full
+  const longlong first= 0;
+  EXPECT_EQ(Key_hash_set::KEY_EXISTS, set.insert(key(first)));
+
+  // init() empties the set and reuses the slots
+  ASSERT_FALSE(set.init());
+  EXPECT_EQ(0U, set.elements());
+  EXPECT_FALSE(set.contains(key(first)));
+  EXPECT_EQ(Key_hash_set::KEY_INSERTED, set.insert(key(first)));
+}
+
+
+TEST(KeyHashSetTest, TooSmallLimit)
+{
+  Key_hash_set set(PSI_NOT_INSTRUMENTED, sizeof(longlong), 100);
+  EXPECT_TRUE(set.init());
+  EXPECT_FALSE(set.is_initialized());
+}
+
+}
@@ -29,6 +29,7 @@
 #include "mdl.h"
 #include <mysqld_error.h>
 
+#include "my_atomic.h"
 #include "thr_malloc.h"
 #include "thread_utils.h"
 #include "test_mdl_context_owner.h"
@@ -4062,6 +4063,139 @@ TEST_F(MDLTest, FindLockOwner)
 }
 
 
+/**
+  Thread class for the stress test of "fast path" locks. Acquires and
+  releases SW locks on the same table, like DML statements on a hot table.
+*/
+
+class MDL_fast_path_thread : public Thread, public Test_MDL_context_owner
+{
+public:
+  MDL_fast_path_thread(int iterations, enum_mdl_type mdl_type,
+                       int32 volatile *shared_holders,
+                       int32 volatile *exclusive_holders)
+    : m_iterations(iterations), m_mdl_type(mdl_type),
+      m_shared_holders(shared_holders),
+      m_exclusive_holders(exclusive_holders)
+  {
+    m_mdl_context.init(this);
+  }
+
+  ~MDL_fast_path_thread()
+  {
+    m_mdl_context.destroy();
+  }
+
+  virtual void run();
+
+  virtual void notify_shared_lock(MDL_context_owner *in_use,
+                                  bool needs_thr_lock_abort)
+  { }
+
+private:
+  MDL_context   m_mdl_context;
+  int           m_iterations;
+  enum_mdl_type m_mdl_type;
+  int32 volatile *m_shared_holders;
+  int32 volatile *m_exclusive_holders;
+};
+
+
+void MDL_fast_path_thread::run()
+{
+  const bool is_exclusive= (m_mdl_type == MDL_EXCLUSIVE);
+
+  for (int i= 0; i < m_iterations; ++i)
+  {
+    MDL_request global_request, request;
+    MDL_REQUEST_INIT(&global_request,
+                     MDL_key::GLOBAL, "", "", MDL_INTENTION_EXCLUSIVE,
+                     MDL_TRANSACTION);
+    MDL_REQUEST_INIT(&request,
+                     MDL_key::TABLE, db_name, table_name1, m_mdl_type,
+                     MDL_TRANSACTION);
+
+    EXPECT_FALSE(m_mdl_context.acquire_lock(&global_request, long_timeout));
+    EXPECT_FALSE(m_mdl_context.acquire_lock(&request, long_timeout));
+
+    /* Check that the exclusive lock is never granted with a shared one. */
+    if (is_exclusive)
+    {
+      my_atomic_add32(m_exclusive_holders, 1);
+      EXPECT_EQ(0, my_atomic_load32(m_shared_holders));
+      my_atomic_add32(m_exclusive_holders, -1);
+    }
+    else
+    {
+      my_atomic_add32(m_shared_holders, 1);
+      EXPECT_EQ(0, my_atomic_load32(m_exclusive_holders));
+      my_atomic_add32(m_shared_holders, -1);
+    }
+
+    m_mdl_context.release_transactional_locks();
+  }
+}
+
+
+/**
+  Stress test for many threads acquiring "unobtrusive" locks on the same
+  table using "fast path", which makes the MDL_lock object sharded, with
+  a thread acquiring exclusive locks once in a while, which drains it.
+  The number of acquisitions per second is recorded as a property of the
+  test. Increase the number of iterations for actual benchmarking.
+*/
+
+TEST_F(MDLTest, FastPathConcurrentStress)
+{
+  const int THREADS= 16;
+#if !defined(DBUG_OFF)
+  const int ITERATIONS= 2000;
+#else
+  const int ITERATIONS= 100000;
+#endif
+  int32 volatile shared_holders= 0, exclusive_holders= 0;
+  MDL_fast_path_thread *threads[THREADS];
+  int i;
+
+  for (i= 0; i < THREADS; ++i)
+    threads[i]= new MDL_fast_path_thread(ITERATIONS, MDL_SHARED_WRITE,
+                                         &shared_holders,
+                                         &exclusive_holders);
+  MDL_fast_path_thread exclusive_thread(ITERATIONS / 1000, MDL_EXCLUSIVE,
+                                        &shared_holders, &exclusive_holders);
+
+  ulonglong start= my_getsystime();
+  for (i= 0; i < THREADS; ++i)
+    threads[i]->start();
+  exclusive_thread.start();
+
+  for (i= 0; i < THREADS; ++i)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+  exclusive_thread.join();
+  /* my_getsystime() counts in units of 100 nanoseconds. */
+  ulonglong elapsed= my_getsystime() - start;
+
+  EXPECT_EQ(0, shared_holders);
+  EXPECT_EQ(0, exclusive_holders);
+  if (elapsed > 0)
+    RecordProperty("acquisitions_per_second",
+                   static_cast<int>(THREADS * ITERATIONS * 10000000ULL /
+                                    elapsed));
+
+  /* All locks are gone, the lock for the table can be freed. */
+  mdl_locks_unused_locks_low_water= 0;
+  MDL_REQUEST_INIT(&m_request,
+                   MDL_key::TABLE, db_name, table_name1, MDL_EXCLUSIVE,
+                   MDL_TRANSACTION);
+  EXPECT_FALSE(m_mdl_context.acquire_lock(&m_request, long_timeout));
+  m_mdl_context.release_transactional_locks();
+  EXPECT_EQ(0, mdl_get_unused_locks_count());
+}
+
+
 /** Test class for MDL_key class testing. Doesn't require MDL initialization. */
 
 class MDLKeyTest : public ::testing::Test
@@ -0,0 +1,310 @@
+/* Copyright (c) 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+#include "parsertest.h"
+#include "sql_lex.h"
+#include "sql_query_template.h"
+#include "sql_string.h"
+
+namespace sql_lexer_unittest {
+
+/*
+  Set num_iterations to a reasonable value (e.g. 100000), build release
+  and run with 'sql_lexer-t --disable-tap-output' to see the time taken
+  to parse the statements, or to split them into their templates and
+  literals. The benchmarks record the statements per second as the
+  property statements_per_second, see --gtest_output=xml.
+*/
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+static int num_iterations= 2;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+static int num_iterations= 2000;
+#endif
+
+class LexerTest : public ParserTest
+{
+protected:
+  virtual void SetUp()
+  {
+    initializer.SetUp();
+    thd()->variables.character_set_client= &my_charset_utf8_general_ci;
+    thd()->update_charset();
+  }
+  virtual void TearDown() { initializer.TearDown(); }
+
+  const char *first_table_name(const char *query)
+  {
+    SELECT_LEX *select_lex= parse(query, 0);
+    return select_lex->table_list.first->table_name;
+  }
+
+  /// Free what parse() allocated, as after each statement of a session
+  void end_statement()
+  {
+    thd()->end_statement();
+    thd()->cleanup_after_query();
+    free_root(thd()->mem_root, MYF(MY_KEEP_PREALLOC));
+  }
+
+  /// Split a statement into its template and literals, like mysql_parse()
+  enum_query_template_split split(const char *query, String *text,
+                                  Query_template_literals *literals)
+  {
+    Parser_state state;
+    state.init(thd(), const_cast<char*>(query), strlen(query));
+    return query_template_split(thd(), &state, text, literals);
+  }
+
+  /// Parameters of a template, freed with the items of the statement
+  Item_param **make_params(size_t count)
+  {
+    Item_param **params=
+      static_cast<Item_param**>(thd()->alloc(count * sizeof(Item_param*)));
+    for (size_t i= 0; i < count; i++)
+    {
+      params[i]= new Item_param(POS(), static_cast<uint>(i));
+      params[i]->next= thd()->free_list;
+      thd()->free_list= params[i];
+    }
+    return params;
+  }
+
+  /// Record the rate of a benchmark which started at start
+  void record_statements_per_second(ulonglong start, size_t num_queries)
+  {
+    /* my_getsystime() counts in units of 100 nanoseconds. */
+    const ulonglong elapsed= my_getsystime() - start;
+    if (elapsed > 0)
+      RecordProperty("statements_per_second",
+                     static_cast<int>(num_iterations * num_queries *
+                                      10000000ULL / elapsed));
+  }
+
+  void benchmark(const char **queries, size_t num_queries);
+  void benchmark_templates(const char **queries, size_t num_queries);
+};
+
+
+void LexerTest::benchmark(const char **queries, size_t num_queries)
+{
+  const ulonglong start= my_getsystime();
+  for (int i= 0; i < num_iterations; i++)
+  {
+    for (size_t j= 0; j < num_queries; j++)
+    {
+      parse(queries[j], 0);
+      end_statement();
+    }
+  }
+  record_statements_per_second(start, num_queries);
+}
+
+
+/*
+  What a statement costs instead of parse() when it is executed from a
+  cached template, but for the lookup of the template.
+*/
+void LexerTest::benchmark_templates(const char **queries, size_t num_queries)
+{
+  const ulonglong start= my_getsystime();
+  for (int i= 0; i < num_iterations; i++)
+  {
+    for (size_t j= 0; j < num_queries; j++)
+    {
+      char buff[STRING_BUFFER_USUAL_SIZE * 4];
+      String text(buff, sizeof(buff), &my_charset_bin);
+      Query_template_literals literals(thd()->mem_root);
+      EXPECT_EQ(QUERY_TEMPLATE_SPLIT, split(queries[j], &text, &literals));
+      EXPECT_FALSE(query_template_bind(thd(), make_params(literals.size()),
+                                       literals));
+      end_statement();
+    }
+  }
+  record_statements_per_second(start, num_queries);
+}
+
+
+TEST_F(LexerTest, AsciiIdentifiers)
+{
+  EXPECT_STREQ("t1", first_table_name("SELECT a FROM t1 WHERE b = 1"));
+  end_statement();
+  EXPECT_STREQ("t_2", first_table_name("SELECT a FROM db.t_2 WHERE b = 1"));
+  end_statement();
+  EXPECT_STREQ("T3", first_table_name("DELETE FROM T3 WHERE id = 1"));
+  end_statement();
+}
+
+
+TEST_F(LexerTest, MultiByteIdentifiers)
+{
+  // 't', 'a' with ring above, '1'
+  EXPECT_STREQ("t\xc3\xa5" "1",
+               first_table_name("SELECT a FROM t\xc3\xa5" "1 WHERE b = 1"));
+  end_statement();
+  EXPECT_STREQ("\xc3\xa5",
+               first_table_name("SELECT a FROM db.\xc3\xa5 WHERE b = 1"));
+  end_statement();
+}
+
+
+/*
+  Single-row statements by primary key, which are most of the statements
+  of OLTP applications.
+*/
+static const char *point_statements[]=
+{
+  "SELECT c, pad FROM sbtest1 WHERE id = 4711",
+  "INSERT INTO sbtest1 (id, k, c, pad) VALUES (4711, 42, 'abc', 'def')",
+  "UPDATE sbtest1 SET k = k + 1 WHERE id = 4711",
+  "DELETE FROM sbtest1 WHERE id = 4711"
+};
+
+
+TEST_F(LexerTest, BenchmarkPointStatements)
+{
+  benchmark(point_statements, array_elements(point_statements));
+}
+
+
+TEST_F(LexerTest, BenchmarkPointStatementsFromTemplate)
+{
+  benchmark_templates(point_statements, array_elements(point_statements));
+}
+
+
+TEST_F(LexerTest, TemplateOfPointStatement)
+{
+  String text;
+  Query_template_literals literals(thd()->mem_root);
+  EXPECT_EQ(QUERY_TEMPLATE_SPLIT,
+            split("UPDATE t1 SET b = 'it''s', c = c + 1.5 WHERE a = -42",
+                  &text, &literals));
+  EXPECT_STREQ("UPDATE t1 SET b = ?, c = c + ? WHERE a = -?",
+               text.c_ptr_safe());
+  ASSERT_EQ(3U, literals.size());
+  EXPECT_EQ(Query_template_literal::STRING, literals[0].type);
+  EXPECT_STREQ("it's", literals[0].value.str);
+  EXPECT_EQ(Query_template_literal::DECIMAL, literals[1].type);
+  EXPECT_STREQ("1.5", literals[1].value.str);
+  EXPECT_EQ(Query_template_literal::INT, literals[2].type);
+  EXPECT_STREQ("42", literals[2].value.str);
+  end_statement();
+}
+
+
+TEST_F(LexerTest, TemplateKeepsTypedLiterals)
+{
+  String text;
+  Query_template_literals literals(thd()->mem_root);
+  EXPECT_EQ(QUERY_TEMPLATE_SPLIT,
+            split("SELECT a FROM t1 WHERE b = _latin1'x' AND"
+                  " c = DATE '2015-01-01' AND d = 1e3 AND"
+                  " e = 18446744073709551615", &text, &literals));
+  EXPECT_STREQ("SELECT a FROM t1 WHERE b = _latin1'x' AND"
+               " c = DATE '2015-01-01' AND d = ? AND e = ?",
+               text.c_ptr_safe());
+  ASSERT_EQ(2U, literals.size());
+  EXPECT_EQ(Query_template_literal::REAL, literals[0].type);
+  EXPECT_EQ(Query_template_literal::UINT, literals[1].type);
+  end_statement();
+}
+
+
+TEST_F(LexerTest, NoTemplate)
+{
+  const char *queries[]=
+  {
+    "SHOW TABLES",
+    "SELECT a FROM t1 WHERE b = 1; SELECT 2",
+    "SELECT a INTO @a FROM t1 WHERE b = 1",
+    "SELECT a FROM t1 WHERE b = ?",
+    "DELETE FROM t1 WHERE b = 'unterminated"
+  };
+  for (size_t i= 0; i < array_elements(queries); i++)
+  {
+    String text;
+    Query_template_literals literals(thd()->mem_root);
+    EXPECT_EQ(QUERY_TEMPLATE_NONE, split(queries[i], &text, &literals))
+      << queries[i];
+    end_statement();
+  }
+}
+
+
+TEST_F(LexerTest, TemplateWithoutShape)
+{
+  const char *queries[]=
+  {
+    "SELECT a FROM t1 JOIN t2 USING (b) WHERE a = 1",
+    "SELECT a FROM t1 WHERE a = 1 UNION SELECT a FROM t2 WHERE a = 2",
+    "SELECT a FROM t1 WHERE b = (SELECT MAX(b) FROM t2)",
+    "SELECT a FROM t1 WHERE b = 1 ORDER BY c",
+    "DELETE FROM t1 WHERE b = 1 ORDER BY c LIMIT 1",
+    "INSERT INTO t1 SELECT a FROM t2 WHERE b = 1"
+  };
+  for (size_t i= 0; i < array_elements(queries); i++)
+  {
+    String text;
+    Query_template_literals literals(thd()->mem_root);
+    EXPECT_EQ(QUERY_TEMPLATE_NO_SHAPE, split(queries[i], &text, &literals))
+      << queries[i];
+    end_statement();
+  }
+}
+
+
+TEST_F(LexerTest, BindTemplateLiterals)
+{
+  String text;
+  Query_template_literals literals(thd()->mem_root);
+  EXPECT_EQ(QUERY_TEMPLATE_SPLIT,
+            split("INSERT INTO t1 VALUES"
+                  " (18446744073709551615, -7, 2.50, 1e1, 'abc')",
+                  &text, &literals));
+  ASSERT_EQ(5U, literals.size());
+
+  Item_param **params= make_params(literals.size());
+  EXPECT_FALSE(query_template_bind(thd(), params, literals));
+
+  EXPECT_TRUE(params[0]->unsigned_flag);
+  EXPECT_EQ(ULLONG_MAX, static_cast<ulonglong>(params[0]->val_int()));
+  EXPECT_FALSE(params[1]->unsigned_flag);
+  EXPECT_EQ(7, params[1]->val_int());
+  EXPECT_EQ(2.5, params[2]->val_real());
+  EXPECT_EQ(10.0, params[3]->val_real());
+  String buff;
+  EXPECT_STREQ("abc", params[4]->val_str(&buff)->c_ptr_safe());
+  end_statement();
+}
+
+
+TEST_F(LexerTest, BenchmarkRangeStatements)
+{
+  const char *queries[]=
+  {
+    "SELECT c FROM sbtest1 WHERE id BETWEEN 4711 AND 4810 ORDER BY c",
+    "SELECT SUM(k) FROM sbtest1 WHERE id BETWEEN 4711 AND 4810",
+    "SELECT DISTINCT c FROM sbtest1 WHERE id BETWEEN 4711 AND 4810"
+  };
+  benchmark(queries, array_elements(queries));
+}
+
+}
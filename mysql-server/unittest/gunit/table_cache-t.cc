@@ -17,6 +17,7 @@
 #include "my_config.h"
 #include <gtest/gtest.h>
 #include "test_utils.h"
+#include "thread_utils.h"
 
 #include "table_cache.h"
 
@@ -32,6 +33,7 @@ extern handlerton *example_hton;
 namespace table_cache_unittest {
 
 using my_testing::Server_initializer;
+using thread::Thread;
 
 // Strings in asserts are slightly different on Windows
 #ifdef SAFE_MUTEX
@@ -155,8 +157,11 @@ public:
       the share is up-to-date.
     */
     version= refresh_version;
-    // Ensure that share is never destroyed.
-    ref_count= UINT_MAX;
+    /*
+      Ensure that share is never destroyed. Leave room for the references
+      added by the tests.
+    */
+    ref_count= INT_MAX32 / 2;
   }
 
   ~Mock_share()
@@ -1038,4 +1043,143 @@ TEST_F(TableCacheDoubleCacheTest, Iterator)
   share_2.destroy_table(table_5);
 }
 
+
+
+/**
+  Thread which opens a table the way open_table() does when the TABLE
+  objects for it in its table cache are all in use: it finds the share
+  through the cache and adds a reference to it under the lock of the
+  cache only. The reference is dropped under LOCK_open, as by
+  release_table_share().
+*/
+
+class Table_cache_share_thread : public Thread
+{
+public:
+  Table_cache_share_thread(THD *thd, TABLE_SHARE *share, int iterations)
+    : m_thd(thd), m_share(share), m_iterations(iterations)
+  { }
+
+  virtual void run()
+  {
+    Table_cache *table_cache= table_cache_manager.get_cache(m_thd);
+    my_hash_value_type hash_value= my_calc_hash(&table_def_cache,
+                                     (uchar*)m_share->table_cache_key.str,
+                                     m_share->table_cache_key.length);
+
+    for (int i= 0; i < m_iterations; ++i)
+    {
+      TABLE_SHARE *share;
+
+      table_cache->lock();
+      TABLE *table= table_cache->get_table(m_thd, hash_value,
+                                           m_share->table_cache_key.str,
+                                           m_share->table_cache_key.length,
+                                           &share);
+      EXPECT_TRUE(table == NULL);
+      EXPECT_TRUE(share == m_share);
+      share->increment_ref_count();
+      table_cache->unlock();
+
+      mysql_mutex_lock(&LOCK_open);
+      share->decrement_ref_count();
+      mysql_mutex_unlock(&LOCK_open);
+    }
+  }
+
+private:
+  THD *m_thd;
+  TABLE_SHARE *m_share;
+  int m_iterations;
+};
+
+
+/**
+  Add and drop references to a share through two table cache instances
+  concurrently, and check that none is lost or leaked.
+
+  @returns the time the threads took, in units of 100 nanoseconds
+*/
+
+static ulonglong concurrent_share_references(THD *thd_1, THD *thd_2,
+                                             int iterations)
+{
+  Mock_share share_1("share_1");
+  const int32 ref_count= share_1.ref_count;
+
+  // The threads use different caches, each with a used TABLE for the share.
+  Table_cache *table_cache_1= table_cache_manager.get_cache(thd_1);
+  Table_cache *table_cache_2= table_cache_manager.get_cache(thd_2);
+  EXPECT_NE(table_cache_1, table_cache_2);
+
+  TABLE *table_1= share_1.create_table(thd_1);
+  TABLE *table_2= share_1.create_table(thd_2);
+  table_cache_1->lock();
+  table_cache_1->add_used_table(thd_1, table_1);
+  table_cache_1->unlock();
+  table_cache_2->lock();
+  table_cache_2->add_used_table(thd_2, table_2);
+  table_cache_2->unlock();
+
+  Table_cache_share_thread thread_1(thd_1, &share_1, iterations);
+  Table_cache_share_thread thread_2(thd_2, &share_1, iterations);
+
+  ulonglong start= my_getsystime();
+  thread_1.start();
+  thread_2.start();
+  thread_1.join();
+  thread_2.join();
+  ulonglong elapsed= my_getsystime() - start;
+
+  EXPECT_EQ(ref_count, share_1.ref_count);
+
+  // Clean-up
+  table_cache_1->lock();
+  table_cache_1->remove_table(table_1);
+  table_cache_1->unlock();
+  table_cache_2->lock();
+  table_cache_2->remove_table(table_2);
+  table_cache_2->unlock();
+
+  share_1.destroy_table(table_1);
+  share_1.destroy_table(table_2);
+
+  return elapsed;
+}
+
+
+/*
+  Test that references to a share added through different table cache
+  instances concurrently are not lost or leaked.
+*/
+
+TEST_F(TableCacheDoubleCacheTest, ConcurrentShareReferences)
+{
+  concurrent_share_references(get_thd(0), get_thd(1), 10000);
+}
+
+
+/*
+  Measure how many references to a share can be added per second through
+  different table cache instances concurrently. Run with
+  --gtest_also_run_disabled_tests, the rate is recorded as the property
+  references_per_second.
+*/
+
+TEST_F(TableCacheDoubleCacheTest, DISABLED_BenchmarkConcurrentShareReferences)
+{
+#if !defined(DBUG_OFF)
+  // There is no point in benchmarking anything in debug mode.
+  const int ITERATIONS= 10000;
+#else
+  const int ITERATIONS= 1000000;
+#endif
+  /* my_getsystime() counts in units of 100 nanoseconds. */
+  ulonglong elapsed=
+    concurrent_share_references(get_thd(0), get_thd(1), ITERATIONS);
+  if (elapsed > 0)
+    RecordProperty("references_per_second",
+                   static_cast<int>(2 * ITERATIONS * 10000000ULL / elapsed));
+}
+
 }
@@ -24,6 +24,9 @@
 #include "mysqld.h"
 #include "mysqld_thd_manager.h"  // Global_THD_manager
 
+#include <algorithm>
+#include <vector>
+
 using thread::Thread;
 using thread::Notification;
 
@@ -285,6 +288,178 @@ TEST_F(ThreadManagerTest, ThreadID)
 }
 
 
+/*
+  Allocates thread ids, concurrently with other instances.
+*/
+class Thread_id_thread : public Thread
+{
+public:
+  Thread_id_thread(Global_THD_manager *thd_manager, int num_ids)
+    : m_thd_manager(thd_manager), m_num_ids(num_ids)
+  {}
+
+  const std::vector<my_thread_id> &get_ids() const { return m_ids; }
+
+protected:
+  virtual void run()
+  {
+    for (int i= 0; i < m_num_ids; i++)
+      m_ids.push_back(m_thd_manager->get_new_thread_id());
+  }
+
+private:
+  Global_THD_manager *m_thd_manager;
+  int m_num_ids;
+  std::vector<my_thread_id> m_ids;
+};
+
+
+TEST_F(ThreadManagerTest, ConcurrentThreadID)
+{
+  const int num_threads= 8;
+  const int num_ids= 1000;
+  Thread_id_thread *threads[num_threads];
+  for (int i= 0; i < num_threads; i++)
+  {
+    threads[i]= new Thread_id_thread(thd_manager, num_ids);
+    threads[i]->start();
+  }
+
+  std::vector<my_thread_id> ids;
+  for (int i= 0; i < num_threads; i++)
+  {
+    threads[i]->join();
+    ids.insert(ids.end(), threads[i]->get_ids().begin(),
+               threads[i]->get_ids().end());
+    delete threads[i];
+  }
+
+  // No id is handed out twice, nor the reserved one
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids.end(), std::unique(ids.begin(), ids.end()));
+  EXPECT_FALSE(std::binary_search(ids.begin(), ids.end(),
+                                  Global_THD_manager::reserved_thread_id));
+
+  for (size_t i= 0; i < ids.size(); i++)
+    thd_manager->release_thread_id(ids[i]);
+}
+
+
+/*
+  Adds its THDs to the THD list and removes them again, a number of
+  times, concurrently with other instances and with scans of the list.
+*/
+class Add_remove_thread : public Thread
+{
+public:
+  Add_remove_thread(Global_THD_manager *thd_manager, THD **thds,
+                    int num_thds, int loops)
+    : m_thd_manager(thd_manager), m_thds(thds), m_num_thds(num_thds),
+      m_loops(loops)
+  {}
+
+protected:
+  virtual void run()
+  {
+    for (int i= 0; i < m_loops; i++)
+    {
+      for (int j= 0; j < m_num_thds; j++)
+        m_thd_manager->add_thd(m_thds[j]);
+      for (int j= 0; j < m_num_thds; j++)
+        m_thd_manager->remove_thd(m_thds[j]);
+    }
+  }
+
+private:
+  Global_THD_manager *m_thd_manager;
+  THD **m_thds;
+  int m_num_thds;
+  int m_loops;
+};
+
+
+/*
+  Scans the THD list, like SHOW PROCESSLIST, until it is told to stop.
+*/
+class Scan_thread : public Thread
+{
+public:
+  Scan_thread(Global_THD_manager *thd_manager, Notification *stop)
+    : m_thd_manager(thd_manager), m_stop(stop), m_num_scans(0)
+  {}
+
+  int get_num_scans() const { return m_num_scans; }
+
+protected:
+  virtual void run()
+  {
+    TestFunc1 counter;
+    TestFunc2 finder;
+    finder.set_search_value(UINT_MAX32);
+    while (!m_stop->has_been_notified())
+    {
+      m_thd_manager->do_for_all_thd(&counter);
+      m_thd_manager->do_for_all_thd_copy(&counter);
+      EXPECT_TRUE(m_thd_manager->find_thd(&finder) == NULL);
+      m_num_scans++;
+    }
+  }
+
+private:
+  Global_THD_manager *m_thd_manager;
+  Notification *m_stop;
+  int m_num_scans;
+};
+
+
+/*
+  Connect and disconnect bursts of several threads, concurrent with
+  scans of the THD list. The time of the test shows the contention on
+  the THD list.
+*/
+TEST_F(ThreadManagerTest, ConcurrentAddRemove)
+{
+  const int num_threads= 8;
+  const int thds_per_thread= 16;
+  const int loops= 2000;
+
+  THD *thds[num_threads * thds_per_thread];
+  for (int i= 0; i < num_threads * thds_per_thread; i++)
+  {
+    thds[i]= new THD(false);
+    thds[i]->server_id= i;
+    thds[i]->set_new_thread_id();
+  }
+
+  Notification stop;
+  Scan_thread scanner(thd_manager, &stop);
+  scanner.start();
+
+  Add_remove_thread *threads[num_threads];
+  for (int i= 0; i < num_threads; i++)
+  {
+    threads[i]= new Add_remove_thread(thd_manager,
+                                      &thds[i * thds_per_thread],
+                                      thds_per_thread, loops);
+    threads[i]->start();
+  }
+  for (int i= 0; i < num_threads; i++)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  stop.notify();
+  scanner.join();
+  EXPECT_LT(0, scanner.get_num_scans());
+
+  EXPECT_EQ(0U, thd_manager->get_thd_count());
+
+  for (int i= 0; i < num_threads * thds_per_thread; i++)
+    delete thds[i];
+}
+
+
 #if !defined(DBUG_OFF)
 TEST_F(ThreadManagerTest, ThreadIDDeathTest)
 {
@@ -59,4 +59,87 @@ TEST_F(UniqueCostTest, GetUseCost)
   EXPECT_GT(dup_removal_cost, 0.0);
 }
 
+
+extern "C" int unique_int_cmp(const void *, const void *a, const void *b)
+{
+  int x, y;
+  memcpy(&x, a, sizeof(x));
+  memcpy(&y, b, sizeof(y));
+  return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+
+struct Walk_result
+{
+  int count;
+  int last;
+  bool sorted;
+};
+
+
+extern "C" int unique_walk_check(void *key, element_count, void *arg)
+{
+  Walk_result *result= static_cast<Walk_result*>(arg);
+  int value;
+  memcpy(&value, key, sizeof(value));
+  if (result->count > 0 && value <= result->last)
+    result->sorted= false;
+  result->last= value;
+  result->count++;
+  return 0;
+}
+
+
+// Duplicates are removed while all keys fit in the hash set.
+TEST_F(UniqueCostTest, HashSet)
+{
+  Unique unique(unique_int_cmp, NULL, sizeof(int), 1024 * 1024);
+  EXPECT_FALSE(unique.enable_hash_set());
+  for (int i= 0; i < 50000; i++)
+  {
+    int key= i % 3000;
+    EXPECT_FALSE(unique.unique_add(&key));
+  }
+  EXPECT_EQ(0U, unique.elements);
+  EXPECT_EQ(3000U, unique.elements_in_tree());
+
+  unique.reset();
+  EXPECT_EQ(0U, unique.elements_in_tree());
+  int key= 42;
+  EXPECT_FALSE(unique.unique_add(&key));
+  EXPECT_FALSE(unique.unique_add(&key));
+  EXPECT_EQ(1U, unique.elements_in_tree());
+}
+
+
+// Keys are moved to the tree when the hash set exceeds its memory limit.
+TEST_F(UniqueCostTest, HashSetSpill)
+{
+  Unique unique(unique_int_cmp, NULL, sizeof(int), 16 * 1024);
+  EXPECT_FALSE(unique.enable_hash_set());
+  const int num_keys= 10000;
+  for (int i= num_keys - 1; i >= 0; i--)
+  {
+    int key= (i * 7) % num_keys;
+    EXPECT_FALSE(unique.unique_add(&key));
+    EXPECT_FALSE(unique.unique_add(&key));
+  }
+
+  Walk_result result= { 0, 0, true };
+  EXPECT_FALSE(unique.walk(unique_walk_check, &result));
+  EXPECT_EQ(num_keys, result.count);
+  EXPECT_TRUE(result.sorted);
+}
+
+
+// The hash set is not used if it can not fit in the memory limit.
+TEST_F(UniqueCostTest, HashSetTooBig)
+{
+  Unique unique(unique_int_cmp, NULL, sizeof(int), 1024);
+  EXPECT_TRUE(unique.enable_hash_set());
+  int key= 1;
+  EXPECT_FALSE(unique.unique_add(&key));
+  EXPECT_EQ(1U, unique.elements_in_tree());
+}
+
 }
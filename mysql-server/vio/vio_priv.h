@@ -50,6 +50,11 @@ void vio_delete_shared_memory(Vio *vio);
 #endif /* !EMBEDDED_LIBRARY */
 #endif /* _WIN32 */
 
+#ifndef _WIN32
+#include <sys/uio.h>
+size_t vio_writev(Vio *vio, const struct iovec *iov, int iovcnt);
+#endif
+
 my_bool vio_buff_has_data(Vio *vio);
 int vio_socket_io_wait(Vio *vio, enum enum_vio_io_event event);
 int vio_socket_timeout(Vio *vio, uint which, my_bool old_mode);
@@ -214,6 +214,90 @@ size_t vio_write(Vio *vio, const uchar* buf, size_t size)
   DBUG_RETURN(ret);
 }
 
+
+#ifndef _WIN32
+/**
+  Write the data of several buffers, with one system call if the
+  transport is a plain socket.
+
+  Transports that have their own write function, like SSL, write the
+  buffers one after the other and stop at the first short write.
+
+  @param vio     VIO object to write to.
+  @param iov     The buffers to write.
+  @param iovcnt  The number of buffers.
+
+  @return The number of bytes written, or -1 on error, like vio_write().
+*/
+
+size_t vio_writev(Vio *vio, const struct iovec *iov, int iovcnt)
+{
+  ssize_t ret;
+  int flags= 0;
+  size_t length= 0;
+  struct msghdr msg;
+  int i;
+  MYSQL_SOCKET_WAIT_VARIABLES(locker, state) /* no ';' */
+  DBUG_ENTER("vio_writev");
+
+  if (vio->write != vio_write)
+  {
+    size_t written= 0;
+    for (i= 0; i < iovcnt; i++)
+    {
+      size_t sentcnt;
+      if (iov[i].iov_len == 0)
+        continue;
+      sentcnt= vio->write(vio, (const uchar *) iov[i].iov_base,
+                          iov[i].iov_len);
+      if (sentcnt == (size_t) -1)
+        DBUG_RETURN(written ? written : sentcnt);
+      written+= sentcnt;
+      if (sentcnt < iov[i].iov_len)
+        break;
+    }
+    DBUG_RETURN(written);
+  }
+
+  for (i= 0; i < iovcnt; i++)
+    length+= iov[i].iov_len;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov= (struct iovec *) iov;
+  msg.msg_iovlen= iovcnt;
+
+  /* If timeout is enabled, do not block. */
+  if (vio->write_timeout >= 0)
+    flags= VIO_DONTWAIT;
+
+  for (;;)
+  {
+    int error;
+
+    /* Instrumented like mysql_socket_send() */
+    MYSQL_START_SOCKET_WAIT(locker, &state, vio->mysql_socket,
+                            PSI_SOCKET_SEND, length);
+    ret= sendmsg(mysql_socket_getfd(vio->mysql_socket), &msg, flags);
+    MYSQL_END_SOCKET_WAIT(locker, ret > 0 ? (size_t) ret : 0);
+
+    if (ret != -1)
+      break;
+
+    error= socket_errno;
+
+    /* The operation would block? */
+    if (error != SOCKET_EAGAIN && error != SOCKET_EWOULDBLOCK)
+      break;
+
+    /* Wait for the output buffer to become writable.*/
+    if ((ret= vio_socket_io_wait(vio, VIO_IO_EVENT_WRITE)))
+      break;
+  }
+
+  DBUG_RETURN(ret);
+}
+#endif /* _WIN32 */
+
 //WL#4896: Not covered
 static int vio_set_blocking(Vio *vio, my_bool status)
 {